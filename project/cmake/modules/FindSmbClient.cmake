@@ -35,6 +35,12 @@ if(SMBCLIENT_FOUND)
   set(SMBCLIENT_INCLUDE_DIRS ${SMBCLIENT_INCLUDE_DIR})
   set(SMBCLIENT_DEFINITIONS -DHAVE_LIBSMBCLIENT=1)
 
+  include(CheckLibraryExists)
+  check_library_exists(${SMBCLIENT_LIBRARY} smbc_readdirplus "" HAVE_SMBC_READDIRPLUS)
+  if(HAVE_SMBC_READDIRPLUS)
+    list(APPEND SMBCLIENT_DEFINITIONS -DHAVE_SMBC_READDIRPLUS=1)
+  endif()
+
   if(NOT TARGET SmbClient::SmbClient)
     add_library(SmbClient::SmbClient UNKNOWN IMPORTED)
     set_target_properties(SmbClient::SmbClient PROPERTIES
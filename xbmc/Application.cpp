@@ -3658,6 +3658,31 @@ void CApplication::OnQueueNextItem()
   g_windowManager.SendThreadMessage(msg);
 }
 
+void CApplication::UpdateUpcomingItems()
+{
+  if (!m_pPlayer->IsPlayingAudio())
+    return;
+
+  CFileItemList items;
+  const CPlayList& playlist = g_playlistPlayer.GetPlaylist(g_playlistPlayer.GetCurrentPlaylist());
+  for (int i = 1; i <= g_advancedSettings.m_audioPreloadTracks; i++)
+  {
+    int next = g_playlistPlayer.GetNextSong(i);
+    if (next < 0 || next >= playlist.size())
+      break;
+
+    // items that have to be resolved before playback are left to GUI_MSG_QUEUE_NEXT_ITEM
+    const CFileItemPtr item = playlist[next];
+    if (!item->IsAudio() || item->IsVideo() ||
+        URIUtils::IsPlugin(item->GetPath()) || URIUtils::IsUPnP(item->GetPath()))
+      continue;
+
+    items.Add(CFileItemPtr(new CFileItem(*item)));
+  }
+
+  m_pPlayer->SetUpcomingFiles(items);
+}
+
 void CApplication::OnPlayBackStopped()
 {
   CSingleLock lock(m_playStateMutex);
@@ -4273,6 +4298,8 @@ bool CApplication::OnMessage(CGUIMessage& message)
       param["player"]["speed"] = 1;
       param["player"]["playerid"] = g_playlistPlayer.GetCurrentPlaylist();
       CAnnouncementManager::GetInstance().Announce(Player, "xbmc", "OnPlay", m_itemCurrentFile, param);
+
+      UpdateUpcomingItems();
       return true;
     }
     break;
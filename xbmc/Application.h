@@ -422,6 +422,11 @@ protected:
    */
   bool NotifyActionListeners(const CAction &action) const;
 
+  /*!
+   \brief Tell the player which playlist items follow the current one so that it can prepare them.
+   */
+  void UpdateUpcomingItems();
+
   bool m_confirmSkinChange;
   bool m_ignoreSkinSettingChanges;
 
@@ -504,6 +504,13 @@ void CApplicationPlayer::OnNothingToQueueNotify()
     player->OnNothingToQueueNotify();
 }
 
+void CApplicationPlayer::SetUpcomingFiles(const CFileItemList &files)
+{
+  std::shared_ptr<IPlayer> player = GetInternal();
+  if (player)
+    player->SetUpcomingFiles(files);
+}
+
 void CApplicationPlayer::GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo &info)
 {
   std::shared_ptr<IPlayer> player = GetInternal();
@@ -170,6 +170,7 @@ public:
   void  SetSubtitleVisible(bool bVisible);
   void  SetTime(int64_t time);
   void  SetTotalTime(int64_t time);
+  void  SetUpcomingFiles(const CFileItemList &files);
   void  SetVideoStream(int iStream);
   void  SetVolume(float volume);
   bool  SwitchChannel(const PVR::CPVRChannelPtr &channel);
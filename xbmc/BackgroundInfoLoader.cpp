@@ -27,6 +27,8 @@
 CBackgroundInfoLoader::CBackgroundInfoLoader() : m_thread (NULL)
 {
   m_bStop = true;
+  m_bPartial = false;
+  m_taken = 0;
   m_pObserver=NULL;
   m_pProgressCallback=NULL;
   m_pVecItems = NULL;
@@ -46,44 +48,35 @@ void CBackgroundInfoLoader::Run()
     {
       OnLoaderStart();
 
-      // Stage 1: All "fast" stuff we have already cached
-      for (std::vector<CFileItemPtr>::const_iterator iter = m_vecItems.begin(); iter != m_vecItems.end(); ++iter)
+      // a partial listing keeps growing while we work, so take the items in batches
+      while (!m_bStop && !(m_pProgressCallback && m_pProgressCallback->Abort()))
       {
-        CFileItemPtr pItem = *iter;
-
-        // Ask the callback if we should abort
-        if ((m_pProgressCallback && m_pProgressCallback->Abort()) || m_bStop)
-          break;
-
-        try
-        {
-          if (LoadItemCached(pItem.get()) && m_pObserver)
-            m_pObserver->OnItemLoaded(pItem.get());
-        }
-        catch (...)
+        std::vector<CFileItemPtr> items;
+        bool partial;
         {
-          CLog::Log(LOGERROR, "CBackgroundInfoLoader::LoadItemCached - Unhandled exception for item %s", CURL::GetRedacted(pItem->GetPath()).c_str());
+          CSingleLock lock(m_lock);
+          items.assign(m_vecItems.begin() + m_taken, m_vecItems.end());
+          m_taken = m_vecItems.size();
+          partial = m_bPartial;
         }
-      }
-
-      // Stage 2: All "slow" stuff that we need to lookup
-      for (std::vector<CFileItemPtr>::const_iterator iter = m_vecItems.begin(); iter != m_vecItems.end(); ++iter)
-      {
-        CFileItemPtr pItem = *iter;
 
-        // Ask the callback if we should abort
-        if ((m_pProgressCallback && m_pProgressCallback->Abort()) || m_bStop)
-          break;
-
-        try
-        {
-          if (LoadItemLookup(pItem.get()) && m_pObserver)
-            m_pObserver->OnItemLoaded(pItem.get());
-        }
-        catch (...)
+        if (!items.empty())
         {
-          CLog::Log(LOGERROR, "CBackgroundInfoLoader::LoadItemLookup - Unhandled exception for item %s", CURL::GetRedacted(pItem->GetPath()).c_str());
+          if (LoadItems(items) && partial)
+          {
+            // remember the copies that are done, Load() hands their info on
+            CSingleLock lock(m_lock);
+            if (m_bPartial)
+            {
+              for (std::vector<CFileItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it)
+                m_loaded[(*it)->GetPath()] = *it;
+            }
+          }
         }
+        else if (partial)
+          m_partialEvent.WaitMSec(100);
+        else
+          break;
       }
     }
 
@@ -97,14 +90,86 @@ void CBackgroundInfoLoader::Run()
   }
 }
 
+bool CBackgroundInfoLoader::LoadItems(const std::vector<CFileItemPtr>& items)
+{
+  // Stage 1: All "fast" stuff we have already cached
+  for (std::vector<CFileItemPtr>::const_iterator iter = items.begin(); iter != items.end(); ++iter)
+  {
+    CFileItemPtr pItem = *iter;
+
+    // Ask the callback if we should abort
+    if ((m_pProgressCallback && m_pProgressCallback->Abort()) || m_bStop)
+      break;
+
+    try
+    {
+      if (LoadItemCached(pItem.get()) && m_pObserver)
+        m_pObserver->OnItemLoaded(pItem.get());
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "CBackgroundInfoLoader::LoadItemCached - Unhandled exception for item %s", CURL::GetRedacted(pItem->GetPath()).c_str());
+    }
+  }
+
+  // Stage 2: All "slow" stuff that we need to lookup
+  for (std::vector<CFileItemPtr>::const_iterator iter = items.begin(); iter != items.end(); ++iter)
+  {
+    CFileItemPtr pItem = *iter;
+
+    // Ask the callback if we should abort
+    if ((m_pProgressCallback && m_pProgressCallback->Abort()) || m_bStop)
+      break;
+
+    try
+    {
+      if (LoadItemLookup(pItem.get()) && m_pObserver)
+        m_pObserver->OnItemLoaded(pItem.get());
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "CBackgroundInfoLoader::LoadItemLookup - Unhandled exception for item %s", CURL::GetRedacted(pItem->GetPath()).c_str());
+    }
+  }
+
+  return !m_bStop && !(m_pProgressCallback && m_pProgressCallback->Abort());
+}
+
 void CBackgroundInfoLoader::Load(CFileItemList& items)
 {
+  CSingleLock lock(m_lock);
+  if (m_bPartial && m_thread)
+  {
+    // carry on with the loader started on the partial listing, it still waits
+    // for entries. Copies it has not taken yet are replaced by the real items.
+    m_vecItems.erase(m_vecItems.begin() + m_taken, m_vecItems.end());
+    for (int nItem=0; nItem < items.Size(); nItem++)
+    {
+      CFileItemPtr pItem = items[nItem];
+      std::map<std::string, CFileItemPtr>::const_iterator it = m_loaded.find(pItem->GetPath());
+      if (it != m_loaded.end())
+      {
+        pItem->UpdateInfo(*it->second, false);
+        pItem->SetArt(it->second->GetArt());
+      }
+      else
+        m_vecItems.push_back(pItem);
+    }
+    m_loaded.clear();
+
+    m_pVecItems = &items;
+    m_bPartial = false;
+    m_partialEvent.Set();
+    return;
+  }
+  lock.Leave();
+
   StopThread();
 
   if (items.IsEmpty())
     return;
 
-  CSingleLock lock(m_lock);
+  lock.Enter();
 
   for (int nItem=0; nItem < items.Size(); nItem++)
     m_vecItems.push_back(items[nItem]);
@@ -118,9 +183,43 @@ void CBackgroundInfoLoader::Load(CFileItemList& items)
   m_thread->SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
 }
 
+void CBackgroundInfoLoader::OnPartialListing(const CFileItemList& items)
+{
+  if (items.IsEmpty())
+    return;
+
+  CSingleLock lock(m_lock);
+  if (m_bPartial && m_thread)
+  {
+    for (int nItem=0; nItem < items.Size(); nItem++)
+      m_vecItems.push_back(items[nItem]);
+    m_partialEvent.Set();
+    return;
+  }
+  lock.Leave();
+
+  StopThread();
+
+  lock.Enter();
+  for (int nItem=0; nItem < items.Size(); nItem++)
+    m_vecItems.push_back(items[nItem]);
+
+  // loaders may look at the list they work on, give them one for the directory
+  m_partialItems.reset(new CFileItemList(items.GetPath()));
+  m_pVecItems = m_partialItems.get();
+  m_bStop = false;
+  m_bPartial = true;
+  m_bIsLoading = true;
+
+  m_thread = new CThread(this, "BackgroundLoader");
+  m_thread->Create();
+  m_thread->SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
+}
+
 void CBackgroundInfoLoader::StopAsync()
 {
   m_bStop = true;
+  m_partialEvent.Set();
 }
 
 
@@ -135,7 +234,11 @@ void CBackgroundInfoLoader::StopThread()
     m_thread = NULL;
   }
   m_vecItems.clear();
+  m_taken = 0;
+  m_loaded.clear();
   m_pVecItems = NULL;
+  m_partialItems.reset();
+  m_bPartial = false;
   m_bIsLoading = false;
 }
 
@@ -23,9 +23,13 @@
 #include "threads/Thread.h"
 #include "IProgressCallback.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "filesystem/IDirectory.h"
 
-#include <vector>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 class CFileItem; typedef std::shared_ptr<CFileItem> CFileItemPtr;
 class CFileItemList;
@@ -37,13 +41,24 @@ public:
   virtual void OnItemLoaded(CFileItem* pItem) = 0;
 };
 
-class CBackgroundInfoLoader : public IRunnable
+class CBackgroundInfoLoader : public IRunnable, public XFILE::IDirectoryListingObserver
 {
 public:
   CBackgroundInfoLoader();
   virtual ~CBackgroundInfoLoader();
 
+  /*! \brief Load the info of the items in the background.
+   A loader started by OnPartialListing() is not stopped but carries on with the
+   items: those it has already done get their info from its copies, the others
+   are queued behind the entries it is working on.
+   */
   void Load(CFileItemList& items);
+
+  /*! \brief Start loading entries of a listing that is still being fetched.
+   The first batch starts the loader, further batches are queued behind it until
+   Load() hands over the complete listing or StopThread() is called.
+   */
+  virtual void OnPartialListing(const CFileItemList& items);
   bool IsLoading();
   virtual void Run();
   void SetObserver(IBackgroundLoaderObserver* pObserver);
@@ -59,12 +74,19 @@ protected:
   virtual void OnLoaderStart() {};
   virtual void OnLoaderFinish() {};
 
+  bool LoadItems(const std::vector<CFileItemPtr>& items);
+
   CFileItemList *m_pVecItems;
   std::vector<CFileItemPtr> m_vecItems; // FileItemList would delete the items and we only want to keep a reference.
+  size_t m_taken; // number of m_vecItems the loader thread has taken
+  std::map<std::string, CFileItemPtr> m_loaded; // entries of a partial listing that are done, by path
   CCriticalSection m_lock;
 
   volatile bool m_bIsLoading;
   volatile bool m_bStop;
+  volatile bool m_bPartial; // more items of the listing are still to come
+  CEvent m_partialEvent;
+  std::unique_ptr<CFileItemList> m_partialItems;
   CThread *m_thread;
 
   IBackgroundLoaderObserver* m_pObserver;
@@ -58,17 +58,25 @@
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "utils/Mime.h"
+#include "utils/ParallelFor.h"
 #include "utils/Random.h"
 #include "events/IEvent.h"
 
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
 
 using namespace XFILE;
 using namespace PLAYLIST;
 using namespace MUSIC_INFO;
 using namespace PVR;
 using namespace EPG;
+using namespace KODI::UTILS;
+
+// minimum number of items handled by one thread when processing lists
+#define FILEITEMLIST_PARALLEL_CHUNK 1024
+// checking folders for stacking accesses the filesystem, split those finer
+#define FILEITEMLIST_STACK_CHUNK    8
 
 CFileItem::CFileItem(const CSong& song)
 {
@@ -2073,12 +2081,15 @@ void CFileItemList::Sort(SortDescription sortDescription)
 
   const Fields fields = SortUtils::GetFieldsForSorting(sortDescription.sortBy);
   SortItems sortItems((size_t)Size());
-  for (int index = 0; index < Size(); index++)
+  ParallelFor(sortItems.size(), FILEITEMLIST_PARALLEL_CHUNK, [&](size_t begin, size_t end)
   {
-    sortItems[index] = std::shared_ptr<SortItem>(new SortItem);
-    m_items[index]->ToSortable(*sortItems[index], fields);
-    (*sortItems[index])[FieldId] = index;
-  }
+    for (size_t index = begin; index < end; index++)
+    {
+      sortItems[index] = std::shared_ptr<SortItem>(new SortItem);
+      m_items[index]->ToSortable(*sortItems[index], fields);
+      (*sortItems[index])[FieldId] = (int)index;
+    }
+  });
 
   // do the sorting
   SortUtils::Sort(sortDescription, sortItems);
@@ -2295,6 +2306,21 @@ int CFileItemList::GetSelectedCount() const
 void CFileItemList::FilterCueItems()
 {
   CSingleLock lock(m_lock);
+
+  // read all cue sheets up front, they are applied in list order below
+  std::vector<CCueDocumentPtr> cuesheets(m_items.size());
+  ParallelFor(m_items.size(), FILEITEMLIST_STACK_CHUNK, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      if (m_items[i]->m_bIsFolder || !m_items[i]->IsCUESheet())
+        continue;
+      CCueDocumentPtr cuesheet(new CCueDocument);
+      if (cuesheet->ParseFile(m_items[i]->GetPath()))
+        cuesheets[i] = cuesheet;
+    }
+  });
+
   // Handle .CUE sheet files...
   std::vector<std::string> itemstodelete;
   for (int i = 0; i < (int)m_items.size(); i++)
@@ -2304,8 +2330,8 @@ void CFileItemList::FilterCueItems()
     { // see if it's a .CUE sheet
       if (pItem->IsCUESheet())
       {
-        CCueDocumentPtr cuesheet(new CCueDocument);
-        if (cuesheet->ParseFile(pItem->GetPath()))
+        CCueDocumentPtr cuesheet = cuesheets[i];
+        if (cuesheet)
         {
           std::vector<std::string> MediaFileVec;
           cuesheet->GetMediaFiles(MediaFileVec);
@@ -2436,77 +2462,123 @@ void CFileItemList::StackFolders()
     return;
   }
 
-  // stack folders
-  for (int i = 0; i < Size(); i++)
+  // stack folders, every item only depends on itself so they are checked in parallel
+  std::atomic<bool> sortBroken(false);
+  ParallelFor(m_items.size(), FILEITEMLIST_STACK_CHUNK, [&](size_t begin, size_t end)
   {
-    CFileItemPtr item = Get(i);
-    // combined the folder checks
-    if (item->m_bIsFolder)
+    // matching changes the state of an expression, every thread needs its own
+    VECCREGEXP regExps(folderRegExps);
+    for (size_t i = begin; i < end; i++)
     {
-      // only check known fast sources?
-      // NOTES:
-      // 1. rars and zips may be on slow sources? is this supposed to be allowed?
-      if( !item->IsRemote()
-        || item->IsSmb()
-        || item->IsNfs()
-        || URIUtils::IsInRAR(item->GetPath())
-        || URIUtils::IsInZIP(item->GetPath())
-        || URIUtils::IsOnLAN(item->GetPath())
-        )
+      CFileItemPtr item = m_items[i];
+      // combined the folder checks
+      if (item->m_bIsFolder)
       {
-        // stack cd# folders if contains only a single video file
+        // only check known fast sources?
+        // NOTES:
+        // 1. rars and zips may be on slow sources? is this supposed to be allowed?
+        if( !item->IsRemote()
+          || item->IsSmb()
+          || item->IsNfs()
+          || URIUtils::IsInRAR(item->GetPath())
+          || URIUtils::IsInZIP(item->GetPath())
+          || URIUtils::IsOnLAN(item->GetPath())
+          )
+        {
+          // stack cd# folders if contains only a single video file
 
-        bool bMatch(false);
+          bool bMatch(false);
 
-        VECCREGEXP::iterator expr = folderRegExps.begin();
-        while (!bMatch && expr != folderRegExps.end())
-        {
-          //CLog::Log(LOGDEBUG,"%s: Running expression %s on %s", __FUNCTION__, expr->GetPattern().c_str(), item->GetLabel().c_str());
-          bMatch = (expr->RegFind(item->GetLabel().c_str()) != -1);
-          if (bMatch)
+          VECCREGEXP::iterator expr = regExps.begin();
+          while (!bMatch && expr != regExps.end())
           {
-            CFileItemList items;
-            CDirectory::GetDirectory(item->GetPath(),items,g_advancedSettings.m_videoExtensions);
-            // optimized to only traverse listing once by checking for filecount
-            // and recording last file item for later use
-            int nFiles = 0;
-            int index = -1;
-            for (int j = 0; j < items.Size(); j++)
+            //CLog::Log(LOGDEBUG,"%s: Running expression %s on %s", __FUNCTION__, expr->GetPattern().c_str(), item->GetLabel().c_str());
+            bMatch = (expr->RegFind(item->GetLabel().c_str()) != -1);
+            if (bMatch)
             {
-              if (!items[j]->m_bIsFolder)
+              CFileItemList items;
+              CDirectory::GetDirectory(item->GetPath(),items,g_advancedSettings.m_videoExtensions);
+              // optimized to only traverse listing once by checking for filecount
+              // and recording last file item for later use
+              int nFiles = 0;
+              int index = -1;
+              for (int j = 0; j < items.Size(); j++)
               {
-                nFiles++;
-                index = j;
+                if (!items[j]->m_bIsFolder)
+                {
+                  nFiles++;
+                  index = j;
+                }
+
+                if (nFiles > 1)
+                  break;
               }
 
-              if (nFiles > 1)
-                break;
+              if (nFiles == 1)
+                *item = *items[index];
             }
-
-            if (nFiles == 1)
-              *item = *items[index];
+            expr++;
           }
-          expr++;
-        }
-
-        // check for dvd folders
-        if (!bMatch)
-        {
-          std::string dvdPath = item->GetOpticalMediaPath();
 
-          if (!dvdPath.empty())
+          // check for dvd folders
+          if (!bMatch)
           {
-            // NOTE: should this be done for the CD# folders too?
-            item->m_bIsFolder = false;
-            item->SetPath(dvdPath);
-            item->SetLabel2("");
-            item->SetLabelPreformated(true);
-            m_sortDescription.sortBy = SortByNone; /* sorting is now broken */
+            std::string dvdPath = item->GetOpticalMediaPath();
+
+            if (!dvdPath.empty())
+            {
+              // NOTE: should this be done for the CD# folders too?
+              item->m_bIsFolder = false;
+              item->SetPath(dvdPath);
+              item->SetLabel2("");
+              item->SetLabelPreformated(true);
+              sortBroken = true;
+            }
           }
         }
       }
     }
-  }
+  });
+
+  if (sortBroken)
+    m_sortDescription.sortBy = SortByNone; /* sorting is now broken */
+}
+
+namespace
+{
+// captures of a video stack expression for one file name
+struct StackMatch
+{
+  bool matched = false;
+  std::string title;
+  std::string volume;
+  std::string ignore;
+  std::string extension;
+  int volumeStart = 0;
+  int ignoreStart = 0;
+};
+
+// a file taking part in stacking with its matches at offset 0
+struct StackCandidate
+{
+  bool skip = true;
+  std::string file;
+  std::vector<StackMatch> matches;
+};
+
+void MatchStackExpression(CRegExp &expr, const std::string &file, size_t offset, StackMatch &match)
+{
+  match.matched = expr.RegFind(file, offset) != -1;
+  if (!match.matched)
+    return;
+
+  match.title = expr.GetMatch(1);
+  match.volume = expr.GetMatch(2);
+  match.ignore = expr.GetMatch(3);
+  match.extension = expr.GetMatch(4);
+  match.volumeStart = expr.GetSubStart(2);
+  match.ignoreStart = expr.GetSubStart(3);
+}
 }
 
 void CFileItemList::StackFiles()
@@ -2528,18 +2600,54 @@ void CFileItemList::StackFiles()
     strRegExp++;
   }
 
+  // the file names and their matches at offset 0 don't change while stacking,
+  // work them out for all items in parallel
+  std::vector<StackCandidate> candidates(m_items.size());
+  ParallelFor(m_items.size(), FILEITEMLIST_PARALLEL_CHUNK / 8, [&](size_t begin, size_t end)
+  {
+    // matching changes the state of an expression, every thread needs its own
+    VECCREGEXP regExps(stackRegExps);
+    for (size_t i = begin; i < end; i++)
+    {
+      const CFileItemPtr &item = m_items[i];
+      StackCandidate &candidate = candidates[i];
+
+      // skip folders, nfo files, playlists
+      candidate.skip = item->m_bIsFolder
+                    || item->IsParentFolder()
+                    || item->IsNFO()
+                    || item->IsPlayList();
+      if (candidate.skip)
+        continue;
+
+      std::string filePath;
+      URIUtils::Split(item->GetPath(), filePath, candidate.file);
+      if (URIUtils::HasEncodedFilename(CURL(filePath)))
+        candidate.file = CURL::Decode(candidate.file);
+
+      candidate.matches.resize(regExps.size());
+      for (size_t e = 0; e < regExps.size(); e++)
+        MatchStackExpression(regExps[e], candidate.file, 0, candidate.matches[e]);
+    }
+  });
+
+  // retries after a false positive match at a later offset
+  StackMatch retry1, retry2;
+  auto match = [&](size_t item, size_t expr, size_t offset, StackMatch &retry) -> const StackMatch&
+  {
+    if (offset == 0)
+      return candidates[item].matches[expr];
+    MatchStackExpression(stackRegExps[expr], candidates[item].file, offset, retry);
+    return retry;
+  };
+
   // now stack the files, some of which may be from the previous stack iteration
   int i = 0;
   while (i < Size())
   {
     CFileItemPtr item1 = Get(i);
 
-    // skip folders, nfo files, playlists
-    if (item1->m_bIsFolder
-      || item1->IsParentFolder()
-      || item1->IsNFO()
-      || item1->IsPlayList()
-      )
+    if (candidates[i].skip)
     {
       // increment index
       i++;
@@ -2549,56 +2657,45 @@ void CFileItemList::StackFiles()
     int64_t               size        = 0;
     size_t                offset      = 0;
     std::string           stackName;
-    std::string           file1;
-    std::string           filePath;
+    const std::string    &file1       = candidates[i].file;
     std::vector<int>      stack;
-    VECCREGEXP::iterator  expr        = stackRegExps.begin();
-
-    URIUtils::Split(item1->GetPath(), filePath, file1);
-    if (URIUtils::HasEncodedFilename(CURL(filePath)))
-      file1 = CURL::Decode(file1);
+    size_t                expr        = 0;
 
     int j;
-    while (expr != stackRegExps.end())
+    while (expr < stackRegExps.size())
     {
-      if (expr->RegFind(file1, offset) != -1)
+      const StackMatch &match1 = match(i, expr, offset, retry1);
+      if (match1.matched)
       {
-        std::string Title1      = expr->GetMatch(1),
-                    Volume1     = expr->GetMatch(2),
-                    Ignore1     = expr->GetMatch(3),
-                    Extension1  = expr->GetMatch(4);
+        std::string Title1      = match1.title;
+        const std::string &Volume1     = match1.volume,
+                          &Ignore1     = match1.ignore,
+                          &Extension1  = match1.extension;
         if (offset)
-          Title1 = file1.substr(0, expr->GetSubStart(2));
+          Title1 = file1.substr(0, match1.volumeStart);
         j = i + 1;
         while (j < Size())
         {
           CFileItemPtr item2 = Get(j);
 
-          // skip folders, nfo files, playlists
-          if (item2->m_bIsFolder
-            || item2->IsParentFolder()
-            || item2->IsNFO()
-            || item2->IsPlayList()
-            )
+          if (candidates[j].skip)
           {
             // increment index
             j++;
             continue;
           }
 
-          std::string file2, filePath2;
-          URIUtils::Split(item2->GetPath(), filePath2, file2);
-          if (URIUtils::HasEncodedFilename(CURL(filePath2)) )
-            file2 = CURL::Decode(file2);
+          const std::string &file2 = candidates[j].file;
 
-          if (expr->RegFind(file2, offset) != -1)
+          const StackMatch &match2 = match(j, expr, offset, retry2);
+          if (match2.matched)
           {
-            std::string  Title2      = expr->GetMatch(1),
-                        Volume2     = expr->GetMatch(2),
-                        Ignore2     = expr->GetMatch(3),
-                        Extension2  = expr->GetMatch(4);
+            std::string Title2      = match2.title;
+            const std::string &Volume2     = match2.volume,
+                              &Ignore2     = match2.ignore,
+                              &Extension2  = match2.extension;
             if (offset)
-              Title2 = file2.substr(0, expr->GetSubStart(2));
+              Title2 = file2.substr(0, match2.volumeStart);
             if (StringUtils::EqualsNoCase(Title1, Title2))
             {
               if (!StringUtils::EqualsNoCase(Volume1, Volume2))
@@ -2624,7 +2721,7 @@ void CFileItemList::StackFiles()
               }
               else if (!StringUtils::EqualsNoCase(Ignore1, Ignore2)) // False positive, try again with offset
               {
-                offset = expr->GetSubStart(3);
+                offset = match2.ignoreStart;
                 break;
               }
               else // Extension mismatch
@@ -2650,7 +2747,7 @@ void CFileItemList::StackFiles()
           j++;
         }
         if (j == Size())
-          expr = stackRegExps.end();
+          expr = stackRegExps.size();
       }
       else // No match 1
       {
@@ -2672,7 +2769,10 @@ void CFileItemList::StackFiles()
         item1->SetPath(stackPath);
         // clean up list
         for (unsigned k = 1; k < stack.size(); k++)
+        {
           Remove(i+1);
+          candidates.erase(candidates.begin() + i + 1);
+        }
         // item->m_bIsFolder = true;  // don't treat stacked files as folders
         // the label may be in a different char set from the filename (eg over smb
         // the label is converted from utf8, but the filename is not)
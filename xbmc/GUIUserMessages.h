@@ -142,3 +142,6 @@
 
 // Send to RDS Radiotext handlers to inform about changed data
 #define GUI_MSG_UPDATE_RADIOTEXT      GUI_MSG_USER + 41
+
+// Sent to media windows when entries of a directory that is still being listed arrived
+#define GUI_MSG_PARTIAL_LISTING       GUI_MSG_USER + 42
@@ -56,6 +56,7 @@ void CTextureCache::Initialize()
 void CTextureCache::Deinitialize()
 {
   CancelJobs();
+  m_pipeline.Stop();
   CSingleLock lock(m_databaseSection);
   m_database.Close();
 }
@@ -130,6 +131,41 @@ void CTextureCache::BackgroundCacheImage(const std::string &url)
   AddJob(new CTextureCacheJob(path, details.hash));
 }
 
+unsigned int CTextureCache::CacheImages(const std::vector<std::string> &images)
+{
+  unsigned int queued = 0;
+  for (std::vector<std::string>::const_iterator it = images.begin(); it != images.end(); ++it)
+  {
+    if (it->empty())
+      continue;
+
+    CTextureDetails details;
+    std::string path(GetCachedImage(*it, details));
+    if (!path.empty() && details.hash.empty())
+      continue; // image is already cached and doesn't need to be checked further
+
+    path = CTextureUtils::UnwrapImageURL(*it);
+    if (path.empty())
+      continue;
+
+    { // skip images currently being cached
+      CSingleLock lock(m_processingSection);
+      if (!m_processinglist.insert(path).second)
+        continue;
+    }
+
+    m_pipeline.Add(new CTextureCacheJob(path, details.hash));
+    queued++;
+  }
+
+  return queued;
+}
+
+void CTextureCache::GetPipelineStatistics(TextureCachePipelineStatistics &statistics)
+{
+  m_pipeline.GetStatistics(statistics);
+}
+
 std::string CTextureCache::CacheImage(const std::string &image, CBaseTexture **texture /* = NULL */, CTextureDetails *details /* = NULL */)
 {
   std::string url = CTextureUtils::UnwrapImageURL(image);
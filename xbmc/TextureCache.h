@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include "utils/JobManager.h"
+#include "TextureCachePipeline.h"
 #include "TextureDatabase.h"
 #include "threads/Event.h"
 
@@ -80,6 +81,22 @@ public:
    */
   void BackgroundCacheImage(const std::string &image);
 
+  /*! \brief Cache a list of images (if required) in the background
+
+   Images which are neither cached already nor being cached are passed to
+   the decode, resize and encode stages of the caching pipeline.
+
+   \param images urls of the images to cache
+   \return number of images queued for (re)caching
+   \sa BackgroundCacheImage, CTextureCachePipeline
+   */
+  unsigned int CacheImages(const std::vector<std::string> &images);
+
+  /*! \brief Retrieve the progress and throughput of the caching pipeline
+   \sa CacheImages
+   */
+  void GetPipelineStatistics(TextureCachePipelineStatistics &statistics);
+
   /*! \brief Cache an image to image cache, optionally return the texture
 
    Caches the given image, returning the texture if the caller wants it.
@@ -156,6 +173,8 @@ public:
   bool Export(const std::string &image, const std::string &destination, bool overwrite);
   bool Export(const std::string &image, const std::string &destination); //! @todo BACKWARD COMPATIBILITY FOR MUSIC THUMBS
 private:
+  friend class CTextureCachePipeline;
+
   // private construction, and no assignements; use the provided singleton methods
   CTextureCache();
   CTextureCache(const CTextureCache&);
@@ -226,5 +245,6 @@ private:
   CEvent               m_completeEvent; ///< Set whenever a job has finished
   std::vector<CTextureDetails> m_useCounts; ///< Use count tracking
   CCriticalSection             m_useCountSection;
+  CTextureCachePipeline        m_pipeline; ///< decode, resize and encode stages used by CacheImages
 };
 
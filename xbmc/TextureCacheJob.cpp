@@ -39,12 +39,20 @@
 CTextureCacheJob::CTextureCacheJob(const std::string &url, const std::string &oldHash):
   m_url(url),
   m_oldHash(oldHash),
-  m_cachePath(CTextureCache::GetCacheFile(m_url))
+  m_cachePath(CTextureCache::GetCacheFile(m_url)),
+  m_width(0),
+  m_height(0),
+  m_scalingAlgorithm(CPictureScalingAlgorithm::NoAlgorithm),
+  m_texture(NULL),
+  m_scaled(NULL),
+  m_complete(false)
 {
 }
 
 CTextureCacheJob::~CTextureCacheJob()
 {
+  delete m_texture;
+  delete[] m_scaled;
 }
 
 bool CTextureCacheJob::operator==(const CJob* job) const
@@ -74,57 +82,107 @@ bool CTextureCacheJob::DoWork()
 }
 
 bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
+{
+  if (!Decode())
+    return false;
+
+#if defined(HAS_OMXPLAYER)
+  if (m_complete && m_texture == NULL && out_texture && !m_details.file.empty())
+  {
+    unsigned int width = m_details.width, height = m_details.height;
+    *out_texture = LoadImage(CTextureCache::GetCachedPath(m_details.file), width, height, "" /* already flipped */);
+  }
+#endif
+
+  if (!Scale() || !Encode())
+    return false;
+
+  if (out_texture && m_texture) // caller wants the texture
+  {
+    *out_texture = m_texture;
+    m_texture = NULL;
+  }
+  return true;
+}
+
+bool CTextureCacheJob::Decode()
 {
   // unwrap the URL as required
   std::string additional_info;
-  unsigned int width, height;
-  CPictureScalingAlgorithm::Algorithm scalingAlgorithm;
-  std::string image = DecodeImageURL(m_url, width, height, scalingAlgorithm, additional_info);
+  m_image = DecodeImageURL(m_url, m_width, m_height, m_scalingAlgorithm, additional_info);
 
-  m_details.updateable = additional_info != "music" && UpdateableURL(image);
+  m_details.updateable = additional_info != "music" && UpdateableURL(m_image);
 
   // generate the hash
-  m_details.hash = GetImageHash(image);
+  m_details.hash = GetImageHash(m_image);
   if (m_details.hash.empty())
     return false;
   else if (m_details.hash == m_oldHash)
+  {
+    m_complete = true;
     return true;
+  }
 
 #if defined(HAS_OMXPLAYER)
-  if (COMXImage::CreateThumb(image, width, height, additional_info, CTextureCache::GetCachedPath(m_cachePath + ".jpg")))
+  if (COMXImage::CreateThumb(m_image, m_width, m_height, additional_info, CTextureCache::GetCachedPath(m_cachePath + ".jpg")))
   {
-    m_details.width = width;
-    m_details.height = height;
+    m_details.width = m_width;
+    m_details.height = m_height;
     m_details.file = m_cachePath + ".jpg";
-    if (out_texture)
-      *out_texture = LoadImage(CTextureCache::GetCachedPath(m_details.file), width, height, "" /* already flipped */);
-    CLog::Log(LOGDEBUG, "Fast %s image '%s' to '%s': %p", m_oldHash.empty() ? "Caching" : "Recaching", CURL::GetRedacted(image).c_str(), m_details.file.c_str(), out_texture);
+    CLog::Log(LOGDEBUG, "Fast %s image '%s' to '%s'", m_oldHash.empty() ? "Caching" : "Recaching", CURL::GetRedacted(m_image).c_str(), m_details.file.c_str());
+    m_complete = true;
     return true;
   }
 #endif
-  CBaseTexture *texture = LoadImage(image, width, height, additional_info, true);
-  if (texture)
-  {
-    if (texture->HasAlpha())
-      m_details.file = m_cachePath + ".png";
-    else
-      m_details.file = m_cachePath + ".jpg";
 
-    CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.empty() ? "Caching" : "Recaching", CURL::GetRedacted(image).c_str(), m_details.file.c_str());
+  m_texture = LoadImage(m_image, m_width, m_height, additional_info, true);
+  if (m_texture == NULL)
+    return false;
 
-    if (CPicture::CacheTexture(texture, width, height, CTextureCache::GetCachedPath(m_details.file), scalingAlgorithm))
-    {
-      m_details.width = width;
-      m_details.height = height;
-      if (out_texture) // caller wants the texture
-        *out_texture = texture;
-      else
-        delete texture;
-      return true;
-    }
+  if (m_texture->HasAlpha())
+    m_details.file = m_cachePath + ".png";
+  else
+    m_details.file = m_cachePath + ".jpg";
+
+  return true;
+}
+
+bool CTextureCacheJob::Scale(struct SwsContext **scaler /* = NULL */)
+{
+  if (m_complete)
+    return true;
+  if (m_texture == NULL)
+    return false;
+
+  CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.empty() ? "Caching" : "Recaching", CURL::GetRedacted(m_image).c_str(), m_details.file.c_str());
+
+  return CPicture::ScaleTextureForCache(m_texture->GetPixels(), m_texture->GetWidth(), m_texture->GetHeight(), m_texture->GetPitch(),
+                                        m_texture->GetOrientation(), m_width, m_height, m_scaled, m_scalingAlgorithm, scaler);
+}
+
+bool CTextureCacheJob::Encode()
+{
+  if (m_complete)
+    return true;
+
+  bool success = false;
+  std::string cachedPath = CTextureCache::GetCachedPath(m_details.file);
+  if (m_scaled != NULL)
+  {
+    success = CPicture::CreateThumbnailFromSurface((unsigned char*)m_scaled, m_width, m_height, m_width * 4, cachedPath);
+    delete[] m_scaled;
+    m_scaled = NULL;
   }
-  delete texture;
-  return false;
+  else if (m_texture != NULL)
+    success = CPicture::CreateThumbnailFromSurface(m_texture->GetPixels(), m_width, m_height, m_texture->GetPitch(), cachedPath);
+
+  if (!success)
+    return false;
+
+  m_details.width = m_width;
+  m_details.height = m_height;
+  m_complete = true;
+  return true;
 }
 
 bool CTextureCacheJob::ResizeTexture(const std::string &url, uint8_t* &result, size_t &result_size)
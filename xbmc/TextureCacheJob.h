@@ -28,6 +28,7 @@
 #include "utils/Job.h"
 
 class CBaseTexture;
+struct SwsContext;
 
 /*!
  \ingroup textures
@@ -79,6 +80,23 @@ public:
    */
   bool CacheTexture(CBaseTexture **texture = NULL);
 
+  /*! \name Caching stages
+   CacheTexture() split into stages which may run on different threads one after another,
+   see CTextureCachePipeline. Every stage returns false if caching failed.
+   */
+  //@{
+  /*! \brief Load and decode the image unless the cached version is still up to date */
+  bool Decode();
+  /*! \brief Resize, rotate and flip the decoded image to its cached size
+   \param scaler [in/out] scaling context reused between images, see CPicture::ScaleTextureForCache
+   */
+  bool Scale(struct SwsContext **scaler = NULL);
+  /*! \brief Encode the image as JPG or PNG and write it to the cache */
+  bool Encode();
+  /*! \brief Whether there is nothing left to do for the remaining stages */
+  bool IsComplete() const { return m_complete; }
+  //@}
+
   static bool ResizeTexture(const std::string &url, uint8_t* &result, size_t &result_size);
 
   std::string m_url;
@@ -125,6 +143,15 @@ private:
   static CBaseTexture *LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels = false);
 
   std::string    m_cachePath;
+
+  // state passed between the caching stages
+  std::string    m_image;
+  unsigned int   m_width;
+  unsigned int   m_height;
+  CPictureScalingAlgorithm::Algorithm m_scalingAlgorithm;
+  CBaseTexture  *m_texture;
+  uint32_t      *m_scaled;
+  bool           m_complete;
 };
 
 /* \brief Job class for storing the use count of textures
@@ -0,0 +1,266 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+
+#include "TextureCachePipeline.h"
+#include "TextureCache.h"
+#include "TextureCacheJob.h"
+#include "pictures/Picture.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
+#include "utils/log.h"
+
+class CTextureCachePipeline::CWorker : public CThread
+{
+public:
+  CWorker(CTextureCachePipeline &pipeline, Stage stage)
+    : CThread(stage == StageDecode ? "TextureDecode" : (stage == StageScale ? "TextureScale" : "TextureEncode")),
+      m_pipeline(pipeline),
+      m_stage(stage)
+  { }
+
+protected:
+  void Process()
+  {
+    SetPriority(GetMinPriority());
+    m_pipeline.Run(m_stage);
+  }
+
+private:
+  CTextureCachePipeline &m_pipeline;
+  Stage m_stage;
+};
+
+static unsigned int GetThreadCount(unsigned int configured)
+{
+  if (configured > 0)
+    return configured;
+  return std::max(1, g_cpuInfo.getCPUCount() / 2);
+}
+
+CTextureCachePipeline::CTextureCachePipeline()
+  : m_maxQueueSize(1),
+    m_stop(false),
+    m_queued(0),
+    m_cached(0),
+    m_uptodate(0),
+    m_failed(0),
+    m_pending(0),
+    m_batchStart(0),
+    m_batchEnd(0),
+    m_batchCompleted(0)
+{
+  for (int i = 0; i < StageCount; i++)
+    m_stageTime[i] = 0;
+}
+
+CTextureCachePipeline::~CTextureCachePipeline()
+{
+  Stop();
+}
+
+void CTextureCachePipeline::Add(CTextureCacheJob *job)
+{
+  CSingleLock lock(m_critSection);
+  if (m_workers.empty())
+    Start();
+
+  // a new batch starts whenever the pipeline has run dry
+  if (m_pending == 0)
+  {
+    m_batchStart = CurrentHostCounter();
+    m_batchEnd = 0;
+    m_batchCompleted = 0;
+  }
+
+  m_queues[StageDecode].push_back(job);
+  m_queued++;
+  m_pending++;
+  m_queueChanged.notifyAll();
+}
+
+void CTextureCachePipeline::Start()
+{
+  m_stop = false;
+  m_maxQueueSize = g_advancedSettings.m_textureCacheQueueSize;
+
+  unsigned int threads[StageCount] = {
+    GetThreadCount(g_advancedSettings.m_textureCacheDecodeThreads),
+    GetThreadCount(g_advancedSettings.m_textureCacheScaleThreads),
+    GetThreadCount(g_advancedSettings.m_textureCacheEncodeThreads)
+  };
+
+  for (int stage = 0; stage < StageCount; stage++)
+  {
+    for (unsigned int i = 0; i < threads[stage]; i++)
+    {
+      CWorker *worker = new CWorker(*this, static_cast<Stage>(stage));
+      worker->Create();
+      m_workers.push_back(worker);
+    }
+  }
+
+  CLog::Log(LOGDEBUG, "CTextureCachePipeline: started with %u decode, %u scale and %u encode threads",
+            threads[StageDecode], threads[StageScale], threads[StageEncode]);
+}
+
+void CTextureCachePipeline::Stop()
+{
+  std::vector<CWorker*> workers;
+  {
+    CSingleLock lock(m_critSection);
+    m_stop = true;
+    m_queueChanged.notifyAll();
+    workers.swap(m_workers);
+  }
+
+  for (std::vector<CWorker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+  {
+    (*it)->StopThread();
+    delete *it;
+  }
+
+  // cancel whatever didn't make it through the pipeline
+  std::vector<CTextureCacheJob*> cancelled;
+  {
+    CSingleLock lock(m_critSection);
+    for (int stage = 0; stage < StageCount; stage++)
+    {
+      cancelled.insert(cancelled.end(), m_queues[stage].begin(), m_queues[stage].end());
+      m_queues[stage].clear();
+    }
+  }
+
+  for (std::vector<CTextureCacheJob*>::iterator it = cancelled.begin(); it != cancelled.end(); ++it)
+    Complete(*it, false);
+}
+
+void CTextureCachePipeline::Run(Stage stage)
+{
+  struct SwsContext *scaler = NULL;
+
+  CTextureCacheJob *job;
+  while ((job = Pop(stage)) != NULL)
+  {
+    int64_t start = CurrentHostCounter();
+    bool success = false;
+    switch (stage)
+    {
+      case StageDecode:
+        success = job->Decode();
+        break;
+      case StageScale:
+        success = job->Scale(&scaler);
+        break;
+      default:
+        success = job->Encode();
+        break;
+    }
+
+    {
+      CSingleLock lock(m_critSection);
+      m_stageTime[stage] += CurrentHostCounter() - start;
+    }
+
+    if (!success || job->IsComplete())
+      Complete(job, success);
+    else if (!Push(static_cast<Stage>(stage + 1), job))
+      Complete(job, false);
+  }
+
+  CPicture::FreeScaler(scaler);
+}
+
+CTextureCacheJob* CTextureCachePipeline::Pop(Stage stage)
+{
+  CSingleLock lock(m_critSection);
+  while (!m_stop && m_queues[stage].empty())
+    m_queueChanged.wait(lock);
+
+  if (m_stop)
+    return NULL;
+
+  CTextureCacheJob *job = m_queues[stage].front();
+  m_queues[stage].pop_front();
+  m_queueChanged.notifyAll();
+  return job;
+}
+
+bool CTextureCachePipeline::Push(Stage stage, CTextureCacheJob *job)
+{
+  CSingleLock lock(m_critSection);
+  while (!m_stop && m_queues[stage].size() >= m_maxQueueSize)
+    m_queueChanged.wait(lock);
+
+  if (m_stop)
+    return false;
+
+  m_queues[stage].push_back(job);
+  m_queueChanged.notifyAll();
+  return true;
+}
+
+void CTextureCachePipeline::Complete(CTextureCacheJob *job, bool success)
+{
+  bool uptodate = success && job->m_oldHash == job->m_details.hash;
+  CTextureCache::GetInstance().OnCachingComplete(success, job);
+  delete job;
+
+  CSingleLock lock(m_critSection);
+  if (!success)
+    m_failed++;
+  else if (uptodate)
+    m_uptodate++;
+  else
+    m_cached++;
+
+  m_batchCompleted++;
+  if (m_pending > 0 && --m_pending == 0)
+    m_batchEnd = CurrentHostCounter();
+}
+
+void CTextureCachePipeline::GetStatistics(TextureCachePipelineStatistics &statistics)
+{
+  CSingleLock lock(m_critSection);
+  double frequency = static_cast<double>(CurrentHostFrequency());
+
+  statistics.queued = m_queued;
+  statistics.cached = m_cached;
+  statistics.uptodate = m_uptodate;
+  statistics.failed = m_failed;
+  statistics.pending = m_pending;
+  for (int stage = 0; stage < StageCount; stage++)
+  {
+    statistics.waiting[stage] = m_queues[stage].size();
+    statistics.stageTime[stage] = m_stageTime[stage] / frequency;
+  }
+
+  statistics.imagesPerSecond = 0.0;
+  if (m_batchStart > 0)
+  {
+    int64_t end = m_batchEnd > 0 ? m_batchEnd : CurrentHostCounter();
+    if (end > m_batchStart)
+      statistics.imagesPerSecond = m_batchCompleted / ((end - m_batchStart) / frequency);
+  }
+}
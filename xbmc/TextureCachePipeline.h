@@ -0,0 +1,108 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
+class CTextureCacheJob;
+
+typedef struct TextureCachePipelineStatistics
+{
+  uint64_t queued;        ///< images added to the pipeline
+  uint64_t cached;        ///< images decoded, resized and written to the cache
+  uint64_t uptodate;      ///< images whose cached version was still up to date
+  uint64_t failed;        ///< images which couldn't be cached
+  unsigned int pending;   ///< images in the pipeline right now
+  unsigned int waiting[3];///< images waiting for decoding, resizing and encoding
+  double stageTime[3];    ///< seconds spent decoding, resizing and encoding
+  double imagesPerSecond; ///< throughput of the current or last batch
+} TextureCachePipelineStatistics;
+
+/*!
+ \ingroup textures
+ \brief Caches large numbers of images in separate decode, resize and encode stages.
+
+ Every stage is run by its own pool of threads so that the I/O bound loading
+ and writing of images overlaps with the CPU bound resizing. Decoded images
+ waiting for the next stage are limited by a bounded queue, only the list of
+ images waiting to be loaded is unbounded.
+ */
+class CTextureCachePipeline
+{
+public:
+  CTextureCachePipeline();
+  ~CTextureCachePipeline();
+
+  /*!
+   \brief Queues a job for caching, starting the worker threads if required
+   The pipeline takes ownership of the job and passes it to
+   CTextureCache::OnCachingComplete once it has been processed.
+   */
+  void Add(CTextureCacheJob *job);
+
+  /*!
+   \brief Stops all worker threads, cancelling any queued jobs
+   */
+  void Stop();
+
+  void GetStatistics(TextureCachePipelineStatistics &statistics);
+
+private:
+  CTextureCachePipeline(const CTextureCachePipeline&);
+  CTextureCachePipeline& operator=(const CTextureCachePipeline&);
+
+  enum Stage
+  {
+    StageDecode = 0,
+    StageScale,
+    StageEncode,
+    StageCount
+  };
+
+  class CWorker;
+
+  void Start();
+  void Run(Stage stage);
+  CTextureCacheJob* Pop(Stage stage);
+  bool Push(Stage stage, CTextureCacheJob *job);
+  void Complete(CTextureCacheJob *job, bool success);
+
+  CCriticalSection m_critSection;
+  XbmcThreads::ConditionVariable m_queueChanged;
+  std::deque<CTextureCacheJob*> m_queues[StageCount]; ///< jobs waiting for each stage
+  std::vector<CWorker*> m_workers;
+  size_t m_maxQueueSize;
+  bool m_stop;
+
+  uint64_t m_queued;
+  uint64_t m_cached;
+  uint64_t m_uptodate;
+  uint64_t m_failed;
+  unsigned int m_pending;
+  int64_t m_stageTime[StageCount];
+  int64_t m_batchStart;
+  int64_t m_batchEnd;
+  uint64_t m_batchCompleted;
+};
@@ -23,9 +23,14 @@
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSPProcess.h"
 #include "cores/AudioEngine/Engines/ActiveAE/ActiveAE.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
 
+extern "C" {
+#include "libavutil/channel_layout.h"
+}
+
 using namespace ActiveAE;
 
 /* typecast AE to CActiveAE */
@@ -179,6 +184,8 @@ CActiveAEBufferPoolResample::CActiveAEBufferPoolResample(AEAudioFormat inputForm
   m_changeResampler = false;
   m_changeDSP = false;
   m_lastSamplePts = 0;
+  m_directConversion = false;
+  m_directIdentity = false;
 }
 
 CActiveAEBufferPoolResample::~CActiveAEBufferPoolResample()
@@ -288,6 +295,7 @@ bool CActiveAEBufferPoolResample::Create(unsigned int totaltime, bool remap, boo
   }
 
   m_changeResampler = false;
+  UpdateDirectConversion();
 
   return true;
 }
@@ -324,6 +332,125 @@ void CActiveAEBufferPoolResample::ChangeResampler()
                                 m_forceResampler);
 
   m_changeResampler = false;
+  UpdateDirectConversion();
+}
+
+void CActiveAEBufferPoolResample::UpdateDirectConversion()
+{
+  m_directConversion = false;
+  m_directIdentity = false;
+  m_directMap.clear();
+
+  // anything but reordering channels and changing the sample format is left to the resampler
+  if (m_useDSP || m_forceResampler ||
+      m_inputFormat.m_sampleRate != m_format.m_sampleRate ||
+      (m_inputFormat.m_dataFormat != AE_FMT_FLOAT && m_inputFormat.m_dataFormat != AE_FMT_FLOATP))
+    return;
+
+  // 24 bit formats need the resampler's post processing
+  if (m_format.m_dataFormat != AE_FMT_FLOAT && m_format.m_dataFormat != AE_FMT_FLOATP &&
+      m_format.m_dataFormat != AE_FMT_S16NE && m_format.m_dataFormat != AE_FMT_S32NE)
+    return;
+
+  unsigned int srcChannels = m_inputFormat.m_channelLayout.Count();
+  unsigned int dstChannels = m_format.m_channelLayout.Count();
+  uint64_t srcLayout = CAEUtil::GetAVChannelLayout(m_inputFormat.m_channelLayout);
+  if (dstChannels == 0 || dstChannels > AE_CH_MAX || srcLayout == 0 ||
+      av_get_channel_layout_nb_channels(srcLayout) != (int)srcChannels)
+    return;
+
+  if (m_remap)
+  {
+    // the same one-to-one mapping the resampler uses as its matrix
+    for (unsigned int out = 0; out < dstChannels; out++)
+      m_directMap.push_back(CAEUtil::GetAVChannelIndex(m_format.m_channelLayout[out], srcLayout));
+  }
+  else if (srcLayout == CAEUtil::GetAVChannelLayout(m_format.m_channelLayout) && srcChannels == dstChannels)
+  {
+    for (unsigned int out = 0; out < dstChannels; out++)
+      m_directMap.push_back(out);
+  }
+  else
+    return;
+
+  m_directIdentity = (srcChannels == dstChannels);
+  for (unsigned int out = 0; out < dstChannels; out++)
+  {
+    if (m_directMap[out] != (int)out)
+      m_directIdentity = false;
+  }
+
+  m_directConversion = true;
+}
+
+int CActiveAEBufferPoolResample::ConvertDirect(CSampleBuffer *in, uint8_t **dst)
+{
+  const CAEKernels &kernels = CAEKernels::Get();
+  const CSoundPacket *src = in->pkt;
+  unsigned int frames = src->nb_samples;
+  unsigned int srcChannels = src->config.channels;
+  unsigned int dstChannels = m_directMap.size();
+  bool srcPlanar = src->planes > 1;
+
+  // planar to planar only moves whole planes
+  if (srcPlanar && m_format.m_dataFormat == AE_FMT_FLOATP)
+  {
+    for (unsigned int ch = 0; ch < dstChannels; ch++)
+    {
+      if (m_directMap[ch] >= 0)
+        memcpy(dst[ch], src->data[m_directMap[ch]], frames * sizeof(float));
+      else
+        memset(dst[ch], 0, frames * sizeof(float));
+    }
+    return frames;
+  }
+
+  // bring the samples into output channel order, interleaved
+  float *target;
+  if (m_format.m_dataFormat == AE_FMT_FLOAT)
+    target = (float*)dst[0];
+  else
+  {
+    m_directBuffer.resize(frames * dstChannels);
+    target = m_directBuffer.data();
+  }
+
+  const float *samples = target;
+  if (srcPlanar)
+  {
+    const float *planes[AE_CH_MAX];
+    for (unsigned int ch = 0; ch < dstChannels; ch++)
+      planes[ch] = m_directMap[ch] >= 0 ? (const float*)src->data[m_directMap[ch]] : NULL;
+    kernels.Interleave(planes, target, dstChannels, frames);
+  }
+  else if (m_directIdentity)
+    samples = (const float*)src->data[0];
+  else
+    kernels.Remap((const float*)src->data[0], srcChannels, target, dstChannels, &m_directMap[0], frames);
+
+  switch (m_format.m_dataFormat)
+  {
+    case AE_FMT_FLOAT:
+      if (samples != target)
+        memcpy(target, samples, frames * dstChannels * sizeof(float));
+      break;
+    case AE_FMT_FLOATP:
+    {
+      float *planes[AE_CH_MAX];
+      for (unsigned int ch = 0; ch < dstChannels; ch++)
+        planes[ch] = (float*)dst[ch];
+      kernels.Deinterleave(samples, planes, dstChannels, frames);
+      break;
+    }
+    case AE_FMT_S16NE:
+      kernels.FloatToS16(samples, (int16_t*)dst[0], frames * dstChannels);
+      break;
+    default:
+      kernels.FloatToS32(samples, (int32_t*)dst[0], frames * dstChannels);
+      break;
+  }
+
+  return frames;
 }
 
 void CActiveAEBufferPoolResample::ChangeAudioDSP()
@@ -466,11 +593,25 @@ bool CActiveAEBufferPoolResample::ResampleBuffers(int64_t timestamp)
         m_planes[i] = m_procSample->pkt->data[i] + start;
       }
 
-      int out_samples = m_resampler->Resample(m_planes,
-                                              m_procSample->pkt->max_nb_samples - m_procSample->pkt->nb_samples,
-                                              in ? in->pkt->data : NULL,
-                                              in ? in->pkt->nb_samples : 0,
-                                              m_resampleRatio);
+      int out_samples;
+      int out_free = m_procSample->pkt->max_nb_samples - m_procSample->pkt->nb_samples;
+      // bypass swresample if it would only convert the samples, unless it still holds some of its own
+      if (m_directConversion && in &&
+          in->pkt->nb_samples <= out_free &&
+          in->pkt->config.channels == (int)m_inputFormat.m_channelLayout.Count() &&
+          m_resampleRatio == 1.0 &&
+          m_resampler->GetBufferedSamples() == 0)
+      {
+        out_samples = ConvertDirect(in, m_planes);
+      }
+      else
+      {
+        out_samples = m_resampler->Resample(m_planes,
+                                            out_free,
+                                            in ? in->pkt->data : NULL,
+                                            in ? in->pkt->nb_samples : 0,
+                                            m_resampleRatio);
+      }
       // in case of error, trigger re-create of resampler
       if (out_samples < 0)
       {
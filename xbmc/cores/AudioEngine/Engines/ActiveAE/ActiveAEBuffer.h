@@ -24,6 +24,7 @@
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSP.h"
 #include <deque>
 #include <memory>
+#include <vector>
 
 extern "C" {
 #include "libavutil/avutil.h"
@@ -116,6 +117,8 @@ public:
 
 protected:
   void ChangeResampler();
+  void UpdateDirectConversion();
+  int ConvertDirect(CSampleBuffer *in, uint8_t **dst);
 
   uint8_t *m_planes[16];
   bool m_empty;
@@ -134,6 +137,12 @@ protected:
   bool m_forceResampler;
   AEQuality m_resampleQuality;
 
+  // sample format conversion and channel remapping without swresample
+  bool m_directConversion;
+  bool m_directIdentity;             ///< input channels are already in output order
+  std::vector<int> m_directMap;      ///< source channel of each output channel, -1 for silence
+  std::vector<float> m_directBuffer; ///< interleaved float samples before integer conversion
+
   // ADSP
   // TODO move away from resample buffers
   void ChangeAudioDSP();
@@ -30,6 +30,7 @@
 CAESinkNULL::CAESinkNULL()
   : CThread("AESinkNull"),
     m_draining(false),
+    m_unthrottled(false),
     m_sink_frameSize(0),
     m_sinkbuffer_size(0),
     m_sinkbuffer_level(0),
@@ -54,6 +55,7 @@ bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
   m_sinkbuffer_size = m_sink_frameSize * format.m_sampleRate / 2;
   m_sinkbuffer_sec_per_byte = 1.0 / (double)(m_sink_frameSize * format.m_sampleRate);
 
+  m_unthrottled = (device == "unthrottled");
   m_draining = false;
   m_wake.Reset();
   m_inited.Reset();
@@ -141,6 +143,9 @@ void CAESinkNULL::Process()
       // drain it
       m_sinkbuffer_level -= read_bytes;
 
+      if (m_unthrottled)
+        continue;
+
       // we MUST drain at the correct audio sample rate
       // or the NULL sink will not work right. So calc
       // an approximate sleep time.
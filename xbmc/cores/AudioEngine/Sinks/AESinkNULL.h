@@ -23,6 +23,12 @@
 #include "threads/Thread.h"
 #include "cores/AudioEngine/Interfaces/AESink.h"
 
+/*!
+ \brief Sink that discards all audio
+ It consumes data at the rate of the audio format unless it is opened with
+ the device "unthrottled" (NULL:unthrottled), which consumes data as fast as
+ the engine delivers it, e.g. for benchmarking the engine.
+ */
 class CAESinkNULL : public CThread, public IAESink
 {
 public:
@@ -46,6 +52,7 @@ private:
   CEvent               m_wake;
   CEvent               m_inited;
   volatile bool        m_draining;
+  bool                 m_unthrottled;
   AEAudioFormat        m_format;
   unsigned int         m_sink_frameSize;
   unsigned int         m_sinkbuffer_size;  ///< total size of the buffer
@@ -0,0 +1,705 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEKernels.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <math.h>
+#include <string.h>
+
+// the vector implementations are built with target attributes so that they
+// don't depend on the flags the rest of the engine is compiled with
+#if defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define AE_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+#endif
+
+// ARMv7 NEON flushes denormals to zero and has neither division nor rounding
+// conversions, so only 64 bit ARM can give the same results as the scalar code
+#if defined(__aarch64__)
+#define AE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// a fused multiply-add rounds differently than a multiplication followed by
+// an addition, don't let the compiler contract the scalar code
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AE_TARGET(x) __attribute__((target(x)))
+#else
+#define AE_TARGET(x)
+#endif
+
+/*
+ * Scalar helpers, also used for the remainders of the vector implementations.
+ * Minimum and maximum follow the semantics of the SSE instructions, the
+ * second operand is returned if either one is NaN.
+ */
+static inline float MaxF(float a, float b)
+{
+  return a > b ? a : b;
+}
+
+static inline float MinF(float a, float b)
+{
+  return a < b ? a : b;
+}
+
+static inline float SoftClamp(float x)
+{
+  if (x < -3.0f)
+    return -1.0f;
+  else if (x > 3.0f)
+    return 1.0f;
+  float y = x * x;
+  return x * (27.0f + y) / (27.0f + 9.0f * y);
+}
+
+static inline int16_t ToS16(float x)
+{
+  return (int16_t)lrintf(MinF(MaxF(x * 32768.0f, -32768.0f), 32767.0f));
+}
+
+// 2147483520 is the largest float below 2^31
+static inline int32_t ToS32(float x)
+{
+  return (int32_t)lrintf(MinF(MaxF(x * 2147483648.0f, -2147483648.0f), 2147483520.0f));
+}
+
+//-----------------------------------------------------------------------------
+// scalar
+//-----------------------------------------------------------------------------
+
+static void GainScalar(float *data, float gain, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    data[i] *= gain;
+}
+
+static void MixGainScalar(float *dst, const float *src, float gain, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    dst[i] += src[i] * gain;
+}
+
+static float PeakScalar(const float *data, unsigned int count)
+{
+  float peak = 0.0f;
+  for (unsigned int i = 0; i < count; i++)
+    peak = MaxF(fabsf(data[i]), peak);
+  return peak;
+}
+
+static void ClampScalar(float *data, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    data[i] = SoftClamp(data[i]);
+}
+
+static void InterleaveScalar(const float * const *src, float *dst, unsigned int channels, unsigned int frames)
+{
+  for (unsigned int ch = 0; ch < channels; ch++)
+  {
+    const float *in = src[ch];
+    float *out = dst + ch;
+    if (in)
+    {
+      for (unsigned int i = 0; i < frames; i++, out += channels)
+        *out = in[i];
+    }
+    else
+    {
+      for (unsigned int i = 0; i < frames; i++, out += channels)
+        *out = 0.0f;
+    }
+  }
+}
+
+static void DeinterleaveScalar(const float *src, float * const *dst, unsigned int channels, unsigned int frames)
+{
+  for (unsigned int ch = 0; ch < channels; ch++)
+  {
+    const float *in = src + ch;
+    float *out = dst[ch];
+    for (unsigned int i = 0; i < frames; i++, in += channels)
+      out[i] = *in;
+  }
+}
+
+static void RemapScalar(const float *src, unsigned int srcChannels, float *dst, unsigned int dstChannels, const int *map, unsigned int frames)
+{
+  for (unsigned int i = 0; i < frames; i++, src += srcChannels, dst += dstChannels)
+  {
+    for (unsigned int ch = 0; ch < dstChannels; ch++)
+      dst[ch] = map[ch] >= 0 ? src[map[ch]] : 0.0f;
+  }
+}
+
+static void FloatToS16Scalar(const float *src, int16_t *dst, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    dst[i] = ToS16(src[i]);
+}
+
+static void FloatToS32Scalar(const float *src, int32_t *dst, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    dst[i] = ToS32(src[i]);
+}
+
+#if defined(AE_KERNELS_X86)
+//-----------------------------------------------------------------------------
+// SSE2
+//-----------------------------------------------------------------------------
+
+AE_TARGET("sse2") static void GainSSE2(float *data, float gain, unsigned int count)
+{
+  const __m128 g = _mm_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+  GainScalar(data + i, gain, count - i);
+}
+
+AE_TARGET("sse2") static void MixGainSSE2(float *dst, const float *src, float gain, unsigned int count)
+{
+  const __m128 g = _mm_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+  MixGainScalar(dst + i, src + i, gain, count - i);
+}
+
+AE_TARGET("sse2") static float PeakSSE2(const float *data, unsigned int count)
+{
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 peak = _mm_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = _mm_max_ps(_mm_andnot_ps(sign, _mm_loadu_ps(data + i)), peak);
+
+  float lanes[4];
+  _mm_storeu_ps(lanes, peak);
+  float result = MaxF(MaxF(lanes[0], lanes[1]), MaxF(lanes[2], lanes[3]));
+  return MaxF(PeakScalar(data + i, count - i), result);
+}
+
+AE_TARGET("sse2") static void ClampSSE2(float *data, unsigned int count)
+{
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 three = _mm_set1_ps(3.0f);
+  const __m128 c9 = _mm_set1_ps(9.0f);
+  const __m128 c27 = _mm_set1_ps(27.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(data + i);
+    __m128 y = _mm_mul_ps(x, x);
+    __m128 r = _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c27, y)), _mm_add_ps(c27, _mm_mul_ps(c9, y)));
+    __m128 over = _mm_cmpgt_ps(_mm_andnot_ps(sign, x), three);
+    __m128 limit = _mm_or_ps(_mm_and_ps(x, sign), one);
+    _mm_storeu_ps(data + i, _mm_or_ps(_mm_and_ps(over, limit), _mm_andnot_ps(over, r)));
+  }
+  ClampScalar(data + i, count - i);
+}
+
+AE_TARGET("sse2") static void InterleaveSSE2(const float * const *src, float *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2 || !src[0] || !src[1])
+  {
+    InterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 4 <= frames; i += 4)
+  {
+    __m128 l = _mm_loadu_ps(src[0] + i);
+    __m128 r = _mm_loadu_ps(src[1] + i);
+    _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+  }
+  const float *rest[2] = { src[0] + i, src[1] + i };
+  InterleaveScalar(rest, dst + 2 * i, 2, frames - i);
+}
+
+AE_TARGET("sse2") static void DeinterleaveSSE2(const float *src, float * const *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2)
+  {
+    DeinterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 4 <= frames; i += 4)
+  {
+    __m128 a = _mm_loadu_ps(src + 2 * i);
+    __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+    _mm_storeu_ps(dst[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(dst[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  float *rest[2] = { dst[0] + i, dst[1] + i };
+  DeinterleaveScalar(src + 2 * i, rest, 2, frames - i);
+}
+
+AE_TARGET("sse2") static void FloatToS16SSE2(const float *src, int16_t *dst, unsigned int count)
+{
+  const __m128 scale = _mm_set1_ps(32768.0f);
+  const __m128 lo = _mm_set1_ps(-32768.0f);
+  const __m128 hi = _mm_set1_ps(32767.0f);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo), hi);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+  FloatToS16Scalar(src + i, dst + i, count - i);
+}
+
+AE_TARGET("sse2") static void FloatToS32SSE2(const float *src, int32_t *dst, unsigned int count)
+{
+  const __m128 scale = _mm_set1_ps(2147483648.0f);
+  const __m128 lo = _mm_set1_ps(-2147483648.0f);
+  const __m128 hi = _mm_set1_ps(2147483520.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_cvtps_epi32(a));
+  }
+  FloatToS32Scalar(src + i, dst + i, count - i);
+}
+
+//-----------------------------------------------------------------------------
+// AVX2
+//-----------------------------------------------------------------------------
+
+AE_TARGET("avx2") static void GainAVX2(float *data, float gain, unsigned int count)
+{
+  const __m256 g = _mm256_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), g));
+  GainScalar(data + i, gain, count - i);
+}
+
+AE_TARGET("avx2") static void MixGainAVX2(float *dst, const float *src, float gain, unsigned int count)
+{
+  const __m256 g = _mm256_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+  MixGainScalar(dst + i, src + i, gain, count - i);
+}
+
+AE_TARGET("avx2") static float PeakAVX2(const float *data, unsigned int count)
+{
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 peak = _mm256_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+    peak = _mm256_max_ps(_mm256_andnot_ps(sign, _mm256_loadu_ps(data + i)), peak);
+
+  float lanes[8];
+  _mm256_storeu_ps(lanes, peak);
+  float result = 0.0f;
+  for (int lane = 0; lane < 8; lane++)
+    result = MaxF(lanes[lane], result);
+  return MaxF(PeakScalar(data + i, count - i), result);
+}
+
+AE_TARGET("avx2") static void ClampAVX2(float *data, unsigned int count)
+{
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 three = _mm256_set1_ps(3.0f);
+  const __m256 c9 = _mm256_set1_ps(9.0f);
+  const __m256 c27 = _mm256_set1_ps(27.0f);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(data + i);
+    __m256 y = _mm256_mul_ps(x, x);
+    __m256 r = _mm256_div_ps(_mm256_mul_ps(x, _mm256_add_ps(c27, y)), _mm256_add_ps(c27, _mm256_mul_ps(c9, y)));
+    __m256 over = _mm256_cmp_ps(_mm256_andnot_ps(sign, x), three, _CMP_GT_OQ);
+    __m256 limit = _mm256_or_ps(_mm256_and_ps(x, sign), one);
+    _mm256_storeu_ps(data + i, _mm256_blendv_ps(r, limit, over));
+  }
+  ClampScalar(data + i, count - i);
+}
+
+AE_TARGET("avx2") static void InterleaveAVX2(const float * const *src, float *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2 || !src[0] || !src[1])
+  {
+    InterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 8 <= frames; i += 8)
+  {
+    __m256 l = _mm256_loadu_ps(src[0] + i);
+    __m256 r = _mm256_loadu_ps(src[1] + i);
+    // unpack works on 128 bit lanes: lo = frames 0,1,4,5 hi = frames 2,3,6,7
+    __m256 lo = _mm256_unpacklo_ps(l, r);
+    __m256 hi = _mm256_unpackhi_ps(l, r);
+    _mm256_storeu_ps(dst + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(dst + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  const float *rest[2] = { src[0] + i, src[1] + i };
+  InterleaveScalar(rest, dst + 2 * i, 2, frames - i);
+}
+
+AE_TARGET("avx2") static void DeinterleaveAVX2(const float *src, float * const *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2)
+  {
+    DeinterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 8 <= frames; i += 8)
+  {
+    __m256 a = _mm256_loadu_ps(src + 2 * i);
+    __m256 b = _mm256_loadu_ps(src + 2 * i + 8);
+    // frames 0,1,4,5 and 2,3,6,7 so that the shuffles below produce ordered planes
+    __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+    __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+    _mm256_storeu_ps(dst[0] + i, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm256_storeu_ps(dst[1] + i, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  float *rest[2] = { dst[0] + i, dst[1] + i };
+  DeinterleaveScalar(src + 2 * i, rest, 2, frames - i);
+}
+
+AE_TARGET("avx2") static void FloatToS16AVX2(const float *src, int16_t *dst, unsigned int count)
+{
+  const __m256 scale = _mm256_set1_ps(32768.0f);
+  const __m256 lo = _mm256_set1_ps(-32768.0f);
+  const __m256 hi = _mm256_set1_ps(32767.0f);
+  unsigned int i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), lo), hi);
+    __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), lo), hi);
+    // packs works on 128 bit lanes, restore the order of the samples
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  FloatToS16Scalar(src + i, dst + i, count - i);
+}
+
+AE_TARGET("avx2") static void FloatToS32AVX2(const float *src, int32_t *dst, unsigned int count)
+{
+  const __m256 scale = _mm256_set1_ps(2147483648.0f);
+  const __m256 lo = _mm256_set1_ps(-2147483648.0f);
+  const __m256 hi = _mm256_set1_ps(2147483520.0f);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), lo), hi);
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_cvtps_epi32(a));
+  }
+  FloatToS32Scalar(src + i, dst + i, count - i);
+}
+
+static bool HasAVX2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  // the OS has to save the ymm registers on context switches
+  __cpuid(info, 1);
+  if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if defined(AE_KERNELS_NEON)
+//-----------------------------------------------------------------------------
+// NEON
+//-----------------------------------------------------------------------------
+
+static void GainNEON(float *data, float gain, unsigned int count)
+{
+  const float32x4_t g = vdupq_n_f32(gain);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmulq_f32(vld1q_f32(data + i), g));
+  GainScalar(data + i, gain, count - i);
+}
+
+static void MixGainNEON(float *dst, const float *src, float gain, unsigned int count)
+{
+  const float32x4_t g = vdupq_n_f32(gain);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), g)));
+  MixGainScalar(dst + i, src + i, gain, count - i);
+}
+
+static float PeakNEON(const float *data, unsigned int count)
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t a = vabsq_f32(vld1q_f32(data + i));
+    peak = vbslq_f32(vcgtq_f32(a, peak), a, peak);
+  }
+
+  float lanes[4];
+  vst1q_f32(lanes, peak);
+  float result = MaxF(MaxF(lanes[0], lanes[1]), MaxF(lanes[2], lanes[3]));
+  return MaxF(PeakScalar(data + i, count - i), result);
+}
+
+static void ClampNEON(float *data, unsigned int count)
+{
+  const uint32x4_t sign = vdupq_n_u32(0x80000000);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t three = vdupq_n_f32(3.0f);
+  const float32x4_t c9 = vdupq_n_f32(9.0f);
+  const float32x4_t c27 = vdupq_n_f32(27.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t x = vld1q_f32(data + i);
+    float32x4_t y = vmulq_f32(x, x);
+    float32x4_t r = vdivq_f32(vmulq_f32(x, vaddq_f32(c27, y)), vaddq_f32(c27, vmulq_f32(c9, y)));
+    uint32x4_t over = vcagtq_f32(x, three);
+    float32x4_t limit = vbslq_f32(sign, x, one);
+    vst1q_f32(data + i, vbslq_f32(over, limit, r));
+  }
+  ClampScalar(data + i, count - i);
+}
+
+static void InterleaveNEON(const float * const *src, float *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2 || !src[0] || !src[1])
+  {
+    InterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 4 <= frames; i += 4)
+  {
+    float32x4x2_t lr;
+    lr.val[0] = vld1q_f32(src[0] + i);
+    lr.val[1] = vld1q_f32(src[1] + i);
+    vst2q_f32(dst + 2 * i, lr);
+  }
+  const float *rest[2] = { src[0] + i, src[1] + i };
+  InterleaveScalar(rest, dst + 2 * i, 2, frames - i);
+}
+
+static void DeinterleaveNEON(const float *src, float * const *dst, unsigned int channels, unsigned int frames)
+{
+  if (channels != 2)
+  {
+    DeinterleaveScalar(src, dst, channels, frames);
+    return;
+  }
+
+  unsigned int i = 0;
+  for (; i + 4 <= frames; i += 4)
+  {
+    float32x4x2_t lr = vld2q_f32(src + 2 * i);
+    vst1q_f32(dst[0] + i, lr.val[0]);
+    vst1q_f32(dst[1] + i, lr.val[1]);
+  }
+  float *rest[2] = { dst[0] + i, dst[1] + i };
+  DeinterleaveScalar(src + 2 * i, rest, 2, frames - i);
+}
+
+// clamp with the NaN semantics of MinF/MaxF, vminq/vmaxq would propagate NaN
+static inline float32x4_t ClampRangeNEON(float32x4_t v, float32x4_t lo, float32x4_t hi)
+{
+  v = vbslq_f32(vcgtq_f32(v, lo), v, lo);
+  return vbslq_f32(vcltq_f32(v, hi), v, hi);
+}
+
+static void FloatToS16NEON(const float *src, int16_t *dst, unsigned int count)
+{
+  const float32x4_t scale = vdupq_n_f32(32768.0f);
+  const float32x4_t lo = vdupq_n_f32(-32768.0f);
+  const float32x4_t hi = vdupq_n_f32(32767.0f);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    int32x4_t a = vcvtnq_s32_f32(ClampRangeNEON(vmulq_f32(vld1q_f32(src + i), scale), lo, hi));
+    int32x4_t b = vcvtnq_s32_f32(ClampRangeNEON(vmulq_f32(vld1q_f32(src + i + 4), scale), lo, hi));
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+  FloatToS16Scalar(src + i, dst + i, count - i);
+}
+
+static void FloatToS32NEON(const float *src, int32_t *dst, unsigned int count)
+{
+  const float32x4_t scale = vdupq_n_f32(2147483648.0f);
+  const float32x4_t lo = vdupq_n_f32(-2147483648.0f);
+  const float32x4_t hi = vdupq_n_f32(2147483520.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_s32(dst + i, vcvtnq_s32_f32(ClampRangeNEON(vmulq_f32(vld1q_f32(src + i), scale), lo, hi)));
+  FloatToS32Scalar(src + i, dst + i, count - i);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// dispatching
+//-----------------------------------------------------------------------------
+
+CAEKernels::CAEKernels() :
+  Gain(GainScalar),
+  MixGain(MixGainScalar),
+  Peak(PeakScalar),
+  Clamp(ClampScalar),
+  Interleave(InterleaveScalar),
+  Deinterleave(DeinterleaveScalar),
+  Remap(RemapScalar),
+  FloatToS16(FloatToS16Scalar),
+  FloatToS32(FloatToS32Scalar),
+  m_implementation(IMPL_SCALAR),
+  m_name("scalar"),
+  m_supported(true)
+{
+}
+
+bool CAEKernels::IsSupported(Implementation implementation)
+{
+  switch (implementation)
+  {
+    case IMPL_SCALAR:
+      return true;
+#if defined(AE_KERNELS_X86)
+    case IMPL_SSE2:
+      return (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE2) != 0;
+    case IMPL_AVX2:
+      return HasAVX2();
+#endif
+#if defined(AE_KERNELS_NEON)
+    case IMPL_NEON:
+      // mandatory on aarch64
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+bool CAEKernels::Initialize(CAEKernels *kernels)
+{
+  for (int i = 0; i < IMPL_COUNT; i++)
+  {
+    kernels[i].m_implementation = static_cast<Implementation>(i);
+    kernels[i].m_supported = IsSupported(kernels[i].m_implementation);
+  }
+
+  // remap only gathers single samples, there's nothing to gain from vectors
+#if defined(AE_KERNELS_X86)
+  CAEKernels &sse2 = kernels[IMPL_SSE2];
+  sse2.m_name = "sse2";
+  sse2.Gain = GainSSE2;
+  sse2.MixGain = MixGainSSE2;
+  sse2.Peak = PeakSSE2;
+  sse2.Clamp = ClampSSE2;
+  sse2.Interleave = InterleaveSSE2;
+  sse2.Deinterleave = DeinterleaveSSE2;
+  sse2.FloatToS16 = FloatToS16SSE2;
+  sse2.FloatToS32 = FloatToS32SSE2;
+
+  CAEKernels &avx2 = kernels[IMPL_AVX2];
+  avx2.m_name = "avx2";
+  avx2.Gain = GainAVX2;
+  avx2.MixGain = MixGainAVX2;
+  avx2.Peak = PeakAVX2;
+  avx2.Clamp = ClampAVX2;
+  avx2.Interleave = InterleaveAVX2;
+  avx2.Deinterleave = DeinterleaveAVX2;
+  avx2.FloatToS16 = FloatToS16AVX2;
+  avx2.FloatToS32 = FloatToS32AVX2;
+#endif
+#if defined(AE_KERNELS_NEON)
+  CAEKernels &neon = kernels[IMPL_NEON];
+  neon.m_name = "neon";
+  neon.Gain = GainNEON;
+  neon.MixGain = MixGainNEON;
+  neon.Peak = PeakNEON;
+  neon.Clamp = ClampNEON;
+  neon.Interleave = InterleaveNEON;
+  neon.Deinterleave = DeinterleaveNEON;
+  neon.FloatToS16 = FloatToS16NEON;
+  neon.FloatToS32 = FloatToS32NEON;
+#endif
+  return true;
+}
+
+const CAEKernels* CAEKernels::Get(Implementation implementation)
+{
+  static CAEKernels kernels[IMPL_COUNT];
+  static const bool initialized = Initialize(kernels);
+  (void)initialized;
+
+  if (implementation < IMPL_SCALAR || implementation >= IMPL_COUNT || !kernels[implementation].m_supported)
+    return NULL;
+  return &kernels[implementation];
+}
+
+const CAEKernels& CAEKernels::SelectBest()
+{
+  const CAEKernels *kernels = NULL;
+  for (int i = IMPL_COUNT - 1; i >= IMPL_SCALAR && !kernels; i--)
+    kernels = Get(static_cast<Implementation>(i));
+  CLog::Log(LOGNOTICE, "CAEKernels: using %s implementation", kernels->GetName());
+  return *kernels;
+}
+
+const CAEKernels& CAEKernels::Get()
+{
+  static const CAEKernels &best = SelectBest();
+  return best;
+}
@@ -0,0 +1,104 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+/*!
+ \brief Sample processing kernels of the audio engine.
+
+ Every implementation is selected at runtime from the features of the CPU
+ the engine is running on, so a build for a baseline CPU still uses the
+ widest vector unit available. All implementations produce exactly the same
+ results as the scalar one: multiplications and additions are never fused
+ and float to integer conversions round to nearest after clamping.
+
+ Kernels are called through the function pointers of the instance returned
+ by Get(), e.g. CAEKernels::Get().Gain(buffer, volume, count).
+ */
+class CAEKernels
+{
+public:
+  enum Implementation
+  {
+    IMPL_SCALAR = 0,
+    IMPL_SSE2,
+    IMPL_AVX2,
+    IMPL_NEON,
+    IMPL_COUNT
+  };
+
+  /*!
+   \brief Retrieve the fastest implementation supported by this CPU
+   */
+  static const CAEKernels& Get();
+
+  /*!
+   \brief Retrieve a specific implementation
+   \return the implementation, NULL if it isn't built in or the CPU lacks support for it
+   */
+  static const CAEKernels* Get(Implementation implementation);
+
+  Implementation GetImplementation() const { return m_implementation; }
+  const char* GetName() const { return m_name; }
+
+  /*! \brief data[i] *= gain */
+  void (*Gain)(float *data, float gain, unsigned int count);
+
+  /*! \brief dst[i] += src[i] * gain */
+  void (*MixGain)(float *dst, const float *src, float gain, unsigned int count);
+
+  /*! \brief Largest absolute value of the samples, 0 for an empty buffer */
+  float (*Peak)(const float *data, unsigned int count);
+
+  /*! \brief Soft clip the samples to [-1, 1], see CAEUtil::SoftClamp */
+  void (*Clamp)(float *data, unsigned int count);
+
+  /*!
+   \brief Interleave planar samples
+   \param src one plane per channel, a NULL plane produces silence
+   */
+  void (*Interleave)(const float * const *src, float *dst, unsigned int channels, unsigned int frames);
+
+  /*! \brief Split interleaved samples into one plane per channel */
+  void (*Deinterleave)(const float *src, float * const *dst, unsigned int channels, unsigned int frames);
+
+  /*!
+   \brief Reorder the channels of interleaved samples
+   \param map source channel of each destination channel, -1 produces silence
+   */
+  void (*Remap)(const float *src, unsigned int srcChannels, float *dst, unsigned int dstChannels, const int *map, unsigned int frames);
+
+  /*! \brief Convert to signed 16 bit, full scale is 1.0 */
+  void (*FloatToS16)(const float *src, int16_t *dst, unsigned int count);
+
+  /*! \brief Convert to signed 32 bit, full scale is 1.0 */
+  void (*FloatToS32)(const float *src, int32_t *dst, unsigned int count);
+
+private:
+  CAEKernels();
+  static bool IsSupported(Implementation implementation);
+  static bool Initialize(CAEKernels *kernels);
+  static const CAEKernels& SelectBest();
+
+  Implementation m_implementation;
+  const char *m_name;
+  bool m_supported;
+};
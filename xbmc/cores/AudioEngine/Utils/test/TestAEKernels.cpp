@@ -0,0 +1,228 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// odd sizes and offsets so that every implementation runs its remainder code
+#define MAX_COUNT 67
+#define MAX_OFFSET 3
+
+namespace
+{
+std::vector<float> RandomSamples(unsigned int count, unsigned int seed)
+{
+  srand(seed);
+  std::vector<float> samples(count);
+  for (unsigned int i = 0; i < count; i++)
+    samples[i] = (rand() / (float)RAND_MAX) * 8.0f - 4.0f;
+
+  // include values at and around the limits of the conversions and the clamp
+  const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, 3.0f, -3.0f, 0.5f / 32768.0f, 1.5f / 32768.0f, 1e-40f };
+  for (unsigned int i = 0; i < count && i < sizeof(special) / sizeof(special[0]); i++)
+    samples[(i * 7) % count] = special[i];
+  return samples;
+}
+
+std::vector<const CAEKernels*> VectorImplementations()
+{
+  std::vector<const CAEKernels*> implementations;
+  for (int i = CAEKernels::IMPL_SCALAR + 1; i < CAEKernels::IMPL_COUNT; i++)
+  {
+    const CAEKernels *kernels = CAEKernels::Get(static_cast<CAEKernels::Implementation>(i));
+    if (kernels)
+      implementations.push_back(kernels);
+  }
+  return implementations;
+}
+
+template<typename T>
+bool BitExact(const std::vector<T> &a, const std::vector<T> &b)
+{
+  return a.size() == b.size() && memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0;
+}
+}
+
+TEST(TestAEKernels, Dispatch)
+{
+  const CAEKernels *scalar = CAEKernels::Get(CAEKernels::IMPL_SCALAR);
+  ASSERT_TRUE(scalar != NULL);
+  EXPECT_EQ(CAEKernels::IMPL_SCALAR, scalar->GetImplementation());
+  EXPECT_TRUE(CAEKernels::Get(CAEKernels::IMPL_COUNT) == NULL);
+
+  const CAEKernels &best = CAEKernels::Get();
+  EXPECT_EQ(&best, CAEKernels::Get(best.GetImplementation()));
+}
+
+TEST(TestAEKernels, GainAndMix)
+{
+  const CAEKernels *scalar = CAEKernels::Get(CAEKernels::IMPL_SCALAR);
+  std::vector<const CAEKernels*> implementations = VectorImplementations();
+  for (std::vector<const CAEKernels*>::iterator it = implementations.begin(); it != implementations.end(); ++it)
+  {
+    for (unsigned int count = 0; count <= MAX_COUNT; count++)
+    {
+      for (unsigned int offset = 0; offset < MAX_OFFSET; offset++)
+      {
+        std::vector<float> src = RandomSamples(count + MAX_OFFSET + 1, count);
+        std::vector<float> expected = RandomSamples(count + MAX_OFFSET + 1, count + 1000);
+        std::vector<float> actual = expected;
+
+        scalar->Gain(&expected[offset], 0.3f, count);
+        (*it)->Gain(&actual[offset], 0.3f, count);
+        EXPECT_TRUE(BitExact(expected, actual)) << (*it)->GetName() << " Gain " << count << "/" << offset;
+
+        scalar->MixGain(&expected[offset], &src[offset], 0.7f, count);
+        (*it)->MixGain(&actual[offset], &src[offset], 0.7f, count);
+        EXPECT_TRUE(BitExact(expected, actual)) << (*it)->GetName() << " MixGain " << count << "/" << offset;
+
+        EXPECT_EQ(scalar->Peak(&expected[offset], count), (*it)->Peak(&actual[offset], count))
+          << (*it)->GetName() << " Peak " << count << "/" << offset;
+
+        scalar->Clamp(&expected[offset], count);
+        (*it)->Clamp(&actual[offset], count);
+        EXPECT_TRUE(BitExact(expected, actual)) << (*it)->GetName() << " Clamp " << count << "/" << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEKernels, Clamp)
+{
+  float samples[] = { 0.0f, 0.5f, -0.5f, 1.0f, 3.0f, -3.0f, 10.0f, -10.0f };
+  CAEKernels::Get().Clamp(samples, sizeof(samples) / sizeof(samples[0]));
+  EXPECT_EQ(0.0f, samples[0]);
+  EXPECT_GT(samples[1], 0.45f);
+  EXPECT_LT(samples[1], 0.5f);
+  EXPECT_EQ(-samples[1], samples[2]);
+  EXPECT_LT(samples[3], 1.0f);
+  EXPECT_EQ(1.0f, samples[4]);
+  EXPECT_EQ(-1.0f, samples[5]);
+  EXPECT_EQ(1.0f, samples[6]);
+  EXPECT_EQ(-1.0f, samples[7]);
+}
+
+TEST(TestAEKernels, Conversion)
+{
+  const CAEKernels *scalar = CAEKernels::Get(CAEKernels::IMPL_SCALAR);
+  std::vector<const CAEKernels*> implementations = VectorImplementations();
+  for (std::vector<const CAEKernels*>::iterator it = implementations.begin(); it != implementations.end(); ++it)
+  {
+    for (unsigned int count = 0; count <= MAX_COUNT; count++)
+    {
+      for (unsigned int offset = 0; offset < MAX_OFFSET; offset++)
+      {
+        std::vector<float> src = RandomSamples(count + MAX_OFFSET, count);
+        // mostly in range, the rest exercises the saturation
+        for (unsigned int i = 0; i < src.size(); i += 2)
+          src[i] /= 4.0f;
+
+        std::vector<int16_t> expected16(count + 1), actual16(count + 1);
+        scalar->FloatToS16(&src[offset], &expected16[0], count);
+        (*it)->FloatToS16(&src[offset], &actual16[0], count);
+        EXPECT_TRUE(BitExact(expected16, actual16)) << (*it)->GetName() << " FloatToS16 " << count << "/" << offset;
+
+        std::vector<int32_t> expected32(count + 1), actual32(count + 1);
+        scalar->FloatToS32(&src[offset], &expected32[0], count);
+        (*it)->FloatToS32(&src[offset], &actual32[0], count);
+        EXPECT_TRUE(BitExact(expected32, actual32)) << (*it)->GetName() << " FloatToS32 " << count << "/" << offset;
+      }
+    }
+  }
+
+  const float samples[] = { 0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.5f, 1.5f / 32768.0f };
+  int16_t s16[7];
+  CAEKernels::Get().FloatToS16(samples, s16, 7);
+  EXPECT_EQ(0, s16[0]);
+  EXPECT_EQ(32767, s16[1]);
+  EXPECT_EQ(-32768, s16[2]);
+  EXPECT_EQ(32767, s16[3]);
+  EXPECT_EQ(-32768, s16[4]);
+  EXPECT_EQ(16384, s16[5]);
+  EXPECT_EQ(2, s16[6]); // ties round to even
+
+  int32_t s32[7];
+  CAEKernels::Get().FloatToS32(samples, s32, 7);
+  EXPECT_EQ(0, s32[0]);
+  EXPECT_EQ(2147483520, s32[1]);
+  EXPECT_EQ(-2147483647 - 1, s32[2]);
+  EXPECT_EQ(1073741824, s32[5]);
+}
+
+TEST(TestAEKernels, Layout)
+{
+  const CAEKernels *scalar = CAEKernels::Get(CAEKernels::IMPL_SCALAR);
+  std::vector<const CAEKernels*> implementations = VectorImplementations();
+  implementations.push_back(scalar);
+  for (std::vector<const CAEKernels*>::iterator it = implementations.begin(); it != implementations.end(); ++it)
+  {
+    for (unsigned int channels = 1; channels <= 6; channels++)
+    {
+      for (unsigned int frames = 0; frames <= MAX_COUNT; frames += 11)
+      {
+        std::vector<std::vector<float> > planes(channels);
+        std::vector<const float*> src(channels);
+        for (unsigned int ch = 0; ch < channels; ch++)
+        {
+          planes[ch] = RandomSamples(frames + 1, ch);
+          src[ch] = &planes[ch][0];
+        }
+
+        std::vector<float> interleaved(frames * channels + 1);
+        (*it)->Interleave(&src[0], &interleaved[0], channels, frames);
+        for (unsigned int i = 0; i < frames * channels; i++)
+          ASSERT_EQ(planes[i % channels][i / channels], interleaved[i]) << (*it)->GetName() << " Interleave";
+
+        std::vector<std::vector<float> > split(channels, std::vector<float>(frames + 1));
+        std::vector<float*> dst(channels);
+        for (unsigned int ch = 0; ch < channels; ch++)
+          dst[ch] = &split[ch][0];
+        (*it)->Deinterleave(&interleaved[0], &dst[0], channels, frames);
+        for (unsigned int ch = 0; ch < channels; ch++)
+          ASSERT_EQ(0, memcmp(&planes[ch][0], &split[ch][0], frames * sizeof(float))) << (*it)->GetName() << " Deinterleave";
+
+        // missing planes produce silence
+        src[0] = NULL;
+        (*it)->Interleave(&src[0], &interleaved[0], channels, frames);
+        for (unsigned int i = 0; i < frames; i++)
+          ASSERT_EQ(0.0f, interleaved[i * channels]) << (*it)->GetName() << " Interleave silence";
+      }
+    }
+  }
+}
+
+TEST(TestAEKernels, Remap)
+{
+  const float src[] = { 1.0f, 2.0f, 3.0f,
+                        4.0f, 5.0f, 6.0f };
+  const int map[] = { 2, -1, 0, 1 };
+  float dst[8];
+  CAEKernels::Get().Remap(src, 3, dst, 4, map, 2);
+
+  const float expected[] = { 3.0f, 0.0f, 1.0f, 2.0f,
+                             6.0f, 0.0f, 4.0f, 5.0f };
+  for (int i = 0; i < 8; i++)
+    EXPECT_EQ(expected[i], dst[i]);
+}
@@ -67,6 +67,7 @@ public:
 };
 
 class CFileItem;
+class CFileItemList;
 
 enum IPlayerAudioCapabilities
 {
@@ -256,6 +257,12 @@ public:
   virtual bool OpenFile(const CFileItem& file, const CPlayerOptions& options){ return false;}
   virtual bool QueueNextFile(const CFileItem &file) { return false; }
   virtual void OnNothingToQueueNotify() {}
+
+  /*!
+   \brief The playlist items that follow the one playing, in playback order
+   Players may open and decode them in advance so that a later QueueNextFile() is instantaneous.
+   */
+  virtual void SetUpcomingFiles(const CFileItemList &files) {}
   virtual bool CloseFile(bool reopen = false) = 0;
   virtual bool IsPlaying() const { return false;}
   virtual bool CanPause() { return true; };
@@ -23,9 +23,14 @@
 #endif
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "system.h"
 
+#include <atomic>
+#include <vector>
+
 #ifdef TARGET_POSIX
 #include "linux/XMemUtils.h"
 #endif
@@ -34,13 +39,168 @@ extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+namespace
+{
+/*
+ * Packets are allocated together with a small trailer that remembers the
+ * size class of the payload buffer, so a freed packet can go back to the
+ * matching free list. DemuxPacket itself is shared with add-ons and must
+ * keep its layout.
+ */
+struct DemuxPacketBlock
+{
+  DemuxPacket packet;
+  int sizeClass;
+};
+
+// class 0 holds packets without payload, class n a buffer of 1 << (n + MIN_CLASS_SHIFT) bytes
+const int MIN_CLASS_SHIFT = 9;
+const int NUM_CLASSES = 14;                 // up to 2 MiB payloads
+const size_t MAX_FREE_PER_CLASS = 64;
+const uint64_t MAX_POOLED_BYTES = 32 * 1024 * 1024;
+
+class CDemuxPacketPool
+{
+public:
+  CDemuxPacketPool()
+    : m_allocations(0)
+    , m_poolHits(0)
+    , m_live(0)
+    , m_pooledBytes(0)
+  {
+  }
+
+  ~CDemuxPacketPool()
+  {
+    for (int i = 0; i < NUM_CLASSES; i++)
+    {
+      for (DemuxPacketBlock* block : m_classes[i].free)
+        Destroy(block);
+    }
+  }
+
+  DemuxPacketBlock* Acquire(int iDataSize)
+  {
+    int sizeClass = GetClass(iDataSize);
+    m_allocations++;
+    m_live++;
+
+    if (sizeClass >= 0)
+    {
+      SizeClass& cls = m_classes[sizeClass];
+      CSingleLock lock(cls.lock);
+      if (!cls.free.empty())
+      {
+        DemuxPacketBlock* block = cls.free.back();
+        cls.free.pop_back();
+        m_pooledBytes -= GetCapacity(sizeClass);
+        m_poolHits++;
+        return block;
+      }
+    }
+
+    DemuxPacketBlock* block = new DemuxPacketBlock;
+    memset(&block->packet, 0, sizeof(DemuxPacket));
+    block->sizeClass = sizeClass;
+    if (iDataSize > 0)
+    {
+      size_t capacity = sizeClass >= 0 ? GetCapacity(sizeClass) : iDataSize + FF_INPUT_BUFFER_PADDING_SIZE;
+      block->packet.pData = (uint8_t*)_aligned_malloc(capacity, 16);
+      if (!block->packet.pData)
+      {
+        delete block;
+        m_live--;
+        return NULL;
+      }
+    }
+    return block;
+  }
+
+  void Release(DemuxPacketBlock* block)
+  {
+    m_live--;
+
+    int sizeClass = block->sizeClass;
+    if (sizeClass >= 0)
+    {
+      size_t capacity = GetCapacity(sizeClass);
+      SizeClass& cls = m_classes[sizeClass];
+      CSingleLock lock(cls.lock);
+      if (cls.free.size() < MAX_FREE_PER_CLASS &&
+          m_pooledBytes + capacity <= MAX_POOLED_BYTES)
+      {
+        cls.free.push_back(block);
+        m_pooledBytes += capacity;
+        return;
+      }
+    }
+    Destroy(block);
+  }
+
+  DemuxPacketStats GetStats() const
+  {
+    DemuxPacketStats stats;
+    stats.allocations = m_allocations;
+    stats.poolHits = m_poolHits;
+    stats.live = m_live;
+    stats.pooledBytes = m_pooledBytes;
+    return stats;
+  }
+
+private:
+  struct SizeClass
+  {
+    CCriticalSection lock;
+    std::vector<DemuxPacketBlock*> free;
+  };
+
+  // returns -1 for payloads too large to be pooled
+  static int GetClass(int iDataSize)
+  {
+    if (iDataSize <= 0)
+      return 0;
+
+    size_t needed = iDataSize + FF_INPUT_BUFFER_PADDING_SIZE;
+    for (int i = 1; i < NUM_CLASSES; i++)
+    {
+      if (needed <= GetCapacity(i))
+        return i;
+    }
+    return -1;
+  }
+
+  static size_t GetCapacity(int sizeClass)
+  {
+    return sizeClass > 0 ? (size_t)1 << (sizeClass + MIN_CLASS_SHIFT) : 0;
+  }
+
+  static void Destroy(DemuxPacketBlock* block)
+  {
+    if (block->packet.pData)
+      _aligned_free(block->packet.pData);
+    delete block;
+  }
+
+  SizeClass m_classes[NUM_CLASSES];
+  std::atomic<uint64_t> m_allocations;
+  std::atomic<uint64_t> m_poolHits;
+  std::atomic<uint64_t> m_live;
+  std::atomic<uint64_t> m_pooledBytes;
+};
+
+CDemuxPacketPool& GetPool()
+{
+  static CDemuxPacketPool pool;
+  return pool;
+}
+}
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      GetPool().Release(reinterpret_cast<DemuxPacketBlock*>(pPacket));
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -50,46 +210,51 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket) return NULL;
-
+  DemuxPacketBlock* block = NULL;
   try
   {
-    memset(pPacket, 0, sizeof(DemuxPacket));
-
-    if (iDataSize > 0)
-    {
-      // need to allocate a few bytes more.
-      // From avcodec.h (ffmpeg)
-      /**
-        * Required number of additionally allocated bytes at the end of the input bitstream for decoding.
-        * this is mainly needed because some optimized bitstream readers read
-        * 32 or 64 bit at once and could read over the end<br>
-        * Note, if the first 23 bits of the additional bytes are not 0 then damaged
-        * MPEG bitstreams could cause overread and segfault
-        */
-      pPacket->pData =(uint8_t*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
-      if (!pPacket->pData)
-      {
-        FreeDemuxPacket(pPacket);
-        return NULL;
-      }
-
-      // reset the last 8 bytes to 0;
-      memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
-    }
-
-    // setup defaults
-    pPacket->dts       = DVD_NOPTS_VALUE;
-    pPacket->pts       = DVD_NOPTS_VALUE;
-    pPacket->iStreamId = -1;
-    pPacket->dispTime = 0;
+    // need to allocate a few bytes more.
+    // From avcodec.h (ffmpeg)
+    /**
+      * Required number of additionally allocated bytes at the end of the input bitstream for decoding.
+      * this is mainly needed because some optimized bitstream readers read
+      * 32 or 64 bit at once and could read over the end<br>
+      * Note, if the first 23 bits of the additional bytes are not 0 then damaged
+      * MPEG bitstreams could cause overread and segfault
+      */
+    block = GetPool().Acquire(iDataSize);
   }
   catch(...)
   {
     CLog::Log(LOGERROR, "%s - Exception thrown", __FUNCTION__);
-    FreeDemuxPacket(pPacket);
-    pPacket = NULL;
+    return NULL;
   }
+  if (!block)
+    return NULL;
+
+  DemuxPacket* pPacket = &block->packet;
+
+  // recycled packets keep their payload buffer only
+  uint8_t* pData = pPacket->pData;
+  memset(pPacket, 0, sizeof(DemuxPacket));
+  pPacket->pData = pData;
+
+  if (iDataSize > 0)
+  {
+    // reset the padding bytes to 0;
+    memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+  }
+
+  // setup defaults
+  pPacket->dts       = DVD_NOPTS_VALUE;
+  pPacket->pts       = DVD_NOPTS_VALUE;
+  pPacket->iStreamId = -1;
+  pPacket->dispTime = 0;
+
   return pPacket;
 }
+
+DemuxPacketStats CDVDDemuxUtils::GetPacketStats()
+{
+  return GetPool().GetStats();
+}
@@ -22,10 +22,27 @@
 
 #include "DVDDemuxPacket.h"
 
+#include <stdint.h>
+
+struct DemuxPacketStats
+{
+  uint64_t allocations; // total packets handed out
+  uint64_t poolHits;    // allocations served from a free list
+  uint64_t live;        // packets currently in use
+  uint64_t pooledBytes; // payload bytes kept in the free lists
+};
+
 class CDVDDemuxUtils
 {
 public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  /*!
+   \brief Get allocation counters of the demux packet pool.
+   Packets and their payload are recycled in power of two size classes,
+   so steady state playback does not hit the heap for every packet.
+   */
+  static DemuxPacketStats GetPacketStats();
 };
 
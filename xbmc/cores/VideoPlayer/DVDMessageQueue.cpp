@@ -25,11 +25,17 @@
 #include "DVDClock.h"
 #include "math.h"
 
+#define MSGQ_RING_SIZE 4096
+
 CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner)
 {
-  m_iDataSize     = 0;
+  m_dataState     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
+  m_drain = false;
+  m_lockFree = false;
+  m_lockedCount = 0;
+  m_waiting = false;
 
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
@@ -45,29 +51,39 @@ CDVDMessageQueue::~CDVDMessageQueue()
 
 void CDVDMessageQueue::Init()
 {
-  m_iDataSize = 0;
+  NewGeneration();
   m_bAbortRequest = false;
   m_bInitialized = true;
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
   m_drain = false;
+
+  if (m_lockFree && !m_ring)
+    m_ring.reset(new CDVDMessageRing(MSGQ_RING_SIZE));
 }
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
+  CSingleLock consumer(m_consumerSection);
   CSingleLock lock(m_section);
 
-  m_messages.remove_if([type](const DVDMessageListItem &item){
+  auto matches = [type](const DVDMessageListItem &item){
     return type == CDVDMsg::NONE || item.message->IsType(type);
-  });
+  };
 
-  m_prioMessages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
-  });
+  m_messages.remove_if(matches);
+  m_prioMessages.remove_if(matches);
+
+  if (m_ring)
+  {
+    DrainRing();
+    m_spill.remove_if(matches);
+    m_lockedCount = m_messages.size() + m_prioMessages.size();
+  }
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
-    m_iDataSize = 0;
+    NewGeneration();
     m_TimeBack = DVD_NOPTS_VALUE;
     m_TimeFront = DVD_NOPTS_VALUE;
   }
@@ -85,17 +101,40 @@ void CDVDMessageQueue::Abort()
 
 void CDVDMessageQueue::End()
 {
+  CSingleLock consumer(m_consumerSection);
   CSingleLock lock(m_section);
 
   Flush(CDVDMsg::NONE);
 
   m_bInitialized = false;
-  m_iDataSize = 0;
   m_bAbortRequest = false;
 }
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
 {
+  if (m_ring && priority == 0 && front && m_bInitialized && pMsg)
+  {
+    // account before the push, so the consumer never subtracts a message
+    // that was not added yet. The message carries the generation it was
+    // accounted in, a flush in between makes the consumer skip it.
+    unsigned int generation = UpdateTimeFront(pMsg, priority);
+    if (!m_ring->Push(pMsg, generation))
+    {
+      // ring is full, move its content to the spill list to make room.
+      CSingleLock consumer(m_consumerSection);
+      do
+        DrainRing();
+      while (!m_ring->Push(pMsg, generation));
+    }
+
+    // only wake the consumer if it is actually waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting)
+      m_hEvent.Set();
+
+    return MSGQ_OK;
+  }
+
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
@@ -110,6 +149,8 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
     return MSGQ_INVALID_MSG;
   }
 
+  unsigned int generation = UpdateTimeFront(pMsg, priority);
+
   if (priority > 0)
   {
     int prio = priority;
@@ -120,31 +161,18 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
                            [prio](const DVDMessageListItem &item){
                              return prio <= item.priority;
                            });
-    m_prioMessages.emplace(it, pMsg, priority);
+    m_prioMessages.emplace(it, pMsg, priority, generation);
   }
   else
   {
     if (front)
-      m_messages.emplace_front(pMsg, priority);
+      m_messages.emplace_front(pMsg, priority, generation);
     else
-      m_messages.emplace_back(pMsg, priority);
+      m_messages.emplace_back(pMsg, priority, generation);
   }
 
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
-  {
-    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
-    if (packet)
-    {
-      m_iDataSize += packet->iSize;
-      if (packet->dts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->dts;
-      else if (packet->pts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->pts;
-
-      if (m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
-    }
-  }
+  if (m_ring)
+    m_lockedCount++;
 
   pMsg->Release();
 
@@ -156,6 +184,9 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
 
 MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
 {
+  if (m_ring)
+    return GetLockFree(pMsg, iTimeoutInMilliSeconds, priority);
+
   CSingleLock lock(m_section);
 
   *pMsg = NULL;
@@ -177,18 +208,7 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
       DVDMessageListItem& item(msgs.back());
       priority = item.priority;
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
-      {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if (packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if (packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
-      }
+      UpdateTimeBack(item.message, item.priority, item.generation);
 
       *pMsg = item.message->Acquire();
       msgs.pop_back();
@@ -220,8 +240,163 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
   return (MsgQueueReturnCode)ret;
 }
 
+MsgQueueReturnCode CDVDMessageQueue::GetLockFree(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
+{
+  CSingleLock consumer(m_consumerSection);
+
+  *pMsg = NULL;
+
+  if (!m_bInitialized)
+  {
+    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Get MSGQ_NOT_INITIALIZED", m_owner.c_str());
+    return MSGQ_NOT_INITIALIZED;
+  }
+
+  while (!m_bAbortRequest)
+  {
+    // prioritized and out of order messages first
+    if (priority > 0 || m_lockedCount > 0)
+    {
+      CSingleLock lock(m_section);
+      std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
+
+      if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
+      {
+        DVDMessageListItem& item(msgs.back());
+        priority = item.priority;
+        UpdateTimeBack(item.message, item.priority, item.generation);
+        *pMsg = item.message->Acquire();
+        msgs.pop_back();
+        m_lockedCount--;
+        return MSGQ_OK;
+      }
+    }
+
+    if (priority == 0)
+    {
+      if (!m_spill.empty())
+      {
+        DVDMessageListItem& item(m_spill.front());
+        UpdateTimeBack(item.message, item.priority, item.generation);
+        *pMsg = item.message->Acquire();
+        m_spill.pop_front();
+        return MSGQ_OK;
+      }
+
+      CDVDMsg* msg;
+      unsigned int generation;
+      if (m_ring->Pop(msg, generation))
+      {
+        UpdateTimeBack(msg, 0, generation);
+        *pMsg = msg;
+        return MSGQ_OK;
+      }
+    }
+
+    if (!iTimeoutInMilliSeconds)
+      return MSGQ_TIMEOUT;
+
+    m_waiting = true;
+    m_hEvent.Reset();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // a producer might have added a message before it saw m_waiting
+    if (HasMessages(priority))
+    {
+      m_waiting = false;
+      continue;
+    }
+
+    consumer.Leave();
+    bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+    m_waiting = false;
+    if (!signaled)
+      return MSGQ_TIMEOUT;
+    consumer.Enter();
+  }
+
+  return MSGQ_ABORT;
+}
+
+bool CDVDMessageQueue::HasMessages(int priority)
+{
+  if (priority > 0)
+  {
+    CSingleLock lock(m_section);
+    return !m_prioMessages.empty() && (m_prioMessages.back().priority >= priority || m_drain);
+  }
+  return m_lockedCount > 0 || !m_spill.empty() || !m_ring->Empty();
+}
+
+void CDVDMessageQueue::DrainRing()
+{
+  CDVDMsg* msg;
+  unsigned int generation;
+  while (m_ring->Pop(msg, generation))
+  {
+    m_spill.emplace_back(msg, 0, generation);
+    msg->Release();
+  }
+}
+
+void CDVDMessageQueue::NewGeneration()
+{
+  // drops the size added by producers racing with us, their messages
+  // carry the old generation
+  m_dataState = (uint64_t)(Generation(m_dataState) + 1) << 32;
+}
+
+unsigned int CDVDMessageQueue::UpdateTimeFront(CDVDMsg* pMsg, int priority)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET) || priority != 0)
+    return Generation(m_dataState);
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (!packet)
+    return Generation(m_dataState);
+
+  unsigned int generation = Generation(m_dataState.fetch_add((uint32_t)packet->iSize));
+
+  // don't bring back the times of a packet that was flushed already
+  if (Generation(m_dataState) == generation)
+  {
+    if (packet->dts != DVD_NOPTS_VALUE)
+      m_TimeFront = packet->dts;
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      m_TimeFront = packet->pts;
+
+    double expected = DVD_NOPTS_VALUE;
+    m_TimeBack.compare_exchange_strong(expected, m_TimeFront);
+  }
+  return generation;
+}
+
+void CDVDMessageQueue::UpdateTimeBack(CDVDMsg* pMsg, int priority, unsigned int generation)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET) || priority != 0)
+    return;
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+  {
+    // a flush since the message was put already dropped it from the accounting
+    uint64_t state = m_dataState;
+    do
+    {
+      if (Generation(state) != generation)
+        return;
+    } while (!m_dataState.compare_exchange_weak(state, state - (uint32_t)packet->iSize));
+
+    if (packet->dts != DVD_NOPTS_VALUE)
+      m_TimeBack = packet->dts;
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      m_TimeBack = packet->pts;
+  }
+}
+
 unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
 {
+  CSingleLock consumer(m_consumerSection);
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
@@ -238,6 +413,15 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     if(item.message->IsType(type))
       count++;
   }
+  if (m_ring)
+  {
+    DrainRing();
+    for (const auto &item : m_spill)
+    {
+      if(item.message->IsType(type))
+        count++;
+    }
+  }
 
   return count;
 }
@@ -265,18 +449,19 @@ int CDVDMessageQueue::GetLevel() const
 {
   CSingleLock lock(m_section);
 
-  if (m_iDataSize > m_iMaxDataSize)
+  int dataSize = GetDataSize();
+  if (dataSize > m_iMaxDataSize)
     return 100;
-  if (m_iDataSize == 0)
+  if (dataSize == 0)
     return 0;
 
   if (IsDataBased())
-    return std::min(100, 100 * m_iDataSize / m_iMaxDataSize);
+    return std::min(100, 100 * dataSize / m_iMaxDataSize);
 
   int level = std::min(100.0, ceil(100.0 * m_TimeSize * (m_TimeFront - m_TimeBack) / DVD_TIME_BASE ));
 
   // if we added lots of packets with NOPTS, make sure that the queue is not signalled empty
-  if (level == 0 && m_iDataSize != 0)
+  if (level == 0 && dataSize != 0)
   {
     CLog::Log(LOGDEBUG, "CDVDMessageQueue::GetLevel() - can't determine level");
     return 1;
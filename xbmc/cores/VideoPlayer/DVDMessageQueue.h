@@ -21,24 +21,29 @@
  */
 
 #include "DVDMessage.h"
+#include "DVDMessageRing.h"
 #include <atomic>
+#include <memory>
 #include <string>
 #include <list>
 #include <algorithm>
+#include <stdint.h>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
 struct DVDMessageListItem
 {
-  DVDMessageListItem(CDVDMsg* msg, int prio)
+  DVDMessageListItem(CDVDMsg* msg, int prio, unsigned int gen = 0)
   {
     message = msg->Acquire();
     priority = prio;
+    generation = gen;
   }
   DVDMessageListItem()
   {
     message = NULL;
     priority = 0;
+    generation = 0;
   }
   DVDMessageListItem(const DVDMessageListItem&) = delete;
  ~DVDMessageListItem()
@@ -51,6 +56,7 @@ struct DVDMessageListItem
 
   CDVDMsg* message;
   int priority;
+  unsigned int generation; // flush generation the message was accounted in
 };
 
 enum MsgQueueReturnCode
@@ -71,6 +77,17 @@ public:
   CDVDMessageQueue(const std::string &owner);
   virtual ~CDVDMessageQueue();
 
+  /**
+   * Use a lock-free ring for regular (priority 0) messages.
+   * Producers put them without taking a lock, only prioritized and out of
+   * order messages go through the locked lists. A producer only blocks when
+   * the ring is full and has to be spilled. The queue must only be read
+   * from one thread at a time in this mode.
+   * Has to be set before Init().
+   */
+  void SetLockFree(bool lockFree) { m_lockFree = lockFree; }
+  bool IsLockFree() const { return m_lockFree; }
+
   void Init();
   void Flush(CDVDMsg::Message message = CDVDMsg::DEMUXER_PACKET);
   void Abort();
@@ -90,7 +107,7 @@ public:
     return Get(pMsg, iTimeoutInMilliSeconds, priority);
   }
 
-  int GetDataSize() const { return m_iDataSize; }
+  int GetDataSize() const { return DataSize(m_dataState); }
   int GetTimeSize() const;
   unsigned GetPacketCount(CDVDMsg::Message type);
   bool ReceivedAbortRequest() { return m_bAbortRequest; }
@@ -109,16 +126,29 @@ public:
 
 private:
 
+  MsgQueueReturnCode GetLockFree(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority);
+  bool HasMessages(int priority);
+  void DrainRing();
+  void NewGeneration();
+  unsigned int UpdateTimeFront(CDVDMsg* pMsg, int priority);
+  void UpdateTimeBack(CDVDMsg* pMsg, int priority, unsigned int generation);
+
+  static int DataSize(uint64_t state) { return (int)(uint32_t)state; }
+  static unsigned int Generation(uint64_t state) { return (unsigned int)(state >> 32); }
+
   CEvent m_hEvent;
   mutable CCriticalSection m_section;
 
   std::atomic<bool> m_bAbortRequest;
-  bool m_bInitialized;
+  std::atomic<bool> m_bInitialized;
   bool m_drain;
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  // size of the queued packets in the low 32 bits, flush generation in the
+  // high 32 bits. A flush starts a new generation with size 0, messages
+  // accounted in an older one are not subtracted again.
+  std::atomic<uint64_t> m_dataState;
+  std::atomic<double> m_TimeFront;
+  std::atomic<double> m_TimeBack;
   double m_TimeSize;
 
   int m_iMaxDataSize;
@@ -126,5 +156,16 @@ private:
 
   std::list<DVDMessageListItem> m_messages;
   std::list<DVDMessageListItem> m_prioMessages;
+
+  // lock-free mode: m_messages only holds messages put with front == false,
+  // regular messages pass through m_ring and m_spill (oldest first).
+  // producers account and push without a lock, m_spill is only touched
+  // under m_consumerSection
+  bool m_lockFree;
+  std::unique_ptr<CDVDMessageRing> m_ring;
+  std::list<DVDMessageListItem> m_spill;
+  CCriticalSection m_consumerSection;
+  std::atomic<int> m_lockedCount;
+  std::atomic<bool> m_waiting;
 };
 
@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+
+class CDVDMsg;
+
+/*!
+ \brief Bounded multi producer, single consumer ring of messages.
+
+ Slots carry a sequence number so producers can claim them with a single
+ compare and swap and the consumer can tell a written slot from a stale
+ one without taking a lock. The ring holds a reference on every message
+ it contains; Pop() hands that reference over to the caller. Next to each
+ message it keeps the generation the owner tagged it with.
+ */
+class CDVDMessageRing
+{
+public:
+  explicit CDVDMessageRing(size_t capacity)
+  {
+    m_size = 1;
+    while (m_size < capacity)
+      m_size <<= 1;
+    m_mask = m_size - 1;
+
+    m_slots.reset(new Slot[m_size]);
+    for (size_t i = 0; i < m_size; i++)
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+  }
+
+  CDVDMessageRing(const CDVDMessageRing&) = delete;
+  CDVDMessageRing& operator=(const CDVDMessageRing&) = delete;
+
+  /*!
+   \brief Append a message, may be called from any thread.
+   \return false if the ring is full, the message is left untouched
+   */
+  bool Push(CDVDMsg* msg, unsigned int generation)
+  {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    while (true)
+    {
+      Slot& slot = m_slots[pos & m_mask];
+      size_t seq = slot.sequence.load(std::memory_order_acquire);
+      ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+      if (diff == 0)
+      {
+        if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          slot.message = msg;
+          slot.generation = generation;
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+        return false;
+      else
+        pos = m_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  /*!
+   \brief Take the oldest message, only one thread may consume at a time.
+   \return false if the ring is empty
+   */
+  bool Pop(CDVDMsg*& msg, unsigned int& generation)
+  {
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[pos & m_mask];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if ((ptrdiff_t)seq - (ptrdiff_t)(pos + 1) < 0)
+      return false;
+
+    msg = slot.message;
+    generation = slot.generation;
+    slot.sequence.store(pos + m_size, std::memory_order_release);
+    m_tail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool Empty() const
+  {
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    const Slot& slot = m_slots[pos & m_mask];
+    return (ptrdiff_t)slot.sequence.load(std::memory_order_acquire) - (ptrdiff_t)(pos + 1) < 0;
+  }
+
+  size_t Capacity() const { return m_size; }
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    CDVDMsg* message;
+    unsigned int generation;
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_size;
+  size_t m_mask;
+
+  // keep producer and consumer indices on separate cache lines
+  char m_pad0[64];
+  std::atomic<size_t> m_head;
+  char m_pad1[64];
+  std::atomic<size_t> m_tail;
+  char m_pad2[64];
+};
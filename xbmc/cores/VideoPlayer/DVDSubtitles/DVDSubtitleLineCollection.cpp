@@ -19,14 +19,28 @@
  */
 
 #include "DVDSubtitleLineCollection.h"
-#include <stddef.h>
 
+#include <algorithm>
+
+namespace
+{
+bool StartsBefore(const CDVDOverlay* first, const CDVDOverlay* second)
+{
+  return first->iPTSStartTime < second->iPTSStartTime;
+}
+
+bool StartsAfter(double pts, const CDVDOverlay* overlay)
+{
+  return pts < overlay->iPTSStartTime;
+}
+}
 
 CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
 {
-  m_pHead = NULL;
-  m_pCurrent = NULL;
-  m_pTail = NULL;
+  m_sorted = true;
+  m_seek = true;
+  m_showingPos = 0;
+  m_current = 0;
 
   m_iSize = 0;
 }
@@ -38,85 +52,139 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
 
 void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = NULL;
-
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
+  m_overlays.push_back(pOverlay);
+  m_sorted = false;
+  m_seek = true;
 
   m_iSize++;
 }
 
 void CDVDSubtitleLineCollection::Sort()
 {
-  if (!m_pHead || !m_pHead->pNext)
+  if (m_sorted)
     return;
-  
-  for (ListElement* p1 = m_pHead; p1->pNext != NULL; p1 = p1->pNext)
-  {
-    for (ListElement* p2 = p1->pNext; p2 != NULL; p2 = p2->pNext)
-    {
-      if (p1->pOverlay->iPTSStartTime > p2->pOverlay->iPTSStartTime)
-      {
-        CDVDOverlay* temp = p1->pOverlay;
-        p1->pOverlay = p2->pOverlay;
-        p2->pOverlay = temp;
-      }
-    }
-  }
+
+  // keep the file order of events starting at the same time
+  std::stable_sort(m_overlays.begin(), m_overlays.end(), StartsBefore);
+
+  m_maxStop.resize(m_overlays.size());
+  if (!m_overlays.empty())
+    BuildIndex(0, m_overlays.size());
+
+  m_sorted = true;
+  m_seek = true;
+}
+
+double CDVDSubtitleLineCollection::BuildIndex(size_t lo, size_t hi)
+{
+  size_t mid = lo + (hi - lo) / 2;
+  double maxStop = m_overlays[mid]->iPTSStopTime;
+  if (lo < mid)
+    maxStop = std::max(maxStop, BuildIndex(lo, mid));
+  if (mid + 1 < hi)
+    maxStop = std::max(maxStop, BuildIndex(mid + 1, hi));
+
+  m_maxStop[mid] = maxStop;
+  return maxStop;
+}
+
+void CDVDSubtitleLineCollection::FindOverlapping(double iPts, size_t first, size_t lo, size_t hi, std::vector<size_t> &found) const
+{
+  if (lo >= hi || hi <= first)
+    return;
+
+  // everything in this range has stopped already
+  size_t mid = lo + (hi - lo) / 2;
+  if (m_maxStop[mid] < iPts)
+    return;
+
+  if (first < mid)
+    FindOverlapping(iPts, first, lo, mid, found);
+
+  // the upper half starts even later
+  if (m_overlays[mid]->iPTSStartTime > iPts)
+    return;
+
+  if (mid >= first && m_overlays[mid]->iPTSStopTime >= iPts)
+    found.push_back(mid);
+
+  FindOverlapping(iPts, first, mid + 1, hi, found);
+}
+
+void CDVDSubtitleLineCollection::Seek(double iPts, size_t first)
+{
+  m_showing.clear();
+  m_showingPos = 0;
+  FindOverlapping(iPts, first, 0, m_overlays.size(), m_showing);
+
+  m_current = std::upper_bound(m_overlays.begin() + first, m_overlays.end(), iPts, StartsAfter) - m_overlays.begin();
+  m_seek = false;
 }
 
 CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
 {
-  CDVDOverlay* pOverlay = NULL;
+  Sort();
+
+  if (m_seek)
+    Seek(iPts, 0);
 
-  if (m_pCurrent)
+  while (true)
   {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
+    // the overlays already showing come first
+    while (m_showingPos < m_showing.size())
     {
-      m_pCurrent = m_pCurrent->pNext;
+      CDVDOverlay* pOverlay = m_overlays[m_showing[m_showingPos++]];
+      if (pOverlay->iPTSStopTime >= iPts)
+        return pOverlay;
     }
 
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
+    if (m_current >= m_overlays.size())
+      return NULL;
 
+    CDVDOverlay* pOverlay = m_overlays[m_current];
+    if (pOverlay->iPTSStopTime >= iPts)
+    {
       // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
+      m_current++;
+      return pOverlay;
     }
+
+    // playback moved past the next overlay, look up where it is now instead of walking there
+    if (pOverlay->iPTSStartTime <= iPts)
+      Seek(iPts, m_current + 1);
+    else
+      m_current++;
   }
-  return pOverlay;
+}
+
+void CDVDSubtitleLineCollection::GetOverlapping(double iPts, std::vector<CDVDOverlay*> &overlays)
+{
+  Sort();
+
+  std::vector<size_t> found;
+  FindOverlapping(iPts, 0, 0, m_overlays.size(), found);
+
+  overlays.clear();
+  for (std::vector<size_t>::const_iterator it = found.begin(); it != found.end(); ++it)
+    overlays.push_back(m_overlays[*it]);
 }
 
 void CDVDSubtitleLineCollection::Reset()
 {
-  m_pCurrent = m_pHead;
+  m_seek = true;
 }
 
 void CDVDSubtitleLineCollection::Clear()
 {
-  ListElement* pElement = NULL;
-
-  while (m_pHead)
-  {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
-
-    pElement->pOverlay->Release();
-    delete pElement;
-  }
-
-  m_pTail    = NULL;
-  m_pHead    = NULL;
-  m_pCurrent = NULL;
-  m_iSize    = 0;
+  for (std::vector<CDVDOverlay*>::iterator it = m_overlays.begin(); it != m_overlays.end(); ++it)
+    (*it)->Release();
+
+  m_overlays.clear();
+  m_maxStop.clear();
+  m_showing.clear();
+  m_sorted     = true;
+  m_seek       = true;
+  m_showingPos = 0;
+  m_current    = 0;
+  m_iSize      = 0;
 }
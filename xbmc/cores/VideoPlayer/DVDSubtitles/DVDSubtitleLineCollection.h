@@ -22,39 +22,62 @@
 
 #include "../DVDCodecs/Overlay/DVDOverlay.h"
 
-typedef struct stListElement
-{
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
+#include <stddef.h>
+#include <vector>
 
-} ListElement;
+/*!
+ \brief The events of a subtitle file, ordered by start time
 
+ Events are kept in an array sorted by start time. The array doubles as an
+ implicit interval tree: the middle element of every range is the root of
+ its two halves and knows the latest stop time below it. That way the events
+ showing at any pts are found without walking the whole file, which keeps
+ seeking in files with many thousands of events fast.
+ */
 class CDVDSubtitleLineCollection
 {
 public:
   CDVDSubtitleLineCollection();
   virtual ~CDVDSubtitleLineCollection();
 
-  //void Lock()   { EnterCriticalSection(&m_critSection); }
-  //void Unlock() { LeaveCriticalSection(&m_critSection); }
-
   void Add(CDVDOverlay* pSubtitle);
+
+  /*!
+   \brief Sort and index the events, done on first use if the parser doesn't
+   */
   void Sort();
 
-  CDVDOverlay* Get(double iPts = 0LL); // get the first overlay in this fifo
+  /*!
+   \brief Get the next overlay that hasn't stopped at iPts
+   Successive calls return the overlays showing at iPts followed by the ones
+   starting later, ordered by start time. Reset() starts over at the next pts.
+   */
+  CDVDOverlay* Get(double iPts = 0LL);
+
+  /*!
+   \brief Get all overlays showing at iPts, ordered by start time
+   The overlays remain owned by the collection.
+   */
+  void GetOverlapping(double iPts, std::vector<CDVDOverlay*> &overlays);
 
   void Reset();
 
-  void Remove();
   void Clear();
   int GetSize() { return m_iSize; }
 
 private:
-  ListElement* m_pHead;
-  ListElement* m_pCurrent;
-  ListElement* m_pTail;
+  double BuildIndex(size_t lo, size_t hi);
+  void FindOverlapping(double iPts, size_t first, size_t lo, size_t hi, std::vector<size_t> &found) const;
+  void Seek(double iPts, size_t first);
+
+  std::vector<CDVDOverlay*> m_overlays; // sorted by start time if m_sorted
+  std::vector<double> m_maxStop;        // latest stop time in the range each element is the root of
+  bool m_sorted;
+
+  bool m_seek;                          // look up the position of the next Get() in the index
+  std::vector<size_t> m_showing;        // overlays showing at the last looked up position
+  size_t m_showingPos;                  // next of them to return
+  size_t m_current;                     // first overlay starting after the last looked up position
 
   int m_iSize;
-  //CRITICAL_SECTION m_critSection;
 };
-
@@ -27,8 +27,77 @@
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "guilib/GraphicContext.h"
 
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <vector>
+
+// how far ahead of playback the worker renders, at normal speed
+#define LOOKAHEAD_MS 1000
+// bitmap memory of the pre-rendered frames of one track
+#define CACHE_MAX_BYTES (32 * 1024 * 1024)
+// a larger jump of the pts is a seek
+#define SEEK_MS 2000
+
+static std::atomic<uint64_t> g_cacheHits(0);
+static std::atomic<uint64_t> g_cacheMisses(0);
+static std::atomic<uint64_t> g_cacheBytes(0);
+
+/*! \brief Copy of the images of a frame, ass_render_frame reuses its own on the next call */
+class CDVDSubtitlesLibass::CImages
+{
+public:
+  explicit CImages(ASS_Image* images)
+  {
+    size_t bytes = 0;
+    for (ASS_Image* img = images; img; img = img->next)
+      bytes += BitmapSize(img);
+    m_bitmaps.resize(bytes);
+
+    size_t offset = 0;
+    for (ASS_Image* img = images; img; img = img->next)
+    {
+      ASS_Image copy = *img;
+      size_t size = BitmapSize(img);
+      copy.bitmap = NULL;
+      if (size)
+      {
+        memcpy(&m_bitmaps[offset], img->bitmap, size);
+        copy.bitmap = &m_bitmaps[offset];
+        offset += size;
+      }
+      m_images.push_back(copy);
+    }
+    for (size_t i = 0; i < m_images.size(); i++)
+      m_images[i].next = i + 1 < m_images.size() ? &m_images[i + 1] : NULL;
+  }
+
+  ASS_Image* Get() { return m_images.empty() ? NULL : &m_images[0]; }
+  size_t GetSize() const { return m_bitmaps.size() + m_images.size() * sizeof(ASS_Image); }
+
+private:
+  static size_t BitmapSize(const ASS_Image* img)
+  {
+    if (img->w <= 0 || img->h <= 0)
+      return 0;
+    return (size_t)img->stride * (img->h - 1) + img->w;
+  }
+
+  std::vector<ASS_Image> m_images;
+  std::vector<unsigned char> m_bitmaps;
+};
+
+bool CDVDSubtitlesLibass::RenderParams::operator==(const RenderParams& right) const
+{
+  return frameWidth == right.frameWidth && frameHeight == right.frameHeight &&
+         videoWidth == right.videoWidth && videoHeight == right.videoHeight &&
+         useMargin == right.useMargin && position == right.position &&
+         pixelRatio == right.pixelRatio;
+}
+
 static void libass_log(int level, const char *fmt, va_list args, void *data)
 {
   if(level >= 5)
@@ -38,6 +107,7 @@ static void libass_log(int level, const char *fmt, va_list args, void *data)
 }
 
 CDVDSubtitlesLibass::CDVDSubtitlesLibass()
+  : CThread("LibassRenderer")
 {
 
   m_track = NULL;
@@ -45,6 +115,15 @@ CDVDSubtitlesLibass::CDVDSubtitlesLibass()
   m_renderer = NULL;
   m_references = 1;
 
+  m_cacheBytes = 0;
+  m_params = RenderParams();
+  m_lastParams = RenderParams();
+  m_playPts = 0.0;
+  m_step = 0.0;
+  m_speed = 1.0;
+  m_playTime = 0;
+  m_playing = false;
+
   if(!m_dll.Load())
   {
     CLog::Log(LOGERROR, "CDVDSubtitlesLibass: Failed to load libass library");
@@ -93,6 +172,11 @@ CDVDSubtitlesLibass::CDVDSubtitlesLibass()
 
 CDVDSubtitlesLibass::~CDVDSubtitlesLibass()
 {
+  StopThread();
+  ClearCache();
+  m_shown.reset();
+  m_lastImages.reset();
+
   if(m_dll.IsLoaded())
   {
     if(m_track)
@@ -117,6 +201,9 @@ bool CDVDSubtitlesLibass::DecodeHeader(char* data, int size)
   }
 
   m_dll.ass_process_codec_private(m_track, data, size);
+
+  CSingleLock cacheLock(m_cacheSection);
+  ClearCache();
   return true;
 }
 
@@ -130,6 +217,10 @@ bool CDVDSubtitlesLibass::DecodeDemuxPkt(char* data, int size, double start, dou
   }
 
   m_dll.ass_process_chunk(m_track, data, size, DVD_TIME_TO_MSEC(start), DVD_TIME_TO_MSEC(duration));
+
+  // frames rendered before the event arrived miss it
+  CSingleLock cacheLock(m_cacheSection);
+  ClearCache(start, start + duration);
   return true;
 }
 
@@ -148,27 +239,247 @@ bool CDVDSubtitlesLibass::CreateTrack(char* buf, size_t size)
   if(m_track == NULL)
     return false;
 
+  CSingleLock cacheLock(m_cacheSection);
+  ClearCache();
   return true;
 }
 
 ASS_Image* CDVDSubtitlesLibass::RenderImage(int frameWidth, int frameHeight, int videoWidth, int videoHeight, double pts, int useMargin, double position, int *changes)
 {
-  CSingleLock lock(m_section);
-  if(!m_renderer || !m_track)
+  if(!m_renderer)
   {
     CLog::Log(LOGERROR, "CDVDSubtitlesLibass: %s - Missing ASS structs(m_track or m_renderer)", __FUNCTION__);
     return NULL;
   }
 
-  double storage_aspact = (double)frameWidth / frameHeight;
-  m_dll.ass_set_frame_size(m_renderer, frameWidth, frameHeight);
-  int topmargin = (frameHeight - videoHeight) / 2;
-  int leftmargin = (frameWidth - videoWidth) / 2;
+  RenderParams params;
+  params.frameWidth = frameWidth;
+  params.frameHeight = frameHeight;
+  params.videoWidth = videoWidth;
+  params.videoHeight = videoHeight;
+  params.useMargin = useMargin;
+  params.position = position;
+  params.pixelRatio = g_graphicsContext.GetResInfo().fPixelRatio;
+
+  std::shared_ptr<CImages> images;
+  {
+    CSingleLock lock(m_cacheSection);
+    if (params != m_params)
+    {
+      ClearCache();
+      m_params = params;
+    }
+
+    // follow playback, the worker renders the frames after this one
+    unsigned int now = XbmcThreads::SystemClockMillis();
+    if (m_playing)
+    {
+      double delta = pts - m_playPts;
+      if (delta < 0.0 || delta > DVD_MSEC_TO_TIME(SEEK_MS))
+      {
+        ClearCache();
+        m_step = 0.0;
+      }
+      else if (delta > 0.0)
+      {
+        m_step = delta;
+        if (now != m_playTime)
+          m_speed = 0.9 * m_speed + 0.1 * delta / DVD_MSEC_TO_TIME(now - m_playTime);
+      }
+    }
+    m_playPts = pts;
+    m_playTime = now;
+    m_playing = true;
+
+    CacheMap::iterator it = FindEntry(pts);
+    if (it != m_cache.end())
+      images = it->second.images;
+  }
+
+  if (images)
+    g_cacheHits++;
+  else
+  {
+    g_cacheMisses++;
+    CSingleLock lock(m_section);
+    if(!m_track)
+    {
+      CLog::Log(LOGERROR, "CDVDSubtitlesLibass: %s - Missing ASS structs(m_track or m_renderer)", __FUNCTION__);
+      return NULL;
+    }
+    images = Render(params, pts);
+  }
+
+  if (!IsRunning())
+    Create();
+  m_workEvent.Set();
+
+  CSingleLock lock(m_cacheSection);
+  if (changes)
+    *changes = images == m_shown ? 0 : 2;
+  m_shown = images;
+  return images->Get();
+}
+
+LibassCacheStats CDVDSubtitlesLibass::GetCacheStats()
+{
+  LibassCacheStats stats;
+  stats.hits = g_cacheHits;
+  stats.misses = g_cacheMisses;
+  stats.cachedBytes = g_cacheBytes;
+  return stats;
+}
+
+void CDVDSubtitlesLibass::Process()
+{
+  SetPriority(GetMinPriority());
+
+  while (!m_bStop)
+  {
+    RenderParams params;
+    double pts;
+    {
+      CSingleLock lock(m_cacheSection);
+      Trim();
+      if (!GetNextPts(pts))
+      {
+        lock.Leave();
+        m_workEvent.Wait();
+        continue;
+      }
+      params = m_params;
+    }
+
+    CSingleLock lock(m_section);
+    if (m_track)
+      Render(params, pts);
+  }
+}
+
+void CDVDSubtitlesLibass::StopThread(bool bWait /*= true*/)
+{
+  m_bStop = true;
+  m_workEvent.Set();
+  CThread::StopThread(bWait);
+}
+
+std::shared_ptr<CDVDSubtitlesLibass::CImages> CDVDSubtitlesLibass::Render(const RenderParams& params, double pts)
+{
+  double storage_aspact = (double)params.frameWidth / params.frameHeight;
+  m_dll.ass_set_frame_size(m_renderer, params.frameWidth, params.frameHeight);
+  int topmargin = (params.frameHeight - params.videoHeight) / 2;
+  int leftmargin = (params.frameWidth - params.videoWidth) / 2;
   m_dll.ass_set_margins(m_renderer, topmargin, topmargin, leftmargin, leftmargin);
-  m_dll.ass_set_use_margins(m_renderer, useMargin);
-  m_dll.ass_set_line_position(m_renderer, position);
-  m_dll.ass_set_aspect_ratio(m_renderer, storage_aspact / g_graphicsContext.GetResInfo().fPixelRatio, storage_aspact);
-  return m_dll.ass_render_frame(m_renderer, m_track, DVD_TIME_TO_MSEC(pts), changes);
+  m_dll.ass_set_use_margins(m_renderer, params.useMargin);
+  m_dll.ass_set_line_position(m_renderer, params.position);
+  m_dll.ass_set_aspect_ratio(m_renderer, storage_aspact / params.pixelRatio, storage_aspact);
+
+  int changes = 0;
+  ASS_Image* images = m_dll.ass_render_frame(m_renderer, m_track, DVD_TIME_TO_MSEC(pts), &changes);
+
+  // identical frames share their copy, which lets the cache merge them
+  if (changes != 0 || !m_lastImages || params != m_lastParams)
+    m_lastImages.reset(new CImages(images));
+  m_lastParams = params;
+
+  AddEntry(params, pts, m_lastImages);
+  return m_lastImages;
+}
+
+CDVDSubtitlesLibass::CacheMap::iterator CDVDSubtitlesLibass::FindEntry(double pts)
+{
+  CacheMap::iterator it = m_cache.upper_bound(pts);
+  if (it == m_cache.begin())
+    return m_cache.end();
+  --it;
+  if (it->second.stop < pts)
+    return m_cache.end();
+  return it;
+}
+
+bool CDVDSubtitlesLibass::GetNextPts(double& pts)
+{
+  if (!m_playing || m_step <= 0.0 || m_cacheBytes >= CACHE_MAX_BYTES)
+    return false;
+
+  // the first frame after the ones rendered already
+  double next = m_playPts;
+  for (CacheMap::iterator it = FindEntry(next); it != m_cache.end(); it = FindEntry(next))
+    next = it->second.stop + m_step;
+
+  if (next > m_playPts + DVD_MSEC_TO_TIME(LOOKAHEAD_MS) * std::max(1.0, m_speed))
+    return false;
+
+  pts = next;
+  return true;
+}
+
+void CDVDSubtitlesLibass::AddEntry(const RenderParams& params, double pts, const std::shared_ptr<CImages>& images)
+{
+  CSingleLock lock(m_cacheSection);
+  if (params != m_params)
+    return;
+
+  CacheMap::iterator next = m_cache.lower_bound(pts);
+  if (next != m_cache.end() && next->first == pts)
+    return;
+
+  if (next != m_cache.begin())
+  {
+    CacheMap::iterator prev = next;
+    --prev;
+    if (prev->second.stop >= pts)
+      return;
+
+    // the same images one frame later, they are shown in between as well
+    if (prev->second.images == images && m_step > 0.0 && pts - prev->second.stop <= m_step * 1.5)
+    {
+      prev->second.stop = pts;
+      return;
+    }
+  }
+
+  CacheEntry entry;
+  entry.stop = pts;
+  entry.images = images;
+  m_cache.insert(next, std::make_pair(pts, entry));
+
+  size_t size = images->GetSize();
+  m_cacheBytes += size;
+  g_cacheBytes += size;
+}
+
+void CDVDSubtitlesLibass::EraseEntry(CacheMap::iterator it)
+{
+  size_t size = it->second.images->GetSize();
+  m_cacheBytes -= size;
+  g_cacheBytes -= size;
+  m_cache.erase(it);
+}
+
+void CDVDSubtitlesLibass::Trim()
+{
+  while (!m_cache.empty() && m_cache.begin()->second.stop < m_playPts)
+    EraseEntry(m_cache.begin());
+}
+
+void CDVDSubtitlesLibass::ClearCache()
+{
+  m_cache.clear();
+  g_cacheBytes -= m_cacheBytes;
+  m_cacheBytes = 0;
+}
+
+void CDVDSubtitlesLibass::ClearCache(double start, double stop)
+{
+  CacheMap::iterator it = m_cache.begin();
+  while (it != m_cache.end() && it->first <= stop)
+  {
+    if (it->second.stop >= start)
+      EraseEntry(it++);
+    else
+      ++it;
+  }
 }
 
 ASS_Event* CDVDSubtitlesLibass::GetEvents()
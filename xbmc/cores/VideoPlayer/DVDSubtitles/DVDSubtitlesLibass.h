@@ -23,15 +23,35 @@
 #include "DllLibass.h"
 #include "DVDResource.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+
+struct LibassCacheStats
+{
+  uint64_t hits;        // frames served from the pre-rendered cache
+  uint64_t misses;      // frames rendered on demand by the caller
+  uint64_t cachedBytes; // bitmap bytes currently held by the caches
+};
 
 /** Wrapper for Libass **/
 
-class CDVDSubtitlesLibass : public IDVDResourceCounted<CDVDSubtitlesLibass>
+class CDVDSubtitlesLibass : public IDVDResourceCounted<CDVDSubtitlesLibass>, private CThread
 {
 public:
   CDVDSubtitlesLibass();
   virtual ~CDVDSubtitlesLibass();
 
+  /*!
+   \brief Get the rendered subtitles at pts
+   Frames are rendered ahead of playback on a worker thread, guessing the
+   upcoming pts from the previous calls. The returned images stay valid
+   until the next call.
+   \param changes set to 0 if the images are the same as the ones returned by the previous call
+   */
   ASS_Image* RenderImage(int frameWidth, int frameHeight, int videoWidth, int videoHeight, double pts, int useMargin = 0, double position = 0.0, int* changes = NULL);
   ASS_Event* GetEvents();
 
@@ -41,12 +61,72 @@ public:
   bool DecodeDemuxPkt(char* data, int size, double start, double duration);
   bool CreateTrack(char* buf, size_t size);
 
+  /*!
+   \brief Get the counters of the pre-rendered caches of all instances
+   */
+  static LibassCacheStats GetCacheStats();
+
+protected:
+  virtual void Process();
+  virtual void StopThread(bool bWait = true);
+
 private:
+  class CImages;
+
+  struct RenderParams
+  {
+    int frameWidth;
+    int frameHeight;
+    int videoWidth;
+    int videoHeight;
+    int useMargin;
+    double position;
+    float pixelRatio;
+
+    bool operator==(const RenderParams& right) const;
+    bool operator!=(const RenderParams& right) const { return !(*this == right); }
+  };
+
+  // rendered images, valid from the start pts (key of the map) up to stop
+  struct CacheEntry
+  {
+    double stop;
+    std::shared_ptr<CImages> images;
+  };
+  typedef std::map<double, CacheEntry> CacheMap;
+
+  std::shared_ptr<CImages> Render(const RenderParams& params, double pts);
+  CacheMap::iterator FindEntry(double pts);
+  bool GetNextPts(double& pts);
+  void AddEntry(const RenderParams& params, double pts, const std::shared_ptr<CImages>& images);
+  void EraseEntry(CacheMap::iterator it);
+  void Trim();
+  void ClearCache();
+  void ClearCache(double start, double stop);
+
   DllLibass m_dll;
   long m_references;
   ASS_Library* m_library;
   ASS_Track* m_track;
   ASS_Renderer* m_renderer;
   CCriticalSection m_section;
+
+  // pre-rendered frames, guarded by m_cacheSection which is never held
+  // while waiting for m_section so that hits don't wait for the worker
+  CCriticalSection m_cacheSection;
+  CEvent m_workEvent;
+  CacheMap m_cache;
+  size_t m_cacheBytes;
+  RenderParams m_params;
+  std::shared_ptr<CImages> m_shown;
+  double m_playPts;
+  double m_step;
+  double m_speed;
+  unsigned int m_playTime;
+  bool m_playing;
+
+  // last frame rendered by libass, libass reports changes relative to it
+  RenderParams m_lastParams;
+  std::shared_ptr<CImages> m_lastImages;
 };
 
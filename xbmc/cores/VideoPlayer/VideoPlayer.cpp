@@ -32,6 +32,7 @@
 #include "DVDDemuxers/DVDDemuxVobsub.h"
 #include "DVDDemuxers/DVDFactoryDemuxer.h"
 #include "DVDDemuxers/DVDDemuxFFmpeg.h"
+#include "DVDSubtitles/DVDSubtitlesLibass.h"
 
 #include "DVDFileInfo.h"
 
@@ -3253,6 +3254,19 @@ void CVideoPlayer::GetGeneralInfo(std::string& strGeneralInfo)
           strBuf += StringUtils::Format(" %d msec", DVD_TIME_TO_MSEC(m_State.cache_delay));
       }
 
+      DemuxPacketStats pktStats = CDVDDemuxUtils::GetPacketStats();
+      strBuf += StringUtils::Format(", pkt:%llu %2.0f%% pool:%s"
+                                    , (unsigned long long)pktStats.live
+                                    , pktStats.allocations ? 100.0 * pktStats.poolHits / pktStats.allocations : 0.0
+                                    , StringUtils::SizeToString(pktStats.pooledBytes).c_str());
+
+      LibassCacheStats assStats = CDVDSubtitlesLibass::GetCacheStats();
+      if (assStats.hits + assStats.misses > 0)
+        strBuf += StringUtils::Format(", ass hit:%llu miss:%llu %s"
+                                      , (unsigned long long)assStats.hits
+                                      , (unsigned long long)assStats.misses
+                                      , StringUtils::SizeToString(assStats.cachedBytes).c_str());
+
       strGeneralInfo = StringUtils::Format("Player: a/v:% 6.3f, %s"
                                            , dDiff
                                            , strBuf.c_str());
@@ -0,0 +1,218 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDMessageQueue.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class TestDVDMessageQueue : public ::testing::TestWithParam<bool>
+{
+protected:
+  TestDVDMessageQueue() : queue("test")
+  {
+    queue.SetLockFree(GetParam());
+    queue.Init();
+  }
+
+  int GetValue()
+  {
+    CDVDMsg* msg = NULL;
+    if (queue.Get(&msg, 0) != MSGQ_OK)
+      return -1;
+    int value = static_cast<CDVDMsgInt*>(msg)->m_value;
+    msg->Release();
+    return value;
+  }
+
+  void PutPacket(int size)
+  {
+    DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+    packet->iSize = size;
+    queue.Put(new CDVDMsgDemuxerPacket(packet));
+  }
+
+  bool GetPacket()
+  {
+    CDVDMsg* msg = NULL;
+    if (queue.Get(&msg, 0) != MSGQ_OK)
+      return false;
+    msg->Release();
+    return true;
+  }
+
+  CDVDMessageQueue queue;
+};
+
+TEST_P(TestDVDMessageQueue, FirstInFirstOut)
+{
+  for (int i = 0; i < 10; i++)
+    queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+
+  for (int i = 0; i < 10; i++)
+    EXPECT_EQ(i, GetValue());
+  EXPECT_EQ(-1, GetValue());
+}
+
+TEST_P(TestDVDMessageQueue, Priority)
+{
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 1));
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 2));
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 3), 0, false);
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 4), 1);
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 5), 10);
+
+  CDVDMsg* msg = NULL;
+  int priority = 5;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_EQ(5, static_cast<CDVDMsgInt*>(msg)->m_value);
+  EXPECT_EQ(10, priority);
+  msg->Release();
+
+  priority = 5;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+
+  EXPECT_EQ(4, GetValue());
+  EXPECT_EQ(3, GetValue());
+  EXPECT_EQ(1, GetValue());
+  EXPECT_EQ(2, GetValue());
+}
+
+TEST_P(TestDVDMessageQueue, Flush)
+{
+  for (int i = 0; i < 10; i++)
+  {
+    queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+    queue.Put(new CDVDMsgInt(CDVDMsg::PLAYER_SETSPEED, i));
+  }
+  EXPECT_EQ(10U, queue.GetPacketCount(CDVDMsg::PLAYER_SETSPEED));
+
+  queue.Flush(CDVDMsg::PLAYER_SETSPEED);
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::PLAYER_SETSPEED));
+  EXPECT_EQ(10U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  for (int i = 0; i < 10; i++)
+    EXPECT_EQ(i, GetValue());
+}
+
+TEST_P(TestDVDMessageQueue, Overflow)
+{
+  // more messages than the lock-free ring holds
+  const int count = 10000;
+  for (int i = 0; i < count; i++)
+    queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+
+  for (int i = 0; i < count; i++)
+    ASSERT_EQ(i, GetValue());
+}
+
+TEST_P(TestDVDMessageQueue, MultipleProducers)
+{
+  const int producers = 4;
+  const int count = 20000;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++)
+  {
+    threads.push_back(std::thread([this, p, count]() {
+      for (int i = 0; i < count; i++)
+        queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, p * count + i));
+    }));
+  }
+
+  // messages of each producer have to arrive in order
+  std::vector<int> last(producers, -1);
+  for (int received = 0; received < producers * count; received++)
+  {
+    CDVDMsg* msg = NULL;
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 5000));
+    int value = static_cast<CDVDMsgInt*>(msg)->m_value;
+    msg->Release();
+
+    int p = value / count;
+    EXPECT_LT(last[p], value % count);
+    last[p] = value % count;
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+}
+
+TEST_P(TestDVDMessageQueue, DataSize)
+{
+  for (int i = 0; i < 10; i++)
+    PutPacket(100);
+  EXPECT_EQ(1000, queue.GetDataSize());
+
+  ASSERT_TRUE(GetPacket());
+  EXPECT_EQ(900, queue.GetDataSize());
+
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_FALSE(GetPacket());
+
+  for (int i = 0; i < 5; i++)
+    PutPacket(100);
+  EXPECT_EQ(500, queue.GetDataSize());
+  for (int i = 0; i < 5; i++)
+    ASSERT_TRUE(GetPacket());
+  EXPECT_EQ(0, queue.GetDataSize());
+}
+
+TEST_P(TestDVDMessageQueue, FlushWhilePutting)
+{
+  const int producers = 2;
+  const int count = 20000;
+
+  std::atomic<int> running(producers);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++)
+  {
+    threads.push_back(std::thread([this, &running, count]() {
+      for (int i = 0; i < count; i++)
+        PutPacket(10);
+      running--;
+    }));
+  }
+
+  // packets put around a flush must neither be counted twice nor go
+  // negative once the consumer gets them
+  for (int i = 0; running > 0; i++)
+  {
+    if (i % 100 == 0)
+      queue.Flush();
+    else
+      GetPacket();
+    EXPECT_GE(queue.GetDataSize(), 0);
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  while (GetPacket())
+    ;
+  EXPECT_EQ(0, queue.GetDataSize());
+}
+
+INSTANTIATE_TEST_CASE_P(LockedAndLockFree, TestDVDMessageQueue, ::testing::Bool());
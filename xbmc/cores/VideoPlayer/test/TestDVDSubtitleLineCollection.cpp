@@ -0,0 +1,179 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDSubtitles/DVDSubtitleLineCollection.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+CDVDOverlay* MakeOverlay(double start, double stop)
+{
+  CDVDOverlay* overlay = new CDVDOverlay(DVDOVERLAY_TYPE_TEXT);
+  overlay->iPTSStartTime = start;
+  overlay->iPTSStopTime = stop;
+  return overlay;
+}
+
+bool StartsBefore(const CDVDOverlay* first, const CDVDOverlay* second)
+{
+  return first->iPTSStartTime < second->iPTSStartTime;
+}
+
+// the linear cursor the index replaces
+class CReferenceCollection
+{
+public:
+  explicit CReferenceCollection(std::vector<CDVDOverlay*> overlays)
+    : m_overlays(overlays), m_current(0)
+  {
+    std::stable_sort(m_overlays.begin(), m_overlays.end(), StartsBefore);
+  }
+
+  CDVDOverlay* Get(double pts)
+  {
+    while (m_current < m_overlays.size() && m_overlays[m_current]->iPTSStopTime < pts)
+      m_current++;
+    if (m_current < m_overlays.size())
+      return m_overlays[m_current++];
+    return NULL;
+  }
+
+  void Reset() { m_current = 0; }
+
+private:
+  std::vector<CDVDOverlay*> m_overlays;
+  size_t m_current;
+};
+
+// karaoke like: many short events, some long ones spanning them
+std::vector<CDVDOverlay*> RandomOverlays(unsigned int count, unsigned int seed)
+{
+  srand(seed);
+  std::vector<CDVDOverlay*> overlays;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    double start = rand() % 10000;
+    double length = (i % 10 == 0) ? rand() % 3000 : rand() % 50;
+    overlays.push_back(MakeOverlay(start, start + length));
+  }
+  return overlays;
+}
+}
+
+TEST(TestDVDSubtitleLineCollection, SortsByStart)
+{
+  CDVDSubtitleLineCollection collection;
+  collection.Add(MakeOverlay(300, 400));
+  collection.Add(MakeOverlay(100, 200));
+  collection.Add(MakeOverlay(200, 300));
+  EXPECT_EQ(3, collection.GetSize());
+
+  // no Sort(), like the parsers that add events in file order
+  EXPECT_EQ(100, collection.Get(0)->iPTSStartTime);
+  EXPECT_EQ(200, collection.Get(0)->iPTSStartTime);
+  EXPECT_EQ(300, collection.Get(0)->iPTSStartTime);
+  EXPECT_TRUE(collection.Get(0) == NULL);
+
+  collection.Clear();
+  EXPECT_EQ(0, collection.GetSize());
+  EXPECT_TRUE(collection.Get(0) == NULL);
+}
+
+TEST(TestDVDSubtitleLineCollection, Overlapping)
+{
+  CDVDSubtitleLineCollection collection;
+  collection.Add(MakeOverlay(0, 1000));
+  collection.Add(MakeOverlay(100, 150));
+  collection.Add(MakeOverlay(120, 130));
+  collection.Add(MakeOverlay(140, 200));
+  collection.Add(MakeOverlay(500, 600));
+  collection.Sort();
+
+  std::vector<CDVDOverlay*> overlays;
+  collection.GetOverlapping(125, overlays);
+  ASSERT_EQ(3u, overlays.size());
+  EXPECT_EQ(0, overlays[0]->iPTSStartTime);
+  EXPECT_EQ(100, overlays[1]->iPTSStartTime);
+  EXPECT_EQ(120, overlays[2]->iPTSStartTime);
+
+  collection.GetOverlapping(700, overlays);
+  ASSERT_EQ(1u, overlays.size());
+  EXPECT_EQ(0, overlays[0]->iPTSStartTime);
+
+  collection.GetOverlapping(2000, overlays);
+  EXPECT_TRUE(overlays.empty());
+
+  // showing ones first, then the ones to come
+  collection.Reset();
+  EXPECT_EQ(0, collection.Get(145)->iPTSStartTime);
+  EXPECT_EQ(100, collection.Get(145)->iPTSStartTime);
+  EXPECT_EQ(140, collection.Get(145)->iPTSStartTime);
+  EXPECT_EQ(500, collection.Get(145)->iPTSStartTime);
+  EXPECT_TRUE(collection.Get(145) == NULL);
+}
+
+TEST(TestDVDSubtitleLineCollection, MatchesLinearSearch)
+{
+  std::vector<CDVDOverlay*> overlays = RandomOverlays(2000, 1);
+
+  CDVDSubtitleLineCollection collection;
+  for (std::vector<CDVDOverlay*>::iterator it = overlays.begin(); it != overlays.end(); ++it)
+    collection.Add(*it);
+  collection.Sort();
+  CReferenceCollection reference(overlays);
+
+  srand(2);
+  double pts = 0;
+  for (int i = 0; i < 3000; i++)
+  {
+    int action = rand() % 10;
+    if (action == 0)
+    {
+      // seek back
+      pts = rand() % 11000;
+      collection.Reset();
+      reference.Reset();
+    }
+    else if (action == 1)
+      pts += rand() % 2000; // jump forward
+    else
+      pts += rand() % 20;
+
+    CDVDOverlay* expected = reference.Get(pts);
+    CDVDOverlay* actual = collection.Get(pts);
+    ASSERT_EQ(expected, actual) << "step " << i << " pts " << pts;
+
+    std::vector<CDVDOverlay*> showing;
+    collection.GetOverlapping(pts, showing);
+    std::vector<CDVDOverlay*> brute;
+    for (std::vector<CDVDOverlay*>::iterator it = overlays.begin(); it != overlays.end(); ++it)
+    {
+      if ((*it)->iPTSStartTime <= pts && (*it)->iPTSStopTime >= pts)
+        brute.push_back(*it);
+    }
+    std::stable_sort(brute.begin(), brute.end(), StartsBefore);
+    ASSERT_EQ(brute, showing) << "pts " << pts;
+  }
+}
@@ -64,7 +64,7 @@ void CAudioDecoder::Destroy()
   m_canPlay = false;
 }
 
-bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
+bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferTime)
 {
   Destroy();
 
@@ -100,8 +100,10 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     return false;
   }
 
-  /* allocate the pcmBuffer for 2 seconds of audio */
-  m_pcmBuffer.Create(2 * blockSize * m_codec->m_format.m_sampleRate);
+  /* allocate the pcmBuffer for bufferTime ms of audio */
+  uint64_t bufferSize = (uint64_t)blockSize * m_codec->m_format.m_sampleRate * bufferTime / 1000;
+  bufferSize = std::min<uint64_t>(bufferSize, MAX_BUFFER_SIZE);
+  m_pcmBuffer.Create((unsigned int)(bufferSize - bufferSize % blockSize));
 
   if (file.HasMusicInfoTag())
   {
@@ -37,6 +37,9 @@ class CFileItem;
 #define OUTPUT_SAMPLES PACKET_SIZE      // max number of output samples
 #define INPUT_SAMPLES  PACKET_SIZE      // number of input samples (distributed over channels)
 
+#define BUFFER_TIME     2000                // ms of decoded audio we buffer by default
+#define MAX_BUFFER_SIZE (64 * 1024 * 1024)  // upper bound of the decoded audio buffer in bytes
+
 #define STATUS_NO_FILE  0
 #define STATUS_QUEUING  1
 #define STATUS_QUEUED   2
@@ -55,7 +58,11 @@ public:
   CAudioDecoder();
   ~CAudioDecoder();
 
-  bool Create(const CFileItem &file, int64_t seekOffset);
+  /*!
+   \brief Open the file and prepare decoding
+   \param bufferTime ms of decoded audio to buffer ahead of playback, limited to MAX_BUFFER_SIZE
+   */
+  bool Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferTime = BUFFER_TIME);
   void Destroy();
 
   int ReadSamples(int numsamples);
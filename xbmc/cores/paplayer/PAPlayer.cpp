@@ -25,8 +25,10 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "music/tags/MusicInfoTag.h"
+#include "URL.h"
 #include "utils/log.h"
 #include "utils/JobManager.h"
+#include "utils/StringUtils.h"
 
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
@@ -37,6 +39,8 @@
 #define TIME_TO_CACHE_NEXT_FILE 5000 /* 5 seconds before end of song, start caching the next song */
 #define FAST_XFADE_TIME           80 /* 80 milliseconds */
 #define MAX_SKIP_XFADE_TIME     2000 /* max 2 seconds crossfade on track skip */
+#define PRELOAD_XFADE_MARGIN    2000 /* preloaded audio exceeds the crossfade by at least 2 seconds */
+#define PRELOAD_HANDOVER_TIME   3000 /* max 3 seconds to wait for a preload that is opening the file */
 
 class CQueueNextFileJob : public CJob
 {
@@ -53,6 +57,22 @@ public:
   }
 };
 
+class CPreloadFileJob : public CJob
+{
+  CFileItem m_item;
+  std::shared_ptr<PAPlayer::PreloadState> m_state;
+  unsigned int m_bufferTime;
+
+public:
+                CPreloadFileJob(const CFileItem& item, const std::shared_ptr<PAPlayer::PreloadState> &state, unsigned int bufferTime)
+                  : m_item(item), m_state(state), m_bufferTime(bufferTime) {}
+  virtual       ~CPreloadFileJob() {}
+  virtual bool  DoWork();
+
+private:
+  bool Continue(const std::string &key);
+};
+
 // PAP: Psycho-acoustic Audio Player
 // Supporting all open  audio codec standards.
 // First one being nullsoft's nsv audio decoder format
@@ -73,7 +93,8 @@ PAPlayer::PAPlayer(IPlayerCallback& callback) :
   m_jobCounter         (0),
   m_continueStream     (false),
   m_newForcedPlayerTime(-1),
-  m_newForcedTotalTime (-1)
+  m_newForcedTotalTime (-1),
+  m_preload            (new PreloadState())
 {
   memset(&m_playerGUIData, 0, sizeof(m_playerGUIData));
   m_processInfo.reset(CProcessInfo::CreateInstance());
@@ -344,17 +365,21 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
     m_continueStream = false;
   }
 
-  StreamInfo *si = new StreamInfo();
-  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+  StreamInfo *si = TakePreloadedStream(file);
+  if (!si)
   {
-    CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
+    si = new StreamInfo();
+    if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+    {
+      CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
 
-    delete si;
-    // advance playlist
-    if (job)
-      m_callback.OnPlayBackStarted();
-    m_callback.OnQueueNextItem();
-    return false;
+      delete si;
+      // advance playlist
+      if (job)
+        m_callback.OnPlayBackStarted();
+      m_callback.OnQueueNextItem();
+      return false;
+    }
   }
 
   /* decode until there is data-available */
@@ -451,6 +476,186 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
   return true;
 }
 
+void PAPlayer::SetUpcomingFiles(const CFileItemList &files)
+{
+  std::vector<StreamInfo*> unused;
+  std::vector<CFileItemPtr> added;
+  {
+    CSingleLock lock(m_preload->m_lock);
+    PreloadMap &current = m_preload->m_preloads;
+    PreloadMap preloads;
+    for (int i = 0; i < files.Size(); i++)
+    {
+      const CFileItemPtr &file = files[i];
+      // cd drives don't like to be read ahead and cue sheet tracks continue the current stream
+      if (file->IsCDDA() || file->m_lStartOffset)
+        continue;
+
+      std::string key = GetPreloadKey(*file);
+      PreloadMap::iterator it = current.find(key);
+      if (it != current.end())
+      {
+        preloads.insert(*it);
+        current.erase(it);
+      }
+      else if (preloads.find(key) == preloads.end())
+      {
+        PreloadInfo info = { NULL, false, false };
+        preloads[key] = info;
+        added.push_back(file);
+      }
+    }
+
+    // files no longer upcoming, loading ones are discarded by their job
+    for (PreloadMap::iterator it = current.begin(); it != current.end(); ++it)
+    {
+      if (it->second.m_stream)
+        unused.push_back(it->second.m_stream);
+    }
+    current.swap(preloads);
+  }
+
+  for (std::vector<StreamInfo*>::iterator it = unused.begin(); it != unused.end(); ++it)
+  {
+    (*it)->m_decoder.Destroy();
+    delete *it;
+  }
+
+  // hold at least the crossfade so that the transition never waits for the source
+  unsigned int bufferTime = std::max<unsigned int>(g_advancedSettings.m_audioPreloadSeconds * 1000,
+                                                   m_defaultCrossfadeMS + PRELOAD_XFADE_MARGIN);
+
+  // the jobs only share the preload state, closing the player doesn't wait for them
+  for (std::vector<CFileItemPtr>::iterator it = added.begin(); it != added.end(); ++it)
+    CJobManager::GetInstance().AddJob(new CPreloadFileJob(**it, m_preload, bufferTime), NULL, CJob::PRIORITY_LOW);
+}
+
+std::string PAPlayer::GetPreloadKey(const CFileItem &file)
+{
+  return StringUtils::Format("%s|%" PRId64, file.GetPath().c_str(), file.m_lStartOffset);
+}
+
+bool CPreloadFileJob::DoWork()
+{
+  std::string key = PAPlayer::GetPreloadKey(m_item);
+  {
+    CSingleLock lock(m_state->m_lock);
+    PAPlayer::PreloadMap::iterator it = m_state->m_preloads.find(key);
+    if (it == m_state->m_preloads.end() || it->second.m_hurry)
+    {
+      // queued before we got to it, the player opens the file itself
+      if (it != m_state->m_preloads.end())
+        m_state->m_preloads.erase(it);
+      m_state->m_event.Set();
+      return false;
+    }
+    it->second.m_loading = true;
+  }
+
+  PAPlayer::StreamInfo *si = new PAPlayer::StreamInfo();
+  bool success = si->m_decoder.Create(m_item, (m_item.m_lStartOffset * 1000) / 75, m_bufferTime);
+  while (success && Continue(key))
+  {
+    int status = si->m_decoder.GetStatus();
+    if (status == STATUS_ENDING || status == STATUS_ENDED)
+      break;
+
+    int result = si->m_decoder.ReadSamples(PACKET_SIZE);
+    if (result == RET_ERROR)
+      success = false;
+    else if (result == RET_SLEEP)
+    {
+      // the buffer is full once the decoder stops reading
+      if (si->m_decoder.GetStatus() != STATUS_QUEUING)
+        break;
+      XbmcThreads::ThreadSleep(1);
+    }
+  }
+
+  CSingleLock lock(m_state->m_lock);
+  PAPlayer::PreloadMap::iterator it = m_state->m_preloads.find(key);
+  if (success && it != m_state->m_preloads.end())
+  {
+    CLog::Log(LOGDEBUG, "CPreloadFileJob::DoWork - Preloaded %s", CURL::GetRedacted(m_item.GetPath()).c_str());
+    it->second.m_stream = si;
+    si = NULL;
+  }
+  else if (it != m_state->m_preloads.end())
+  {
+    CLog::Log(LOGINFO, "CPreloadFileJob::DoWork - Failed to preload %s", CURL::GetRedacted(m_item.GetPath()).c_str());
+    m_state->m_preloads.erase(it);
+  }
+  m_state->m_event.Set();
+  lock.Leave();
+
+  if (si)
+  {
+    si->m_decoder.Destroy();
+    delete si;
+  }
+  return success;
+}
+
+bool CPreloadFileJob::Continue(const std::string &key)
+{
+  CSingleLock lock(m_state->m_lock);
+  PAPlayer::PreloadMap::const_iterator it = m_state->m_preloads.find(key);
+  return it != m_state->m_preloads.end() && !it->second.m_hurry;
+}
+
+PAPlayer::StreamInfo* PAPlayer::TakePreloadedStream(const CFileItem &file)
+{
+  std::string key = GetPreloadKey(file);
+  CSingleLock lock(m_preload->m_lock);
+  PreloadMap &preloads = m_preload->m_preloads;
+  PreloadMap::iterator it = preloads.find(key);
+
+  // the preload has the file open already, let it hand over what it decoded so far.
+  // A job that hasn't started yet or takes too long is left behind, it discards
+  // its stream once it finds the entry gone.
+  XbmcThreads::EndTime timeout(PRELOAD_HANDOVER_TIME);
+  while (it != preloads.end() && !it->second.m_stream)
+  {
+    if (!it->second.m_loading || timeout.IsTimePast())
+    {
+      CLog::Log(LOGDEBUG, "PAPlayer::TakePreloadedStream - Preload of %s not ready, opening it directly", CURL::GetRedacted(file.GetPath()).c_str());
+      preloads.erase(it);
+      return NULL;
+    }
+
+    it->second.m_hurry = true;
+    lock.Leave();
+    m_preload->m_event.WaitMSec(100);
+    lock.Enter();
+    it = preloads.find(key);
+  }
+
+  if (it == preloads.end())
+    return NULL;
+
+  StreamInfo *si = it->second.m_stream;
+  preloads.erase(it);
+  return si;
+}
+
+void PAPlayer::ClearPreloads()
+{
+  PreloadMap preloads;
+  {
+    CSingleLock lock(m_preload->m_lock);
+    m_preload->m_preloads.swap(preloads);
+  }
+
+  for (PreloadMap::iterator it = preloads.begin(); it != preloads.end(); ++it)
+  {
+    if (it->second.m_stream)
+    {
+      it->second.m_stream->m_decoder.Destroy();
+      delete it->second.m_stream;
+    }
+  }
+}
+
 void PAPlayer::UpdateStreamInfoPlayNextAtFrame(StreamInfo *si, unsigned int crossFadingTime)
 {
   // if no crossfading or cue sheet, wait for eof
@@ -535,6 +740,7 @@ bool PAPlayer::CloseFile(bool reopen)
   if (!m_isPaused)
     SoftStop(true, true);
   CloseAllStreams(false);
+  ClearPreloads();
 
   /* wait for the thread to terminate */
   StopThread(true);//true - wait for end of thread
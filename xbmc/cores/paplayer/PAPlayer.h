@@ -22,6 +22,9 @@
 
 #include <atomic>
 #include <list>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "cores/IPlayer.h"
@@ -35,11 +38,13 @@
 
 class IAEStream;
 class CFileItem;
+class CFileItemList;
 class CProcessInfo;
 
 class PAPlayer : public IPlayer, public CThread, public IJobCallback
 {
 friend class CQueueNextFileJob;
+friend class CPreloadFileJob;
 public:
   PAPlayer(IPlayerCallback& callback);
   virtual ~PAPlayer();
@@ -49,6 +54,7 @@ public:
   virtual bool OpenFile(const CFileItem& file, const CPlayerOptions &options);
   virtual bool QueueNextFile(const CFileItem &file);
   virtual void OnNothingToQueueNotify();
+  virtual void SetUpcomingFiles(const CFileItemList &files) override;
   virtual bool CloseFile(bool reopen = false);
   virtual bool IsPlaying() const;
   virtual void Pause() override;
@@ -126,6 +132,23 @@ private:
 
   typedef std::list<StreamInfo*> StreamList;
 
+  typedef struct
+  {
+    StreamInfo* m_stream;                /* the decoded stream, NULL while loading */
+    bool m_loading;                      /* the job has started to open the file */
+    bool m_hurry;                        /* the stream is queued, stop decoding ahead */
+  } PreloadInfo;
+
+  typedef std::map<std::string, PreloadInfo> PreloadMap;
+
+  /* shared with the preload jobs, which may outlive the player */
+  struct PreloadState
+  {
+    CCriticalSection  m_lock;            /* lock for the preloaded streams */
+    PreloadMap        m_preloads;        /* upcoming files, decoded ahead by CPreloadFileJob */
+    CEvent            m_event;           /* signaled when a preload finished */
+  };
+
   bool                m_signalSpeedChange;   /* true if OnPlaybackSpeedChange needs to be called */
   std::atomic_int m_playbackSpeed;           /* the playback speed (1 = normal) */
   bool                m_isPlaying;
@@ -149,7 +172,12 @@ private:
   int64_t             m_newForcedTotalTime;
   std::unique_ptr<CProcessInfo> m_processInfo;
 
+  std::shared_ptr<PreloadState> m_preload;
+
   bool QueueNextFileEx(const CFileItem &file, bool fadeIn = true, bool job = false);
+  static std::string GetPreloadKey(const CFileItem &file);
+  StreamInfo* TakePreloadedStream(const CFileItem &file);
+  void ClearPreloads();
   void SoftStart(bool wait = false);
   void SoftStop(bool wait = false, bool close = true);
   void CloseAllStreams(bool fade = true);
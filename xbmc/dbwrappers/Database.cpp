@@ -212,6 +212,34 @@ std::string CDatabase::GetSingleValue(const std::string &query, std::unique_ptr<
   return ret;
 }
 
+int CDatabase::GetCount(const std::string &query)
+{
+  try
+  {
+    if (!m_pDB.get())
+      return -1;
+
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(query);
+    if (stmt->step())
+      return stmt->column_int(0);
+  }
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - failed on query '%s'", __FUNCTION__, query.c_str());
+  }
+  return -1;
+}
+
+int CDatabase::GetUniqueId(const dbiplus::StatementPtr &stmt)
+{
+  if (!stmt->step())
+    return -1;
+  int id = stmt->column_int(0);
+  if (stmt->step())
+    return -1;
+  return id;
+}
+
 std::string CDatabase::GetSingleValue(const std::string &strTable, const std::string &strColumn, const std::string &strWhereClause /* = std::string() */, const std::string &strOrderBy /* = std::string() */)
 {
   std::string query = PrepareSQL("SELECT %s FROM %s", strColumn.c_str(), strTable.c_str());
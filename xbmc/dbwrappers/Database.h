@@ -20,15 +20,17 @@
  *
  */
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace dbiplus {
   class Database;
   class Dataset;
+  class Statement;
+  typedef std::shared_ptr<Statement> StatementPtr;
 }
 
-#include <memory>
-#include <string>
-#include <vector>
-
 class DatabaseSettings; // forward
 class CDbUrl;
 struct SortDescription;
@@ -110,6 +112,19 @@ public:
    */
   std::string GetSingleValue(const std::string &query, std::unique_ptr<dbiplus::Dataset> &ds);
 
+  /*! \brief Get the number returned by a count query.
+   The query is compiled once and served from the statement cache afterwards.
+   \param query the query in question.
+   \return the number from the query, -1 on failure.
+   */
+  int GetCount(const std::string &query);
+
+  /*! \brief Get the id returned by a lookup that has to match a single row.
+   \param stmt the statement with its parameters bound.
+   \return the id from the first column, -1 if no or several rows match.
+   */
+  int GetUniqueId(const dbiplus::StatementPtr &stmt);
+
   /*!
    * @brief Delete values from a table.
    * @param strTable The table to delete the values from.
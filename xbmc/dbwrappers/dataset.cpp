@@ -30,6 +30,9 @@
 #include "utils/log.h"
 #include <cstring>
 #include <algorithm>
+#include <iomanip>
+#include <locale>
+#include <sstream>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -82,6 +85,112 @@ std::string Database::prepare(const char *format, ...)
   return result;
 }
 
+//************* Statement emulation ***************
+
+/* Statement for backends without native prepared statements: bound values are
+   escaped by the database and substituted for the '?' placeholders when the
+   statement is stepped for the first time. */
+class EmulatedStatement : public Statement {
+public:
+  EmulatedStatement(Database *newDb, const std::string &sql)
+    : db(newDb)
+  {
+    // split the statement on placeholders outside of quoted literals
+    std::string part;
+    char quote = 0;
+    for (std::string::const_iterator i = sql.begin(); i != sql.end(); ++i)
+    {
+      if (quote)
+      {
+        if (*i == quote)
+          quote = 0;
+      }
+      else if (*i == '\'' || *i == '"' || *i == '`')
+        quote = *i;
+      else if (*i == '?')
+      {
+        parts.push_back(part);
+        part.clear();
+        continue;
+      }
+      part += *i;
+    }
+    parts.push_back(part);
+    params.resize(parts.size() - 1, "NULL");
+  }
+
+  virtual void reset()
+  {
+    ds.reset();
+    std::fill(params.begin(), params.end(), "NULL");
+  }
+
+  virtual void bind_null(int index) { set_param(index, "NULL"); }
+  virtual void bind_int(int index, int value) { set_param(index, std::to_string(value)); }
+  virtual void bind_int64(int index, int64_t value) { set_param(index, std::to_string(value)); }
+  virtual void bind_double(int index, double value)
+  {
+    // the printf of the databases rounds to 15 or 16 digits, keep all 17 a
+    // double needs to read back the same, independent of the locale
+    std::ostringstream str;
+    str.imbue(std::locale::classic());
+    str << std::setprecision(17) << value;
+    set_param(index, str.str());
+  }
+  virtual void bind_text(int index, const std::string &value) { set_param(index, db->prepare("'%s'", value.c_str())); }
+
+  virtual bool step()
+  {
+    if (!ds)
+    {
+      std::string sql = parts[0];
+      for (size_t i = 0; i < params.size(); i++)
+        sql += params[i] + parts[i + 1];
+
+      ds.reset(db->CreateDataset());
+      ds->query(sql);
+      return !ds->eof();
+    }
+    if (!ds->eof())
+      ds->next();
+    return !ds->eof();
+  }
+
+  virtual int column_count() { return ds ? ds->fieldCount() : 0; }
+  virtual const char *column_name(int col) { return ds ? ds->fieldName(col) : ""; }
+  virtual bool column_is_null(int col) { return value(col).get_isNull(); }
+  virtual fType column_type(int col) { return value(col).get_fType(); }
+  virtual int column_int(int col) { return value(col).get_asInt(); }
+  virtual int64_t column_int64(int col) { return value(col).get_asInt64(); }
+  virtual double column_double(int col) { return value(col).get_asDouble(); }
+  virtual std::string column_text(int col) { return value(col).get_asString(); }
+
+private:
+  field_value value(int col)
+  {
+    if (!ds || ds->eof())
+      throw DbErrors("No row to read column %d from", col);
+    return ds->fv(col);
+  }
+
+  void set_param(int index, const std::string &value)
+  {
+    if (index < 1 || index > (int)params.size())
+      throw DbErrors("Parameter index %d out of range", index);
+    params[index - 1] = value;
+  }
+
+  Database *db;
+  std::unique_ptr<Dataset> ds;
+  std::vector<std::string> parts;
+  std::vector<std::string> params;
+};
+
+StatementPtr Database::prepare_statement(const std::string &sql)
+{
+  return StatementPtr(new EmulatedStatement(this, sql));
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset():
@@ -93,6 +202,7 @@ Dataset::Dataset():
   frecno = 0;
   fbof = feof = true;
   autocommit = true;
+  streaming = false;
   fieldIndexMapID = ~0;
 
   fields_object = new Fields();
@@ -111,6 +221,7 @@ Dataset::Dataset(Database *newDb):
   frecno = 0;
   fbof = feof = true;
   autocommit = true;
+  streaming = false;
   fieldIndexMapID = ~0;
 
   fields_object = new Fields();
@@ -202,11 +313,65 @@ void Dataset::parse_sql(std::string &sql) {
 }
 
 
+bool Dataset::query_statement(const StatementPtr &stmt) {
+  close();
+
+  bool row = stmt->step();
+
+  // column headers
+  const int numColumns = stmt->column_count();
+  result.record_header.resize(numColumns);
+  for (int i = 0; i < numColumns; i++)
+    result.record_header[i].name = stmt->column_name(i);
+
+  // returned rows
+  for (; row; row = stmt->step())
+  {
+    sql_record *rec = new sql_record;
+    rec->resize(numColumns);
+    for (int i = 0; i < numColumns; i++)
+    {
+      field_value &v = rec->at(i);
+      if (stmt->column_is_null(i))
+      {
+        v.set_asString("");
+        v.set_isNull();
+        continue;
+      }
+      switch (stmt->column_type(i))
+      {
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+        v.set_asInt64(stmt->column_int64(i));
+        break;
+      case ft_Float:
+      case ft_Double:
+      case ft_LongDouble:
+        v.set_asDouble(stmt->column_double(i));
+        break;
+      default:
+        v.set_asString(stmt->column_text(i));
+        break;
+      }
+    }
+    result.records.push_back(rec);
+  }
+
+  active = true;
+  ds_state = dsSelect;
+  first();
+  return true;
+}
+
 void Dataset::close(void) {
   haveError  = false;
   frecno = 0;
   fbof = feof = true;
   active = false;
+  streaming = false;
 
   fieldIndexMap_Entries.clear();
   fieldIndexMap_Sorter.clear();
@@ -31,6 +31,7 @@
 #include <cstdio>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "qry_dat.h"
@@ -56,6 +57,43 @@ class Dataset;		// forward declaration of class Dataset
 #define DB_UNEXPECTED		7	// This shouldn't ever happen
 #define DB_UNEXPECTED_RESULT   -1       //For integer functions
 
+/******************* Class Statement definition *******************
+
+   represents a compiled SQL statement with '?' placeholders;
+   parameters are bound by 1-based index, columns are read by
+   0-based index without going through field_value
+
+******************************************************************/
+class Statement {
+public:
+  virtual ~Statement() {}
+
+/* clear bound parameters and rewind, so the statement can be run again */
+  virtual void reset() = 0;
+
+/* bind parameters (index starting with 1) */
+  virtual void bind_null(int index) = 0;
+  virtual void bind_int(int index, int value) = 0;
+  virtual void bind_int64(int index, int64_t value) = 0;
+  virtual void bind_double(int index, double value) = 0;
+  virtual void bind_text(int index, const std::string &value) = 0;
+
+/* fetch the next row, returns false when there are no more rows */
+  virtual bool step() = 0;
+
+/* typed access to the columns of the current row (index starting with 0) */
+  virtual int column_count() = 0;
+  virtual const char *column_name(int col) = 0;
+  virtual bool column_is_null(int col) = 0;
+  virtual fType column_type(int col) = 0;
+  virtual int column_int(int col) = 0;
+  virtual int64_t column_int64(int col) = 0;
+  virtual double column_double(int col) = 0;
+  virtual std::string column_text(int col) = 0;
+};
+
+typedef std::shared_ptr<Statement> StatementPtr;
+
 /******************* Class Database definition ********************
 
    represents  connection with database server;
@@ -163,6 +201,14 @@ public:
    */
   virtual std::string vprepare(const char *format, va_list args) = 0;
 
+  /*! \brief Compile a SQL statement with '?' placeholders for repeated execution.
+   The default implementation substitutes the bound values into the SQL text
+   and runs it through a Dataset, so every backend supports the interface.
+   \param sql - SQL statement, parameters given as '?'
+   \return the statement, reset and ready for binding.
+   */
+  virtual StatementPtr prepare_statement(const std::string &sql);
+
   virtual bool in_transaction() {return false;};
 
 };
@@ -211,6 +257,7 @@ protected:
   ParamList plist;              // Paramlist for locate
   bool fbof, feof;
   bool autocommit;		// for transactions
+  bool streaming;		// forward-only, one row at a time
 
 
 /* Variables to store SQL statements */
@@ -308,6 +355,17 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &sql) = 0;
+/* as query, but forward-only: rows are fetched from the server one at a time
+   as the cursor advances, so only the current row is held in memory.
+   num_rows() returns the rows fetched so far; seek, prev and last are not
+   available. The default implementation materializes the result. */
+  virtual bool query_streaming(const std::string &sql) { return query(sql); }
+/* as query and query_streaming, but runs a statement from prepare_statement
+   with its parameters bound. Values are read with the typed column accessors. */
+  virtual bool query_statement(const StatementPtr &stmt);
+  virtual bool query_statement_streaming(const StatementPtr &stmt) { return query_statement(stmt); }
+/* is the dataset opened by query_streaming */
+  bool is_streaming() const { return streaming; }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -1350,6 +1350,8 @@ char *MysqlDatabase::mysql_vmprintf(const char *zFormat, va_list ap) {
 //************* MysqlDataset implementation ***************
 
 MysqlDataset::MysqlDataset():Dataset() {
+  stream_res = NULL;
+  stream_rows = 0;
   haveError = false;
   db = NULL;
   errmsg = NULL;
@@ -1357,6 +1359,8 @@ MysqlDataset::MysqlDataset():Dataset() {
 }
 
 MysqlDataset::MysqlDataset(MysqlDatabase *newDb):Dataset(newDb) {
+  stream_res = NULL;
+  stream_rows = 0;
   haveError = false;
   db = newDb;
   errmsg = NULL;
@@ -1546,7 +1550,7 @@ const void* MysqlDataset::getExecRes() {
   return &exec_res;
 }
 
-bool MysqlDataset::query(const std::string &query) {
+MYSQL_RES *MysqlDataset::prepare_select(const std::string &query, bool unbuffered) {
   if(!handle()) throw DbErrors("No Database Connection");
   std::string qry = query;
   int fs = qry.find("select");
@@ -1568,74 +1572,87 @@ bool MysqlDataset::query(const std::string &query) {
     throw DbErrors(db->getErrorMsg());
 
   MYSQL* conn = handle();
-  stmt = mysql_store_result(conn);
+  stmt = unbuffered ? mysql_use_result(conn) : mysql_store_result(conn);
   if (stmt == NULL)
     throw DbErrors("Missing result set!");
 
   // column headers
   const unsigned int numColumns = mysql_num_fields(stmt);
   MYSQL_FIELD *fields = mysql_fetch_fields(stmt);
-  MYSQL_ROW row;
   result.record_header.resize(numColumns);
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = fields[i].name;
 
+  return stmt;
+}
+
+void MysqlDataset::fetch_row(MYSQL_RES *res, MYSQL_ROW row, sql_record &rec) {
+  const unsigned int numColumns = mysql_num_fields(res);
+  MYSQL_FIELD *fields = mysql_fetch_fields(res);
+  // a streaming dataset reuses the record, don't keep values of the last row
+  rec.assign(numColumns, field_value());
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = rec.at(i);
+    switch (fields[i].type)
+    {
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_DECIMAL:
+      case MYSQL_TYPE_NEWDECIMAL:
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+        if (row[i] != NULL)
+        {
+          v.set_asInt(atoi(row[i]));
+        }
+        else
+        {
+          v.set_asInt(0);
+        }
+        break;
+      case MYSQL_TYPE_FLOAT:
+      case MYSQL_TYPE_DOUBLE:
+        if (row[i] != NULL)
+        {
+          v.set_asDouble(atof(row[i]));
+        }
+        else
+        {
+          v.set_asDouble(0);
+        }
+        break;
+      case MYSQL_TYPE_STRING:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_VARCHAR:
+        if (row[i] != NULL) v.set_asString((const char *)row[i] );
+        break;
+      case MYSQL_TYPE_TINY_BLOB:
+      case MYSQL_TYPE_MEDIUM_BLOB:
+      case MYSQL_TYPE_LONG_BLOB:
+      case MYSQL_TYPE_BLOB:
+        if (row[i] != NULL) v.set_asString((const char *)row[i]);
+        break;
+      case MYSQL_TYPE_NULL:
+      default:
+        CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
+        v.set_asString("");
+        v.set_isNull();
+        break;
+    }
+  }
+}
+
+bool MysqlDataset::query(const std::string &query) {
+  MYSQL_RES *stmt = prepare_select(query, false);
+  MYSQL_ROW row;
+
   // returned rows
   while ((row = mysql_fetch_row(stmt)))
   { // have a row of data
     sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (fields[i].type)
-      {
-        case MYSQL_TYPE_LONGLONG:
-        case MYSQL_TYPE_DECIMAL:
-        case MYSQL_TYPE_NEWDECIMAL:
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONG:
-          if (row[i] != NULL)
-          {
-            v.set_asInt(atoi(row[i]));
-          }
-          else
-          {
-            v.set_asInt(0);
-          }
-          break;
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-          if (row[i] != NULL)
-          {
-            v.set_asDouble(atof(row[i]));
-          }
-          else
-          {
-            v.set_asDouble(0);
-          }
-          break;
-        case MYSQL_TYPE_STRING:
-        case MYSQL_TYPE_VAR_STRING:
-        case MYSQL_TYPE_VARCHAR:
-          if (row[i] != NULL) v.set_asString((const char *)row[i] );
-          break;
-        case MYSQL_TYPE_TINY_BLOB:
-        case MYSQL_TYPE_MEDIUM_BLOB:
-        case MYSQL_TYPE_LONG_BLOB:
-        case MYSQL_TYPE_BLOB:
-          if (row[i] != NULL) v.set_asString((const char *)row[i]);
-          break;
-        case MYSQL_TYPE_NULL:
-        default:
-          CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
-          v.set_asString("");
-          v.set_isNull();
-          break;
-      }
-    }
+    fetch_row(stmt, row, *res);
     result.records.push_back(res);
   }
   mysql_free_result(stmt);
@@ -1645,6 +1662,50 @@ bool MysqlDataset::query(const std::string &query) {
   return true;
 }
 
+bool MysqlDataset::query_streaming(const std::string &query) {
+  // rows stay on the server until fetched, the connection can't be used for
+  // other queries until the dataset reaches eof or is closed
+  stream_res = prepare_select(query, true);
+  stream_rows = 0;
+  streaming = true;
+  active = true;
+  ds_state = dsSelect;
+
+  // the single row buffer is overwritten by every fetch
+  result.records.push_back(new sql_record);
+  fetch_next();
+  fbof = feof;
+  return true;
+}
+
+void MysqlDataset::fetch_next() {
+  if (stream_res == NULL)
+  {
+    feof = true;
+    return;
+  }
+
+  MYSQL_ROW row = mysql_fetch_row(stream_res);
+  if (row)
+  {
+    if (result.records[0] == NULL)
+      result.records[0] = new sql_record;
+    fetch_row(stream_res, row, *result.records[0]);
+    stream_rows++;
+    feof = false;
+    fill_fields();
+    return;
+  }
+
+  // done (or failed), release the result so the connection can be used again
+  unsigned int err = mysql_errno(handle());
+  mysql_free_result(stream_res);
+  stream_res = NULL;
+  feof = true;
+  if (err != 0)
+    throw DbErrors("Error fetching row: %s", mysql_error(handle()));
+}
+
 void MysqlDataset::open(const std::string &sql) {
    set_select_sql(sql);
    open();
@@ -1662,6 +1723,12 @@ void MysqlDataset::open() {
 }
 
 void MysqlDataset::close() {
+  if (stream_res)
+  {
+    mysql_free_result(stream_res);
+    stream_res = NULL;
+  }
+  stream_rows = 0;
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -1681,6 +1748,8 @@ void MysqlDataset::cancel() {
 }
 
 int MysqlDataset::num_rows() {
+  if (streaming)
+    return stream_rows;
   return result.records.size();
 }
 
@@ -1693,21 +1762,40 @@ bool MysqlDataset::bof() {
 }
 
 void MysqlDataset::first() {
+  if (streaming)
+  {
+    if (stream_rows > 1)
+      throw DbErrors("Can't rewind a forward-only dataset");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void MysqlDataset::last() {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::last();
   fill_fields();
 }
 
 void MysqlDataset::prev(void) {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::prev();
   fill_fields();
 }
 
 void MysqlDataset::next(void) {
+  if (streaming)
+  {
+    if (ds_state == dsSelect && !feof)
+    {
+      fbof = false;
+      fetch_next();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof())
       fill_fields();
@@ -1727,6 +1815,8 @@ void MysqlDataset::free_row(void)
 }
 
 bool MysqlDataset::seek(int pos) {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   if (ds_state == dsSelect)
   {
     Dataset::seek(pos);
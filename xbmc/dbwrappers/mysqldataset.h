@@ -112,6 +112,18 @@ class MysqlDataset : public Dataset {
 protected:
   MYSQL* handle();
 
+/* unbuffered result of a dataset opened by query_streaming */
+  MYSQL_RES *stream_res;
+  int stream_rows;
+
+/* Sends a select statement and fills the column headers from its result,
+   buffered with mysql_store_result or unbuffered with mysql_use_result */
+  MYSQL_RES *prepare_select(const std::string &query, bool unbuffered);
+/* Copies a fetched row into rec */
+  static void fetch_row(MYSQL_RES *res, MYSQL_ROW row, sql_record &rec);
+/* Fetches the next row of a streaming dataset */
+  void fetch_next();
+
 /* Makes direct queries to database */
   virtual void make_query(StringList &_sql);
 /* Makes direct inserts into database */
@@ -149,6 +161,7 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+  virtual bool query_streaming(const std::string &query);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -28,6 +28,7 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include "sqlitedataset.h"
 #include "utils/log.h"
@@ -90,12 +91,111 @@ static int busy_callback(void*, int busyCount)
   return 1;
 }
 
+//************* SqliteStatement implementation ***************
+
+SqliteStatement::SqliteStatement(SqliteDatabase *newDb, sqlite3_stmt *newStmt, const std::string &newSql)
+  : db(newDb),
+    stmt(newStmt),
+    sql(newSql)
+{
+}
+
+SqliteStatement::~SqliteStatement() {
+  sqlite3_finalize(stmt);
+}
+
+void SqliteStatement::check_bind(int rc) {
+  if (db->setErr(rc, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteStatement::reset() {
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+}
+
+void SqliteStatement::bind_null(int index) {
+  check_bind(sqlite3_bind_null(stmt, index));
+}
+
+void SqliteStatement::bind_int(int index, int value) {
+  check_bind(sqlite3_bind_int(stmt, index, value));
+}
+
+void SqliteStatement::bind_int64(int index, int64_t value) {
+  check_bind(sqlite3_bind_int64(stmt, index, value));
+}
+
+void SqliteStatement::bind_double(int index, double value) {
+  check_bind(sqlite3_bind_double(stmt, index, value));
+}
+
+void SqliteStatement::bind_text(int index, const std::string &value) {
+  check_bind(sqlite3_bind_text(stmt, index, value.c_str(), value.size(), SQLITE_TRANSIENT));
+}
+
+bool SqliteStatement::step() {
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW)
+    return true;
+  if (rc == SQLITE_DONE)
+    return false;
+
+  // sqlite3_reset() reports the actual error of the failed step
+  db->setErr(sqlite3_reset(stmt), sql.c_str());
+  throw DbErrors(db->getErrorMsg());
+}
+
+int SqliteStatement::column_count() {
+  return sqlite3_column_count(stmt);
+}
+
+const char *SqliteStatement::column_name(int col) {
+  return sqlite3_column_name(stmt, col);
+}
+
+bool SqliteStatement::column_is_null(int col) {
+  return sqlite3_column_type(stmt, col) == SQLITE_NULL;
+}
+
+fType SqliteStatement::column_type(int col) {
+  switch (sqlite3_column_type(stmt, col))
+  {
+  case SQLITE_INTEGER:
+    return ft_Int64;
+  case SQLITE_FLOAT:
+    return ft_Double;
+  default:
+    return ft_String;
+  }
+}
+
+int SqliteStatement::column_int(int col) {
+  return sqlite3_column_int(stmt, col);
+}
+
+int64_t SqliteStatement::column_int64(int col) {
+  return sqlite3_column_int64(stmt, col);
+}
+
+double SqliteStatement::column_double(int col) {
+  return sqlite3_column_double(stmt, col);
+}
+
+std::string SqliteStatement::column_text(int col) {
+  const char *text = (const char *)sqlite3_column_text(stmt, col);
+  if (text == NULL)
+    return "";
+  return std::string(text, sqlite3_column_bytes(stmt, col));
+}
+
 //************* SqliteDatabase implementation ***************
 
 SqliteDatabase::SqliteDatabase() {
 
   active = false;  
   _in_transaction = false;    // for transaction
+  stmt_cache_size = 32;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -281,7 +381,9 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
-  sqlite3_close(conn);
+  clear_statement_cache();
+  // statements still held by callers keep the connection alive until finalized
+  sqlite3_close_v2(conn);
   active = false;
 }
 
@@ -468,10 +570,77 @@ std::string SqliteDatabase::vprepare(const char *format, va_list args)
 }
 
 
+// methods for compiled statements
+// ---------------------------------------------
+StatementPtr SqliteDatabase::prepare_statement(const std::string &sql)
+{
+  return get_statement(sql);
+}
+
+std::shared_ptr<SqliteStatement> SqliteDatabase::get_statement(const std::string &sql, bool cache)
+{
+  if (!active) throw DbErrors("No Database Connection");
+
+  std::shared_ptr<SqliteStatement> owner;
+  std::unordered_map<std::string, StatementList::iterator>::iterator it = stmt_index.find(sql);
+  if (it != stmt_index.end())
+  {
+    // the cache holds one reference, any further one is an active user
+    if (it->second->use_count() == 1)
+    {
+      stmt_cache.splice(stmt_cache.begin(), stmt_cache, it->second);
+      owner = stmt_cache.front();
+    }
+  }
+
+  if (!owner)
+  {
+    sqlite3_stmt *stmt = NULL;
+    if (setErr(sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, NULL), sql.c_str()) != SQLITE_OK)
+    {
+      sqlite3_finalize(stmt);
+      throw DbErrors(getErrorMsg());
+    }
+    owner.reset(new SqliteStatement(this, stmt, sql));
+
+    if (cache && it == stmt_index.end() && stmt_cache_size > 0)
+    {
+      stmt_cache.push_front(owner);
+      stmt_index[sql] = stmt_cache.begin();
+      while (stmt_cache.size() > stmt_cache_size)
+      {
+        stmt_index.erase(stmt_cache.back()->getSql());
+        stmt_cache.pop_back();
+      }
+    }
+  }
+
+  // hand out a reference that rewinds the statement once the caller is done
+  // with it, so no read transaction is left open behind a cached statement
+  return std::shared_ptr<SqliteStatement>(owner.get(), [owner](SqliteStatement *stmt) { stmt->reset(); });
+}
+
+void SqliteDatabase::set_statement_cache_size(unsigned int size)
+{
+  stmt_cache_size = size;
+  while (stmt_cache.size() > stmt_cache_size)
+  {
+    stmt_index.erase(stmt_cache.back()->getSql());
+    stmt_cache.pop_back();
+  }
+}
+
+void SqliteDatabase::clear_statement_cache()
+{
+  stmt_index.clear();
+  stmt_cache.clear();
+}
+
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
   haveError = false;
+  stream_rows = 0;
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
@@ -480,6 +649,7 @@ SqliteDataset::SqliteDataset():Dataset() {
 
 SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   haveError = false;
+  stream_rows = 0;
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
@@ -660,7 +830,7 @@ const void* SqliteDataset::getExecRes() {
 }
 
 
-bool SqliteDataset::query(const std::string &query) {
+std::shared_ptr<SqliteStatement> SqliteDataset::prepare_select(const std::string &query) {
     if(!handle()) throw DbErrors("No Database Connection");
     std::string qry = query;
     int fs = qry.find("select");
@@ -670,48 +840,62 @@ bool SqliteDataset::query(const std::string &query) {
 
   close();
 
-  sqlite3_stmt *stmt = NULL;
-  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
-    throw DbErrors(db->getErrorMsg());
+  // ad-hoc queries carry their values in the SQL text and are rarely run
+  // twice, so they reuse a cached statement but don't add one. Otherwise
+  // they would evict the prepared statements that are run over and over.
+  std::shared_ptr<SqliteStatement> stmt = static_cast<SqliteDatabase*>(db)->get_statement(query, false);
+  fill_header(stmt->getHandle());
+  return stmt;
+}
 
-  // column headers
+void SqliteDataset::fill_header(sqlite3_stmt *stmt) {
   const unsigned int numColumns = sqlite3_column_count(stmt);
   result.record_header.resize(numColumns);
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = sqlite3_column_name(stmt, i);
+}
+
+void SqliteDataset::fetch_row(sqlite3_stmt *stmt, sql_record &rec) {
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  rec.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = rec.at(i);
+    switch (sqlite3_column_type(stmt, i))
+    {
+    case SQLITE_INTEGER:
+      v.set_asInt64(sqlite3_column_int64(stmt, i));
+      break;
+    case SQLITE_FLOAT:
+      v.set_asDouble(sqlite3_column_double(stmt, i));
+      break;
+    case SQLITE_TEXT:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_BLOB:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_NULL:
+    default:
+      v.set_asString("");
+      v.set_isNull();
+      break;
+    }
+  }
+}
+
+bool SqliteDataset::query(const std::string &query) {
+  std::shared_ptr<SqliteStatement> cached = prepare_select(query);
+  sqlite3_stmt *stmt = cached->getHandle();
 
   // returned rows
   while (sqlite3_step(stmt) == SQLITE_ROW)
   { // have a row of data
     sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
+    fetch_row(stmt, *res);
     result.records.push_back(res);
   }
-  if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
+  if (db->setErr(sqlite3_reset(stmt),query.c_str()) == SQLITE_OK)
   {
     active = true;
     ds_state = dsSelect;
@@ -724,6 +908,66 @@ bool SqliteDataset::query(const std::string &query) {
   }  
 }
 
+bool SqliteDataset::query_streaming(const std::string &query) {
+  stream_stmt = prepare_select(query);
+  start_streaming();
+  return true;
+}
+
+bool SqliteDataset::query_statement_streaming(const StatementPtr &stmt) {
+  // statements of other databases can only be materialized
+  std::shared_ptr<SqliteStatement> sqliteStmt = std::dynamic_pointer_cast<SqliteStatement>(stmt);
+  if (!sqliteStmt)
+    return Dataset::query_statement(stmt);
+
+  close();
+  fill_header(sqliteStmt->getHandle());
+  stream_stmt = sqliteStmt;
+  start_streaming();
+  return true;
+}
+
+void SqliteDataset::start_streaming() {
+  stream_rows = 0;
+  streaming = true;
+  active = true;
+  ds_state = dsSelect;
+
+  // the single row buffer is overwritten by every step
+  result.records.push_back(new sql_record);
+  fetch_next();
+  fbof = feof;
+}
+
+void SqliteDataset::fetch_next() {
+  if (!stream_stmt)
+  {
+    feof = true;
+    return;
+  }
+
+  sqlite3_stmt *stmt = stream_stmt->getHandle();
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW)
+  {
+    if (result.records[0] == NULL)
+      result.records[0] = new sql_record;
+    fetch_row(stmt, *result.records[0]);
+    stream_rows++;
+    feof = false;
+    fill_fields();
+    return;
+  }
+
+  // done (or failed), release the statement so it no longer holds a read lock
+  std::string query = stream_stmt->getSql();
+  rc = sqlite3_reset(stmt);
+  stream_stmt.reset();
+  feof = true;
+  if (db->setErr(rc, query.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
 void SqliteDataset::open(const std::string &sql) {
   set_select_sql(sql);
   open();
@@ -740,6 +984,8 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  stream_stmt.reset();
+  stream_rows = 0;
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -760,6 +1006,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (streaming)
+    return stream_rows;
   return result.records.size();
 }
 
@@ -775,21 +1023,40 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (streaming)
+  {
+    if (stream_rows > 1)
+      throw DbErrors("Can't rewind a forward-only dataset");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (streaming)
+  {
+    if (ds_state == dsSelect && !feof)
+    {
+      fbof = false;
+      fetch_next();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
@@ -809,6 +1076,8 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (streaming)
+    throw DbErrors("Can't seek in a forward-only dataset");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
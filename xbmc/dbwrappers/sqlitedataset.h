@@ -29,10 +29,54 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <list>
+#include <unordered_map>
 #include "dataset.h"
 #include <sqlite3.h>
 
 namespace dbiplus {
+class SqliteDatabase;
+
+/***************** Class SqliteStatement definition *****************
+
+       class 'SqliteStatement' wraps a compiled sqlite3_stmt
+
+******************************************************************/
+class SqliteStatement : public Statement {
+protected:
+  SqliteDatabase *db;
+  sqlite3_stmt *stmt;
+  std::string sql;
+
+  void check_bind(int rc);
+
+public:
+  SqliteStatement(SqliteDatabase *newDb, sqlite3_stmt *newStmt, const std::string &newSql);
+  ~SqliteStatement();
+
+  sqlite3_stmt *getHandle() { return stmt; }
+  const std::string &getSql() const { return sql; }
+
+  virtual void reset();
+
+  virtual void bind_null(int index);
+  virtual void bind_int(int index, int value);
+  virtual void bind_int64(int index, int64_t value);
+  virtual void bind_double(int index, double value);
+  virtual void bind_text(int index, const std::string &value);
+
+  virtual bool step();
+
+  virtual int column_count();
+  virtual const char *column_name(int col);
+  virtual bool column_is_null(int col);
+  virtual fType column_type(int col);
+  virtual int column_int(int col);
+  virtual int64_t column_int64(int col);
+  virtual double column_double(int col);
+  virtual std::string column_text(int col);
+};
+
 /***************** Class SqliteDatabase definition ******************
 
        class 'SqliteDatabase' connects with Sqlite-server
@@ -45,6 +89,14 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* LRU cache of compiled statements, most recently used first */
+  typedef std::list<std::shared_ptr<SqliteStatement> > StatementList;
+  StatementList stmt_cache;
+  std::unordered_map<std::string, StatementList::iterator> stmt_index;
+  unsigned int stmt_cache_size;
+
+  void clear_statement_cache();
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -94,6 +146,13 @@ public:
 /* virtual methods for formatting */
   virtual std::string vprepare(const char *format, va_list args);
 
+/* compiled statements are served from an LRU cache of stmt_cache_size entries;
+   a cached statement that is still in use is compiled again, uncached.
+   only statements compiled with cache set are added to the cache */
+  virtual StatementPtr prepare_statement(const std::string &sql);
+  std::shared_ptr<SqliteStatement> get_statement(const std::string &sql, bool cache = true);
+  void set_statement_cache_size(unsigned int size);
+
   bool in_transaction() {return _in_transaction;}; 	
 
 };
@@ -110,6 +169,21 @@ class SqliteDataset : public Dataset {
 protected:
   sqlite3* handle();
 
+/* statement of a dataset opened by query_streaming */
+  std::shared_ptr<SqliteStatement> stream_stmt;
+  int stream_rows;
+
+/* Compiles a select statement and fills the column headers */
+  std::shared_ptr<SqliteStatement> prepare_select(const std::string &query);
+/* Fills the column headers from a compiled statement */
+  void fill_header(sqlite3_stmt *stmt);
+/* Starts fetching the rows of stream_stmt one at a time */
+  void start_streaming();
+/* Copies the current row of the statement into rec */
+  static void fetch_row(sqlite3_stmt *stmt, sql_record &rec);
+/* Steps a streaming dataset to its next row */
+  void fetch_next();
+
 /* Makes direct queries to database */
   virtual void make_query(StringList &_sql);
 /* Makes direct inserts into database */
@@ -148,6 +222,8 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+  virtual bool query_streaming(const std::string &query);
+  virtual bool query_statement_streaming(const StatementPtr &stmt);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -0,0 +1,495 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "BlockCache.h"
+#include "IFile.h"
+#include "SpecialProtocol.h"
+#include "URL.h"
+#include "Util.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+#if defined(TARGET_POSIX)
+#include "posix/PosixFile.h"
+#define CacheLocalFile CPosixFile
+#elif defined(TARGET_WINDOWS)
+#include "win32/Win32File.h"
+#define CacheLocalFile CWin32File
+#endif // TARGET_WINDOWS
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+using namespace XFILE;
+
+CBlockCache::CBlockCache(size_t memorySize, int64_t spillSize)
+ : CCacheStrategy()
+ , m_slots(0)
+ , m_cur(0)
+ , m_end(0)
+ , m_memorySize(memorySize)
+ , m_spillSize(spillSize)
+ , m_spillRead(NULL)
+ , m_spillWrite(NULL)
+{
+  m_maxBlocks = std::max((size_t)8, memorySize / BLOCK_SIZE);
+  m_frontSize = m_maxBlocks * BLOCK_SIZE / 4 * 3;
+  m_maxSlots = (int)std::min((int64_t)INT_MAX, spillSize / (int64_t)BLOCK_SIZE);
+}
+
+CBlockCache::~CBlockCache()
+{
+  Close();
+}
+
+int CBlockCache::Open()
+{
+  Close();
+
+  m_cur = 0;
+  m_end = 0;
+
+  if (m_maxSlots > 0)
+  {
+    m_spillName = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/filecache%03d.cache", 999));
+    m_spillRead = new CacheLocalFile();
+    m_spillWrite = new CacheLocalFile();
+
+    CURL fileURL(m_spillName);
+    if (m_spillName.empty() || !m_spillWrite->OpenForWrite(fileURL, true) || !m_spillRead->Open(fileURL))
+    {
+      // not fatal, blocks just get dropped instead of spilled
+      CLog::Log(LOGWARNING, "%s - unable to create spill file \"%s\"", __FUNCTION__, m_spillName.c_str());
+      Close();
+    }
+  }
+
+  return CACHE_RC_OK;
+}
+
+void CBlockCache::Close()
+{
+  CSingleLock lock(m_sync);
+
+  Clear();
+
+  if (m_spillWrite)
+    m_spillWrite->Close();
+  if (m_spillRead)
+  {
+    m_spillRead->Close();
+    if (!m_spillName.empty() && !m_spillRead->Delete(CURL(m_spillName)))
+      CLog::Log(LOGWARNING, "%s - failed to delete spill file \"%s\"", __FUNCTION__, m_spillName.c_str());
+  }
+
+  delete m_spillRead;
+  delete m_spillWrite;
+  m_spillRead = NULL;
+  m_spillWrite = NULL;
+  m_spillName.clear();
+}
+
+void CBlockCache::Clear()
+{
+  for (BlockMap::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    delete[] it->second.data;
+
+  m_blocks.clear();
+  m_memoryLru.clear();
+  m_spillLru.clear();
+  m_freeSlots.clear();
+  m_slots = 0;
+}
+
+int64_t CBlockCache::ContiguousEnd(int64_t pos, int64_t limit)
+{
+  int64_t index = pos / BLOCK_SIZE;
+  size_t offset = (size_t)(pos % BLOCK_SIZE);
+
+  BlockMap::iterator it = m_blocks.find(index);
+  if (it == m_blocks.end() || offset < it->second.begin || offset > it->second.end)
+  {
+    // the write position and the end of a full previous block are valid as well
+    if (pos == m_end)
+      return pos;
+    if (offset != 0)
+      return -1;
+    BlockMap::iterator prev = m_blocks.find(index - 1);
+    if (prev == m_blocks.end() || prev->second.end != BLOCK_SIZE)
+      return -1;
+    return pos;
+  }
+
+  int64_t end = index * BLOCK_SIZE + it->second.end;
+  while (it->second.end == BLOCK_SIZE && end < limit)
+  {
+    ++it;
+    if (it == m_blocks.end() || it->first != index + 1 || it->second.begin != 0)
+      break;
+    index++;
+    end = index * BLOCK_SIZE + it->second.end;
+  }
+  return end;
+}
+
+size_t CBlockCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  CSingleLock lock(m_sync);
+
+  size_t front = m_end > m_cur ? (size_t)(m_end - m_cur) : 0;
+  if (front >= m_frontSize)
+    return 0;
+
+  return std::min(iRequestSize, m_frontSize - front);
+}
+
+/**
+ * Writes at most up to the end of the block at the current write
+ * position, so multiple calls may be needed. Data that is already
+ * cached from an earlier pass is not copied again.
+ */
+int CBlockCache::WriteToCache(const char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  size_t front = m_end > m_cur ? (size_t)(m_end - m_cur) : 0;
+  if (front >= m_frontSize)
+    return 0;
+
+  int64_t index = m_end / BLOCK_SIZE;
+  size_t offset = (size_t)(m_end % BLOCK_SIZE);
+  len = std::min(len, std::min(m_frontSize - front, BLOCK_SIZE - offset));
+  if (len == 0)
+    return 0;
+
+  BlockMap::iterator it = m_blocks.find(index);
+  if (it == m_blocks.end() || offset < it->second.begin || offset + len > it->second.end)
+  {
+    Block *block = GetWritableBlock(index);
+    if (!block)
+      return 0;
+
+    memcpy(block->data + offset, buf, len);
+
+    if (block->begin == block->end)
+    {
+      block->begin = offset;
+      block->end = offset + len;
+    }
+    else if (offset >= block->begin && offset <= block->end)
+      block->end = std::max(block->end, offset + len);
+    else if (offset < block->begin && offset + len >= block->begin)
+    {
+      block->begin = offset;
+      block->end = std::max(block->end, offset + len);
+    }
+    else
+    {
+      // not connected to what the block holds, keep the new data only
+      block->begin = offset;
+      block->end = offset + len;
+    }
+  }
+
+  m_end += len;
+  m_written.Set();
+
+  return len;
+}
+
+CBlockCache::Block *CBlockCache::GetWritableBlock(int64_t index)
+{
+  BlockMap::iterator it = m_blocks.find(index);
+  if (it != m_blocks.end() && it->second.data)
+  {
+    m_memoryLru.splice(m_memoryLru.end(), m_memoryLru, it->second.lru);
+    return &it->second;
+  }
+
+  if (m_memoryLru.size() >= m_maxBlocks)
+  {
+    if (!MakeRoom())
+      return NULL;
+    // making room may have dropped a spilled block
+    it = m_blocks.find(index);
+  }
+
+  uint8_t *data = new uint8_t[BLOCK_SIZE];
+
+  if (it == m_blocks.end())
+  {
+    Block block;
+    block.data = NULL;
+    block.slot = -1;
+    block.begin = 0;
+    block.end = 0;
+    it = m_blocks.insert(std::make_pair(index, block)).first;
+  }
+  else
+  {
+    // bring a spilled block back into memory
+    Block &block = it->second;
+    size_t size = block.end - block.begin;
+    int64_t pos = (int64_t)block.slot * BLOCK_SIZE + block.begin;
+    if (m_spillRead->Seek(pos, SEEK_SET) != pos || m_spillRead->Read(data + block.begin, size) != (ssize_t)size)
+    {
+      CLog::Log(LOGERROR, "%s - failed to read block from spill file", __FUNCTION__);
+      block.begin = 0;
+      block.end = 0;
+    }
+    m_freeSlots.push_back(block.slot);
+    m_spillLru.erase(block.lru);
+    block.slot = -1;
+  }
+
+  it->second.data = data;
+  it->second.lru = m_memoryLru.insert(m_memoryLru.end(), index);
+  return &it->second;
+}
+
+bool CBlockCache::MakeRoom()
+{
+  // never evict what is between the reader and the writer. A reader ahead
+  // of the writer (writer catching up on a range cached before) only
+  // needs its current block.
+  int64_t first = m_cur / BLOCK_SIZE;
+  int64_t last = m_end / BLOCK_SIZE;
+
+  for (std::list<int64_t>::iterator lru = m_memoryLru.begin(); lru != m_memoryLru.end(); ++lru)
+  {
+    if ((*lru >= first && *lru <= last) || *lru == first || *lru == last)
+      continue;
+
+    BlockMap::iterator it = m_blocks.find(*lru);
+    if (!Spill(it))
+      Drop(it);
+    return true;
+  }
+  return false;
+}
+
+bool CBlockCache::Spill(BlockMap::iterator it)
+{
+  if (!m_spillWrite)
+    return false;
+
+  int slot;
+  if (!m_freeSlots.empty())
+  {
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  else if (m_slots < m_maxSlots)
+    slot = m_slots++;
+  else if (!m_spillLru.empty())
+  {
+    // reuse the slot of the least recently used spilled block
+    BlockMap::iterator oldest = m_blocks.find(m_spillLru.front());
+    slot = oldest->second.slot;
+    m_spillLru.pop_front();
+    m_blocks.erase(oldest);
+  }
+  else
+    return false;
+
+  Block &block = it->second;
+  size_t size = block.end - block.begin;
+  int64_t pos = (int64_t)slot * BLOCK_SIZE + block.begin;
+  if (size > 0 &&
+      (m_spillWrite->Seek(pos, SEEK_SET) != pos || m_spillWrite->Write(block.data + block.begin, size) != (ssize_t)size))
+  {
+    CLog::Log(LOGERROR, "%s - failed to write block to spill file", __FUNCTION__);
+    m_freeSlots.push_back(slot);
+    return false;
+  }
+
+  delete[] block.data;
+  block.data = NULL;
+  block.slot = slot;
+  m_memoryLru.erase(block.lru);
+  block.lru = m_spillLru.insert(m_spillLru.end(), it->first);
+  return true;
+}
+
+void CBlockCache::Drop(BlockMap::iterator it)
+{
+  Block &block = it->second;
+  if (block.data)
+  {
+    delete[] block.data;
+    m_memoryLru.erase(block.lru);
+  }
+  else
+  {
+    m_freeSlots.push_back(block.slot);
+    m_spillLru.erase(block.lru);
+  }
+  m_blocks.erase(it);
+}
+
+/**
+ * Reads data from cache. Will only read up till the end of
+ * the current block, so multiple calls may be needed.
+ */
+int CBlockCache::ReadFromCache(char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  int64_t index = m_cur / BLOCK_SIZE;
+  size_t offset = (size_t)(m_cur % BLOCK_SIZE);
+
+  BlockMap::iterator it = m_blocks.find(index);
+  if (it == m_blocks.end() || offset < it->second.begin || offset >= it->second.end)
+  {
+    if (IsEndOfInput())
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  Block &block = it->second;
+  len = std::min(len, block.end - offset);
+  if (len == 0)
+    return 0;
+
+  if (block.data)
+  {
+    memcpy(buf, block.data + offset, len);
+    m_memoryLru.splice(m_memoryLru.end(), m_memoryLru, block.lru);
+  }
+  else
+  {
+    int64_t pos = (int64_t)block.slot * BLOCK_SIZE + offset;
+    if (m_spillRead->Seek(pos, SEEK_SET) != pos || m_spillRead->Read(buf, len) != (ssize_t)len)
+    {
+      CLog::Log(LOGERROR, "%s - failed to read from spill file", __FUNCTION__);
+      return CACHE_RC_ERROR;
+    }
+    m_spillLru.splice(m_spillLru.end(), m_spillLru, block.lru);
+  }
+
+  m_cur += len;
+
+  m_space.Set();
+
+  return len;
+}
+
+/* Wait "millis" milliseconds for "minimum" amount of data to come in.
+ * Only data without a gap from the read position counts.
+ */
+int64_t CBlockCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CSingleLock lock(m_sync);
+  int64_t limit = std::max(m_end, m_cur + (int64_t)m_frontSize);
+  int64_t avail = std::max((int64_t)0, ContiguousEnd(m_cur, limit) - m_cur);
+
+  if(millis == 0 || IsEndOfInput())
+    return avail;
+
+  if(minimum > m_frontSize)
+    minimum = m_frontSize;
+
+  XbmcThreads::EndTime endtime(millis);
+  while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast() )
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    limit = std::max(m_end, m_cur + (int64_t)m_frontSize);
+    avail = std::max((int64_t)0, ContiguousEnd(m_cur, limit) - m_cur);
+  }
+
+  return avail;
+}
+
+int64_t CBlockCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  if (pos >= m_end && pos < m_end + 100000)
+  {
+    m_cur = m_end;
+    lock.Leave();
+    WaitForData((size_t)(pos - m_cur), 5000);
+    lock.Enter();
+  }
+
+  // data has to connect to the write position, else the reader would
+  // run into a gap that is never filled. If it does not, CFileCache
+  // resets to pos and the source continues where the cached data ends.
+  int64_t from = std::min(pos, m_end);
+  int64_t to = std::max(pos, m_end);
+  if (ContiguousEnd(from, to) >= to)
+  {
+    m_cur = pos;
+    return pos;
+  }
+
+  return CACHE_RC_ERROR;
+}
+
+bool CBlockCache::Reset(int64_t pos, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+  if (!clearAnyway)
+  {
+    int64_t end = ContiguousEnd(pos);
+    if (end >= 0)
+    {
+      m_cur = pos;
+      m_end = end;
+      return false;
+    }
+  }
+  else
+    Clear();
+
+  m_end = pos;
+  m_cur = pos;
+
+  return true;
+}
+
+int64_t CBlockCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  int64_t end = ContiguousEnd(iFilePosition);
+  return end >= 0 ? end : iFilePosition;
+}
+
+int64_t CBlockCache::CachedDataEndPos()
+{
+  return m_end;
+}
+
+bool CBlockCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  return ContiguousEnd(iFilePosition, iFilePosition) >= 0;
+}
+
+CCacheStrategy *CBlockCache::CreateNew()
+{
+  return new CBlockCache(m_memorySize, m_spillSize);
+}
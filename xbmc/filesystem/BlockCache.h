@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CACHEBLOCK_H
+#define CACHEBLOCK_H
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace XFILE {
+
+/**
+ * Cache strategy keeping the file in fixed size blocks indexed by file
+ * offset. Unlike CCircularCache, data already fetched stays available
+ * after a seek, so many disjoint ranges can be cached at once and seeking
+ * back into one of them only needs the source to continue where that
+ * range ends. Blocks live in RAM and, if a spill size is given, least
+ * recently used blocks are moved to a temporary file instead of being
+ * dropped.
+ */
+class CBlockCache : public CCacheStrategy
+{
+public:
+    CBlockCache(size_t memorySize, int64_t spillSize = 0);
+    virtual ~CBlockCache();
+
+    virtual int Open();
+    virtual void Close();
+
+    virtual size_t GetMaxWriteSize(const size_t& iRequestSize);
+    virtual int WriteToCache(const char *buf, size_t len);
+    virtual int ReadFromCache(char *buf, size_t len);
+    virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis);
+
+    virtual int64_t Seek(int64_t pos);
+    virtual bool Reset(int64_t pos, bool clearAnyway=true);
+
+    virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition);
+    virtual int64_t CachedDataEndPos();
+    virtual bool IsCachedPosition(int64_t iFilePosition);
+
+    virtual CCacheStrategy *CreateNew();
+
+    static const size_t BLOCK_SIZE = 256 * 1024;
+
+protected:
+    struct Block
+    {
+      uint8_t *data;                        /**< block data if in memory, NULL if spilled */
+      int      slot;                        /**< slot in spill file, -1 if in memory */
+      size_t   begin;                       /**< start of valid data in block */
+      size_t   end;                         /**< end of valid data in block */
+      std::list<int64_t>::iterator lru;     /**< position in m_memoryLru or m_spillLru */
+    };
+    typedef std::map<int64_t, Block> BlockMap;
+
+    /*!
+     \brief End of data available without gap from a position
+     \param pos file position
+     \param limit stop looking further than this position
+     \return end position, or -1 if pos is not cached
+     */
+    int64_t ContiguousEnd(int64_t pos, int64_t limit = INT64_MAX);
+    Block *GetWritableBlock(int64_t index);
+    bool MakeRoom();
+    bool Spill(BlockMap::iterator it);
+    void Drop(BlockMap::iterator it);
+    void Clear();
+
+    BlockMap           m_blocks;
+    std::list<int64_t> m_memoryLru;  /**< blocks in memory, least recently used first */
+    std::list<int64_t> m_spillLru;   /**< blocks in spill file, least recently used first */
+    std::vector<int>   m_freeSlots;
+    int                m_slots;      /**< number of slots used in spill file */
+
+    int64_t           m_cur;         /**< current reading position in file */
+    int64_t           m_end;         /**< current writing position in file */
+    size_t            m_memorySize;
+    size_t            m_maxBlocks;   /**< maximum number of blocks in memory */
+    size_t            m_frontSize;   /**< maximum data ahead of m_cur */
+    int64_t           m_spillSize;
+    int               m_maxSlots;    /**< maximum number of blocks in spill file */
+    std::string       m_spillName;
+    IFile            *m_spillRead;
+    IFile            *m_spillWrite;
+    CCriticalSection  m_sync;
+    CEvent            m_written;
+};
+
+} // namespace XFILE
+#endif
@@ -129,6 +129,23 @@ extern "C" size_t header_callback(void *ptr, size_t size, size_t nmemb, void *st
   return state->HeaderCallback(ptr, size, nmemb);
 }
 
+extern "C" size_t range_write_callback(char *buffer,
+               size_t size,
+               size_t nitems,
+               void *userp)
+{
+  if(userp == NULL) return 0;
+
+  CCurlFile::CRangePrefetcher::Connection *conn = (CCurlFile::CRangePrefetcher::Connection *)userp;
+  return conn->owner->WriteCallback(conn, buffer, size, nitems);
+}
+
+/* range requests only care about the response code, which curl tracks itself */
+extern "C" size_t range_header_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+  return size * nmemb;
+}
+
 /* used only by CCurlFile::Stat to bail out of unwanted transfers */
 extern "C" int transfer_abort_callback(void *clientp,
                curl_off_t dltotal,
@@ -439,6 +456,7 @@ CCurlFile::CCurlFile()
   m_cipherlist = "";
   m_state = new CReadState();
   m_oldState = NULL;
+  m_prefetch = NULL;
   m_skipshout = false;
   m_httpresponse = -1;
   m_acceptCharset = "UTF-8,*;q=0.8"; /* prefer UTF-8 if available */
@@ -456,6 +474,9 @@ void CCurlFile::Close()
   if (m_opened && m_forWrite && !m_inError)
       Write(NULL, 0);
 
+  delete m_prefetch;
+  m_prefetch = NULL;
+
   m_state->Disconnect();
   delete m_oldState;
   m_oldState = NULL;
@@ -536,7 +557,7 @@ void CCurlFile::SetCommonOptions(CReadState* state)
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYPEER, 0);
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYHOST, 0);
 
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_URL, m_url.c_str());
+  g_curlInterface.easy_setopt(h, CURLOPT_URL, m_url.c_str());
   g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_TRANSFERTEXT, FALSE);
 
   // setup POST data if it is set (and it may be empty)
@@ -1086,9 +1107,72 @@ bool CCurlFile::Open(const CURL& url)
     m_url = efurl;
   }
 
+  if (m_seekable && m_multisession && !m_postdataset && m_customrequest.empty() &&
+      g_advancedSettings.m_curlprefetchconnections > 1 &&
+      m_state->m_fileSize > 2 * (int64_t)g_advancedSettings.m_curlprefetchchunksize)
+    StartPrefetch();
+
   return true;
 }
 
+void CCurlFile::StartPrefetch()
+{
+  // the prefetcher takes over from the current position, so stop the
+  // transfer that was used to probe the file
+  g_curlInterface.multi_remove_handle(m_state->m_multiHandle, m_state->m_easyHandle);
+
+  m_prefetch = new CRangePrefetcher(m_state->m_easyHandle, m_url, m_state->m_fileSize,
+                                    g_advancedSettings.m_curlprefetchconnections,
+                                    g_advancedSettings.m_curlprefetchchunksize,
+                                    m_state->m_cancelled);
+  m_prefetch->Seek(m_state->m_filePos);
+
+  CLog::Log(LOGDEBUG, "CCurlFile::StartPrefetch - using %d connections of %d bytes", g_advancedSettings.m_curlprefetchconnections, g_advancedSettings.m_curlprefetchchunksize);
+}
+
+void CCurlFile::StopPrefetch()
+{
+  int64_t pos = m_prefetch->GetPosition();
+  delete m_prefetch;
+  m_prefetch = NULL;
+
+  // reconnect the single stream where the prefetcher left off
+  int64_t size = m_state->m_fileSize;
+  m_state->Disconnect();
+
+  SetCommonOptions(m_state);
+  SetRequestHeaders(m_state);
+
+  m_state->m_fileSize = size;
+  m_state->m_filePos = pos;
+  m_state->m_sendRange = true;
+
+  m_state->Connect(m_bufferSize);
+  SetCorrectHeaders(m_state);
+}
+
+ssize_t CCurlFile::Read(void* lpBuf, size_t uiBufSize)
+{
+  if (m_prefetch)
+  {
+    ssize_t read = m_prefetch->Read(lpBuf, uiBufSize);
+    if (read >= 0 || m_state->m_cancelled)
+      return read;
+
+    CLog::Log(LOGWARNING, "CCurlFile::Read - range prefetch failed, continuing with a single connection");
+    StopPrefetch();
+  }
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+bool CCurlFile::ReadString(char *szLine, int iLineLength)
+{
+  // line based reading is left to the single stream
+  if (m_prefetch)
+    StopPrefetch();
+  return m_state->ReadString(szLine, iLineLength);
+}
+
 bool CCurlFile::OpenForWrite(const CURL& url, bool bOverWrite)
 {
   if(m_opened)
@@ -1262,7 +1346,7 @@ bool CCurlFile::Exists(const CURL& url)
 
 int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  int64_t nextPos = m_state->m_filePos;
+  int64_t nextPos = m_prefetch ? m_prefetch->GetPosition() : m_state->m_filePos;
   
   if(!m_seekable)
     return -1;
@@ -1288,6 +1372,9 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   // We can't seek beyond EOF
   if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
 
+  if (m_prefetch)
+    return m_prefetch->Seek(nextPos) ? nextPos : -1;
+
   if(m_state->Seek(nextPos))
     return nextPos;
 
@@ -1366,6 +1453,8 @@ int64_t CCurlFile::GetLength()
 int64_t CCurlFile::GetPosition()
 {
   if (!m_opened) return 0;
+  if (m_prefetch)
+    return m_prefetch->GetPosition();
   return m_state->m_filePos;
 }
 
@@ -1763,6 +1852,354 @@ void CCurlFile::CReadState::SetReadBuffer(const void* lpBuf, int64_t uiBufSize)
   m_filePos = 0;
 }
 
+CCurlFile::CRangePrefetcher::CRangePrefetcher(CURL_HANDLE* easyTemplate, const std::string& url,
+                                              int64_t fileSize, unsigned int connections,
+                                              unsigned int chunkSize, const bool& cancelled)
+  : m_multiHandle(NULL)
+  , m_fileSize(fileSize)
+  , m_filePos(0)
+  , m_nextStart(0)
+  , m_chunkSize(chunkSize)
+  , m_maxChunks(2 * connections)
+  , m_startTime(XbmcThreads::SystemClockMillis())
+  , m_cancelled(cancelled)
+{
+  m_multiHandle = g_curlInterface.multi_init();
+
+  // connections hold their own address as curl userdata, so never resize after this
+  m_connections.resize(connections);
+  for (std::vector<Connection>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    Connection& conn = *it;
+    conn.easy = NULL;
+    conn.chunk = NULL;
+    conn.started = 0;
+    conn.checked = false;
+    conn.stats = ConnectionStats();
+    conn.owner = this;
+
+    // duplicates share the options of the probing request, including the
+    // header lists owned by it, and go back to the session pool when done
+    g_curlInterface.easy_duplicate(easyTemplate, NULL, &conn.easy, NULL);
+
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_URL, url.c_str());
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_WRITEDATA, &conn);
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_WRITEFUNCTION, range_write_callback);
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_WRITEHEADER, NULL);
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_HEADERFUNCTION, range_header_callback);
+    g_curlInterface.easy_setopt(conn.easy, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0);
+  }
+}
+
+CCurlFile::CRangePrefetcher::~CRangePrefetcher()
+{
+  DropChunks(m_nextStart);
+
+  std::vector<ConnectionStats> stats;
+  GetStats(stats);
+  for (size_t i = 0; i < stats.size(); i++)
+    CLog::Log(LOGDEBUG, "CCurlFile::CRangePrefetcher - connection %u: %u requests, %" PRIu64 " bytes, %u ms, %.0f bytes/s",
+              (unsigned int)i, stats[i].requests, stats[i].bytes, stats[i].busyTime, stats[i].speed);
+
+  for (std::vector<Connection>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+    g_curlInterface.easy_release(&it->easy, NULL);
+
+  if (m_multiHandle)
+    g_curlInterface.multi_cleanup(m_multiHandle);
+}
+
+size_t CCurlFile::CRangePrefetcher::WriteCallback(Connection* conn, char *buffer, size_t size, size_t nitems)
+{
+  size_t amount = size * nitems;
+  Chunk* chunk = conn->chunk;
+  if (!chunk)
+    return 0;
+
+  if (!conn->checked)
+  {
+    // a server that answers with the whole body ignored our range, so this
+    // mode cannot work against it
+    long code = 0;
+    g_curlInterface.easy_getinfo(conn->easy, CURLINFO_RESPONSE_CODE, &code);
+    if (code != 206)
+    {
+      CLog::Log(LOGWARNING, "CCurlFile::CRangePrefetcher - server answered range request with %ld", code);
+      chunk->failed = true;
+      return 0;
+    }
+    conn->checked = true;
+  }
+
+  size_t room = (size_t)(chunk->end - chunk->start) - chunk->data.size();
+  size_t used = std::min(amount, room);
+  chunk->data.insert(chunk->data.end(), buffer, buffer + used);
+  conn->stats.bytes += used;
+
+  return amount;
+}
+
+void CCurlFile::CRangePrefetcher::Schedule()
+{
+  while (m_chunks.size() < m_maxChunks && m_nextStart < m_fileSize)
+  {
+    Chunk* chunk = new Chunk();
+    chunk->start = m_nextStart;
+    chunk->end = std::min(m_nextStart + (int64_t)m_chunkSize, m_fileSize);
+    chunk->connection = -1;
+    chunk->retries = 0;
+    chunk->done = false;
+    chunk->failed = false;
+    chunk->data.reserve((size_t)(chunk->end - chunk->start));
+
+    m_chunks.push_back(chunk);
+    m_nextStart = chunk->end;
+  }
+
+  // hand idle connections the earliest chunks that still miss data
+  std::vector<Connection>::iterator conn = m_connections.begin();
+  for (std::deque<Chunk*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+  {
+    Chunk* chunk = *it;
+    if (chunk->done || chunk->failed || chunk->connection >= 0)
+      continue;
+
+    while (conn != m_connections.end() && conn->chunk)
+      ++conn;
+    if (conn == m_connections.end())
+      break;
+
+    if (!Start(*conn, chunk))
+      chunk->failed = true;
+  }
+}
+
+bool CCurlFile::CRangePrefetcher::Start(Connection& conn, Chunk* chunk)
+{
+  int64_t from = chunk->start + chunk->data.size();
+  std::string range = StringUtils::Format("%" PRId64 "-%" PRId64, from, chunk->end - 1);
+  g_curlInterface.easy_setopt(conn.easy, CURLOPT_RANGE, range.c_str());
+
+  conn.chunk = chunk;
+  conn.checked = false;
+  conn.started = XbmcThreads::SystemClockMillis();
+  conn.stats.requests++;
+  chunk->connection = (int)(&conn - &m_connections[0]);
+
+  if (g_curlInterface.multi_add_handle(m_multiHandle, conn.easy) != CURLM_OK)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CRangePrefetcher - failed to start range %s", range.c_str());
+    conn.chunk = NULL;
+    chunk->connection = -1;
+    return false;
+  }
+  return true;
+}
+
+void CCurlFile::CRangePrefetcher::Detach(Chunk* chunk)
+{
+  if (chunk->connection < 0)
+    return;
+
+  Connection& conn = m_connections[chunk->connection];
+  g_curlInterface.multi_remove_handle(m_multiHandle, conn.easy);
+  conn.stats.busyTime += XbmcThreads::SystemClockMillis() - conn.started;
+  conn.chunk = NULL;
+  chunk->connection = -1;
+}
+
+void CCurlFile::CRangePrefetcher::DropChunks(int64_t pos)
+{
+  while (!m_chunks.empty() && m_chunks.front()->end <= pos)
+  {
+    Detach(m_chunks.front());
+    delete m_chunks.front();
+    m_chunks.pop_front();
+  }
+}
+
+bool CCurlFile::CRangePrefetcher::Seek(int64_t pos)
+{
+  if (pos < 0 || pos > m_fileSize)
+    return false;
+
+  if (!m_chunks.empty() && pos >= m_chunks.front()->start && pos < m_nextStart)
+    DropChunks(pos);
+  else
+  {
+    DropChunks(m_nextStart);
+    m_nextStart = pos;
+  }
+
+  m_filePos = pos;
+  Schedule();
+  return true;
+}
+
+ssize_t CCurlFile::CRangePrefetcher::Read(void* lpBuf, size_t uiBufSize)
+{
+  if (m_filePos >= m_fileSize)
+    return 0;
+
+  while (!m_cancelled)
+  {
+    Schedule();
+    if (m_chunks.empty())
+      return 0;
+
+    Chunk* head = m_chunks.front();
+    size_t offset = (size_t)(m_filePos - head->start);
+    if (head->data.size() > offset)
+    {
+      size_t amount = std::min(uiBufSize, head->data.size() - offset);
+      memcpy(lpBuf, &head->data[offset], amount);
+      m_filePos += amount;
+      DropChunks(m_filePos);
+      return amount;
+    }
+
+    if (head->failed)
+      return -1;
+
+    if (!Perform())
+      return -1;
+  }
+  return -1;
+}
+
+bool CCurlFile::CRangePrefetcher::Perform()
+{
+  int running = 0;
+  CURLMcode result = g_curlInterface.multi_perform(m_multiHandle, &running);
+  if (result != CURLM_OK && result != CURLM_CALL_MULTI_PERFORM)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CRangePrefetcher - Multi perform failed with code %d", result);
+    return false;
+  }
+
+  int msgs;
+  CURLMsg* msg;
+  while ((msg = g_curlInterface.multi_info_read(m_multiHandle, &msgs)))
+  {
+    if (msg->msg == CURLMSG_DONE)
+      HandleDone(msg->easy_handle, msg->data.result);
+  }
+
+  // finished requests are replaced on the next Schedule(), no need to wait for them
+  if (result == CURLM_CALL_MULTI_PERFORM || running == 0)
+    return true;
+
+  int maxfd = -1;
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+  FD_ZERO(&fdread);
+  FD_ZERO(&fdwrite);
+  FD_ZERO(&fdexcep);
+
+  g_curlInterface.multi_fdset(m_multiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+  long timeout = 0;
+  if (CURLM_OK != g_curlInterface.multi_timeout(m_multiHandle, &timeout) || timeout == -1 || timeout > 200)
+    timeout = 200;
+
+  int rc;
+  do
+  {
+    if (maxfd == -1)
+    {
+#ifdef TARGET_WINDOWS
+      Sleep(100);
+      rc = 0;
+#else
+      struct timeval wait = { 0, 100 * 1000 }; /* 100ms */
+      rc = select(0, NULL, NULL, NULL, &wait);
+#endif
+    }
+    else
+    {
+      struct timeval wait = { (int)timeout / 1000, ((int)timeout % 1000) * 1000 };
+      rc = select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &wait);
+    }
+#ifdef TARGET_WINDOWS
+  } while(rc == SOCKET_ERROR && WSAGetLastError() == WSAEINTR);
+#else
+  } while(rc == SOCKET_ERROR && errno == EINTR);
+#endif
+
+  if (rc == SOCKET_ERROR)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CRangePrefetcher - Failed with socket error");
+    return false;
+  }
+  return true;
+}
+
+void CCurlFile::CRangePrefetcher::HandleDone(CURL_HANDLE* easy, int result)
+{
+  Chunk* chunk = NULL;
+  for (std::vector<Connection>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    if (it->easy == easy)
+    {
+      chunk = it->chunk;
+      break;
+    }
+  }
+  if (!chunk)
+    return;
+
+  Detach(chunk);
+
+  if (chunk->failed)
+    return;
+
+  if (chunk->start + (int64_t)chunk->data.size() == chunk->end)
+  {
+    chunk->done = true;
+    return;
+  }
+
+  // resume the range where it stopped on the next Schedule()
+  if (chunk->retries < g_advancedSettings.m_curlretries)
+  {
+    chunk->retries++;
+    CLog::Log(LOGWARNING, "CCurlFile::CRangePrefetcher - range %" PRId64 " failed: %s(%d), (re)try %i",
+              chunk->start, g_curlInterface.easy_strerror((CURLcode)result), result, chunk->retries);
+    return;
+  }
+
+  CLog::Log(LOGERROR, "CCurlFile::CRangePrefetcher - range %" PRId64 " failed: %s(%d)",
+            chunk->start, g_curlInterface.easy_strerror((CURLcode)result), result);
+  chunk->failed = true;
+}
+
+double CCurlFile::CRangePrefetcher::GetDownloadSpeed() const
+{
+  uint64_t bytes = 0;
+  for (std::vector<Connection>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+    bytes += it->stats.bytes;
+
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - m_startTime;
+  if (elapsed == 0)
+    return 0.0;
+  return bytes * 1000.0 / elapsed;
+}
+
+void CCurlFile::CRangePrefetcher::GetStats(std::vector<ConnectionStats>& stats) const
+{
+  unsigned int now = XbmcThreads::SystemClockMillis();
+
+  stats.clear();
+  for (std::vector<Connection>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    ConnectionStats s = it->stats;
+    if (it->chunk)
+      s.busyTime += now - it->started;
+    s.speed = s.busyTime ? s.bytes * 1000.0 / s.busyTime : 0.0;
+    stats.push_back(s);
+  }
+}
+
 void CCurlFile::ClearRequestHeaders()
 {
   m_requestheaders.clear();
@@ -1932,6 +2369,9 @@ int CCurlFile::IoControl(EIoControl request, void* param)
 
 double CCurlFile::GetDownloadSpeed()
 {
+  if (m_prefetch)
+    return m_prefetch->GetDownloadSpeed();
+
   double res = 0.0f;
   g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_SPEED_DOWNLOAD, &res);
   return res;
@@ -21,8 +21,10 @@
 
 #include "IFile.h"
 #include "utils/RingBuffer.h"
+#include <deque>
 #include <map>
 #include <string>
+#include <vector>
 #include "utils/HttpHeader.h"
 
 namespace XCURL
@@ -58,8 +60,8 @@ namespace XFILE
       virtual int64_t  GetLength();
       virtual int  Stat(const CURL& url, struct __stat64* buffer);
       virtual void Close();
-      virtual bool ReadString(char *szLine, int iLineLength)     { return m_state->ReadString(szLine, iLineLength); }
-      virtual ssize_t Read(void* lpBuf, size_t uiBufSize)        { return m_state->Read(lpBuf, uiBufSize); }
+      virtual bool ReadString(char *szLine, int iLineLength);
+      virtual ssize_t Read(void* lpBuf, size_t uiBufSize);
       virtual ssize_t Write(const void* lpBuf, size_t uiBufSize);
       virtual std::string GetMimeType()                          { return m_state->m_httpheader.GetMimeType(); }
       virtual std::string GetContent()                           { return m_state->m_httpheader.GetValue("content-type"); }
@@ -153,16 +155,89 @@ namespace XFILE
           void         Disconnect();
       };
 
+      /*!
+       \brief Fetches a seekable http resource through several concurrent
+       byte-range requests ahead of the read position and hands the data
+       back in order.
+       */
+      class CRangePrefetcher
+      {
+      public:
+          struct ConnectionStats
+          {
+            uint64_t     bytes;      // payload bytes received
+            unsigned int requests;   // range requests issued
+            unsigned int busyTime;   // ms spent with a request in flight
+            double       speed;      // bytes per second while busy
+          };
+
+          struct Chunk
+          {
+            int64_t           start;
+            int64_t           end;         // exclusive
+            std::vector<char> data;
+            int               connection;  // index into m_connections, -1 when idle
+            int               retries;
+            bool              done;
+            bool              failed;
+          };
+
+          struct Connection
+          {
+            XCURL::CURL_HANDLE* easy;
+            Chunk*              chunk;
+            unsigned int        started;
+            bool                checked;     // response code verified for current request
+            ConnectionStats     stats;
+            CRangePrefetcher*   owner;
+          };
+
+          CRangePrefetcher(XCURL::CURL_HANDLE* easyTemplate, const std::string& url,
+                           int64_t fileSize, unsigned int connections,
+                           unsigned int chunkSize, const bool& cancelled);
+          ~CRangePrefetcher();
+
+          bool         Seek(int64_t pos);
+          ssize_t      Read(void* lpBuf, size_t uiBufSize);
+          int64_t      GetPosition() const { return m_filePos; }
+          double       GetDownloadSpeed() const;
+          void         GetStats(std::vector<ConnectionStats>& stats) const;
+
+          size_t       WriteCallback(Connection* conn, char *buffer, size_t size, size_t nitems);
+
+      private:
+          void         Schedule();
+          bool         Start(Connection& conn, Chunk* chunk);
+          void         Detach(Chunk* chunk);
+          void         DropChunks(int64_t pos);
+          bool         Perform();
+          void         HandleDone(XCURL::CURL_HANDLE* easy, int result);
+
+          XCURL::CURLM*            m_multiHandle;
+          std::vector<Connection>  m_connections;
+          std::deque<Chunk*>       m_chunks;
+          int64_t                  m_fileSize;
+          int64_t                  m_filePos;
+          int64_t                  m_nextStart;   // first byte not yet scheduled
+          unsigned int             m_chunkSize;
+          unsigned int             m_maxChunks;
+          unsigned int             m_startTime;
+          const bool&              m_cancelled;   // owned by the read state of the file
+      };
+
     protected:
       void ParseAndCorrectUrl(CURL &url);
       void SetCommonOptions(CReadState* state);
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
+      void StartPrefetch();
+      void StopPrefetch();
       bool Service(const std::string& strURL, std::string& strHTML);
 
     protected:
       CReadState*     m_state;
       CReadState*     m_oldState;
+      CRangePrefetcher* m_prefetch;
       unsigned int    m_bufferSize;
       int64_t         m_writeOffset;
 
@@ -163,6 +163,7 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
         g_directoryCache.ClearDirectory(realURL.Get());
 
       pDirectory->SetFlags(hints.flags);
+      pDirectory->SetListingObserver(hints.observer);
 
       bool result = false, cancel = false;
       while (!result && !cancel)
@@ -192,11 +193,15 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
         {
           if (!cancel && g_application.IsCurrentThread() && pDirectory->ProcessRequirements())
             continue;
+          pDirectory->SetListingObserver(NULL);
           CLog::Log(LOGERROR, "%s - Error getting %s", __FUNCTION__, url.GetRedacted().c_str());
           return false;
         }
       }
 
+      // a cancelled fetch may still be running, so detach the observer
+      pDirectory->SetListingObserver(NULL);
+
       // cache the directory, if necessary
       if (!(hints.flags & DIR_FLAG_BYPASS_CACHE))
         g_directoryCache.SetDirectory(realURL.Get(), items, pDirectory->GetCacheType(url));
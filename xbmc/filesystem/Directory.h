@@ -37,11 +37,12 @@ public:
   class CHints
   {
   public:
-    CHints() : flags(DIR_FLAG_DEFAULTS)
+    CHints() : flags(DIR_FLAG_DEFAULTS), observer(NULL)
     {
     };
     std::string mask;
     int flags;
+    IDirectoryListingObserver* observer; ///< receives entries while the directory is being listed
   };
 
   static bool GetDirectory(const CURL& url
@@ -20,6 +20,7 @@
 
 #include "DirectoryCache.h"
 #include "FileItem.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
@@ -28,19 +29,23 @@
 #include "climits"
 
 #include <algorithm>
+#include <functional>
 
 // Maximum number of directories to keep in our cache
 #define MAX_CACHED_DIRS 50
 
 using namespace XFILE;
 
-CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
+CDirectoryCache::CDir::CDir(const std::string &path, DIR_CACHE_TYPE cacheType)
 {
+  m_path = path;
   m_cacheType = cacheType;
   m_lastAccess = 0;
+  m_memorySize = sizeof(CDir) + path.size();
+  m_prev = NULL;
+  m_next = NULL;
   m_Items = new CFileItemList;
   m_Items->SetIgnoreURLOptions(true);
-  m_Items->SetFastLookup(true);
 }
 
 CDirectoryCache::CDir::~CDir()
@@ -48,34 +53,124 @@ CDirectoryCache::CDir::~CDir()
   delete m_Items;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+void CDirectoryCache::CDir::SetItems(const CFileItemList &items)
+{
+  m_Items->Copy(items);
+  for (int i = 0; i < m_Items->Size(); ++i)
+  {
+    const CFileItemPtr item = m_Items->Get(i);
+    m_memorySize += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size();
+    m_memorySize += AddFileName(item->GetPath());
+  }
+}
+
+void CDirectoryCache::CDir::AddFile(const std::string &file)
+{
+  CFileItemPtr item(new CFileItem(file, false));
+  m_Items->Add(item);
+  m_memorySize += sizeof(CFileItem) + file.size() + item->GetLabel().size();
+  m_memorySize += AddFileName(file);
+}
+
+size_t CDirectoryCache::CDir::AddFileName(const std::string &file)
+{
+  std::string fileName = CURL(file).GetWithoutOptions();
+  size_t size = fileName.size() + sizeof(std::string);
+  if (!m_files.insert(std::move(fileName)).second)
+    return 0;
+  return size;
+}
+
+bool CDirectoryCache::CDir::Contains(const std::string &file) const
+{
+  return m_files.find(file) != m_files.end();
+}
+
+void CDirectoryCache::CDir::SetLastAccess(std::atomic<unsigned int> &accessCounter)
 {
   m_lastAccess = accessCounter++;
 }
 
+void CDirectoryCache::CShard::Link(CDir *dir)
+{
+  dir->m_prev = NULL;
+  dir->m_next = m_head;
+  if (m_head)
+    m_head->m_prev = dir;
+  m_head = dir;
+  if (!m_tail)
+    m_tail = dir;
+}
+
+void CDirectoryCache::CShard::Unlink(CDir *dir)
+{
+  if (dir->m_prev)
+    dir->m_prev->m_next = dir->m_next;
+  else
+    m_head = dir->m_next;
+  if (dir->m_next)
+    dir->m_next->m_prev = dir->m_prev;
+  else
+    m_tail = dir->m_prev;
+  dir->m_prev = dir->m_next = NULL;
+}
+
+void CDirectoryCache::CShard::Touch(CDir *dir)
+{
+  if (m_head == dir)
+    return;
+  Unlink(dir);
+  Link(dir);
+}
+
+CDirectoryCache::CDir* CDirectoryCache::CShard::GetOldest(const CDir *keep) const
+{
+  // ensure dirs that are always cached aren't cleared
+  for (CDir *dir = m_tail; dir; dir = dir->m_prev)
+  {
+    if (dir->m_cacheType != DIR_CACHE_ALWAYS && dir != keep)
+      return dir;
+  }
+  return NULL;
+}
+
 CDirectoryCache::CDirectoryCache(void)
 {
   m_accessCounter = 0;
-#ifdef _DEBUG
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
-#endif
+  m_numCached = 0;
+  m_memorySize = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void)
 {
 }
 
-bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+CDirectoryCache::CShard& CDirectoryCache::GetShard(const std::string &storedPath)
 {
-  CSingleLock lock (m_cs);
+  return m_shards[std::hash<std::string>()(storedPath) % NUM_SHARDS];
+}
+
+void CDirectoryCache::UpdateStats(CShard &shard, const CURL &url, bool hit)
+{
+  CacheStats &stats = shard.m_stats[url.GetProtocol().empty() ? "file" : url.GetProtocol()];
+  if (hit)
+    stats.hits++;
+  else
+    stats.misses++;
+}
 
+bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+{
   // Get rid of any URL options, else the compare may be wrong
-  std::string storedPath = CURL(strPath).GetWithoutOptions();
+  CURL url(strPath);
+  std::string storedPath = url.GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  ciCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
   {
     CDir* dir = i->second;
     if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
@@ -83,12 +178,12 @@ bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &it
     {
       items.Copy(*dir->m_Items);
       dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
+      shard.Touch(dir);
+      UpdateStats(shard, url, true);
       return true;
     }
   }
+  UpdateStats(shard, url, false);
   return false;
 }
 
@@ -108,20 +203,33 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
 
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  // copy the items before taking the lock
+  CDir* dir = new CDir(storedPath, cacheType);
+  dir->SetItems(items);
+
+  {
+    CShard &shard = GetShard(storedPath);
+    CSingleLock lock (shard.m_cs);
+
+    iCache i = shard.m_cache.find(storedPath);
+    if (i != shard.m_cache.end())
+      Delete(shard, i);
 
-  CheckIfFull();
+    dir->SetLastAccess(m_accessCounter);
+    shard.m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
+    shard.Link(dir);
+    m_memorySize += dir->GetMemorySize();
+    if (cacheType != DIR_CACHE_ALWAYS)
+      m_numCached++;
+  }
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
+  // the listing just added is never evicted, even if it alone exceeds the budget
+  CheckIfFull(dir);
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -134,88 +242,119 @@ void CDirectoryCache::ClearFile(const std::string& strFile)
 
 void CDirectoryCache::ClearDirectory(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
+    Delete(shard, i);
 }
 
 void CDirectoryCache::ClearSubPaths(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    if (URIUtils::PathHasParent(i->first, storedPath))
-      Delete(i++);
-    else
-      i++;
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end())
+    {
+      if (URIUtils::PathHasParent(i->first, storedPath))
+        Delete(shard, i++);
+      else
+        i++;
+    }
   }
 }
 
 void CDirectoryCache::AddFile(const std::string& strFile)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string strPath = URIUtils::GetDirectory(CURL(strFile).GetWithoutOptions());
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(strPath);
+  CSingleLock lock (shard.m_cs);
+
+  ciCache i = shard.m_cache.find(strPath);
+  if (i != shard.m_cache.end())
   {
     CDir *dir = i->second;
-    CFileItemPtr item(new CFileItem(strFile, false));
-    dir->m_Items->Add(item);
+    size_t size = dir->GetMemorySize();
+    dir->AddFile(strFile);
+    m_memorySize += dir->GetMemorySize() - size;
     dir->SetLastAccess(m_accessCounter);
+    shard.Touch(dir);
   }
 }
 
 bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   // Get rid of any URL options, else the compare may be wrong
-  std::string strPath = CURL(strFile).GetWithoutOptions();
+  CURL url(strFile);
+  std::string strFileName = url.GetWithoutOptions();
+  std::string strPath = strFileName;
   URIUtils::RemoveSlashAtEnd(strPath);
   std::string storedPath = URIUtils::GetDirectory(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  ciCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
   {
     bInCache = true;
     CDir *dir = i->second;
     dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-    m_cacheHits++;
-#endif
-    return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile));
+    shard.Touch(dir);
+    UpdateStats(shard, url, true);
+    return (URIUtils::PathEquals(strPath, storedPath) || dir->Contains(strFileName));
   }
-#ifdef _DEBUG
-  m_cacheMisses++;
-#endif
+  UpdateStats(shard, url, false);
   return false;
 }
 
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
+  {
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end() )
+      Delete(shard, i++);
+  }
+}
+
+std::map<std::string, CDirectoryCache::CacheStats> CDirectoryCache::GetStats() const
+{
+  std::map<std::string, CacheStats> stats;
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
+  {
+    const CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+
+    for (std::map<std::string, CacheStats>::const_iterator i = shard.m_stats.begin(); i != shard.m_stats.end(); ++i)
+    {
+      CacheStats &total = stats[i->first];
+      total.hits += i->second.hits;
+      total.misses += i->second.misses;
+    }
+  }
+  return stats;
 }
 
 void CDirectoryCache::InitCache(std::set<std::string>& dirs)
@@ -232,60 +371,86 @@ void CDirectoryCache::InitCache(std::set<std::string>& dirs)
 
 void CDirectoryCache::ClearCache(std::set<std::string>& dirs)
 {
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    if (dirs.find(i->first) != dirs.end())
-      Delete(i++);
-    else
-      i++;
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end())
+    {
+      if (dirs.find(i->first) != dirs.end())
+        Delete(shard, i++);
+      else
+        i++;
+    }
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(const CDir *keep)
 {
-  CSingleLock lock (m_cs);
-
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // remove the least recently used folders while there are too many of them or
+  // they take up too much memory. Each shard keeps its own LRU order, so pick
+  // the oldest of the shards' least recently used folders.
+  while (m_numCached > MAX_CACHED_DIRS ||
+         m_memorySize > g_advancedSettings.m_directoryCacheMemSize)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    unsigned int oldestAccess = UINT_MAX;
+    CShard *oldestShard = NULL;
+    for (unsigned int s = 0; s < NUM_SHARDS; s++)
     {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
+      CSingleLock lock (m_shards[s].m_cs);
+      const CDir *dir = m_shards[s].GetOldest(keep);
+      if (dir && (!oldestShard || dir->GetLastAccess() < oldestAccess))
+      {
+        oldestAccess = dir->GetLastAccess();
+        oldestShard = &m_shards[s];
+      }
     }
+    if (!oldestShard)
+      break;
+
+    // the shard may have changed in between, just take its oldest folder
+    CSingleLock lock (oldestShard->m_cs);
+    CDir *dir = oldestShard->GetOldest(keep);
+    if (dir)
+      Delete(*oldestShard, oldestShard->m_cache.find(dir->m_path));
   }
-  if (lastAccessed != m_cache.end() && numCached >= MAX_CACHED_DIRS)
-    Delete(lastAccessed);
 }
 
-void CDirectoryCache::Delete(iCache it)
+void CDirectoryCache::Delete(CShard &shard, iCache it)
 {
   CDir* dir = it->second;
+  shard.Unlink(dir);
+  m_memorySize -= dir->GetMemorySize();
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+    m_numCached--;
   delete dir;
-  m_cache.erase(it);
+  shard.m_cache.erase(it);
 }
 
 #ifdef _DEBUG
 void CDirectoryCache::PrintStats() const
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
+  std::map<std::string, CacheStats> stats = GetStats();
+  for (std::map<std::string, CacheStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
+    CLog::Log(LOGDEBUG, "%s - %s: total of %u cache hits, and %u cache misses", __FUNCTION__, i->first.c_str(), i->second.hits, i->second.misses);
+
   // run through and find the oldest and the number of items cached
   unsigned int oldest = UINT_MAX;
   unsigned int numItems = 0;
   unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    CDir *dir = i->second;
-    oldest = std::min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    CSingleLock lock (m_shards[s].m_cs);
+    for (ciCache i = m_shards[s].m_cache.begin(); i != m_shards[s].m_cache.end(); i++)
+    {
+      CDir *dir = i->second;
+      oldest = std::min(oldest, dir->GetLastAccess());
+      numItems += dir->m_Items->Size();
+      numDirs++;
+    }
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total (%u bytes).  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, (unsigned int)m_memorySize, oldest, (unsigned int)m_accessCounter);
 }
 #endif
@@ -23,10 +23,15 @@
 #include "Directory.h"
 #include "threads/CriticalSection.h"
 
+#include <atomic>
 #include <map>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 class CFileItem;
+class CURL;
 
 namespace XFILE
 {
@@ -35,18 +40,40 @@ namespace XFILE
     class CDir
     {
     public:
-      CDir(DIR_CACHE_TYPE cacheType);
+      CDir(const std::string &path, DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
+      void SetItems(const CFileItemList &items);
+      void AddFile(const std::string &file);
+      bool Contains(const std::string &file) const;
+
+      void SetLastAccess(std::atomic<unsigned int> &accessCounter);
       unsigned int GetLastAccess() const { return m_lastAccess; };
+      size_t GetMemorySize() const { return m_memorySize; };
 
+      std::string m_path;
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+
+      // links of the LRU list of the shard, most recently used first
+      CDir* m_prev;
+      CDir* m_next;
     private:
+      size_t AddFileName(const std::string &file);
+
+      std::unordered_set<std::string> m_files;
       unsigned int m_lastAccess;
+      size_t m_memorySize;
     };
+
   public:
+    struct CacheStats
+    {
+      CacheStats() : hits(0), misses(0) {}
+      unsigned int hits;
+      unsigned int misses;
+    };
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false);
@@ -57,27 +84,59 @@ namespace XFILE
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
+
+    /*! \brief Get the cache hits and misses of GetDirectory() and FileExists() per protocol
+     \return map of protocol to statistics
+     */
+    std::map<std::string, CacheStats> GetStats() const;
+
+    /*! \brief Get the estimated memory used by the cached listings
+     \return size in bytes
+     */
+    size_t GetMemorySize() const { return m_memorySize; };
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
   protected:
+    /*! \brief Cached directories whose paths hash to the same shard, guarded by
+     their own lock so that lookups of unrelated paths don't contend.
+     */
+    class CShard
+    {
+    public:
+      CShard() : m_head(NULL), m_tail(NULL) {}
+
+      void Link(CDir *dir);
+      void Unlink(CDir *dir);
+      void Touch(CDir *dir);
+      CDir* GetOldest(const CDir *keep = NULL) const;
+
+      mutable CCriticalSection m_cs;
+      std::unordered_map<std::string, CDir*> m_cache;
+      std::map<std::string, CacheStats> m_stats;
+      CDir* m_head;
+      CDir* m_tail;
+    };
+    typedef std::unordered_map<std::string, CDir*>::iterator iCache;
+    typedef std::unordered_map<std::string, CDir*>::const_iterator ciCache;
+
     void InitCache(std::set<std::string>& dirs);
     void ClearCache(std::set<std::string>& dirs);
-    void CheckIfFull();
-
-    std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
-    void Delete(iCache i);
+    /*! \brief Evict the least recently used folders while the cache is full
+     \param keep folder that must not be evicted, NULL for none
+     */
+    void CheckIfFull(const CDir *keep = NULL);
 
-    CCriticalSection m_cs;
+    CShard& GetShard(const std::string &storedPath);
+    void Delete(CShard &shard, iCache i);
+    void UpdateStats(CShard &shard, const CURL &url, bool hit);
 
-    unsigned int m_accessCounter;
+    static const unsigned int NUM_SHARDS = 16;
+    CShard m_shards[NUM_SHARDS];
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    std::atomic<unsigned int> m_accessCounter;
+    std::atomic<unsigned int> m_numCached;   ///< directories that may be evicted
+    std::atomic<size_t>       m_memorySize;  ///< estimated size of all directories
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -24,6 +24,7 @@
 #include "File.h"
 #include "URL.h"
 
+#include "BlockCache.h"
 #include "CircularCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
@@ -207,7 +208,10 @@ bool CFileCache::Open(const CURL& url)
         front /= 2;
         back /= 2;
       }
-      m_pCache = new CCircularCache(front, back);
+      if (g_advancedSettings.m_cacheSparse)
+        m_pCache = new CBlockCache(front + back, (int64_t)g_advancedSettings.m_cacheSpillSize * 1024 * 1024);
+      else
+        m_pCache = new CCircularCache(front, back);
       m_forwardCacheSize = front;
     }
 
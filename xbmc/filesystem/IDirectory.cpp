@@ -19,18 +19,24 @@
  */
 
 #include "IDirectory.h"
+#include "FileItem.h"
 #include "dialogs/GUIDialogOK.h"
 #include "guilib/GUIKeyboardFactory.h"
 #include "URL.h"
 #include "PasswordManager.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
+#include "threads/SingleLock.h"
 
 using namespace XFILE;
 
+#define PARTIAL_LISTING_BATCH 100
+
 IDirectory::IDirectory(void)
 {
   m_flags = DIR_FLAG_DEFAULTS;
+  m_listingObserver = NULL;
+  m_notifiedItems = 0;
 }
 
 IDirectory::~IDirectory(void)
@@ -119,6 +125,28 @@ void IDirectory::SetFlags(int flags)
   m_flags = flags;
 }
 
+void IDirectory::SetListingObserver(IDirectoryListingObserver* observer)
+{
+  CSingleLock lock(m_observerSection);
+  m_listingObserver = observer;
+  m_notifiedItems = 0;
+}
+
+void IDirectory::NotifyPartialListing(const CFileItemList& items)
+{
+  CSingleLock lock(m_observerSection);
+  if (!m_listingObserver || items.Size() - m_notifiedItems < PARTIAL_LISTING_BATCH)
+    return;
+
+  // copies, the listing keeps changing its items while the observer works on them
+  CFileItemList batch(items.GetPath());
+  for (int i = m_notifiedItems; i < items.Size(); i++)
+    batch.Add(CFileItemPtr(new CFileItem(*items.Get(i))));
+  m_notifiedItems = items.Size();
+
+  m_listingObserver->OnPartialListing(batch);
+}
+
 bool IDirectory::ProcessRequirements()
 {
   std::string type = m_requirements["type"].asString();
@@ -20,6 +20,7 @@
  */
 
 #include <string>
+#include "threads/CriticalSection.h"
 #include "utils/Variant.h"
 
 class CFileItemList;
@@ -48,6 +49,23 @@ namespace XFILE
     DIR_FLAG_READ_CACHE    = (2 << 4), ///< Force reading from the directory cache (if available)
     DIR_FLAG_BYPASS_CACHE  = (2 << 5)  ///< Completely bypass the directory cache (no reading, no writing)
   };
+/*!
+ \ingroup filesystem
+ \brief Receives the entries of a directory while it is still being listed.
+ \sa IDirectory::SetListingObserver
+ */
+class IDirectoryListingObserver
+{
+public:
+  virtual ~IDirectoryListingObserver() {}
+  /*!
+   \brief Called on the listing thread with the entries added since the previous call.
+   The items are copies of the entries of the listing, which has not been filtered yet.
+   \param items Batch of newly listed entries.
+   */
+  virtual void OnPartialListing(const CFileItemList& items) = 0;
+};
+
 /*!
  \ingroup filesystem
  \brief Interface to the directory on a file system.
@@ -130,6 +148,22 @@ public:
   void SetMask(const std::string& strMask);
   void SetFlags(int flags);
 
+  /*! \brief Set the observer that receives entries while GetDirectory is running.
+   Implementations that list slowly (network shares) hand out batches through
+   NotifyPartialListing. Setting NULL waits for a running notification to return.
+   \param observer the observer, or NULL to detach.
+   \sa NotifyPartialListing
+   */
+  void SetListingObserver(IDirectoryListingObserver* observer);
+
+  /*! \brief Pass the entries listed so far to the listing observer.
+   Call this from GetDirectory after adding entries. Entries are handed on in
+   batches, so it is cheap to call it for every entry.
+   \param items the listing being filled by GetDirectory.
+   \sa SetListingObserver
+   */
+  void NotifyPartialListing(const CFileItemList& items);
+
   /*! \brief Process additional requirements before the directory fetch is performed.
    Some directory fetches may require authentication, keyboard input etc.  The IDirectory subclass
    should call GetKeyboardInput, SetErrorDialog or RequireAuthentication and then return false 
@@ -175,5 +209,11 @@ protected:
   int m_flags; ///< Directory flags - see DIR_FLAG
 
   CVariant m_requirements;
+
+  IDirectoryListingObserver* m_listingObserver; ///< Observer set by SetListingObserver()
+
+private:
+  CCriticalSection m_observerSection;
+  int m_notifiedItems; ///< Number of listed entries already handed to the observer
 };
 }
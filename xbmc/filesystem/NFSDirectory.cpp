@@ -247,6 +247,7 @@ bool CNFSDirectory::GetDirectory(const CURL& url, CFileItemList &items)
       path = linkUrl.Get();
     }
     
+    // libnfs lists with READDIRPLUS, the attributes come with the entry
     iSize = tmpDirent.size;
     bIsDir = tmpDirent.type == NF3DIR;
     lTimeDate = tmpDirent.mtime.tv_sec;
@@ -284,6 +285,7 @@ bool CNFSDirectory::GetDirectory(const CURL& url, CFileItemList &items)
       }
       pItem->SetPath(path);
       items.Add(pItem);
+      NotifyPartialListing(items);
     }
   }
 
@@ -37,7 +37,7 @@ CSFTPDirectory::~CSFTPDirectory(void)
 bool CSFTPDirectory::GetDirectory(const CURL& url, CFileItemList &items)
 {
   CSFTPSessionPtr session = CSFTPSessionManager::CreateSession(url);
-  return session->GetDirectory(url.GetWithoutFilename().c_str(), url.GetFileName().c_str(), items);
+  return session->GetDirectory(url.GetWithoutFilename().c_str(), url.GetFileName().c_str(), items, this);
 }
 
 bool CSFTPDirectory::Exists(const CURL& url)
@@ -20,6 +20,7 @@
 
 #include "threads/SystemClock.h"
 #include "SFTPFile.h"
+#include "IDirectory.h"
 #ifdef HAS_FILESYSTEM_SFTP
 #include "threads/SingleLock.h"
 #include "utils/log.h"
@@ -142,7 +143,7 @@ void CSFTPSession::CloseFileHandle(sftp_file handle)
   sftp_close(handle);
 }
 
-bool CSFTPSession::GetDirectory(const std::string &base, const std::string &folder, CFileItemList &items)
+bool CSFTPSession::GetDirectory(const std::string &base, const std::string &folder, CFileItemList &items, XFILE::IDirectory *directory)
 {
   int sftp_error = SSH_FX_OK;
   if (m_connected)
@@ -189,6 +190,8 @@ bool CSFTPSession::GetDirectory(const std::string &base, const std::string &fold
           std::string localPath = folder;
           localPath.append(itemName);
 
+          // sftp_readdir() returns the attributes with the name, only
+          // symlinks need a stat of their own
           if (attributes->type == SSH_FILEXFER_TYPE_SYMLINK)
           {
             CSingleLock lock(m_critSect);
@@ -220,6 +223,8 @@ bool CSFTPSession::GetDirectory(const std::string &base, const std::string &fold
 
           pItem->SetPath(base + localPath);
           items.Add(pItem);
+          if (directory)
+            directory->NotifyPartialListing(items);
 
           {
             CSingleLock lock(m_critSect);
@@ -39,6 +39,11 @@
 
 class CURL;
 
+namespace XFILE
+{
+  class IDirectory;
+}
+
 #if LIBSSH_VERSION_INT < SSH_VERSION_INT(0,3,2)
 #define ssh_session SSH_SESSION
 #endif
@@ -62,7 +67,7 @@ public:
 
   sftp_file CreateFileHande(const std::string &file);
   void CloseFileHandle(sftp_file handle);
-  bool GetDirectory(const std::string &base, const std::string &folder, CFileItemList &items);
+  bool GetDirectory(const std::string &base, const std::string &folder, CFileItemList &items, XFILE::IDirectory *directory = NULL);
   bool DirectoryExists(const char *path);
   bool FileExists(const char *path);
   int Stat(const char *path, struct __stat64* buffer);
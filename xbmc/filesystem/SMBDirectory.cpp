@@ -51,6 +51,10 @@ struct CachedDirEntry
 {
   unsigned int type;
   std::string name;
+  bool hasInfo; // attributes below were returned with the listing
+  bool hidden;
+  int64_t size;
+  int64_t mtime;
 };
 
 using namespace XFILE;
@@ -95,11 +99,37 @@ bool CSMBDirectory::GetDirectory(const CURL& url, CFileItemList &items)
   struct smbc_dirent* dirEnt;
 
   lock.Enter();
+#ifdef HAVE_SMBC_READDIRPLUS
+  // inside a share the server hands out the attributes together with the
+  // names, which saves a stat and a getxattr round trip for every entry
+  if (!url.GetShareName().empty())
+  {
+    const struct libsmb_file_info* info;
+    while ((info = smbc_readdirplus(fd)))
+    {
+      CachedDirEntry aDir;
+      aDir.type = (info->attrs & SMBC_DOS_MODE_DIRECTORY) ? SMBC_DIR : SMBC_FILE;
+      aDir.name = info->name;
+      aDir.hasInfo = true;
+      aDir.hidden = (info->attrs & SMBC_DOS_MODE_HIDDEN) != 0;
+      aDir.size = info->size;
+      aDir.mtime = info->mtime_ts.tv_sec;
+      if (aDir.mtime == 0) // if modification date is missing, use create date
+        aDir.mtime = info->ctime_ts.tv_sec;
+      vecEntries.push_back(aDir);
+    }
+  }
+  if (vecEntries.empty())
+#endif
   while ((dirEnt = smbc_readdir(fd)))
   {
     CachedDirEntry aDir;
     aDir.type = dirEnt->smbc_type;
     aDir.name = dirEnt->name;
+    aDir.hasInfo = false;
+    aDir.hidden = false;
+    aDir.size = 0;
+    aDir.mtime = 0;
     vecEntries.push_back(aDir);
   }
   smbc_closedir(fd);
@@ -127,9 +157,16 @@ bool CSMBDirectory::GetDirectory(const CURL& url, CFileItemList &items)
       if (StringUtils::StartsWith(strFile, "."))
         hidden = true;
 
+      if (aDir.hasInfo)
+      {
+        bIsDir = (aDir.type == SMBC_DIR);
+        hidden |= aDir.hidden;
+        lTimeDate = aDir.mtime;
+        iSize = aDir.size;
+      }
       // only stat files that can give proper responses
-      if ( aDir.type == SMBC_FILE ||
-           aDir.type == SMBC_DIR )
+      else if ( aDir.type == SMBC_FILE ||
+                aDir.type == SMBC_DIR )
       {
         // set this here to if the stat should fail
         bIsDir = (aDir.type == SMBC_DIR);
@@ -209,6 +246,7 @@ bool CSMBDirectory::GetDirectory(const CURL& url, CFileItemList &items)
           pItem->SetProperty("file:hidden", true);
         items.Add(pItem);
       }
+      NotifyPartialListing(items);
     }
   }
 
@@ -74,7 +74,13 @@ bool CVirtualDirectory::GetDirectory(const CURL& url, CFileItemList &items, bool
   if (!bUseFileDirectories)
     flags |= DIR_FLAG_NO_FILE_DIRS;
   if (!strPath.empty() && strPath != "files://")
-    return CDirectory::GetDirectory(strPath, items, m_strFileMask, flags, m_allowThreads);
+  {
+    CDirectory::CHints hints;
+    hints.flags = flags;
+    hints.mask = m_strFileMask;
+    hints.observer = m_listingObserver;
+    return CDirectory::GetDirectory(strPath, items, hints, m_allowThreads);
+  }
 
   // if strPath is blank, clear the list (to avoid parent items showing up)
   if (strPath.empty())
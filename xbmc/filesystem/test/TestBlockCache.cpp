@@ -0,0 +1,157 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/BlockCache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+char ByteAt(int64_t pos)
+{
+  return (char)((pos * 7 + (pos >> 13)) & 0xff);
+}
+
+// writes [from, to) into the cache at its current write position
+void Fill(CBlockCache &cache, int64_t from, int64_t to)
+{
+  std::vector<char> buf(64 * 1024);
+  for (int64_t pos = from; pos < to;)
+  {
+    size_t size = (size_t)std::min((int64_t)buf.size(), to - pos);
+    for (size_t i = 0; i < size; i++)
+      buf[i] = ByteAt(pos + i);
+
+    int written = cache.WriteToCache(buf.data(), size);
+    ASSERT_GT(written, 0);
+    pos += written;
+  }
+}
+
+// reads [from, to) from the current read position and verifies it
+void Verify(CBlockCache &cache, int64_t from, int64_t to)
+{
+  std::vector<char> buf(100000);
+  for (int64_t pos = from; pos < to;)
+  {
+    int read = cache.ReadFromCache(buf.data(), (size_t)std::min((int64_t)buf.size(), to - pos));
+    ASSERT_GT(read, 0);
+    for (int i = 0; i < read; i++)
+      ASSERT_EQ(ByteAt(pos + i), buf[i]);
+    pos += read;
+  }
+}
+}
+
+TEST(TestBlockCache, ReadWrite)
+{
+  CBlockCache cache(4 * 1024 * 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  cache.Reset(1000, false);
+  Fill(cache, 1000, 1000000);
+  EXPECT_EQ(1000000, cache.CachedDataEndPos());
+
+  ASSERT_EQ(1000, cache.Seek(1000));
+  Verify(cache, 1000, 1000000);
+  EXPECT_EQ(0, cache.WaitForData(0, 0));
+
+  char c;
+  EXPECT_EQ(CACHE_RC_WOULD_BLOCK, cache.ReadFromCache(&c, 1));
+  cache.EndOfInput();
+  EXPECT_EQ(0, cache.ReadFromCache(&c, 1));
+}
+
+TEST(TestBlockCache, DisjointRanges)
+{
+  const int64_t second = 1000000000;
+
+  CBlockCache cache(4 * 1024 * 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  cache.Reset(0, false);
+  Fill(cache, 0, 1500000);
+
+  // position not cached, the cache resets to an empty range there
+  EXPECT_FALSE(cache.IsCachedPosition(second));
+  EXPECT_EQ(second, cache.CachedDataEndPosIfSeekTo(second));
+  EXPECT_TRUE(cache.Reset(second, false));
+  Fill(cache, second, second + 1000000);
+
+  // the first range survived the seek
+  EXPECT_TRUE(cache.IsCachedPosition(0));
+  EXPECT_TRUE(cache.IsCachedPosition(700000));
+  EXPECT_EQ(1500000, cache.CachedDataEndPosIfSeekTo(700000));
+  EXPECT_TRUE(cache.IsCachedPosition(second + 500000));
+  EXPECT_FALSE(cache.IsCachedPosition(1600000));
+
+  // a cached range that does not reach the write position can't be
+  // seeked to directly, the source has to continue where it ends
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(700000));
+  EXPECT_FALSE(cache.Reset(700000, false));
+  EXPECT_EQ(1500000, cache.CachedDataEndPos());
+  Verify(cache, 700000, 1500000);
+
+  Fill(cache, 1500000, 2000000);
+  Verify(cache, 1500000, 2000000);
+}
+
+TEST(TestBlockCache, FullReset)
+{
+  CBlockCache cache(4 * 1024 * 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(cache, 0, 500000);
+  EXPECT_TRUE(cache.IsCachedPosition(1000));
+  EXPECT_TRUE(cache.Reset(600000, true));
+  EXPECT_FALSE(cache.IsCachedPosition(1000));
+}
+
+TEST(TestBlockCache, Eviction)
+{
+  const size_t memory = 2 * 1024 * 1024;
+
+  CBlockCache cache(memory);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  // write and consume far more than fits in memory
+  std::vector<char> buf(64 * 1024);
+  int64_t end = 0;
+  while (end < 10 * (int64_t)memory)
+  {
+    int written = cache.WriteToCache(buf.data(), buf.size());
+    if (written == 0)
+    {
+      ASSERT_GT(cache.ReadFromCache(buf.data(), buf.size()), 0);
+      continue;
+    }
+    ASSERT_GT(written, 0);
+    end += written;
+  }
+
+  // oldest data is gone, the front is still readable
+  EXPECT_FALSE(cache.IsCachedPosition(1000));
+  EXPECT_TRUE(cache.IsCachedPosition(end - 1000));
+  EXPECT_EQ(end - 1000, cache.Seek(end - 1000));
+}
@@ -21,11 +21,47 @@
 #include "filesystem/Directory.h"
 #include "filesystem/SpecialProtocol.h"
 #include "FileItem.h"
+#include "URL.h"
+#include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "test/TestUtils.h"
 
 #include "gtest/gtest.h"
 
+namespace
+{
+class CSlowDirectory : public XFILE::IDirectory
+{
+public:
+  bool GetDirectory(const CURL& url, CFileItemList &items) override
+  {
+    for (int i = 0; i < 250; i++)
+    {
+      items.Add(CFileItemPtr(new CFileItem(StringUtils::Format("item%i", i))));
+      NotifyPartialListing(items);
+    }
+    return true;
+  }
+};
+
+class CListingCollector : public XFILE::IDirectoryListingObserver
+{
+public:
+  void OnPartialListing(const CFileItemList& items) override
+  {
+    batches.push_back(items.Size());
+    for (int i = 0; i < items.Size(); i++)
+    {
+      labels.push_back(items[i]->GetLabel());
+      seen.push_back(items[i]);
+    }
+  }
+  std::vector<int> batches;
+  std::vector<std::string> labels;
+  std::vector<CFileItemPtr> seen;
+};
+}
+
 TEST(TestDirectory, General)
 {
   std::string tmppath1, tmppath2, tmppath3;
@@ -65,3 +101,32 @@ TEST(TestDirectory, CreateRecursive)
   EXPECT_TRUE(XFILE::CDirectory::Create(path2));
   EXPECT_TRUE(XFILE::CDirectory::RemoveRecursive(path1));
 }
+
+TEST(TestDirectory, PartialListing)
+{
+  CSlowDirectory dir;
+  CListingCollector collector;
+  CFileItemList items;
+
+  dir.SetListingObserver(&collector);
+  EXPECT_TRUE(dir.GetDirectory(CURL("slow://"), items));
+  EXPECT_EQ(250, items.Size());
+
+  // entries are handed on in full batches, the rest comes with the listing
+  ASSERT_EQ(2u, collector.batches.size());
+  EXPECT_EQ(100, collector.batches[0]);
+  EXPECT_EQ(100, collector.batches[1]);
+  ASSERT_EQ(200u, collector.labels.size());
+  EXPECT_EQ("item0", collector.labels[0]);
+  EXPECT_EQ("item199", collector.labels[199]);
+
+  // the observer works on its own copies of the entries
+  EXPECT_NE(items[0].get(), collector.seen[0].get());
+  EXPECT_EQ(items[0]->GetLabel(), collector.seen[0]->GetLabel());
+
+  // a detached observer no longer hears about the listing
+  CFileItemList again;
+  dir.SetListingObserver(NULL);
+  EXPECT_TRUE(dir.GetDirectory(CURL("slow://"), again));
+  EXPECT_EQ(2u, collector.batches.size());
+}
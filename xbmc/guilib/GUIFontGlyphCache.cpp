@@ -0,0 +1,234 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+
+#include "GUIFontGlyphCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/StringUtils.h"
+#include "utils/auto_buffer.h"
+#include "utils/log.h"
+
+#define GLYPH_CACHE_FOLDER "special://temp/fontcache/"
+#define GLYPH_CACHE_MAGIC "KGC1"
+
+// code, left, top, width, rows, advance
+#define GLYPH_HEADER_SIZE (sizeof(uint32_t) + 2 * sizeof(int16_t) + 2 * sizeof(uint16_t) + sizeof(float))
+
+std::shared_ptr<CGUIFontGlyphCache> CGUIFontGlyphCache::Get(const std::string &fontFile, float height, float aspect, bool border)
+{
+  // identify the font file by its name, size and modification time
+  struct __stat64 stat;
+  if (XFILE::CFile::Stat(fontFile, &stat) != 0)
+    return std::shared_ptr<CGUIFontGlyphCache>();
+
+  uint32_t hash = Crc32::ComputeFromLowerCase(StringUtils::Format("%s|%llu|%llu", fontFile.c_str(),
+                                                                 (unsigned long long)stat.st_size,
+                                                                 (unsigned long long)stat.st_mtime));
+  std::string path = StringUtils::Format(GLYPH_CACHE_FOLDER "%08x_%.2f_%.3f%s.glyphs", hash, height, aspect, border ? "_border" : "");
+
+  static CCriticalSection cachesSection;
+  static std::map<std::string, std::weak_ptr<CGUIFontGlyphCache> > caches;
+
+  CSingleLock lock(cachesSection);
+  std::shared_ptr<CGUIFontGlyphCache> cache = caches[path].lock();
+  if (!cache)
+  {
+    for (std::map<std::string, std::weak_ptr<CGUIFontGlyphCache> >::iterator it = caches.begin(); it != caches.end(); )
+    {
+      if (it->second.expired() && it->first != path)
+        caches.erase(it++);
+      else
+        ++it;
+    }
+
+    cache.reset(new CGUIFontGlyphCache(path));
+    cache->Load();
+    caches[path] = cache;
+  }
+
+  return cache;
+}
+
+CGUIFontGlyphCache::CGUIFontGlyphCache(const std::string &path)
+  : m_path(path),
+    m_dirty(false)
+{ }
+
+CGUIFontGlyphCache::~CGUIFontGlyphCache()
+{
+  Save();
+}
+
+CGUIFontGlyphCache::GlyphPtr CGUIFontGlyphCache::GetGlyph(uint32_t letterAndStyle) const
+{
+  CSingleLock lock(m_critSection);
+  std::map<uint32_t, GlyphPtr>::const_iterator it = m_glyphs.find(letterAndStyle);
+  if (it == m_glyphs.end())
+    return GlyphPtr();
+  return it->second;
+}
+
+bool CGUIFontGlyphCache::HasGlyph(uint32_t letterAndStyle) const
+{
+  CSingleLock lock(m_critSection);
+  return m_glyphs.find(letterAndStyle) != m_glyphs.end();
+}
+
+void CGUIFontGlyphCache::AddGlyph(uint32_t letterAndStyle, const GlyphPtr &glyph)
+{
+  CSingleLock lock(m_critSection);
+  if (m_glyphs.insert(std::make_pair(letterAndStyle, glyph)).second)
+    m_dirty = true;
+}
+
+void CGUIFontGlyphCache::GetCharacters(std::vector<uint32_t> &characters) const
+{
+  CSingleLock lock(m_critSection);
+  characters.clear();
+  characters.reserve(m_glyphs.size());
+  for (std::map<uint32_t, GlyphPtr>::const_iterator it = m_glyphs.begin(); it != m_glyphs.end(); ++it)
+    characters.push_back(it->first);
+}
+
+bool CGUIFontGlyphCache::Load()
+{
+  if (!XFILE::CFile::Exists(m_path))
+    return false;
+
+  XUTILS::auto_buffer buffer;
+  XFILE::CFile file;
+  if (file.LoadFile(m_path, buffer) <= 0)
+    return false;
+
+  const char *data = buffer.get();
+  const char *end = data + buffer.size();
+  uint32_t count = 0;
+  if (buffer.size() < 4 + sizeof(count) || memcmp(data, GLYPH_CACHE_MAGIC, 4) != 0)
+  {
+    CLog::Log(LOGWARNING, "CGUIFontGlyphCache: ignoring invalid glyph cache %s", m_path.c_str());
+    return false;
+  }
+  memcpy(&count, data + 4, sizeof(count));
+  data += 4 + sizeof(count);
+
+  std::map<uint32_t, GlyphPtr> glyphs;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (end - data < (ptrdiff_t)GLYPH_HEADER_SIZE)
+      break;
+
+    uint32_t code;
+    int16_t left, top;
+    uint16_t width, rows;
+    std::shared_ptr<Glyph> glyph(new Glyph);
+    memcpy(&code, data, sizeof(code)); data += sizeof(code);
+    memcpy(&left, data, sizeof(left)); data += sizeof(left);
+    memcpy(&top, data, sizeof(top)); data += sizeof(top);
+    memcpy(&width, data, sizeof(width)); data += sizeof(width);
+    memcpy(&rows, data, sizeof(rows)); data += sizeof(rows);
+    memcpy(&glyph->advance, data, sizeof(glyph->advance)); data += sizeof(glyph->advance);
+
+    size_t size = (size_t)width * rows;
+    if ((size_t)(end - data) < size)
+      break;
+
+    glyph->left = left;
+    glyph->top = top;
+    glyph->width = width;
+    glyph->rows = rows;
+    glyph->pixels.assign(data, data + size);
+    data += size;
+    glyphs[code] = glyph;
+  }
+
+  if (glyphs.size() != count)
+  {
+    CLog::Log(LOGWARNING, "CGUIFontGlyphCache: ignoring truncated glyph cache %s", m_path.c_str());
+    return false;
+  }
+
+  CSingleLock lock(m_critSection);
+  m_glyphs.swap(glyphs);
+  m_dirty = false;
+  CLog::Log(LOGDEBUG, "CGUIFontGlyphCache: loaded %u glyphs from %s", count, m_path.c_str());
+  return true;
+}
+
+bool CGUIFontGlyphCache::Save()
+{
+  std::string data;
+  {
+    CSingleLock lock(m_critSection);
+    if (!m_dirty)
+      return true;
+
+    uint32_t count = m_glyphs.size();
+    data.append(GLYPH_CACHE_MAGIC, 4);
+    data.append((const char*)&count, sizeof(count));
+    for (std::map<uint32_t, GlyphPtr>::const_iterator it = m_glyphs.begin(); it != m_glyphs.end(); ++it)
+    {
+      const Glyph &glyph = *it->second;
+      int16_t left = glyph.left, top = glyph.top;
+      uint16_t width = glyph.width, rows = glyph.rows;
+      data.append((const char*)&it->first, sizeof(it->first));
+      data.append((const char*)&left, sizeof(left));
+      data.append((const char*)&top, sizeof(top));
+      data.append((const char*)&width, sizeof(width));
+      data.append((const char*)&rows, sizeof(rows));
+      data.append((const char*)&glyph.advance, sizeof(glyph.advance));
+      if (!glyph.pixels.empty())
+        data.append((const char*)&glyph.pixels[0], glyph.pixels.size());
+    }
+    m_dirty = false;
+  }
+
+  if (!XFILE::CDirectory::Exists(GLYPH_CACHE_FOLDER))
+    XFILE::CDirectory::Create(GLYPH_CACHE_FOLDER);
+
+  // write to a temporary file first so that nobody loads a partial cache
+  std::string tempPath = m_path + ".tmp";
+  XFILE::CFile file;
+  if (!file.OpenForWrite(tempPath, true) ||
+      file.Write(data.c_str(), data.size()) != (ssize_t)data.size())
+  {
+    CLog::Log(LOGERROR, "CGUIFontGlyphCache: unable to write %s", tempPath.c_str());
+    file.Close();
+    XFILE::CFile::Delete(tempPath);
+    return false;
+  }
+  file.Close();
+
+  if (!XFILE::CFile::Rename(tempPath, m_path))
+  {
+    XFILE::CFile::Delete(m_path);
+    if (!XFILE::CFile::Rename(tempPath, m_path))
+    {
+      CLog::Log(LOGERROR, "CGUIFontGlyphCache: unable to replace %s", m_path.c_str());
+      XFILE::CFile::Delete(tempPath);
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+
+/*!
+ \ingroup textures
+ \brief On-disk cache of the glyphs FreeType rendered for a font file at a given size.
+
+ Glyphs are keyed by character and style, the same way CGUIFontTTFBase stores
+ them. A font finding its glyph in here only has to copy the coverage bitmap
+ into its texture instead of loading, styling, stroking and rendering it.
+
+ The cache for a font file, size, aspect and border is shared between all
+ users in the process and written back to special://temp/fontcache/ once
+ the last one lets go of it.
+ */
+class CGUIFontGlyphCache
+{
+public:
+  struct Glyph
+  {
+    short left;       ///< horizontal offset of the bitmap from the pen position
+    short top;        ///< vertical offset of the top of the bitmap from the base line
+    unsigned short width;
+    unsigned short rows;
+    float advance;    ///< horizontal advance in pixels
+    std::vector<uint8_t> pixels; ///< 8 bit coverage, width * rows without padding
+  };
+  typedef std::shared_ptr<const Glyph> GlyphPtr;
+
+  /*!
+   \brief Retrieve the cache for a font, loading it from disk if it isn't in use yet
+   \param fontFile path to the font file
+   \param height, aspect, border parameters the font is rendered with
+   \return the cache, empty if the font file can't be identified
+   */
+  static std::shared_ptr<CGUIFontGlyphCache> Get(const std::string &fontFile, float height, float aspect, bool border);
+
+  ~CGUIFontGlyphCache();
+
+  GlyphPtr GetGlyph(uint32_t letterAndStyle) const;
+  bool HasGlyph(uint32_t letterAndStyle) const;
+  void AddGlyph(uint32_t letterAndStyle, const GlyphPtr &glyph);
+
+  /*!
+   \brief Retrieve all cached characters in ascending order
+   */
+  void GetCharacters(std::vector<uint32_t> &characters) const;
+
+  /*!
+   \brief Write the cache to disk if glyphs were added since it was loaded or saved
+   */
+  bool Save();
+
+private:
+  explicit CGUIFontGlyphCache(const std::string &path);
+  CGUIFontGlyphCache(const CGUIFontGlyphCache&);
+  CGUIFontGlyphCache& operator=(const CGUIFontGlyphCache&);
+
+  bool Load();
+
+  mutable CCriticalSection m_critSection;
+  std::string m_path;
+  std::map<uint32_t, GlyphPtr> m_glyphs;
+  bool m_dirty;
+};
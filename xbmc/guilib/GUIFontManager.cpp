@@ -90,6 +90,39 @@ static bool CheckFont(std::string& strPath, const std::string& newPath,
   return true;
 }
 
+static void GetCharacterRanges(const TiXmlNode *fontNode, vecCharacterRanges &ranges)
+{
+  // hexadecimal ranges like "0020-007e, 4e00-9fff"
+  std::string charRanges;
+  ranges.clear();
+  if (!XMLUtils::GetString(fontNode, "charranges", charRanges))
+    return;
+
+  std::vector<std::string> tokens = StringUtils::Tokenize(charRanges, ", ");
+  for (std::vector<std::string>::const_iterator i = tokens.begin(); i != tokens.end(); ++i)
+  {
+    std::vector<std::string> bounds = StringUtils::Split(*i, "-");
+    char *end = NULL;
+    character_t first = 0, last = 0;
+    bool valid = (bounds.size() == 1 || bounds.size() == 2) && !bounds.front().empty() && !bounds.back().empty();
+    if (valid)
+    {
+      first = strtoul(bounds.front().c_str(), &end, 16);
+      valid = *end == '\0';
+    }
+    if (valid)
+    {
+      last = strtoul(bounds.back().c_str(), &end, 16);
+      valid = *end == '\0' && first <= last && last <= 0xffff;
+    }
+
+    if (valid)
+      ranges.push_back(std::make_pair(first, last));
+    else
+      CLog::Log(LOGWARNING, "%s: ignoring invalid character range %s", __FUNCTION__, i->c_str());
+  }
+}
+
 CGUIFont* GUIFontManager::LoadTTF(const std::string& strFontName, const std::string& strFilename, color_t textColor, color_t shadowColor, const int iSize, const int iStyle, bool border, float lineSpacing, float aspect, const RESOLUTION_INFO *sourceRes, bool preserveAspect)
 {
   float originalAspect = aspect;
@@ -398,6 +431,7 @@ void GUIFontManager::LoadFonts(const TiXmlNode* fontNode)
     color_t shadowColor = 0;
     color_t textColor = 0;
     int iStyle = FONT_STYLE_NORMAL;
+    vecCharacterRanges charRanges;
 
     XMLUtils::GetString(fontNode, "name", fontName);
     XMLUtils::GetInt(fontNode, "size", iSize);
@@ -407,13 +441,16 @@ void GUIFontManager::LoadFonts(const TiXmlNode* fontNode)
     CGUIControlFactory::GetColor(fontNode, "color", textColor);
     XMLUtils::GetString(fontNode, "filename", fileName);
     GetStyle(fontNode, iStyle);
+    GetCharacterRanges(fontNode, charRanges);
 
     if (!fontName.empty() && URIUtils::HasExtension(fileName, ".ttf"))
     {
       //! @todo Why do we tolower() this shit?
       std::string strFontFileName = fileName;
       StringUtils::ToLower(strFontFileName);
-      LoadTTF(fontName, strFontFileName, textColor, shadowColor, iSize, iStyle, false, lineSpacing, aspect);
+      CGUIFont *font = LoadTTF(fontName, strFontFileName, textColor, shadowColor, iSize, iStyle, false, lineSpacing, aspect);
+      if (font && !charRanges.empty())
+        font->GetFont()->PrerenderGlyphs(charRanges, iStyle);
     }
     fontNode = fontNode->NextSibling("font");
   }
@@ -20,6 +20,7 @@
 
 #include "GUIFont.h"
 #include "GUIFontTTF.h"
+#include "GUIFontGlyphCache.h"
 #include "GUIFontManager.h"
 #include "Texture.h"
 #include "GraphicContext.h"
@@ -30,6 +31,7 @@
 #include "URL.h"
 #include "filesystem/File.h"
 #include "threads/SystemClock.h"
+#include "utils/JobManager.h"
 
 #include <math.h>
 #include <memory>
@@ -54,6 +56,7 @@
 #define CHAR_CHUNK    64      // 64 chars allocated at a time (1024 bytes)
 #define GLYPH_STRENGTH_BOLD 24
 #define GLYPH_STRENGTH_LIGHT -48
+#define GLYPH_PRELOAD_MAX_HEIGHT 2048 // glyphs beyond this texture height are placed on demand only
 
 
 class CFreeTypeLibrary
@@ -154,6 +157,32 @@ private:
 XBMC_GLOBAL_REF(CFreeTypeLibrary, g_freeTypeLibrary); // our freetype library
 #define g_freeTypeLibrary XBMC_GLOBAL_USE(CFreeTypeLibrary)
 
+static FT_Pos GetBorderStrength(FT_Face face)
+{
+  FT_Pos strength = FT_MulFix( face->units_per_EM, face->size->metrics.y_scale) / 12;
+  if (strength < 128)
+    strength = 128;
+  return strength;
+}
+
+static CGUIFontGlyphCache::GlyphPtr CreateCachedGlyph(FT_BitmapGlyph bitGlyph, float advance)
+{
+  const FT_Bitmap &bitmap = bitGlyph->bitmap;
+  std::shared_ptr<CGUIFontGlyphCache::Glyph> glyph(new CGUIFontGlyphCache::Glyph);
+  glyph->left = (short)bitGlyph->left;
+  glyph->top = (short)bitGlyph->top;
+  glyph->width = (unsigned short)bitmap.width;
+  glyph->rows = (unsigned short)bitmap.rows;
+  glyph->advance = advance;
+
+  // store the rows without the padding freetype may add
+  glyph->pixels.resize(glyph->width * glyph->rows);
+  for (unsigned int y = 0; y < glyph->rows; y++)
+    memcpy(&glyph->pixels[y * glyph->width], bitmap.buffer + y * bitmap.pitch, glyph->width);
+
+  return glyph;
+}
+
 CGUIFontTTFBase::CGUIFontTTFBase(const std::string& strFileName) : m_staticCache(*this), m_dynamicCache(*this)
 {
   m_texture = NULL;
@@ -175,6 +204,8 @@ CGUIFontTTFBase::CGUIFontTTFBase(const std::string& strFileName) : m_staticCache
   m_textureHeight = m_textureWidth = 0;
   m_textureScaleX = m_textureScaleY = 0.0;
   m_ellipsesWidth = m_height = 0.0f;
+  m_aspect = 1.0f;
+  m_border = false;
   m_color = 0;
   m_nTexture = 0;
 }
@@ -235,6 +266,7 @@ void CGUIFontTTFBase::Clear()
   if (m_stroker)
     g_freeTypeLibrary.ReleaseStroker(m_stroker);
   m_stroker = NULL;
+  m_glyphCache.reset();
 
   m_vertexTrans.clear();
   m_vertex.clear();
@@ -279,9 +311,7 @@ bool CGUIFontTTFBase::Load(const std::string& strFilename, float height, float a
      add on the strength of any border - the non-bordered font needs
      aligning with the bordered font by utilising GetTextBaseLine()
      */
-    FT_Pos strength = FT_MulFix( m_face->units_per_EM, m_face->size->metrics.y_scale) / 12;
-    if (strength < 128)
-      strength = 128;
+    FT_Pos strength = GetBorderStrength(m_face);
 
     cellDescender -= strength;
     cellAscender  += strength;
@@ -300,6 +330,8 @@ bool CGUIFontTTFBase::Load(const std::string& strFilename, float height, float a
   m_cellHeight   = cellAscender - cellDescender;
 
   m_height = height;
+  m_aspect = aspect;
+  m_border = border;
 
   delete(m_texture);
   m_texture = NULL;
@@ -324,6 +356,11 @@ bool CGUIFontTTFBase::Load(const std::string& strFilename, float height, float a
   m_posX = m_textureWidth;
   m_posY = -(int)GetTextureLineHeight();
 
+  // place the glyphs rendered by previous runs straight into the texture
+  m_glyphCache = CGUIFontGlyphCache::Get(strFilename, height, aspect, border);
+  if (m_glyphCache)
+    LoadCachedGlyphs();
+
   // cache the ellipses width
   Character *ellipse = GetCharacter(L'.');
   if (ellipse) m_ellipsesWidth = ellipse->advance;
@@ -675,7 +712,13 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
   if (nestedBeginCount) Begin();
   m_nestedBeginCount = nestedBeginCount;
 
-  // fixup quick access
+  UpdateQuickLookup();
+
+  return m_char + low;
+}
+
+void CGUIFontTTFBase::UpdateQuickLookup()
+{
   memset(m_charquick, 0, sizeof(m_charquick));
   for(int i=0;i<m_numChars;i++)
   {
@@ -685,44 +728,182 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
       m_charquick[ch] = m_char+i;
     }
   }
+}
 
-  return m_char + low;
+void CGUIFontTTFBase::LoadCachedGlyphs()
+{
+  std::vector<character_t> characters;
+  m_glyphCache->GetCharacters(characters);
+  if (characters.empty())
+    return;
+
+  delete[] m_char;
+  m_maxChars = (characters.size() / CHAR_CHUNK + 1) * CHAR_CHUNK;
+  m_char = new Character[m_maxChars];
+  m_numChars = 0;
+
+  // the cache is sorted the same way as our table, so the glyphs can simply be appended
+  for (std::vector<character_t>::const_iterator it = characters.begin(); it != characters.end(); ++it)
+  {
+    if (m_posY + 2 * (int)GetTextureLineHeight() > GLYPH_PRELOAD_MAX_HEIGHT ||
+        !CacheCharacter(*it & 0xffff, *it >> 16, m_char + m_numChars))
+      break;
+  }
+  UpdateQuickLookup();
+
+  CLog::Log(LOGDEBUG, "%s: placed %i of %i cached glyphs for %s", __FUNCTION__, m_numChars, (int)characters.size(), m_strFileName.c_str());
+}
+
+void CGUIFontTTFBase::PrerenderGlyphs(const vecCharacterRanges &ranges, uint32_t style)
+{
+  if (!m_glyphCache || ranges.empty())
+    return;
+
+  std::shared_ptr<CGUIFontGlyphCache> cache = m_glyphCache;
+  std::string fontFile = m_strFilename;
+  float height = m_height;
+  float aspect = m_aspect;
+  bool border = m_border;
+  style &= FONT_STYLE_BOLD | FONT_STYLE_ITALICS | FONT_STYLE_LIGHT;
+
+  CJobManager::GetInstance().Submit([=]() {
+    RenderGlyphsToCache(cache, fontFile, height, aspect, border, ranges, style);
+  }, CJob::PRIORITY_LOW_PAUSABLE);
+}
+
+void CGUIFontTTFBase::RenderGlyphsToCache(std::shared_ptr<CGUIFontGlyphCache> cache, const std::string &fontFile, float height, float aspect,
+                                          bool border, const vecCharacterRanges &ranges, uint32_t style)
+{
+  // freetype objects may not be used from several threads at once, so don't touch the shared library
+  CFreeTypeLibrary library;
+  XUTILS::auto_buffer fontFileInMemory;
+  FT_Face face = library.GetFont(fontFile, height, aspect, fontFileInMemory);
+  if (!face)
+    return;
+
+  FT_Stroker stroker = NULL;
+  if (border)
+  {
+    stroker = library.GetStroker();
+    if (stroker)
+      FT_Stroker_Set(stroker, GetBorderStrength(face), FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
+  }
+
+  unsigned int rendered = 0;
+  for (vecCharacterRanges::const_iterator range = ranges.begin(); range != ranges.end(); ++range)
+  {
+    character_t last = std::min<character_t>(range->second, 0xffff);
+    for (character_t letter = range->first; letter <= last; letter++)
+    {
+      character_t letterAndStyle = (style << 16) | letter;
+      if (cache->HasGlyph(letterAndStyle) || FT_Get_Char_Index(face, letter) == 0)
+        continue;
+
+      FT_Glyph glyph = NULL;
+      float advance;
+      if (!RenderGlyph(face, stroker, letter, style, glyph, advance))
+        continue;
+
+      cache->AddGlyph(letterAndStyle, CreateCachedGlyph((FT_BitmapGlyph)glyph, advance));
+      FT_Done_Glyph(glyph);
+      rendered++;
+    }
+  }
+
+  if (stroker)
+    CFreeTypeLibrary::ReleaseStroker(stroker);
+  CFreeTypeLibrary::ReleaseFont(face);
+
+  if (rendered > 0)
+  {
+    CLog::Log(LOGDEBUG, "%s: rendered %u glyphs of %s", __FUNCTION__, rendered, fontFile.c_str());
+    cache->Save();
+  }
 }
 
 bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *ch)
 {
-  int glyph_index = FT_Get_Char_Index( m_face, letter );
+  character_t letterAndStyle = (style << 16) | letter;
+
+  // copy the glyph from the cache if it has been rendered before
+  if (m_glyphCache)
+  {
+    CGUIFontGlyphCache::GlyphPtr cached = m_glyphCache->GetGlyph(letterAndStyle);
+    if (cached)
+    {
+      FT_BitmapGlyphRec bitGlyph;
+      memset(&bitGlyph, 0, sizeof(bitGlyph));
+      bitGlyph.left = cached->left;
+      bitGlyph.top = cached->top;
+      bitGlyph.bitmap.width = cached->width;
+      bitGlyph.bitmap.rows = cached->rows;
+      bitGlyph.bitmap.pitch = cached->width;
+      bitGlyph.bitmap.num_grays = 256;
+      bitGlyph.bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+      if (!cached->pixels.empty())
+        bitGlyph.bitmap.buffer = const_cast<unsigned char*>(&cached->pixels[0]);
+      return PlaceCharacter(letterAndStyle, &bitGlyph, cached->advance, ch);
+    }
+  }
 
   FT_Glyph glyph = NULL;
-  if (FT_Load_Glyph( m_face, glyph_index, FT_LOAD_TARGET_LIGHT ))
+  float advance;
+  if (!RenderGlyph(m_face, m_stroker, letter, style, glyph, advance))
+    return false;
+
+  FT_BitmapGlyph bitGlyph = (FT_BitmapGlyph)glyph;
+  if (m_glyphCache)
+    m_glyphCache->AddGlyph(letterAndStyle, CreateCachedGlyph(bitGlyph, advance));
+
+  bool placed = PlaceCharacter(letterAndStyle, bitGlyph, advance, ch);
+
+  // free the glyph
+  FT_Done_Glyph(glyph);
+
+  return placed;
+}
+
+bool CGUIFontTTFBase::RenderGlyph(FT_Face face, FT_Stroker stroker, wchar_t letter, uint32_t style, FT_Glyph &glyph, float &advance)
+{
+  int glyph_index = FT_Get_Char_Index( face, letter );
+
+  glyph = NULL;
+  if (FT_Load_Glyph( face, glyph_index, FT_LOAD_TARGET_LIGHT ))
   {
     CLog::Log(LOGDEBUG, "%s Failed to load glyph %x", __FUNCTION__, letter);
     return false;
   }
   // make bold if applicable
   if (style & FONT_STYLE_BOLD)
-    SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_BOLD);
+    SetGlyphStrength(face->glyph, GLYPH_STRENGTH_BOLD);
   // and italics if applicable
   if (style & FONT_STYLE_ITALICS)
-    ObliqueGlyph(m_face->glyph);
+    ObliqueGlyph(face->glyph);
   // and light if applicable
   if (style & FONT_STYLE_LIGHT)
-    SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_LIGHT);
+    SetGlyphStrength(face->glyph, GLYPH_STRENGTH_LIGHT);
   // grab the glyph
-  if (FT_Get_Glyph(m_face->glyph, &glyph))
+  if (FT_Get_Glyph(face->glyph, &glyph))
   {
     CLog::Log(LOGDEBUG, "%s Failed to get glyph %x", __FUNCTION__, letter);
     return false;
   }
-  if (m_stroker)
-    FT_Glyph_StrokeBorder(&glyph, m_stroker, 0, 1);
+  if (stroker)
+    FT_Glyph_StrokeBorder(&glyph, stroker, 0, 1);
   // render the glyph
   if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, NULL, 1))
   {
     CLog::Log(LOGDEBUG, "%s Failed to render glyph %x to a bitmap", __FUNCTION__, letter);
+    FT_Done_Glyph(glyph);
+    glyph = NULL;
     return false;
   }
-  FT_BitmapGlyph bitGlyph = (FT_BitmapGlyph)glyph;
+  advance = (float)MathUtils::round_int( (float)face->glyph->advance.x / 64 );
+  return true;
+}
+
+bool CGUIFontTTFBase::PlaceCharacter(character_t letterAndStyle, FT_BitmapGlyph bitGlyph, float advance, Character *ch)
+{
   FT_Bitmap bitmap = bitGlyph->bitmap;
   bool isEmptyGlyph = (bitmap.width == 0 || bitmap.rows == 0);
 
@@ -747,7 +928,6 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
         if (newHeight > g_Windowing.GetMaxTextureSize())
         {
           CLog::Log(LOGDEBUG, "%s: New cache texture is too large (%u > %u pixels long)", __FUNCTION__, newHeight, g_Windowing.GetMaxTextureSize());
-          FT_Done_Glyph(glyph);
           return false;
         }
 
@@ -755,7 +935,6 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
         newTexture = ReallocTexture(newHeight);
         if(newTexture == NULL)
         {
-          FT_Done_Glyph(glyph);
           CLog::Log(LOGDEBUG, "%s: Failed to allocate new texture of height %u", __FUNCTION__, newHeight);
           return false;
         }
@@ -765,20 +944,19 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
 
     if(m_texture == NULL)
     {
-      FT_Done_Glyph(glyph);
       CLog::Log(LOGDEBUG, "%s: no texture to cache character to", __FUNCTION__);
       return false;
     }
   }
   // set the character in our table
-  ch->letterAndStyle = (style << 16) | letter;
+  ch->letterAndStyle = letterAndStyle;
   ch->offsetX = (short)bitGlyph->left;
   ch->offsetY = (short)m_cellBaseLine - bitGlyph->top;
   ch->left = isEmptyGlyph ? 0 : ((float)m_posX + ch->offsetX);
   ch->top = isEmptyGlyph ? 0 : ((float)m_posY + ch->offsetY);
   ch->right = ch->left + bitmap.width;
   ch->bottom = ch->top + bitmap.rows;
-  ch->advance = (float)MathUtils::round_int( (float)m_face->glyph->advance.x / 64 );
+  ch->advance = advance;
 
   // we need only render if we actually have some pixels
   if (!isEmptyGlyph)
@@ -794,9 +972,6 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
   }
   m_numChars++;
 
-  // free the glyph
-  FT_Done_Glyph(glyph);
-
   return true;
 }
 
@@ -978,8 +1153,8 @@ void CGUIFontTTFBase::SetGlyphStrength(FT_GlyphSlot slot, int glyphStrength)
     return;
 
   /* some reasonable strength */
-  FT_Pos strength = FT_MulFix( m_face->units_per_EM,
-                    m_face->size->metrics.y_scale ) / glyphStrength;
+  FT_Pos strength = FT_MulFix( slot->face->units_per_EM,
+                    slot->face->size->metrics.y_scale ) / glyphStrength;
 
   FT_BBox bbox_before, bbox_after;
   FT_Outline_Get_CBox( &slot->outline, &bbox_before );
@@ -27,8 +27,10 @@
  *
  */
 
+#include <memory>
 #include <string>
 #include <stdint.h>
+#include <utility>
 #include <vector>
 
 #include "utils/auto_buffer.h"
@@ -45,16 +47,19 @@ using namespace DirectX::PackedVector;
 constexpr size_t LOOKUPTABLE_SIZE = 256 * 8;
 // forward definition
 class CBaseTexture;
+class CGUIFontGlyphCache;
 
 struct FT_FaceRec_;
 struct FT_LibraryRec_;
 struct FT_GlyphSlotRec_;
+struct FT_GlyphRec_;
 struct FT_BitmapGlyphRec_;
 struct FT_StrokerRec_;
 
 typedef struct FT_FaceRec_ *FT_Face;
 typedef struct FT_LibraryRec_ *FT_Library;
 typedef struct FT_GlyphSlotRec_ *FT_GlyphSlot;
+typedef struct FT_GlyphRec_ *FT_Glyph;
 typedef struct FT_BitmapGlyphRec_ *FT_BitmapGlyph;
 typedef struct FT_StrokerRec_ *FT_Stroker;
 
@@ -62,6 +67,7 @@ typedef uint32_t character_t;
 typedef uint32_t color_t;
 typedef std::vector<character_t> vecText;
 typedef std::vector<color_t> vecColors;
+typedef std::vector<std::pair<character_t, character_t> > vecCharacterRanges;
 
 /*!
  \ingroup textures
@@ -104,6 +110,14 @@ public:
 
   const std::string& GetFileName() const { return m_strFileName; };
 
+  /*! \brief Render the glyphs of the given characters to the glyph cache in the background
+   Glyphs already in the cache are skipped, the font picks the others up
+   from the cache as soon as they are needed.
+   \param ranges first and last characters of each range to render
+   \param style font style (FONT_STYLE_BOLD, FONT_STYLE_ITALICS and FONT_STYLE_LIGHT) to render them in
+   */
+  void PrerenderGlyphs(const vecCharacterRanges &ranges, uint32_t style);
+
 protected:
   struct Character
   {
@@ -126,11 +140,16 @@ protected:
                             uint32_t alignment, float maxPixelWidth, bool scrolling);
 
   float m_height;
+  float m_aspect;
+  bool m_border;
   std::string m_strFilename;
 
   // Stuff for pre-rendering for speed
   inline Character *GetCharacter(character_t letter);
   bool CacheCharacter(wchar_t letter, uint32_t style, Character *ch);
+  bool PlaceCharacter(character_t letterAndStyle, FT_BitmapGlyph bitGlyph, float advance, Character *ch);
+  void LoadCachedGlyphs();
+  void UpdateQuickLookup();
   void RenderCharacter(float posX, float posY, const Character *ch, color_t color, bool roundX, std::vector<SVertex> &vertices);
   void ClearCharacterCache();
 
@@ -139,8 +158,11 @@ protected:
   virtual void DeleteHardwareTexture() = 0;
 
   // modifying glyphs
-  void SetGlyphStrength(FT_GlyphSlot slot, int glyphStrength);
+  static bool RenderGlyph(FT_Face face, FT_Stroker stroker, wchar_t letter, uint32_t style, FT_Glyph &glyph, float &advance);
+  static void SetGlyphStrength(FT_GlyphSlot slot, int glyphStrength);
   static void ObliqueGlyph(FT_GlyphSlot slot);
+  static void RenderGlyphsToCache(std::shared_ptr<CGUIFontGlyphCache> cache, const std::string &fontFile, float height, float aspect,
+                                  bool border, const vecCharacterRanges &ranges, uint32_t style);
 
   CBaseTexture* m_texture;        // texture that holds our rendered characters (8bit alpha only)
 
@@ -173,6 +195,8 @@ protected:
   FT_Face    m_face;
   FT_Stroker m_stroker;
 
+  std::shared_ptr<CGUIFontGlyphCache> m_glyphCache; // glyphs rendered before, shared with other instances of the font
+
   float m_originX;
   float m_originY;
 
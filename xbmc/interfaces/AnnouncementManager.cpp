@@ -20,6 +20,9 @@
 
 #include "AnnouncementManager.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include <list>
+#include <set>
 #include <stdio.h>
 #include "utils/log.h"
 #include "utils/Variant.h"
@@ -31,13 +34,240 @@
 #include "pvr/channels/PVRChannel.h"
 #include "PlayListPlayer.h"
 #include "ServiceBroker.h"
+#include "settings/AdvancedSettings.h"
 
 #define LOOKUP_PROPERTY "database-lookup"
 
+// announcements about library items which are merged when repeated
+#define COALESCE_FLAGS (VideoLibrary | AudioLibrary)
+
 using namespace ANNOUNCEMENT;
 
+/*!
+ \brief Queue of the announcements for a single announcer, delivered by its own thread.
+
+ Announcements about the same library item are held back for the coalesce
+ time, a repeated announcement received in the meantime replaces the queued
+ one. Other announcements are delivered right away, announcements about one
+ item keep their order. Once the queue is full library item announcements
+ are dropped, other announcements are always delivered.
+ */
+class CAnnouncementManager::CAnnouncerQueue : public CThread
+{
+public:
+  explicit CAnnouncerQueue(IAnnouncer *announcer)
+    : CThread("AnnounceQueue"),
+      m_announcer(announcer),
+      m_delivered(0),
+      m_merged(0),
+      m_dropped(0),
+      m_overflow(false)
+  { }
+
+  void Push(AnnouncementFlag flag, const std::string &sender, const std::string &message,
+            const std::shared_ptr<const CVariant> &data, const std::string &item,
+            unsigned int coalesceTime, unsigned int maxSize);
+  void Stop();
+  void AddStatistics(AnnouncementStatistics &statistics);
+
+protected:
+  void Process();
+
+private:
+  struct CQueuedAnnouncement
+  {
+    AnnouncementFlag flag;
+    std::string sender;
+    std::string message;
+    std::shared_ptr<const CVariant> data;
+    std::string item;
+    XbmcThreads::EndTime due;
+  };
+  typedef std::list<CQueuedAnnouncement> Queue;
+
+  void Erase(Queue::iterator it);
+
+  IAnnouncer *m_announcer;
+  CCriticalSection m_critSection;
+  CEvent m_queueEvent;
+  Queue m_queue;
+  std::map<std::string, Queue::iterator> m_lastQueued;
+  uint64_t m_delivered;
+  uint64_t m_merged;
+  uint64_t m_dropped;
+  bool m_overflow;
+};
+
+void CAnnouncementManager::CAnnouncerQueue::Push(AnnouncementFlag flag, const std::string &sender, const std::string &message,
+                                                 const std::shared_ptr<const CVariant> &data, const std::string &item,
+                                                 unsigned int coalesceTime, unsigned int maxSize)
+{
+  CSingleLock lock(m_critSection);
+
+  bool coalesce = !item.empty() && coalesceTime > 0;
+  if (coalesce)
+  {
+    // only the latest announcement about the item may be replaced, anything
+    // else about the item in between has to be delivered in order
+    std::map<std::string, Queue::iterator>::iterator last = m_lastQueued.find(item);
+    if (last != m_lastQueued.end() && last->second->flag == flag &&
+        last->second->sender == sender && last->second->message == message)
+    {
+      last->second->data = data;
+      m_merged++;
+      return;
+    }
+  }
+
+  if (m_queue.size() >= maxSize)
+  {
+    Queue::iterator oldest = m_queue.begin();
+    while (oldest != m_queue.end() && oldest->item.empty())
+      ++oldest;
+
+    if (!m_overflow)
+      CLog::Log(LOGWARNING, "CAnnouncementManager - Announcer falling behind, dropping library announcements");
+    m_overflow = true;
+
+    if (oldest != m_queue.end())
+    {
+      Erase(oldest);
+      m_dropped++;
+    }
+    else if (!item.empty())
+    {
+      m_dropped++;
+      return;
+    }
+  }
+
+  CQueuedAnnouncement announcement;
+  announcement.flag = flag;
+  announcement.sender = sender;
+  announcement.message = message;
+  announcement.data = data;
+  announcement.item = item;
+  announcement.due.Set(coalesce ? coalesceTime : 0);
+  m_queue.push_back(announcement);
+
+  if (!item.empty())
+    m_lastQueued[item] = --m_queue.end();
+
+  if (!IsRunning())
+    Create();
+  m_queueEvent.Set();
+}
+
+void CAnnouncementManager::CAnnouncerQueue::Erase(Queue::iterator it)
+{
+  if (!it->item.empty())
+  {
+    std::map<std::string, Queue::iterator>::iterator last = m_lastQueued.find(it->item);
+    if (last != m_lastQueued.end() && last->second == it)
+      m_lastQueued.erase(last);
+  }
+
+  m_queue.erase(it);
+  if (m_queue.empty())
+    m_overflow = false;
+}
+
+void CAnnouncementManager::CAnnouncerQueue::Stop()
+{
+  m_bStop = true;
+  m_queueEvent.Set();
+
+  // an announcer removing itself can't wait for its own thread
+  if (!IsCurrentThread())
+    StopThread();
+
+  CSingleLock lock(m_critSection);
+  m_queue.clear();
+  m_lastQueued.clear();
+}
+
+void CAnnouncementManager::CAnnouncerQueue::AddStatistics(AnnouncementStatistics &statistics)
+{
+  CSingleLock lock(m_critSection);
+  statistics.delivered += m_delivered;
+  statistics.merged += m_merged;
+  statistics.dropped += m_dropped;
+}
+
+void CAnnouncementManager::CAnnouncerQueue::Process()
+{
+  SetPriority(GetMinPriority());
+
+  while (!m_bStop)
+  {
+    CSingleLock lock(m_critSection);
+    if (m_queue.empty())
+    {
+      CSingleExit ex(m_critSection);
+      m_queueEvent.Wait();
+      continue;
+    }
+
+    // deliver the oldest announcement that is due. One held back for
+    // coalescing only delays later announcements about the same item.
+    Queue::iterator next = m_queue.end();
+    unsigned int wait = 0;
+    std::set<std::string> pending;
+    for (Queue::iterator it = m_queue.begin(); it != m_queue.end(); ++it)
+    {
+      unsigned int left = it->due.MillisLeft();
+      if (left > 0)
+      {
+        if (wait == 0 || left < wait)
+          wait = left;
+        pending.insert(it->item);
+      }
+      else if (it->item.empty() || pending.find(it->item) == pending.end())
+      {
+        next = it;
+        break;
+      }
+    }
+
+    if (next == m_queue.end())
+    {
+      CSingleExit ex(m_critSection);
+      m_queueEvent.WaitMSec(wait);
+      continue;
+    }
+
+    CQueuedAnnouncement announcement = *next;
+    Erase(next);
+    m_delivered++;
+    {
+      CSingleExit ex(m_critSection);
+      m_announcer->Announce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), *announcement.data);
+    }
+  }
+}
+
+/*!
+ \brief Identifies the library item an announcement is about, e.g. "movie/12"
+ \return The identification or an empty string if there is no item id in the data
+ */
+static std::string GetItemKey(const CVariant &data)
+{
+  if (!data.isObject())
+    return "";
+
+  const CVariant &item = data.isMember("item") ? data["item"] : data;
+  if (!item.isObject() || !(item["id"].isInteger() || item["id"].isUnsignedInteger()) || item["id"].asInteger() <= 0)
+    return "";
+
+  return StringUtils::Format("%s/%" PRId64, item["type"].asString().c_str(), item["id"].asInteger());
+}
+
 CAnnouncementManager::CAnnouncementManager() : CThread("Announce")
 {
+  m_statistics.announced = 0;
+  m_statistics.delivered = 0;
+  m_statistics.merged = 0;
+  m_statistics.dropped = 0;
 }
 
 CAnnouncementManager::~CAnnouncementManager()
@@ -60,8 +290,45 @@ void CAnnouncementManager::Deinitialize()
   m_bStop = true;
   m_queueEvent.Set();
   StopThread();
+
+  std::vector<AnnouncerQueuePtr> queues;
+  {
+    CSingleLock lock (m_critSection);
+    m_announcers.clear();
+    for (std::map<IAnnouncer *, AnnouncerQueuePtr>::const_iterator it = m_queues.begin(); it != m_queues.end(); ++it)
+      queues.push_back(it->second);
+    m_queues.clear();
+    queues.insert(queues.end(), m_retiredQueues.begin(), m_retiredQueues.end());
+    m_retiredQueues.clear();
+  }
+
+  StopQueues(queues);
+}
+
+void CAnnouncementManager::StopQueues(std::vector<AnnouncerQueuePtr> &queues)
+{
+  // must be called without holding m_critSection as announcers may be
+  // waiting for it while announcing
+  for (std::vector<AnnouncerQueuePtr>::iterator it = queues.begin(); it != queues.end(); ++it)
+  {
+    (*it)->Stop();
+
+    CSingleLock lock (m_critSection);
+    (*it)->AddStatistics(m_statistics);
+
+    // the thread of an announcer which removed itself is still running
+    if ((*it)->IsCurrentThread())
+      m_retiredQueues.push_back(*it);
+  }
+  queues.clear();
+}
+
+void CAnnouncementManager::GetStatistics(AnnouncementStatistics &statistics)
+{
   CSingleLock lock (m_critSection);
-  m_announcers.clear();
+  statistics = m_statistics;
+  for (std::map<IAnnouncer *, AnnouncerQueuePtr>::const_iterator it = m_queues.begin(); it != m_queues.end(); ++it)
+    it->second->AddStatistics(statistics);
 }
 
 void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener)
@@ -71,6 +338,7 @@ void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener)
 
   CSingleLock lock (m_critSection);
   m_announcers.push_back(listener);
+  m_queues[listener] = AnnouncerQueuePtr(new CAnnouncerQueue(listener));
 }
 
 void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
@@ -78,15 +346,32 @@ void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
   if (!listener)
     return;
 
-  CSingleLock lock (m_critSection);
-  for (unsigned int i = 0; i < m_announcers.size(); i++)
+  std::vector<AnnouncerQueuePtr> queues;
   {
-    if (m_announcers[i] == listener)
+    CSingleLock lock (m_critSection);
+    for (unsigned int i = 0; i < m_announcers.size(); i++)
     {
-      m_announcers.erase(m_announcers.begin() + i);
-      return;
+      if (m_announcers[i] == listener)
+      {
+        m_announcers.erase(m_announcers.begin() + i);
+        break;
+      }
+    }
+
+    std::map<IAnnouncer *, AnnouncerQueuePtr>::iterator it = m_queues.find(listener);
+    if (it != m_queues.end())
+    {
+      queues.push_back(it->second);
+      m_queues.erase(it);
     }
+
+    // threads of announcers which removed themselves are done by now
+    queues.insert(queues.end(), m_retiredQueues.begin(), m_retiredQueues.end());
+    m_retiredQueues.clear();
   }
+
+  // wait for an announcement being delivered to the listener
+  StopQueues(queues);
 }
 
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message)
@@ -129,11 +414,23 @@ void CAnnouncementManager::DoAnnounce(AnnouncementFlag flag, const char *sender,
   CLog::Log(LOGDEBUG, "CAnnouncementManager - Announcement: %s from %s", message, sender);
 
   CSingleLock lock (m_critSection);
+  m_statistics.announced++;
+
+  if (g_advancedSettings.m_announceQueued)
+  {
+    // the data is shared by the queues of all announcers
+    std::shared_ptr<const CVariant> sharedData(new CVariant(data));
+    std::string item = (flag & COALESCE_FLAGS) ? GetItemKey(data) : "";
+    for (std::map<IAnnouncer *, AnnouncerQueuePtr>::const_iterator it = m_queues.begin(); it != m_queues.end(); ++it)
+      it->second->Push(flag, sender, message, sharedData, item, g_advancedSettings.m_announceCoalesceTime, g_advancedSettings.m_announceQueueSize);
+    return;
+  }
 
   // Make a copy of announers. They may be removed or even remove themselves during execution of IAnnouncer::Announce()!
   std::vector<IAnnouncer *> announcers(m_announcers);
   for (unsigned int i = 0; i < announcers.size(); i++)
     announcers[i]->Announce(flag, sender, message, data);
+  m_statistics.delivered += announcers.size();
 }
 
 void CAnnouncementManager::DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item, const CVariant &data)
@@ -18,6 +18,9 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <map>
+#include <memory>
+#include <stdint.h>
 #include <vector>
 
 #include "IAnnouncer.h"
@@ -31,6 +34,17 @@ class CVariant;
 
 namespace ANNOUNCEMENT
 {
+  /*!
+   \brief Counters of the announcements handled since startup
+   */
+  typedef struct
+  {
+    uint64_t announced; ///< announcements passed on to the announcers
+    uint64_t delivered; ///< calls to IAnnouncer::Announce()
+    uint64_t merged;    ///< queued announcements replaced by a repeated one
+    uint64_t dropped;   ///< queued announcements dropped as an announcer fell behind
+  } AnnouncementStatistics;
+
   class CAnnouncementManager : public CThread
   {
   public:
@@ -52,6 +66,8 @@ namespace ANNOUNCEMENT
     void Announce(AnnouncementFlag flag, const char *sender, const char *message,
         const std::shared_ptr<const CFileItem>& item, const CVariant &data);
 
+    void GetStatistics(AnnouncementStatistics &statistics);
+
   protected:
     void Process();
     void DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item, const CVariant &data);
@@ -72,7 +88,15 @@ namespace ANNOUNCEMENT
     CAnnouncementManager(const CAnnouncementManager&);
     CAnnouncementManager const& operator=(CAnnouncementManager const&);
 
+    class CAnnouncerQueue;
+    typedef std::shared_ptr<CAnnouncerQueue> AnnouncerQueuePtr;
+
+    void StopQueues(std::vector<AnnouncerQueuePtr> &queues);
+
     CCriticalSection m_critSection;
     std::vector<IAnnouncer *> m_announcers;
+    std::map<IAnnouncer *, AnnouncerQueuePtr> m_queues;
+    std::vector<AnnouncerQueuePtr> m_retiredQueues;
+    AnnouncementStatistics m_statistics;
   };
 }
@@ -133,7 +133,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtists(const std::string &method, ITransportLa
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("artistid", false, "artists", items, param, result, size, false);
+  HandleStreamedFileItemList("artistid", false, "artists", items, param, result, size, false);
   return OK;
 }
 
@@ -245,7 +245,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbums(const std::string &method, ITransportLay
   int size = items.Size();
   if (total > size)
     size = total;
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
+  HandleStreamedFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -357,7 +357,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLaye
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
+  HandleStreamedFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
 
   return OK;
 }
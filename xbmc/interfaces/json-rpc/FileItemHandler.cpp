@@ -19,12 +19,15 @@
  */
 
 #include <map>
+#include <memory>
 #include <string.h>
+#include <vector>
 
 #include "FileItemHandler.h"
 #include "AudioLibrary.h"
 #include "VideoLibrary.h"
 #include "FileOperations.h"
+#include "JSONRPCResponseStream.h"
 #include "utils/SortUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/ISerializable.h"
@@ -210,6 +213,75 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
 }
 
 void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  HandleFileItemList(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit, false);
+}
+
+void CFileItemHandler::HandleStreamedFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  HandleFileItemList(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit, true);
+}
+
+class CFileItemHandler::CStreamedFileItems : public IStreamedArray
+{
+public:
+  CStreamedFileItems(const char *ID, bool allowFile, const char *resultname, const CVariant &parameterObject, const std::set<std::string> &fields)
+    : m_hasID(ID != NULL),
+      m_ID(ID != NULL ? ID : ""),
+      m_allowFile(allowFile),
+      m_resultname(resultname),
+      m_parameterObject(parameterObject),
+      m_fields(fields),
+      m_position(0),
+      m_thumbLoader(NULL)
+  { }
+
+  virtual ~CStreamedFileItems()
+  {
+    delete m_thumbLoader;
+  }
+
+  std::vector<CFileItemPtr> m_items;
+
+  virtual bool WriteNext(CJSONStreamWriter &writer)
+  {
+    if (m_position >= m_items.size())
+      return false;
+
+    if (m_position == 0)
+    {
+      if (m_items.front()->HasVideoInfoTag())
+        m_thumbLoader = new CVideoThumbLoader();
+      else if (m_items.front()->HasMusicInfoTag())
+        m_thumbLoader = new CMusicThumbLoader();
+
+      if (m_thumbLoader != NULL)
+        m_thumbLoader->OnLoaderStart();
+    }
+
+    // release every item once it has been written
+    CFileItemPtr item;
+    item.swap(m_items[m_position++]);
+
+    CVariant object;
+    HandleFileItem(m_hasID ? m_ID.c_str() : NULL, m_allowFile, m_resultname.c_str(), item, m_parameterObject, m_fields, object, false, m_thumbLoader);
+    writer.WriteValue(object[m_resultname]);
+
+    return true;
+  }
+
+private:
+  bool m_hasID;
+  std::string m_ID;
+  bool m_allowFile;
+  std::string m_resultname;
+  CVariant m_parameterObject;
+  std::set<std::string> m_fields;
+  size_t m_position;
+  CThumbLoader *m_thumbLoader;
+};
+
+void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit, bool streamed)
 {
   int start, end;
   HandleLimits(parameterObject, result, size, start, end);
@@ -222,6 +294,24 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
     end = items.Size();
   }
 
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  if (streamed && resultname != NULL && end - start > 0)
+  {
+    std::shared_ptr<CStreamedFileItems> streamedItems(new CStreamedFileItems(ID, allowFile, resultname, parameterObject, fields));
+    streamedItems->m_items.reserve(end - start);
+    for (int i = start; i < end; i++)
+      streamedItems->m_items.push_back(items.Get(i));
+
+    if (CJSONRPCResponseStream::DeferArray(result, resultname, streamedItems))
+      return;
+  }
+
   CThumbLoader *thumbLoader = NULL;
   if (end - start > 0)
   {
@@ -234,13 +324,6 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
       thumbLoader->OnLoaderStart();
   }
 
-  std::set<std::string> fields;
-  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
-  {
-    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
-      fields.insert(field->asString());
-  }
-
   for (int i = start; i < end; i++)
   {
     CFileItemPtr item = items.Get(i);
@@ -18,10 +18,12 @@
  *
  */
 
+#include <algorithm>
 #include <string.h>
 
 #include "JSONRPC.h"
 #include "ServiceDescription.h"
+#include "Application.h"
 #include "addons/Addon.h"
 #include "addons/IAddon.h"
 #include "dbwrappers/DatabaseQuery.h"
@@ -29,14 +31,33 @@
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
+#include "utils/ParallelFor.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "utils/Variant.h"
 #include "TextureDatabase.h"
 
 using namespace ANNOUNCEMENT;
 using namespace JSONRPC;
 
+// upper bounds of the execution time histogram buckets in milliseconds
+static const unsigned int StatisticsBuckets[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+#define STATISTICS_BUCKET_COUNT (sizeof(StatisticsBuckets) / sizeof(unsigned int) + 1)
+
+typedef struct
+{
+  uint64_t calls;
+  uint64_t errors;
+  int64_t totalTime;
+  int64_t maxTime;
+  uint64_t histogram[STATISTICS_BUCKET_COUNT];
+} MethodStatistics;
+
+static CCriticalSection statisticsSection;
+static std::map<std::string, MethodStatistics> statistics;
+
 bool CJSONRPC::m_initialized = false;
 
 void CJSONRPC::Initialize()
@@ -233,15 +254,54 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
   return ACK;
 }
 
+JSONRPC_STATUS CJSONRPC::GetStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result)
+{
+  result["buckets"] = CVariant(CVariant::VariantTypeArray);
+  for (unsigned int index = 0; index < STATISTICS_BUCKET_COUNT - 1; index++)
+    result["buckets"].push_back(StatisticsBuckets[index]);
+
+  result["methods"] = CVariant(CVariant::VariantTypeObject);
+
+  double frequency = (double)CurrentHostFrequency() / 1000.0;
+
+  CSingleLock lock(statisticsSection);
+  for (std::map<std::string, MethodStatistics>::const_iterator it = statistics.begin(); it != statistics.end(); ++it)
+  {
+    CVariant &methodStatistics = result["methods"][it->first];
+    methodStatistics["calls"] = it->second.calls;
+    methodStatistics["errors"] = it->second.errors;
+    methodStatistics["averagetime"] = it->second.calls > 0 ? it->second.totalTime / frequency / it->second.calls : 0.0;
+    methodStatistics["maxtime"] = it->second.maxTime / frequency;
+    methodStatistics["histogram"] = CVariant(CVariant::VariantTypeArray);
+    for (unsigned int index = 0; index < STATISTICS_BUCKET_COUNT; index++)
+      methodStatistics["histogram"].push_back(it->second.histogram[index]);
+  }
+
+  ANNOUNCEMENT::AnnouncementStatistics announcements;
+  CAnnouncementManager::GetInstance().GetStatistics(announcements);
+  result["announcements"]["announced"] = announcements.announced;
+  result["announcements"]["delivered"] = announcements.delivered;
+  result["announcements"]["merged"] = announcements.merged;
+  result["announcements"]["dropped"] = announcements.dropped;
+
+  return OK;
+}
+
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
-  bool hasResponse = false;
+  return MethodCallStream(inputString, transport, client)->ReadAll();
+}
+
+std::shared_ptr<CJSONRPCResponseStream> CJSONRPC::MethodCallStream(const std::string &inputString, ITransportLayer *transport, IClient *client)
+{
+  CVariant inputroot;
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
     CLog::Log(LOGDEBUG, "JSONRPC: Incoming request: %s", inputString.c_str());
 
   inputroot = CJSONVariantParser::Parse((unsigned char *)inputString.c_str(), inputString.length());
+
+  std::shared_ptr<CJSONRPCResponseStream> stream(new CJSONRPCResponseStream(inputroot.isArray() && inputroot.size() > 0, g_advancedSettings.m_jsonOutputCompact));
   if (!inputroot.isNull())
   {
     if (inputroot.isArray())
@@ -249,37 +309,78 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
       if (inputroot.size() <= 0)
       {
         CLog::Log(LOGERROR, "JSONRPC: Empty batch call\n");
-        BuildResponse(inputroot, InvalidRequest, CVariant(), outputroot);
-        hasResponse = true;
+        std::shared_ptr<CVariant> response(new CVariant);
+        BuildResponse(inputroot, InvalidRequest, CVariant(), *response);
+        stream->AddResponse(response, StreamedArrays());
       }
       else
-      {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
-        {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
-          {
-            outputroot.append(response);
-            hasResponse = true;
-          }
-        }
-      }
+        HandleBatchCall(inputroot, *stream, transport, client);
     }
     else
-      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+    {
+      std::shared_ptr<CVariant> response(new CVariant);
+      StreamedArrays arrays;
+      if (HandleMethodCall(inputroot, *response, arrays, transport, client))
+        stream->AddResponse(response, arrays);
+    }
   }
   else
   {
     CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
-    BuildResponse(inputroot, ParseError, CVariant(), outputroot);
-    hasResponse = true;
+    std::shared_ptr<CVariant> response(new CVariant);
+    BuildResponse(inputroot, ParseError, CVariant(), *response);
+    stream->AddResponse(response, StreamedArrays());
   }
 
-  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  stream->End();
+  return stream;
 }
 
-bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
+void CJSONRPC::HandleBatchCall(const CVariant& inputroot, CJSONRPCResponseStream &stream, ITransportLayer *transport, IClient *client)
+{
+  size_t count = inputroot.size();
+  std::vector<std::shared_ptr<CVariant> > responses(count);
+  std::vector<StreamedArrays> arrays(count);
+  std::vector<char> respond(count, 0);
+
+  // methods waiting for the application thread would never finish if it was
+  // the one waiting for them
+  bool concurrent = !g_application.IsCurrentThread();
+
+  size_t index = 0;
+  while (index < count)
+  {
+    // consecutive read-only calls don't depend on each other and are executed
+    // in parallel, any other call is a barrier executed on its own so the
+    // batch keeps its order wherever it can matter
+    size_t end = index + 1;
+    if (concurrent && IsReadOnlyCall(inputroot[index]))
+    {
+      while (end < count && IsReadOnlyCall(inputroot[end]))
+        end++;
+    }
+
+    KODI::UTILS::ParallelFor(end - index, 1, [&](size_t first, size_t last)
+    {
+      for (size_t call = index + first; call < index + last; call++)
+      {
+        responses[call].reset(new CVariant);
+        respond[call] = HandleMethodCall(inputroot[call], *responses[call], arrays[call], transport, client);
+      }
+    });
+
+    index = end;
+  }
+
+  // the responses are sent in the order of the requests
+  for (index = 0; index < count; index++)
+  {
+    if (respond[index])
+      stream.AddResponse(responses[index], arrays[index]);
+  }
+}
+
+bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, StreamedArrays &arrays, ITransportLayer *transport, IClient *client)
 {
   JSONRPC_STATUS errorCode = OK;
   CVariant result;
@@ -296,7 +397,12 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     CVariant params;
 
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
+    {
+      CJSONRPCResponseStream::CMethodScope scope(result, arrays);
+      int64_t start = CurrentHostCounter();
       errorCode = method(methodName, transport, client, params, result);
+      RecordCall(methodName, errorCode, CurrentHostCounter() - start);
+    }
     else
       result = params;
   }
@@ -306,6 +412,10 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     errorCode = InvalidRequest;
   }
 
+  // deferred arrays are only part of a successful result
+  if (errorCode != OK)
+    arrays.clear();
+
   BuildResponse(request, errorCode, result, response);
 
   return !isNotification;
@@ -316,6 +426,35 @@ inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
   return inputroot.isObject() && inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
 }
 
+bool CJSONRPC::IsReadOnlyCall(const CVariant& request)
+{
+  if (!IsProperJSONRPC(request))
+    return false;
+
+  std::string methodName = request["method"].asString();
+  StringUtils::ToLower(methodName);
+
+  return CJSONServiceDescription::IsReadOnly(methodName.c_str());
+}
+
+void CJSONRPC::RecordCall(const std::string &method, JSONRPC_STATUS status, int64_t duration)
+{
+  int64_t milliseconds = duration * 1000 / CurrentHostFrequency();
+  unsigned int bucket = 0;
+  while (bucket < STATISTICS_BUCKET_COUNT - 1 && milliseconds >= StatisticsBuckets[bucket])
+    bucket++;
+
+  CSingleLock lock(statisticsSection);
+  // new entries are value-initialized and start with all counters at zero
+  MethodStatistics &methodStatistics = statistics[method];
+  methodStatistics.calls++;
+  if (status != OK && status != ACK)
+    methodStatistics.errors++;
+  methodStatistics.totalTime += duration;
+  methodStatistics.maxTime = std::max(methodStatistics.maxTime, duration);
+  methodStatistics.histogram[bucket]++;
+}
+
 inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response)
 {
   response["jsonrpc"] = "2.0";
@@ -21,9 +21,12 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 
+#include "JSONRPCResponseStream.h"
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
 
@@ -64,6 +67,19 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request like MethodCall()
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \return Stream generating the JSON-RPC response while it is read
+
+     The called methods are executed before returning but large item lists
+     in their results are only converted while the response is read so the
+     caller can send it out in pieces.
+     */
+    static std::shared_ptr<CJSONRPCResponseStream> MethodCallStream(const std::string &inputString, ITransportLayer *transport, IClient *client);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -71,11 +87,15 @@ namespace JSONRPC
     static JSONRPC_STATUS GetConfiguration(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS SetConfiguration(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS NotifyAll(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
+    static JSONRPC_STATUS GetStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
   
   private:
     static void setup();
-    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static void HandleBatchCall(const CVariant& inputroot, CJSONRPCResponseStream &stream, ITransportLayer *transport, IClient *client);
+    static bool HandleMethodCall(const CVariant& request, CVariant& response, StreamedArrays &arrays, ITransportLayer *transport, IClient *client);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
+    static bool IsReadOnlyCall(const CVariant& request);
+    static void RecordCall(const std::string &method, JSONRPC_STATUS status, int64_t duration);
 
     inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
 
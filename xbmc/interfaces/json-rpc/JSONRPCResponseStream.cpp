@@ -0,0 +1,181 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+
+#include "JSONRPCResponseStream.h"
+#include "threads/ThreadLocal.h"
+#include "utils/Variant.h"
+
+// amount of data generated by ReadAll() before it is moved to the result string
+#define RESPONSE_STREAM_READ_SIZE 65536
+
+using namespace JSONRPC;
+
+static XbmcThreads::ThreadLocal<CJSONRPCResponseStream::CMethodScope> currentScope;
+
+CJSONRPCResponseStream::CMethodScope::CMethodScope(const CVariant &result, StreamedArrays &arrays)
+  : m_result(&result),
+    m_arrays(&arrays),
+    m_previous(currentScope.get())
+{
+  currentScope.set(this);
+}
+
+CJSONRPCResponseStream::CMethodScope::~CMethodScope()
+{
+  currentScope.set(m_previous);
+}
+
+CJSONRPCResponseStream::CJSONRPCResponseStream(bool batch, bool compact)
+  : m_writer(compact),
+    m_batch(batch),
+    m_responses(0)
+{ }
+
+void CJSONRPCResponseStream::AddResponse(const std::shared_ptr<CVariant> &response, const StreamedArrays &arrays)
+{
+  if (m_batch && m_responses == 0)
+    m_steps.push_back([](CJSONStreamWriter &writer) { writer.BeginArray(); return true; });
+  m_responses++;
+
+  if (arrays.empty() || !response->isMember("result"))
+  {
+    m_steps.push_back([response](CJSONStreamWriter &writer) { writer.WriteValue(*response); return true; });
+    return;
+  }
+
+  // the response is written member by member so that the deferred arrays
+  // end up at the same position the CVariant would have put them
+  m_steps.push_back([response](CJSONStreamWriter &writer)
+  {
+    writer.BeginObject();
+    for (CVariant::const_iterator_map it = response->begin_map(); it != response->end_map(); ++it)
+    {
+      if (it->first == "result")
+        break;
+      writer.WriteKey(it->first);
+      writer.WriteValue(it->second);
+    }
+    writer.WriteKey("result");
+    writer.BeginObject();
+    return true;
+  });
+
+  // merge the deferred arrays into the sorted members of the result
+  std::vector<std::string> members;
+  const CVariant &result = (*response)["result"];
+  if (result.isObject())
+  {
+    for (CVariant::const_iterator_map it = result.begin_map(); it != result.end_map(); ++it)
+      members.push_back(it->first);
+  }
+
+  std::vector<std::string>::const_iterator member = members.begin();
+  for (StreamedArrays::const_iterator array = arrays.begin(); array != arrays.end(); ++array)
+  {
+    for (; member != members.end() && *member < array->first; ++member)
+      AddMemberStep(response, *member);
+
+    const std::string &key = array->first;
+    StreamedArrayPtr producer = array->second;
+    m_steps.push_back([key](CJSONStreamWriter &writer)
+    {
+      writer.WriteKey(key);
+      writer.BeginArray();
+      return true;
+    });
+    m_steps.push_back([producer](CJSONStreamWriter &writer)
+    {
+      if (producer->WriteNext(writer))
+        return false;
+      writer.EndArray();
+      return true;
+    });
+  }
+
+  for (; member != members.end(); ++member)
+    AddMemberStep(response, *member);
+
+  m_steps.push_back([response](CJSONStreamWriter &writer)
+  {
+    writer.EndObject();
+    for (CVariant::const_iterator_map it = response->begin_map(); it != response->end_map(); ++it)
+    {
+      if (it->first <= "result")
+        continue;
+      writer.WriteKey(it->first);
+      writer.WriteValue(it->second);
+    }
+    writer.EndObject();
+    return true;
+  });
+}
+
+void CJSONRPCResponseStream::AddMemberStep(const std::shared_ptr<CVariant> &response, const std::string &key)
+{
+  m_steps.push_back([response, key](CJSONStreamWriter &writer)
+  {
+    writer.WriteKey(key);
+    writer.WriteValue((*response)["result"][key]);
+    return true;
+  });
+}
+
+void CJSONRPCResponseStream::End()
+{
+  if (m_batch && m_responses > 0)
+    m_steps.push_back([](CJSONStreamWriter &writer) { writer.EndArray(); return true; });
+}
+
+bool CJSONRPCResponseStream::Read(std::string &output, size_t size)
+{
+  while (!m_steps.empty() && m_writer.GetBufferedSize() < size)
+  {
+    if (m_steps.front()(m_writer))
+      m_steps.pop_front();
+  }
+
+  m_writer.TakeOutput(output);
+
+  return !m_steps.empty();
+}
+
+std::string CJSONRPCResponseStream::ReadAll()
+{
+  std::string output;
+  while (Read(output, RESPONSE_STREAM_READ_SIZE))
+    ;
+
+  return output;
+}
+
+bool CJSONRPCResponseStream::DeferArray(const CVariant &result, const std::string &key, const StreamedArrayPtr &array)
+{
+  CMethodScope *scope = currentScope.get();
+  if (scope == NULL || scope->m_result != &result || !array)
+    return false;
+
+  if (result.isMember(key) || scope->m_arrays->find(key) != scope->m_arrays->end())
+    return false;
+
+  (*scope->m_arrays)[key] = array;
+  return true;
+}
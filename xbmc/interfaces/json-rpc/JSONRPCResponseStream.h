@@ -0,0 +1,144 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "utils/JSONStreamWriter.h"
+
+class CVariant;
+
+namespace JSONRPC
+{
+  /*!
+   \ingroup jsonrpc
+   \brief Array in the result of a method which is only generated while
+   the response is written.
+   */
+  class IStreamedArray
+  {
+  public:
+    virtual ~IStreamedArray() { }
+
+    /*!
+     \brief Writes the next element of the array.
+     \param writer Stream writer the element has to be written to
+     \return False if all elements have already been written, otherwise true
+     */
+    virtual bool WriteNext(CJSONStreamWriter &writer) = 0;
+  };
+
+  typedef std::shared_ptr<IStreamedArray> StreamedArrayPtr;
+  typedef std::map<std::string, StreamedArrayPtr> StreamedArrays;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Serialized JSON-RPC response which is generated while being read.
+
+   The responses are written in the same form CJSONVariantWriter would
+   produce for the full response but only as much of it is generated as is
+   requested by Read(). Arrays deferred with DeferArray() are written
+   element by element so a large result never exists as a whole.
+   */
+  class CJSONRPCResponseStream
+  {
+  public:
+    /*!
+     \param batch Whether the responses belong to a batch call and have to be wrapped in an array
+     \param compact Whether to generate compact or beautified JSON
+     */
+    CJSONRPCResponseStream(bool batch, bool compact);
+
+    /*!
+     \brief Appends a response.
+     \param response Response without the deferred arrays
+     \param arrays Arrays deferred by the method, written as members of response["result"]
+     */
+    void AddResponse(const std::shared_ptr<CVariant> &response, const StreamedArrays &arrays);
+
+    /*!
+     \brief Marks the end of the responses, must be called after the last AddResponse().
+     */
+    void End();
+
+    /*!
+     \brief Whether there is anything to be sent back to the client.
+     */
+    bool HasResponse() const { return m_responses > 0; }
+
+    /*!
+     \brief Generates the next part of the response.
+     \param output String the generated data is appended to
+     \param size Number of bytes after which the generation stops, the last piece can overshoot it
+     \return True if more data is available, false once the response is complete
+     */
+    bool Read(std::string &output, size_t size);
+
+    /*!
+     \brief Generates the rest of the response.
+     */
+    std::string ReadAll();
+
+    /*!
+     \brief Defers an array in the result of the method currently executed
+     by this thread to the response stream.
+
+     \param result Result object of the method, arrays of nested objects can't be deferred
+     \param key Name of the member of result holding the array, must not be set in result
+     \param array Producer of the array elements
+     \return True if the array has been deferred, false if the caller has to fill result[key] itself
+     */
+    static bool DeferArray(const CVariant &result, const std::string &key, const StreamedArrayPtr &array);
+
+    /*!
+     \brief Enables DeferArray() for the result of a method while it is executed.
+     */
+    class CMethodScope
+    {
+    public:
+      CMethodScope(const CVariant &result, StreamedArrays &arrays);
+      ~CMethodScope();
+
+    private:
+      CMethodScope(const CMethodScope&);
+      CMethodScope& operator=(const CMethodScope&);
+
+      const CVariant *m_result;
+      StreamedArrays *m_arrays;
+      CMethodScope *m_previous;
+
+      friend class CJSONRPCResponseStream;
+    };
+
+  private:
+    typedef std::function<bool(CJSONStreamWriter &writer)> Step;
+
+    void AddMemberStep(const std::shared_ptr<CVariant> &response, const std::string &key);
+
+    CJSONStreamWriter m_writer;
+    std::deque<Step> m_steps;
+    bool m_batch;
+    unsigned int m_responses;
+  };
+}
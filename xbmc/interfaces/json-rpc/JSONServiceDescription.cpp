@@ -57,6 +57,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "JSONRPC.GetConfiguration",                     CJSONRPC::GetConfiguration },
   { "JSONRPC.SetConfiguration",                     CJSONRPC::SetConfiguration },
   { "JSONRPC.NotifyAll",                            CJSONRPC::NotifyAll },
+  { "JSONRPC.GetStatistics",                        CJSONRPC::GetStatistics },
 
 // Player
   { "Player.GetActivePlayers",                      CPlayerOperations::GetActivePlayers },
@@ -232,6 +233,8 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
 // Textures operations
   { "Textures.GetTextures",                         CTextureOperations::GetTextures },
   { "Textures.RemoveTexture",                       CTextureOperations::RemoveTexture },
+  { "Textures.CacheTextures",                       CTextureOperations::CacheTextures },
+  { "Textures.GetCacheStatistics",                  CTextureOperations::GetCacheStatistics },
 
 // Settings operations
   { "Settings.GetSections",                         CSettingsOperations::GetSections },
@@ -1226,6 +1229,7 @@ JsonRpcMethod::JsonRpcMethod()
     method(NULL),
     transportneed(Response),
     permission(ReadData),
+    readonly(false),
     description(),
     parameters(),
     returns(new JSONSchemaTypeDefinition())
@@ -1256,6 +1260,8 @@ bool JsonRpcMethod::Parse(const CVariant &value)
   else
     permission = StringToPermission(value.isMember("permission") ? value["permission"].asString() : "");
 
+  readonly = value["readonly"].isBoolean() && value["readonly"].asBoolean();
+
   description = GetString(value["description"], "");
 
   // Check whether there are parameters defined
@@ -1866,6 +1872,9 @@ JSONRPC_STATUS CJSONServiceDescription::Print(CVariant &result, ITransportLayer
         currentMethod["permission"] = permissions[0];
       else
         currentMethod["permission"] = permissions;
+
+      if (methodIterator->second.readonly)
+        currentMethod["readonly"] = true;
     }
 
     currentMethod["params"] = CVariant(CVariant::VariantTypeArray);
@@ -1899,6 +1908,12 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+bool CJSONServiceDescription::IsReadOnly(const char* const method)
+{
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  return iter != m_actionMap.end() && iter->second.readonly;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
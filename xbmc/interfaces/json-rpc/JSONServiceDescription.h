@@ -262,6 +262,11 @@ namespace JSONRPC
      to execute the method
      */
     OperationPermission permission;
+    /*!
+     \brief Whether the method only reads data and
+     can be executed concurrently with other such methods
+     */
+    bool readonly;
     /*!
      \brief Description of the method
      */
@@ -390,6 +395,14 @@ namespace JSONRPC
      given parameters from the request against the json schema description for the given method.
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
+
+    /*!
+     \brief Checks whether the given method is flagged as "readonly"
+     in its json schema description
+     \param method Called method
+     \return True if the method exists and doesn't change any state otherwise false
+     */
+    static bool IsReadOnly(const char* method);
     
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
@@ -102,3 +102,37 @@ JSONRPC_STATUS CTextureOperations::RemoveTexture(const std::string &method, ITra
 
   return ACK;
 }
+
+JSONRPC_STATUS CTextureOperations::CacheTextures(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  std::vector<std::string> urls;
+  const CVariant &urlsObject = parameterObject["urls"];
+  for (CVariant::const_iterator_array url = urlsObject.begin_array(); url != urlsObject.end_array(); ++url)
+    urls.push_back(url->asString());
+
+  result["queued"] = CTextureCache::GetInstance().CacheImages(urls);
+  return OK;
+}
+
+JSONRPC_STATUS CTextureOperations::GetCacheStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  TextureCachePipelineStatistics statistics;
+  CTextureCache::GetInstance().GetPipelineStatistics(statistics);
+
+  result["queued"] = statistics.queued;
+  result["cached"] = statistics.cached;
+  result["uptodate"] = statistics.uptodate;
+  result["failed"] = statistics.failed;
+  result["pending"] = statistics.pending;
+
+  static const char* stages[] = { "decode", "scale", "encode" };
+  for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+  {
+    CVariant &stage = result["stages"][stages[i]];
+    stage["waiting"] = statistics.waiting[i];
+    stage["time"] = statistics.stageTime[i];
+  }
+  result["imagespersecond"] = statistics.imagesPerSecond;
+
+  return OK;
+}
@@ -0,0 +1,168 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/AnnouncementManager.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace ANNOUNCEMENT;
+
+#define COALESCE_TIME 500
+
+namespace
+{
+class CTestAnnouncer : public IAnnouncer
+{
+public:
+  void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data) override
+  {
+    CSingleLock lock(m_critSection);
+    m_received.push_back(std::string(message) + ":" + data["value"].asString());
+    m_event.Set();
+  }
+
+  // waits until count announcements arrived and returns them
+  std::vector<std::string> WaitFor(size_t count, unsigned int timeout)
+  {
+    XbmcThreads::EndTime end(timeout);
+    CSingleLock lock(m_critSection);
+    while (m_received.size() < count && !end.IsTimePast())
+    {
+      CSingleExit ex(m_critSection);
+      m_event.WaitMSec(end.MillisLeft());
+    }
+    return m_received;
+  }
+
+private:
+  CCriticalSection m_critSection;
+  CEvent m_event;
+  std::vector<std::string> m_received;
+};
+
+CVariant ItemData(const char *type, int id, int value)
+{
+  CVariant data;
+  data["item"]["type"] = type;
+  data["item"]["id"] = id;
+  data["value"] = value;
+  return data;
+}
+
+CVariant Data(int value)
+{
+  CVariant data;
+  data["value"] = value;
+  return data;
+}
+}
+
+class TestAnnouncementManager : public ::testing::Test
+{
+protected:
+  TestAnnouncementManager()
+  {
+    m_queued = g_advancedSettings.m_announceQueued;
+    m_coalesceTime = g_advancedSettings.m_announceCoalesceTime;
+    m_queueSize = g_advancedSettings.m_announceQueueSize;
+
+    g_advancedSettings.m_announceQueued = true;
+    g_advancedSettings.m_announceCoalesceTime = COALESCE_TIME;
+    g_advancedSettings.m_announceQueueSize = 1000;
+
+    m_manager.Start();
+    m_manager.AddAnnouncer(&m_announcer);
+  }
+
+  ~TestAnnouncementManager()
+  {
+    m_manager.Deinitialize();
+
+    g_advancedSettings.m_announceQueued = m_queued;
+    g_advancedSettings.m_announceCoalesceTime = m_coalesceTime;
+    g_advancedSettings.m_announceQueueSize = m_queueSize;
+  }
+
+  CAnnouncementManager m_manager;
+  CTestAnnouncer m_announcer;
+
+private:
+  bool m_queued;
+  unsigned int m_coalesceTime;
+  unsigned int m_queueSize;
+};
+
+TEST_F(TestAnnouncementManager, CoalescesRepeatedItemAnnouncements)
+{
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 1));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 2));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 3));
+
+  std::vector<std::string> received = m_announcer.WaitFor(1, COALESCE_TIME * 4);
+  ASSERT_EQ(1u, received.size());
+  EXPECT_EQ("OnUpdate:3", received[0]);
+
+  // nothing else is on its way
+  EXPECT_EQ(1u, m_announcer.WaitFor(2, COALESCE_TIME * 2).size());
+
+  AnnouncementStatistics statistics;
+  m_manager.GetStatistics(statistics);
+  EXPECT_EQ(2u, statistics.merged);
+}
+
+TEST_F(TestAnnouncementManager, HeldBackItemDoesNotBlockOthers)
+{
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 1));
+  m_manager.Announce(Player, "xbmc", "OnPlay", Data(2));
+  m_manager.Announce(System, "xbmc", "OnWake", Data(3));
+
+  // the player and system announcements don't wait for the coalesce time
+  std::vector<std::string> received = m_announcer.WaitFor(2, COALESCE_TIME / 2);
+  ASSERT_EQ(2u, received.size());
+  EXPECT_EQ("OnPlay:2", received[0]);
+  EXPECT_EQ("OnWake:3", received[1]);
+
+  received = m_announcer.WaitFor(3, COALESCE_TIME * 4);
+  ASSERT_EQ(3u, received.size());
+  EXPECT_EQ("OnUpdate:1", received[2]);
+}
+
+TEST_F(TestAnnouncementManager, KeepsOrderPerItem)
+{
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 1));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnRemove", ItemData("movie", 1, 2));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 2, 3));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", ItemData("movie", 1, 4));
+
+  // the update of movie 1 after its removal is not merged into the first one
+  std::vector<std::string> received = m_announcer.WaitFor(4, COALESCE_TIME * 4);
+  ASSERT_EQ(4u, received.size());
+  EXPECT_EQ("OnUpdate:1", received[0]);
+  EXPECT_EQ("OnRemove:2", received[1]);
+  EXPECT_EQ("OnUpdate:3", received[2]);
+  EXPECT_EQ("OnUpdate:4", received[3]);
+}
@@ -1131,11 +1131,12 @@ int CMusicDatabase::AddGenre(const std::string& strGenre1)
       return it->second;
 
 
-    strSQL=PrepareSQL("select * from genre where strGenre like '%s'", strGenre.c_str());
-    m_pDS->query(strSQL);
-    if (m_pDS->num_rows() == 0)
+    strSQL = "select idGenre from genre where strGenre like ?";
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    stmt->bind_text(1, strGenre);
+    if (!stmt->step())
     {
-      m_pDS->close();
+      stmt.reset();
       // doesnt exists, add it
       strSQL=PrepareSQL("insert into genre (idGenre, strGenre) values( NULL, '%s' )", strGenre.c_str());
       m_pDS->exec(strSQL);
@@ -1146,9 +1147,8 @@ int CMusicDatabase::AddGenre(const std::string& strGenre1)
     }
     else
     {
-      int idGenre = m_pDS->fv("idGenre").get_asInt();
+      int idGenre = stmt->column_int(0);
       m_genreCache.insert(std::pair<std::string, int>(strGenre1, idGenre));
-      m_pDS->close();
       return idGenre;
     }
   }
@@ -1196,14 +1196,14 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
     if (!strMusicBrainzArtistID.empty())
     {
       // 1.a) Match on a MusicBrainz ID
-      strSQL = PrepareSQL("SELECT idArtist, strArtist FROM artist WHERE strMusicBrainzArtistID = '%s'",
-                          strMusicBrainzArtistID.c_str());
-      m_pDS->query(strSQL);
-      if (m_pDS->num_rows() > 0)
+      strSQL = "SELECT idArtist, strArtist FROM artist WHERE strMusicBrainzArtistID = ?";
+      dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+      stmt->bind_text(1, strMusicBrainzArtistID);
+      if (stmt->step())
       {
-        int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
-        bool update = m_pDS->fv("strArtist").get_asString().compare(strMusicBrainzArtistID) == 0;
-        m_pDS->close();
+        int idArtist = stmt->column_int(0);
+        bool update = stmt->column_text(1).compare(strMusicBrainzArtistID) == 0;
+        stmt.reset();
         if (update)
         {
           strSQL = PrepareSQL( "UPDATE artist SET strArtist = '%s' WHERE idArtist = %i", strArtist.c_str(), idArtist);
@@ -1212,17 +1212,18 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
         }
         return idArtist;
       }
-      m_pDS->close();
+      stmt.reset();
 
 
       // 1.b) No match on MusicBrainz ID. Look for a previously added artist with no MusicBrainz ID
       //     and update that if it exists.
-      strSQL = PrepareSQL("SELECT idArtist FROM artist WHERE strArtist LIKE '%s' AND strMusicBrainzArtistID IS NULL", strArtist.c_str());
-      m_pDS->query(strSQL);
-      if (m_pDS->num_rows() > 0)
+      strSQL = "SELECT idArtist FROM artist WHERE strArtist LIKE ? AND strMusicBrainzArtistID IS NULL";
+      stmt = m_pDB->prepare_statement(strSQL);
+      stmt->bind_text(1, strArtist);
+      if (stmt->step())
       {
-        int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
-        m_pDS->close();
+        int idArtist = stmt->column_int(0);
+        stmt.reset();
         // 1.b.a) We found an artist by name but with no MusicBrainz ID set, update it and assume it is our artist
         strSQL = PrepareSQL("UPDATE artist SET strArtist = '%s', strMusicBrainzArtistID = '%s' WHERE idArtist = %i",
                             strArtist.c_str(),
@@ -1238,17 +1239,11 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
     }
     else
     {
-      strSQL = PrepareSQL("SELECT idArtist FROM artist WHERE strArtist LIKE '%s'",
-                          strArtist.c_str());
-
-      m_pDS->query(strSQL);
-      if (m_pDS->num_rows() > 0)
-      {
-        int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
-        m_pDS->close();
-        return idArtist;
-      }
-      m_pDS->close();
+      strSQL = "SELECT idArtist FROM artist WHERE strArtist LIKE ?";
+      dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+      stmt->bind_text(1, strArtist);
+      if (stmt->step())
+        return stmt->column_int(0);
     }
 
     // 3) No artist exists at all - add it
@@ -1423,11 +1418,12 @@ int CMusicDatabase::AddRole(const std::string &strRole)
   {
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
-    strSQL = PrepareSQL("SELECT idRole FROM role WHERE strRole LIKE '%s'", strRole.c_str());
-    m_pDS->query(strSQL);
-    if (m_pDS->num_rows() > 0)
-      idRole = m_pDS->fv("idRole").get_asInt();
-    m_pDS->close();
+    strSQL = "SELECT idRole FROM role WHERE strRole LIKE ?";
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    stmt->bind_text(1, strRole);
+    if (stmt->step())
+      idRole = stmt->column_int(0);
+    stmt.reset();
 
     if (idRole < 0)
     {
@@ -1509,17 +1505,9 @@ int CMusicDatabase::GetRoleByName(const std::string& strRole)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL;
-    strSQL = PrepareSQL("SELECT idRole FROM role WHERE strRole like '%s'", strRole.c_str());
-    // run query
-    if (!m_pDS->query(strSQL)) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound != 1)
-    {
-      m_pDS->close();
-      return -1;
-    }
-    return m_pDS->fv("idRole").get_asInt();
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement("SELECT idRole FROM role WHERE strRole like ?");
+    stmt->bind_text(1, strRole);
+    return GetUniqueId(stmt);
   }
   catch (...)
   {
@@ -1885,26 +1873,24 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL);
-    if (m_pDS->num_rows() == 0)
+    int idPath = -1;
+    strSQL = "select idPath from path where strPath=?";
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    stmt->bind_text(1, strPath);
+    if (stmt->step())
+      idPath = stmt->column_int(0);
+    stmt.reset();
+
+    if (idPath < 0)
     {
-      m_pDS->close();
       // doesnt exists, add it
       strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
       m_pDS->exec(strSQL);
 
-      int idPath = (int)m_pDS->lastinsertid();
-      m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
-      return idPath;
-    }
-    else
-    {
-      int idPath = m_pDS->fv("idPath").get_asInt();
-      m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
-      m_pDS->close();
-      return idPath;
+      idPath = (int)m_pDS->lastinsertid();
     }
+    m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
+    return idPath;
   }
   catch (...)
   {
@@ -4015,20 +4001,32 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
       return false;
 
     // Apply the limiting directly here if there's no special sorting but limiting
+    bool limit = false;
+    int limitOffset, limitCount;
     if (extFilter.limit.empty() &&
         sortDescription.sortBy == SortByNone &&
        (sortDescription.limitStart > 0 || sortDescription.limitEnd > 0))
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart);
+      total = GetCount(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra);
+      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart, limitOffset, limitCount);
+      limit = true;
     }
 
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "albumview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
+    // the listing is compiled once and reused from the statement cache when
+    // it is refreshed, only the range of rows is bound
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    if (limit)
+    {
+      stmt->bind_int(1, limitOffset);
+      stmt->bind_int(2, limitCount);
+    }
+
     // run query
     unsigned int time = XbmcThreads::SystemClockMillis();
-    if (!m_pDS->query(strSQL))
+    if (!m_pDS->query_statement(stmt))
       return false;
     CLog::Log(LOGDEBUG, "%s - query took %i ms",
               __FUNCTION__, XbmcThreads::SystemClockMillis() - time); time = XbmcThreads::SystemClockMillis();
@@ -4420,60 +4418,106 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
       return false;
 
     // Apply the limiting directly here if there's no special sorting but limiting
+    bool limit = false;
+    int limitOffset, limitCount;
     if (extFilter.limit.empty() &&
         sortDescription.sortBy == SortByNone &&
        (sortDescription.limitStart > 0 || sortDescription.limitEnd > 0))
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart);
+      total = GetCount(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra);
+      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart, limitOffset, limitCount);
+      limit = true;
     }
 
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "songview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
-    // run query
-    if (!m_pDS->query(strSQL))
-      return false;
 
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
+    // the listing is compiled once and reused from the statement cache when
+    // it is refreshed, only the range of rows is bound
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    if (limit)
     {
-      m_pDS->close();
-      return true;
+      stmt->bind_int(1, limitOffset);
+      stmt->bind_int(2, limitCount);
     }
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
-      return false;
-
-    // get data from returned rows
-    items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
     int count = 0;
-    for (const auto &i : results)
+    auto addSong = [&](const dbiplus::sql_record* const record)
     {
-      unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
-      try
+      CFileItemPtr item(new CFileItem);
+      GetFileItemFromDataset(record, item.get(), musicUrl);
+      // HACK for sorting by database returned order
+      item->m_iprogramCount = ++count;
+      items.Add(item);
+    };
+
+    // without sorting on our side the rows can be consumed as the database
+    // produces them instead of materializing the whole result set first
+    if (sortDescription.sortBy == SortByNone)
+    {
+      if (!m_pDS->query_statement_streaming(stmt))
+        return false;
+
+      for (; !m_pDS->eof(); m_pDS->next())
       {
-        CFileItemPtr item(new CFileItem);
-        GetFileItemFromDataset(record, item.get(), musicUrl);
-        // HACK for sorting by database returned order
-        item->m_iprogramCount = ++count;
-        items.Add(item);
+        try
+        {
+          addSong(m_pDS->get_sql_record());
+        }
+        catch (...)
+        {
+          m_pDS->close();
+          CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
+          return (items.Size() > 0);
+        }
       }
-      catch (...)
+
+      // store the total value of items as a property
+      if (total < m_pDS->num_rows())
+        total = m_pDS->num_rows();
+      if (total > 0)
+        items.SetProperty("total", total);
+    }
+    else
+    {
+      // run query
+      if (!m_pDS->query_statement(stmt))
+        return false;
+
+      int iRowsFound = m_pDS->num_rows();
+      if (iRowsFound == 0)
       {
         m_pDS->close();
-        CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
-        return (items.Size() > 0);
+        return true;
+      }
+
+      // store the total value of items as a property
+      if (total < iRowsFound)
+        total = iRowsFound;
+      items.SetProperty("total", total);
+
+      DatabaseResults results;
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
+        return false;
+
+      // get data from returned rows
+      items.Reserve(results.size());
+      const dbiplus::query_data &data = m_pDS->get_result_set().records;
+      for (const auto &i : results)
+      {
+        unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
+        try
+        {
+          addSong(data.at(targetRow));
+        }
+        catch (...)
+        {
+          m_pDS->close();
+          CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
+          return (items.Size() > 0);
+        }
       }
     }
 
@@ -5160,19 +5204,9 @@ int CMusicDatabase::GetArtistByName(const std::string& strArtist)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL=PrepareSQL("select idArtist from artist where artist.strArtist like '%s'", strArtist.c_str());
-
-    // run query
-    if (!m_pDS->query(strSQL)) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound != 1)
-    {
-      m_pDS->close();
-      return -1;
-    }
-    int lResult = m_pDS->fv("artist.idArtist").get_asInt();
-    m_pDS->close();
-    return lResult;
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement("select idArtist from artist where artist.strArtist like ?");
+    stmt->bind_text(1, strArtist);
+    return GetUniqueId(stmt);
   }
   catch (...)
   {
@@ -5188,20 +5222,16 @@ int CMusicDatabase::GetAlbumByName(const std::string& strAlbum, const std::strin
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL;
+    dbiplus::StatementPtr stmt;
     if (strArtist.empty())
-      strSQL=PrepareSQL("SELECT idAlbum FROM album WHERE album.strAlbum LIKE '%s'", strAlbum.c_str());
+      stmt = m_pDB->prepare_statement("SELECT idAlbum FROM album WHERE album.strAlbum LIKE ?");
     else
-      strSQL=PrepareSQL("SELECT album.idAlbum FROM album WHERE album.strAlbum LIKE '%s' AND album.strArtists LIKE '%s'", strAlbum.c_str(),strArtist.c_str());
-    // run query
-    if (!m_pDS->query(strSQL)) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound != 1)
     {
-      m_pDS->close();
-      return -1;
+      stmt = m_pDB->prepare_statement("SELECT album.idAlbum FROM album WHERE album.strAlbum LIKE ? AND album.strArtists LIKE ?");
+      stmt->bind_text(2, strArtist);
     }
-    return m_pDS->fv("album.idAlbum").get_asInt();
+    stmt->bind_text(1, strAlbum);
+    return GetUniqueId(stmt);
   }
   catch (...)
   {
@@ -5242,17 +5272,9 @@ int CMusicDatabase::GetGenreByName(const std::string& strGenre)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL;
-    strSQL=PrepareSQL("select idGenre from genre where genre.strGenre like '%s'", strGenre.c_str());
-    // run query
-    if (!m_pDS->query(strSQL)) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound != 1)
-    {
-      m_pDS->close();
-      return -1;
-    }
-    return m_pDS->fv("genre.idGenre").get_asInt();
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement("select idGenre from genre where genre.strGenre like ?");
+    stmt->bind_text(1, strGenre);
+    return GetUniqueId(stmt);
   }
   catch (...)
   {
@@ -5600,18 +5622,12 @@ int CMusicDatabase::GetSongIDFromPath(const std::string &filePath)
     URIUtils::Split(filePath, strPath, strFileName);
     URIUtils::AddSlashAtEnd(strPath);
 
-    std::string sql = PrepareSQL("select idSong from song join path on song.idPath = path.idPath where song.strFileName='%s' and path.strPath='%s'", strFileName.c_str(), strPath.c_str());
-    if (!m_pDS->query(sql)) return -1;
-
-    if (m_pDS->num_rows() == 0)
-    {
-      m_pDS->close();
-      return -1;
-    }
-
-    int songID = m_pDS->fv("idSong").get_asInt();
-    m_pDS->close();
-    return songID;
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement("select idSong from song join path on song.idPath = path.idPath where song.strFileName=? and path.strPath=?");
+    stmt->bind_text(1, strFileName);
+    stmt->bind_text(2, strPath);
+    if (stmt->step())
+      return stmt->column_int(0);
+    return -1;
   }
   catch (...)
   {
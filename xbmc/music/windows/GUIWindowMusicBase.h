@@ -72,6 +72,7 @@ protected:
   virtual void UpdateButtons() override;
 
   virtual bool GetDirectory(const std::string &strDirectory, CFileItemList &items) override;
+  virtual CBackgroundInfoLoader* GetListingLoader() override { return &m_thumbLoader; }
   virtual void OnRetrieveMusicInfo(CFileItemList& items);
   virtual void OnPrepareFileItems(CFileItemList &items) override;
   void AddItemToPlayList(const CFileItemPtr &pItem, CFileItemList &queuedItems);
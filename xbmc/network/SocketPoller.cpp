@@ -0,0 +1,321 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <errno.h>
+
+#include "SocketPoller.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+#define HAS_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#ifdef TARGET_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// maximum number of ready sockets fetched by a single epoll_wait()
+#define EPOLL_MAX_EVENTS 64
+// without a wake up pipe changes are only picked up once select() returns
+#define SELECT_MAX_TIMEOUT 100
+
+#ifdef HAS_EPOLL
+// the descriptor and the generation of its registration are kept together
+static uint64_t ToEpollData(SOCKET socket, unsigned int generation)
+{
+  return ((uint64_t)generation << 32) | (uint32_t)socket;
+}
+
+static uint32_t ToEpollEvents(int events)
+{
+  uint32_t epollEvents = 0;
+  if (events & CSocketPoller::EventRead)
+    epollEvents |= EPOLLIN;
+  if (events & CSocketPoller::EventWrite)
+    epollEvents |= EPOLLOUT;
+
+  return epollEvents;
+}
+#endif
+
+CSocketPoller::CSocketPoller()
+  : m_generation(0),
+    m_epoll(-1)
+{
+  m_wakeup[0] = m_wakeup[1] = -1;
+}
+
+CSocketPoller::~CSocketPoller()
+{
+  Deinitialize();
+}
+
+bool CSocketPoller::Initialize()
+{
+  Deinitialize();
+
+  CSingleLock lock(m_critSection);
+#ifdef HAS_EPOLL
+  m_epoll = epoll_create(EPOLL_MAX_EVENTS);
+  if (m_epoll < 0)
+    CLog::Log(LOGWARNING, "SocketPoller: Unable to create epoll instance (%d), falling back to select", errno);
+#endif
+
+#ifdef TARGET_POSIX
+  if (pipe(m_wakeup) == 0)
+  {
+    fcntl(m_wakeup[0], F_SETFL, fcntl(m_wakeup[0], F_GETFL) | O_NONBLOCK);
+    fcntl(m_wakeup[1], F_SETFL, fcntl(m_wakeup[1], F_GETFL) | O_NONBLOCK);
+  }
+  else
+  {
+    CLog::Log(LOGWARNING, "SocketPoller: Unable to create wake up pipe (%d)", errno);
+    m_wakeup[0] = m_wakeup[1] = -1;
+  }
+#endif
+
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0 && m_wakeup[0] >= 0)
+  {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = ToEpollData(m_wakeup[0], 0);
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup[0], &event);
+  }
+#endif
+
+  return true;
+}
+
+void CSocketPoller::Deinitialize()
+{
+  CSingleLock lock(m_critSection);
+  m_sockets.clear();
+
+#ifdef TARGET_POSIX
+  if (m_epoll >= 0)
+    close(m_epoll);
+  if (m_wakeup[0] >= 0)
+    close(m_wakeup[0]);
+  if (m_wakeup[1] >= 0)
+    close(m_wakeup[1]);
+#endif
+
+  m_epoll = -1;
+  m_wakeup[0] = m_wakeup[1] = -1;
+}
+
+bool CSocketPoller::Add(SOCKET socket, int events)
+{
+  CSingleLock lock(m_critSection);
+  Registration &registration = m_sockets[socket];
+  registration.events = events;
+  registration.generation = ++m_generation;
+
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0)
+  {
+    struct epoll_event event = {};
+    event.events = ToEpollEvents(events);
+    event.data.u64 = ToEpollData(socket, registration.generation);
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) < 0)
+    {
+      CLog::Log(LOGERROR, "SocketPoller: Unable to add socket %d (%d)", (int)socket, errno);
+      m_sockets.erase(socket);
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  WakeUp();
+  return true;
+}
+
+bool CSocketPoller::Modify(SOCKET socket, int events)
+{
+  CSingleLock lock(m_critSection);
+  std::map<SOCKET, Registration>::iterator it = m_sockets.find(socket);
+  if (it == m_sockets.end())
+    return false;
+  if (it->second.events == events)
+    return true;
+
+  it->second.events = events;
+
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0)
+  {
+    struct epoll_event event = {};
+    event.events = ToEpollEvents(events);
+    event.data.u64 = ToEpollData(socket, it->second.generation);
+    return epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event) == 0;
+  }
+#endif
+
+  WakeUp();
+  return true;
+}
+
+void CSocketPoller::Remove(SOCKET socket)
+{
+  CSingleLock lock(m_critSection);
+  if (m_sockets.erase(socket) == 0)
+    return;
+
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0)
+  {
+    // the event argument is ignored but must not be NULL on old kernels
+    struct epoll_event event = {};
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, &event);
+    return;
+  }
+#endif
+
+  WakeUp();
+}
+
+int CSocketPoller::Wait(int timeoutMs, std::vector<Event> &events)
+{
+  events.clear();
+
+#ifdef HAS_EPOLL
+  if (m_epoll >= 0)
+  {
+    struct epoll_event ready[EPOLL_MAX_EVENTS];
+    int count = epoll_wait(m_epoll, ready, EPOLL_MAX_EVENTS, timeoutMs);
+    if (count < 0)
+      return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < count; i++)
+    {
+      Event event;
+      event.socket = (SOCKET)(uint32_t)ready[i].data.u64;
+      event.generation = (unsigned int)(ready[i].data.u64 >> 32);
+      event.events = 0;
+
+      if (event.socket == m_wakeup[0])
+      {
+        DrainWakeUp();
+        continue;
+      }
+
+      if (ready[i].events & EPOLLIN)
+        event.events |= EventRead;
+      if (ready[i].events & EPOLLOUT)
+        event.events |= EventWrite;
+      if (ready[i].events & (EPOLLERR | EPOLLHUP))
+        event.events |= EventError;
+      events.push_back(event);
+    }
+
+    return (int)events.size();
+  }
+#endif
+
+  // the sets have to be rebuilt for every call to select()
+  std::vector<Event> sockets;
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<SOCKET, Registration>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+    {
+      Event socket = { it->first, it->second.events, it->second.generation };
+      sockets.push_back(socket);
+    }
+  }
+
+  fd_set rfds, wfds;
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  SOCKET maxfd = 0;
+
+  for (std::vector<Event>::const_iterator it = sockets.begin(); it != sockets.end(); ++it)
+  {
+    if (it->events & EventRead)
+      FD_SET(it->socket, &rfds);
+    if (it->events & EventWrite)
+      FD_SET(it->socket, &wfds);
+    if ((it->events & (EventRead | EventWrite)) && (intptr_t)it->socket > (intptr_t)maxfd)
+      maxfd = it->socket;
+  }
+
+  if (m_wakeup[0] >= 0)
+  {
+    FD_SET(m_wakeup[0], &rfds);
+    if ((intptr_t)m_wakeup[0] > (intptr_t)maxfd)
+      maxfd = m_wakeup[0];
+  }
+  else
+    timeoutMs = std::min(timeoutMs, SELECT_MAX_TIMEOUT);
+
+  struct timeval to;
+  to.tv_sec = timeoutMs / 1000;
+  to.tv_usec = (timeoutMs % 1000) * 1000;
+
+  int res = select((intptr_t)maxfd + 1, &rfds, &wfds, NULL, &to);
+  if (res < 0)
+    return errno == EINTR ? 0 : -1;
+
+  if (m_wakeup[0] >= 0 && FD_ISSET(m_wakeup[0], &rfds))
+    DrainWakeUp();
+
+  for (std::vector<Event>::const_iterator it = sockets.begin(); it != sockets.end(); ++it)
+  {
+    Event event = { it->socket, 0, it->generation };
+    if ((it->events & EventRead) && FD_ISSET(it->socket, &rfds))
+      event.events |= EventRead;
+    if ((it->events & EventWrite) && FD_ISSET(it->socket, &wfds))
+      event.events |= EventWrite;
+    if (event.events != 0)
+      events.push_back(event);
+  }
+
+  return (int)events.size();
+}
+
+bool CSocketPoller::IsCurrent(const Event &event)
+{
+  CSingleLock lock(m_critSection);
+  std::map<SOCKET, Registration>::const_iterator it = m_sockets.find(event.socket);
+  return it != m_sockets.end() && it->second.generation == event.generation;
+}
+
+void CSocketPoller::WakeUp()
+{
+#ifdef TARGET_POSIX
+  // a full pipe already guarantees a wake up
+  if (m_wakeup[1] >= 0 && write(m_wakeup[1], "", 1) < 0 && errno != EAGAIN)
+    CLog::Log(LOGDEBUG, "SocketPoller: Unable to wake up (%d)", errno);
+#endif
+}
+
+void CSocketPoller::DrainWakeUp()
+{
+#ifdef TARGET_POSIX
+  char buffer[64];
+  while (read(m_wakeup[0], buffer, sizeof(buffer)) > 0)
+    ;
+#endif
+}
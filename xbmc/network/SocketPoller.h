@@ -0,0 +1,109 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <vector>
+
+#include "system.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief Waits for readiness on a set of sockets.
+
+ Uses epoll where it is available and falls back to select() otherwise.
+ The sockets can be added, modified and removed from any thread, a thread
+ blocked in Wait() picks up the changes without waiting for its timeout.
+ */
+class CSocketPoller
+{
+public:
+  enum Events
+  {
+    EventRead   = 0x01,
+    EventWrite  = 0x02,
+    EventError  = 0x04
+  };
+
+  typedef struct
+  {
+    SOCKET socket;
+    int events;
+    unsigned int generation; ///< identifies the registration of the socket the event belongs to
+  } Event;
+
+  CSocketPoller();
+  ~CSocketPoller();
+
+  bool Initialize();
+  void Deinitialize();
+
+  /*!
+   \brief Whether the sockets are polled with epoll or with select()
+   */
+  bool IsEpoll() const { return m_epoll >= 0; }
+
+  /*!
+   \brief Starts watching a socket
+   \param events Combination of EventRead and EventWrite to wait for, errors are always reported
+   */
+  bool Add(SOCKET socket, int events);
+  bool Modify(SOCKET socket, int events);
+  void Remove(SOCKET socket);
+
+  /*!
+   \brief Waits until at least one of the sockets is ready
+   \param timeoutMs Maximum time to wait in milliseconds
+   \param events Filled with the ready sockets and their events
+   \return Number of ready sockets, 0 on timeout or wake up and -1 on failure
+   */
+  int Wait(int timeoutMs, std::vector<Event> &events);
+
+  /*!
+   \brief Whether the socket of an event returned by Wait() is still watched
+   under the same registration. A socket removed while handling an earlier
+   event of the same Wait() may already have been replaced by a new one with
+   the same descriptor.
+   */
+  bool IsCurrent(const Event &event);
+
+  /*!
+   \brief Makes a thread blocked in Wait() return
+   */
+  void WakeUp();
+
+private:
+  typedef struct
+  {
+    int events;
+    unsigned int generation;
+  } Registration;
+
+  CSocketPoller(const CSocketPoller&);
+  CSocketPoller& operator=(const CSocketPoller&);
+
+  void DrainWakeUp();
+
+  CCriticalSection m_critSection;
+  std::map<SOCKET, Registration> m_sockets;
+  unsigned int m_generation;
+  int m_epoll;
+  int m_wakeup[2];
+};
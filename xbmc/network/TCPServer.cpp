@@ -19,11 +19,16 @@
  */
 
 #include "TCPServer.h"
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <errno.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#ifndef TARGET_WINDOWS
+#include <fcntl.h>
+#endif
 
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -57,6 +62,35 @@ using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 
 #define RECEIVEBUFFER 1024
+// size of the pieces JSON-RPC responses are sent in
+#define RESPONSE_CHUNK_SIZE 16384
+// no further requests are read from a client while this much data is waiting to be sent to it
+#define OUTBOUND_HIGH_WATERMARK (256 * 1024)
+// announcements are dropped for a client while this much data is waiting to be sent to it
+#define OUTBOUND_QUEUE_LIMIT (4 * 1024 * 1024)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static bool SetNonBlocking(SOCKET socket)
+{
+#ifdef TARGET_WINDOWS
+  u_long nonblocking = 1;
+  return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+  return fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool WouldBlock()
+{
+#ifdef TARGET_WINDOWS
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -119,112 +153,159 @@ void CTCPServer::Process()
 {
   m_bStop = false;
 
+  std::vector<CSocketPoller::Event> events;
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
-
-    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    int res = m_poller.Wait(1000, events);
+    if (res < 0)
     {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
+      CLog::Log(LOGERROR, "JSONRPC Server: Waiting for sockets failed");
+      Sleep(1000);
+      Initialize();
+      continue;
     }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    for (std::vector<CSocketPoller::Event>::const_iterator event = events.begin(); event != events.end(); ++event)
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      // the socket may have been closed by an earlier event and its
+      // descriptor reused for a new connection
+      if (!m_poller.IsCurrent(*event))
+        continue;
+
+      if (std::find(m_servers.begin(), m_servers.end(), event->socket) != m_servers.end())
+      {
+        // the server has been reinitialized and the remaining events are stale
+        if (!AcceptConnection(event->socket))
+          break;
+        continue;
+      }
+
+      CTCPClientPtr client;
+      {
+        CSingleLock lock(m_critSection);
+        std::map<SOCKET, CTCPClientPtr>::const_iterator it = m_connections.find(event->socket);
+        if (it != m_connections.end())
+          client = it->second;
+      }
+
+      if (!client)
+        continue;
+
+      bool close = false;
+      if (event->events & CSocketPoller::EventWrite)
+        close = !client->Flush();
+      if (!close && (event->events & (CSocketPoller::EventRead | CSocketPoller::EventError)))
+        close = !ReadConnection(event->socket);
+
+      if (close)
+        RemoveConnection(event->socket);
     }
+  }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+  Deinitialize();
+}
+
+bool CTCPServer::AcceptConnection(SOCKET server)
+{
+  CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+  CTCPClientPtr newconnection(new CTCPClient());
+  newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+  if (newconnection->m_socket == INVALID_SOCKET)
+  {
+    // the connection has already been taken back by the client
+    if (WouldBlock())
+      return true;
+
+    CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
+    if (EBADF == errno)
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
       Sleep(1000);
       Initialize();
+      return false;
     }
-    else if (res > 0)
+    return true;
+  }
+
+  if (!SetNonBlocking(newconnection->m_socket))
+    CLog::Log(LOGWARNING, "JSONRPC Server: Failed to make new connection non-blocking");
+#ifdef SO_NOSIGPIPE
+  int nosigpipe = 1;
+  setsockopt(newconnection->m_socket, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+
+  CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+  CSingleLock lock(m_critSection);
+  m_connections[newconnection->m_socket] = newconnection;
+  newconnection->Attach(&m_poller);
+
+  return true;
+}
+
+bool CTCPServer::ReadConnection(SOCKET socket)
+{
+  CTCPClientPtr client;
+  {
+    CSingleLock lock(m_critSection);
+    std::map<SOCKET, CTCPClientPtr>::const_iterator it = m_connections.find(socket);
+    if (it == m_connections.end())
+      return false;
+    client = it->second;
+  }
+
+  char buffer[RECEIVEBUFFER] = {};
+  int nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
+  if (nread < 0 && WouldBlock())
+    return true;
+  if (nread <= 0)
+    return false;
+
+  std::string response;
+  if (client->IsNew())
+  {
+    CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+    if (!response.empty())
+      client->Send(response.c_str(), response.size());
+
+    if (websocket != NULL)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      // Replace the CTCPClient with a CWebSocketClient, announcers still
+      // holding on to the old client must not write to the socket anymore
+      CTCPClientPtr websocketClient;
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
-        {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (!response.empty())
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
-        }
+        CSingleLock clientLock(client->m_critSection);
+        websocketClient.reset(new CWebSocketClient(websocket, *client));
+        client->m_socket = INVALID_SOCKET;
       }
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
-      {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
-      }
+      CSingleLock lock(m_critSection);
+      client = websocketClient;
+      m_connections[socket] = client;
     }
   }
 
-  Deinitialize();
+  if (response.size() <= 0)
+    client->PushBuffer(this, buffer, nread);
+
+  return !client->Closing();
+}
+
+void CTCPServer::RemoveConnection(SOCKET socket)
+{
+  CTCPClientPtr client;
+  {
+    CSingleLock lock(m_critSection);
+    std::map<SOCKET, CTCPClientPtr>::iterator it = m_connections.find(socket);
+    if (it == m_connections.end())
+      return;
+
+    client = it->second;
+    m_connections.erase(it);
+  }
+
+  CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+  client->Disconnect();
 }
 
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
@@ -244,17 +325,25 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
-  std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
+  // serialized once and shared by the outbound queues of all clients
+  std::shared_ptr<const std::string> announcement(new std::string(IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact)));
 
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  // the clients are announced to without holding the server lock, so a busy
+  // client only delays the announcer and not the server thread
+  std::vector<CTCPClientPtr> clients;
   {
-    {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
-        continue;
-    }
+    CSingleLock lock(m_critSection);
+    clients.reserve(m_connections.size());
+    for (std::map<SOCKET, CTCPClientPtr>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+      clients.push_back(it->second);
+  }
+
+  for (std::vector<CTCPClientPtr>::const_iterator it = clients.begin(); it != clients.end(); ++it)
+  {
+    if (((*it)->GetAnnouncementFlags() & flag) == 0)
+      continue;
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    (*it)->Announce(announcement);
   }
 }
 
@@ -269,6 +358,14 @@ bool CTCPServer::Initialize()
 
   if (started)
   {
+    m_poller.Initialize();
+    for (std::vector<SOCKET>::const_iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    {
+      SetNonBlocking(*it);
+      m_poller.Add(*it, CSocketPoller::EventRead);
+    }
+    CLog::Log(LOGDEBUG, "JSONRPC Server: Waiting for connections using %s", m_poller.IsEpoll() ? "epoll" : "select");
+
     CAnnouncementManager::GetInstance().AddAnnouncer(this);
     CLog::Log(LOGINFO, "JSONRPC Server: Successfully initialized");
     return true;
@@ -472,18 +569,20 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  std::map<SOCKET, CTCPClientPtr> connections;
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    CSingleLock lock(m_critSection);
+    connections.swap(m_connections);
   }
 
-  m_connections.clear();
+  for (std::map<SOCKET, CTCPClientPtr>::iterator it = connections.begin(); it != connections.end(); ++it)
+    it->second->Disconnect();
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
 
   m_servers.clear();
+  m_poller.Deinitialize();
 
 #ifdef HAVE_LIBBLUETOOTH
   if (m_sdpd)
@@ -497,12 +596,20 @@ void CTCPServer::Deinitialize()
 CTCPServer::CTCPClient::CTCPClient()
 {
   m_new = true;
+  m_failed = false;
+  m_dropping = false;
+  m_generating = false;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
   m_beginBrackets = 0;
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_outboundOffset = 0;
+  m_outboundSize = 0;
+  m_outboundStreams = 0;
+  m_poller = NULL;
+  m_pollEvents = 0;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -536,12 +643,164 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  Enqueue(std::shared_ptr<const std::string>(new std::string(data, size)));
+}
+
+void CTCPServer::CTCPClient::SendResponse(const std::shared_ptr<CJSONRPCResponseStream> &response)
+{
+  if (!response->HasResponse())
+    return;
+
+  CSingleLock lock (m_critSection);
+  OutboundData outbound;
+  outbound.stream = response;
+  m_outbound.push_back(outbound);
+  m_outboundStreams++;
+
+  Flush();
+}
+
+void CTCPServer::CTCPClient::Announce(const std::shared_ptr<const std::string> &announcement)
+{
+  CSingleLock lock (m_critSection);
+  if (!DropAnnouncement())
+    Enqueue(announcement);
+}
+
+void CTCPServer::CTCPClient::Enqueue(const std::shared_ptr<const std::string> &data)
+{
+  CSingleLock lock (m_critSection);
+  bool idle = m_outbound.empty();
+
+  OutboundData outbound;
+  outbound.data = data;
+  m_outbound.push_back(outbound);
+  m_outboundSize += data->size();
+
+  // only send right away if nothing is queued in front of the data, a queued
+  // response is left to the server thread to generate
+  if (idle)
+    Flush();
+  else
+    UpdatePollEvents();
+}
+
+bool CTCPServer::CTCPClient::DropAnnouncement()
+{
+  CSingleLock lock (m_critSection);
+  // the client has been disconnected or replaced after it was announced to
+  if (m_socket == INVALID_SOCKET)
+    return true;
+
+  if (m_outboundSize < OUTBOUND_QUEUE_LIMIT)
+    return false;
+
+  if (!m_dropping)
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client isn't reading its data, dropping announcements");
+  m_dropping = true;
+
+  return true;
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  // while a piece of a response is generated the next call continues sending
+  while (!m_failed && !m_generating && !m_outbound.empty())
+  {
+    if (m_outbound.front().stream)
+    {
+      // generate the next piece of the response without blocking announcers
+      // and queue it in front of the rest. Data is only ever added behind the
+      // stream, so it is still at the front afterwards.
+      std::shared_ptr<CJSONRPCResponseStream> stream = m_outbound.front().stream;
+      std::string *chunk = new std::string();
+      OutboundData outbound;
+      outbound.data.reset(chunk);
+
+      bool more;
+      m_generating = true;
+      {
+        CSingleExit ex(m_critSection);
+        more = stream->Read(*chunk, RESPONSE_CHUNK_SIZE);
+      }
+      m_generating = false;
+
+      if (!more)
+      {
+        m_outbound.pop_front();
+        m_outboundStreams--;
+      }
+
+      if (!chunk->empty())
+      {
+        m_outbound.push_front(outbound);
+        m_outboundSize += chunk->size();
+      }
+      continue;
+    }
+
+    const std::string &data = *m_outbound.front().data;
+    int sent = send(m_socket, data.c_str() + m_outboundOffset, data.size() - m_outboundOffset, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (!WouldBlock())
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC Server: Sending data failed: %d", errno);
+        m_failed = true;
+      }
+      break;
+    }
+
+    m_outboundOffset += sent;
+    m_outboundSize -= sent;
+    if (m_outboundOffset < data.size())
+      break;
+
+    m_outbound.pop_front();
+    m_outboundOffset = 0;
+  }
+
+  if (m_outbound.empty())
+    m_dropping = false;
+
+  UpdatePollEvents();
+  return !m_failed;
+}
+
+void CTCPServer::CTCPClient::Attach(CSocketPoller *poller)
+{
+  CSingleLock lock (m_critSection);
+  m_poller = poller;
+  m_pollEvents = CSocketPoller::EventRead;
+  m_poller->Add(m_socket, m_pollEvents);
+  UpdatePollEvents();
+}
+
+void CTCPServer::CTCPClient::UpdatePollEvents()
+{
+  if (m_poller == NULL || m_socket == INVALID_SOCKET)
+    return;
+
+  // don't read any more requests while the client isn't reading the
+  // responses, a failed connection is reported to the server thread as
+  // writable so it gets closed
+  int events = 0;
+  if (m_failed)
+    events = CSocketPoller::EventRead | CSocketPoller::EventWrite;
+  else
+  {
+    if (m_outboundStreams == 0 && m_outboundSize < OUTBOUND_HIGH_WATERMARK)
+      events |= CSocketPoller::EventRead;
+    if (!m_outbound.empty())
+      events |= CSocketPoller::EventWrite;
+  }
+
+  if (events != m_pollEvents)
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    m_poller->Modify(m_socket, events);
+    m_pollEvents = events;
+  }
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -572,8 +831,8 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        std::shared_ptr<CJSONRPCResponseStream> response = CJSONRPC::MethodCallStream(m_buffer, host, this);
+        SendResponse(response);
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -583,9 +842,11 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
 
 void CTCPServer::CTCPClient::Disconnect()
 {
+  CSingleLock lock (m_critSection);
   if (m_socket > 0)
   {
-    CSingleLock lock (m_critSection);
+    if (m_poller != NULL)
+      m_poller->Remove(m_socket);
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
@@ -595,6 +856,9 @@ void CTCPServer::CTCPClient::Disconnect()
 void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
 {
   m_new               = client.m_new;
+  m_failed            = client.m_failed;
+  m_dropping          = client.m_dropping;
+  m_generating        = client.m_generating;
   m_socket            = client.m_socket;
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
@@ -604,6 +868,12 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_outbound          = client.m_outbound;
+  m_outboundOffset    = client.m_outboundOffset;
+  m_outboundSize      = client.m_outboundSize;
+  m_outboundStreams   = client.m_outboundStreams;
+  m_poller            = client.m_poller;
+  m_pollEvents        = client.m_pollEvents;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -639,6 +909,7 @@ CTCPServer::CWebSocketClient& CTCPServer::CWebSocketClient::operator=(const CWeb
 
 void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
 {
+  CSingleLock lock (m_critSection);
   const CWebSocketMessage *msg = m_websocket->Send(WebSocketTextFrame, data, size);
   if (msg == NULL || !msg->IsComplete())
     return;
@@ -648,6 +919,23 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+void CTCPServer::CWebSocketClient::SendResponse(const std::shared_ptr<CJSONRPCResponseStream> &response)
+{
+  if (!response->HasResponse())
+    return;
+
+  // the whole response has to go into a single message
+  std::string data = response->ReadAll();
+  Send(data.c_str(), data.size());
+}
+
+void CTCPServer::CWebSocketClient::Announce(const std::shared_ptr<const std::string> &announcement)
+{
+  CSingleLock lock (m_critSection);
+  if (!DropAnnouncement())
+    Send(announcement->c_str(), announcement->size());
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
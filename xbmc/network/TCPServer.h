@@ -19,10 +19,15 @@
  *
  */
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 #include <sys/socket.h>
 
 #include "system.h"
+#include "SocketPoller.h"
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
@@ -34,8 +39,12 @@ class CVariant;
 
 namespace JSONRPC
 {
+  class CJSONRPCResponseStream;
+
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
+    friend class TestTCPServerHelper;
+
   public:
     static bool StartServer(int port, bool nonlocal);
     static void StopServer(bool bWait);
@@ -55,6 +64,10 @@ namespace JSONRPC
     bool InitializeTCP();
     void Deinitialize();
 
+    bool AcceptConnection(SOCKET server);
+    bool ReadConnection(SOCKET socket);
+    void RemoveConnection(SOCKET socket);
+
     class CTCPClient : public IClient
     {
     public:
@@ -70,12 +83,25 @@ namespace JSONRPC
       virtual bool SetAnnouncementFlags(int flags);
 
       virtual void Send(const char *data, unsigned int size);
+      virtual void SendResponse(const std::shared_ptr<CJSONRPCResponseStream> &response);
+      virtual void Announce(const std::shared_ptr<const std::string> &announcement);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      /*!
+       \brief Starts watching the socket of the client for incoming and outgoing data
+       */
+      void Attach(CSocketPoller *poller);
+
+      /*!
+       \brief Sends as much of the queued data as possible without blocking
+       \return False if the connection failed
+       */
+      bool Flush();
+
       SOCKET           m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t        m_addrlen;
@@ -83,12 +109,34 @@ namespace JSONRPC
 
     protected:
       void Copy(const CTCPClient& client);
+      void Enqueue(const std::shared_ptr<const std::string> &data);
+      bool DropAnnouncement();
     private:
+      typedef struct
+      {
+        std::shared_ptr<const std::string> data;
+        std::shared_ptr<CJSONRPCResponseStream> stream;
+      } OutboundData;
+
+      void UpdatePollEvents();
+
       bool m_new;
+      bool m_failed;
+      bool m_dropping;
+      bool m_generating;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+
+      // data waiting to be sent, responses are only generated once the
+      // client is ready to receive them
+      std::deque<OutboundData> m_outbound;
+      size_t m_outboundOffset;
+      size_t m_outboundSize;
+      unsigned int m_outboundStreams;
+      CSocketPoller *m_poller;
+      int m_pollEvents;
     };
 
     class CWebSocketClient : public CTCPClient
@@ -101,6 +149,8 @@ namespace JSONRPC
       ~CWebSocketClient();
 
       virtual void Send(const char *data, unsigned int size);
+      virtual void SendResponse(const std::shared_ptr<CJSONRPCResponseStream> &response);
+      virtual void Announce(const std::shared_ptr<const std::string> &announcement);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
@@ -111,8 +161,12 @@ namespace JSONRPC
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    typedef std::shared_ptr<CTCPClient> CTCPClientPtr;
+
+    CCriticalSection m_critSection;
+    std::map<SOCKET, CTCPClientPtr> m_connections;
     std::vector<SOCKET> m_servers;
+    CSocketPoller m_poller;
     int m_port;
     bool m_nonlocal;
     void* m_sdpd;
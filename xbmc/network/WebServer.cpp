@@ -31,11 +31,16 @@
 #include <utility>
 
 #if defined(TARGET_POSIX)
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
+#include "network/httprequesthandler/HTTPResponseCache.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
@@ -46,6 +51,7 @@
 #include "utils/log.h"
 #include "utils/Mime.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 #include "XBDateTime.h"
@@ -67,6 +73,16 @@
 
 #define HEADER_NEWLINE        "\r\n"
 
+// preferred size of the pieces of streamed responses
+#define STREAM_DOWNLOAD_BLOCK_SIZE 32768
+
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN ((uint64_t) -1LL)
+#endif
+#ifndef MHD_CONTENT_READER_END_OF_STREAM
+#define MHD_CONTENT_READER_END_OF_STREAM -1
+#endif
+
 typedef struct {
   std::shared_ptr<XFILE::CFile> file;
   CHttpRanges ranges;
@@ -77,8 +93,17 @@ typedef struct {
   bool boundaryWritten;
   std::string contentType;
   uint64_t writePosition;
+  CWebServer *webserver;
+  const char *handlerName;
+  uint64_t written;
 } HttpFileDownloadContext;
 
+typedef struct {
+  std::shared_ptr<IHTTPRequestHandler> handler;
+  CWebServer *webserver;
+  uint64_t written;
+} HttpStreamDownloadContext;
+
 CWebServer::CWebServer()
   : m_port(0),
     m_daemon_ip6(nullptr),
@@ -284,8 +309,28 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
                 cacheable = false;
             }
 
+            std::string etag;
+            bool hasETag = handler->GetETag(etag) && !etag.empty();
+            std::string ifNoneMatch = HTTPRequestHandlerUtils::GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+
             CDateTime lastModified;
-            if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
+            // handle If-None-Match which takes precedence over If-Modified-Since
+            if (hasETag && !ifNoneMatch.empty())
+            {
+              if (cacheable && MatchesETag(ifNoneMatch, etag, true))
+              {
+                struct MHD_Response *response = create_response(0, nullptr, MHD_NO, MHD_NO);
+                if (response == nullptr)
+                {
+                  CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP 304 response", m_port);
+                  return MHD_NO;
+                }
+
+                RecordRequest(handler, MHD_HTTP_NOT_MODIFIED, 0, false, 0);
+                return FinalizeRequest(handler, MHD_HTTP_NOT_MODIFIED, response);
+              }
+            }
+            else if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
             {
               // handle If-Modified-Since or If-Unmodified-Since
               std::string ifModifiedSince = HTTPRequestHandlerUtils::GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_MODIFIED_SINCE);
@@ -305,6 +350,7 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
                   return MHD_NO;
                 }
 
+                RecordRequest(handler, MHD_HTTP_NOT_MODIFIED, 0, false, 0);
                 return FinalizeRequest(handler, MHD_HTTP_NOT_MODIFIED, response);
               }
               // handle If-Unmodified-Since
@@ -314,9 +360,18 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
             }
 
             // handle If-Range header but only if the Range header is present
-            if (ranged && lastModified.IsValid())
+            std::string ifRange;
+            if (ranged)
+              ifRange = HTTPRequestHandlerUtils::GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
+
+            // If-Range either contains an entity tag which must match strongly or a date
+            if (!ifRange.empty() && (StringUtils::StartsWith(ifRange, "\"") || StringUtils::StartsWith(ifRange, "W/")))
+            {
+              if (!hasETag || !MatchesETag(ifRange, etag, false))
+                ranges.Clear();
+            }
+            else if (ranged && (lastModified.IsValid() || handler->GetLastModifiedDate(lastModified)))
             {
-              std::string ifRange = HTTPRequestHandlerUtils::GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
               if (!ifRange.empty() && lastModified.IsValid())
               {
                 CDateTime ifRangeDate;
@@ -471,16 +526,21 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
   if (handler == nullptr)
     return MHD_NO;
 
+  int64_t start = CurrentHostCounter();
   HTTPRequest request = handler->GetRequest();
   int ret = handler->HandleRequest();
   if (ret == MHD_NO)
   {
     CLog::Log(LOGERROR, "CWebServer[%hu]: failed to handle HTTP request for %s", m_port, request.pathUrl.c_str());
+    RecordRequest(handler, MHD_HTTP_INTERNAL_SERVER_ERROR, 0, false, CurrentHostCounter() - start);
     return SendErrorResponse(request.connection, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
   }
 
   const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
   struct MHD_Response *response = nullptr;
+  // memory responses are sent completely, files and streams count the bytes while being sent
+  uint64_t bytes = 0;
+  bool zeroCopy = false;
   switch (responseDetails.type)
   {
     case HTTPNone:
@@ -492,7 +552,7 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
       break;
 
     case HTTPFileDownload:
-      ret = CreateFileDownloadResponse(handler, response);
+      ret = CreateFileDownloadResponse(handler, response, zeroCopy);
       break;
 
     case HTTPMemoryDownloadNoFreeNoCopy:
@@ -500,6 +560,12 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
     case HTTPMemoryDownloadFreeNoCopy:
     case HTTPMemoryDownloadFreeCopy:
       ret = CreateMemoryDownloadResponse(handler, response);
+      if (request.method != HEAD)
+        bytes = responseDetails.totalLength;
+      break;
+
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(handler, response);
       break;
 
     case HTTPError:
@@ -514,9 +580,11 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
   if (ret == MHD_NO)
   {
     CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create HTTP response for %s", m_port, request.pathUrl.c_str());
+    RecordRequest(handler, MHD_HTTP_INTERNAL_SERVER_ERROR, 0, false, CurrentHostCounter() - start);
     return SendErrorResponse(request.connection, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
   }
 
+  RecordRequest(handler, responseDetails.status, bytes, zeroCopy, CurrentHostCounter() - start);
   return FinalizeRequest(handler, responseDetails.status, response);
 }
 
@@ -537,6 +605,11 @@ int CWebServer::FinalizeRequest(const std::shared_ptr<IHTTPRequestHandler>& hand
   if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
     handler->AddResponseHeader(MHD_HTTP_HEADER_LAST_MODIFIED, lastModified.GetAsRFC1123DateTime());
 
+  // if the request handler has set an entity tag and it hasn't been set as a header, add it
+  std::string etag;
+  if (handler->CanBeCached() && handler->GetETag(etag) && !etag.empty())
+    handler->AddResponseHeader(MHD_HTTP_HEADER_ETAG, etag);
+
   // check if the request handler has set Cache-Control and add it if not
   if (!handler->HasResponseHeader(MHD_HTTP_HEADER_CACHE_CONTROL))
   {
@@ -753,7 +826,7 @@ int CWebServer::CreateRedirect(struct MHD_Connection *connection, const std::str
   return MHD_YES;
 }
 
-int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const
+int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response, bool &zeroCopy)
 {
   if (handler == nullptr)
     return MHD_NO;
@@ -791,6 +864,9 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
     context->contentType = mimeType;
     context->boundaryWritten = false;
     context->writePosition = 0;
+    context->webserver = this;
+    context->handlerName = handler->GetName();
+    context->written = 0;
 
     if (handler->IsRequestRanged())
     {
@@ -850,18 +926,45 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
     // set the initial write position
     context->ranges.GetFirstPosition(context->writePosition);
 
-    // create the response object
-    response = MHD_create_response_from_callback(totalLength, 2048,
-                                                  &CWebServer::ContentReaderCallback,
-                                                  context.get(),
-                                                  &CWebServer::ContentReaderFreeCallback);
-    if (response == nullptr)
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00094400)
+    // a single range of a local file is sent by MHD from the file descriptor
+    // which allows it to use sendfile() instead of copying through the VFS
+    if (context->rangeCountTotal == 1 && fileLength > 0 && g_advancedSettings.m_webserverZeroCopy)
     {
-      CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP response for %s to be filled from %s", m_port, request.pathUrl.c_str(), filePath.c_str());
-      return MHD_NO;
+      int fd = OpenLocalFile(filePath, fileLength);
+      if (fd >= 0)
+      {
+        response = MHD_create_response_from_fd_at_offset64(totalLength, fd, context->writePosition);
+        if (response != nullptr)
+        {
+          zeroCopy = true;
+          context.reset();
+          if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+            CLog::Log(LOGDEBUG, "CWebServer[%hu] [OUT] sending %" PRIu64 " bytes of %s from its file descriptor", m_port, totalLength, filePath.c_str());
+        }
+        else
+          close(fd);
+      }
     }
+#endif
 
-    context.release(); // ownership was passed to mhd
+    if (!zeroCopy)
+    {
+      // create the response object
+      response = MHD_create_response_from_callback(totalLength, 2048,
+                                                    &CWebServer::ContentReaderCallback,
+                                                    context.get(),
+                                                    &CWebServer::ContentReaderFreeCallback);
+      if (response == nullptr)
+      {
+        CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP response for %s to be filled from %s", m_port, request.pathUrl.c_str(), filePath.c_str());
+        return MHD_NO;
+      }
+
+      context.release(); // ownership was passed to mhd
+    }
+    else
+      RecordSentBytes(handler->GetName(), totalLength);
 
     // add Content-Range header
     if (ranged)
@@ -886,6 +989,75 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
   return MHD_YES;
 }
 
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00094400)
+int CWebServer::OpenLocalFile(const std::string &filePath, uint64_t fileLength) const
+{
+  // only plain local files can be handed to MHD, anything else has to go through the VFS
+  std::string localPath = CSpecialProtocol::TranslatePath(filePath);
+  if (URIUtils::IsProtocol(localPath, "file"))
+    localPath = CURL(localPath).GetFileName();
+  else if (localPath.find("://") != std::string::npos)
+    return -1;
+
+  if (!StringUtils::StartsWith(localPath, "/"))
+    return -1;
+
+  int fd = open(localPath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+
+  // make sure the file is the one that has been opened through the VFS
+  struct stat statBuffer;
+  if (fstat(fd, &statBuffer) != 0 || !S_ISREG(statBuffer.st_mode) || static_cast<uint64_t>(statBuffer.st_size) != fileLength)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+#endif
+
+int CWebServer::CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response)
+{
+  if (handler == nullptr)
+    return MHD_NO;
+
+  const HTTPRequest &request = handler->GetRequest();
+
+  if (request.method == HEAD)
+  {
+    response = create_response(0, nullptr, MHD_NO, MHD_NO);
+    if (response == nullptr)
+    {
+      CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP HEAD response for %s", m_port, request.pathUrl.c_str());
+      return MHD_NO;
+    }
+
+    return MHD_YES;
+  }
+
+  std::unique_ptr<HttpStreamDownloadContext> context(new HttpStreamDownloadContext());
+  context->handler = handler;
+  context->webserver = this;
+  context->written = 0;
+
+  // without a known length MHD uses chunked transfer encoding
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, STREAM_DOWNLOAD_BLOCK_SIZE,
+                                               &CWebServer::StreamReaderCallback,
+                                               context.get(),
+                                               &CWebServer::StreamReaderFreeCallback);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a streamed HTTP response for %s", m_port, request.pathUrl.c_str());
+    return MHD_NO;
+  }
+
+  context.release(); // ownership was passed to mhd
+
+  return MHD_YES;
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const
 {
   size_t payloadSize = 0;
@@ -1060,6 +1232,7 @@ int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 
   // add the number of read bytes to the number of written bytes
   written += res;
+  context->written += written;
 
   if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
     CLog::Log(LOGDEBUG, "CWebServer [OUT] wrote %d bytes from %" PRIu64 " in range (%" PRIu64 " - %" PRIu64 ")", written, context->writePosition, start, end);
@@ -1081,6 +1254,42 @@ int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 void CWebServer::ContentReaderFreeCallback(void *cls)
 {
   HttpFileDownloadContext *context = (HttpFileDownloadContext *)cls;
+  if (context != nullptr && context->webserver != nullptr)
+    context->webserver->RecordSentBytes(context->handlerName, context->written);
+  delete context;
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] done");
+}
+
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  if (context == nullptr || context->handler == nullptr)
+    return -1;
+
+  size_t read = context->handler->ReadResponseStream(buf, static_cast<size_t>(max));
+  if (read == 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] streamed %zu bytes at %" PRIu64, read, static_cast<uint64_t>(pos));
+
+  context->written += read;
+  return read;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  if (context != nullptr && context->webserver != nullptr && context->handler != nullptr)
+    context->webserver->RecordSentBytes(context->handler->GetName(), context->written);
   delete context;
 
   if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
@@ -1197,6 +1406,7 @@ bool CWebServer::Stop()
     MHD_stop_daemon(m_daemon_ip4);
     
   m_running = false;
+  LogStatistics();
   CLog::Log(LOGNOTICE, "CWebServer[%hu]: Stopped", m_port);
   m_port = 0;
 
@@ -1248,6 +1458,86 @@ std::string CWebServer::CreateMimeTypeFromExtension(const char *ext)
   return CMime::GetMimeType(ext);
 }
 
+bool CWebServer::MatchesETag(const std::string &header, const std::string &etag, bool weak)
+{
+  // strong comparison requires both entity tags to be strong
+  if (!weak && StringUtils::StartsWith(etag, "W/"))
+    return false;
+
+  std::string opaqueTag = StringUtils::StartsWith(etag, "W/") ? etag.substr(2) : etag;
+
+  std::vector<std::string> tags = StringUtils::Split(header, ",");
+  for (std::vector<std::string>::iterator tag = tags.begin(); tag != tags.end(); ++tag)
+  {
+    StringUtils::Trim(*tag);
+    if (*tag == "*")
+      return true;
+
+    if (StringUtils::StartsWith(*tag, "W/"))
+    {
+      if (!weak)
+        continue;
+      tag->erase(0, 2);
+    }
+
+    if (*tag == opaqueTag)
+      return true;
+  }
+
+  return false;
+}
+
+void CWebServer::RecordRequest(const std::shared_ptr<IHTTPRequestHandler>& handler, int responseStatus, uint64_t bytes, bool zeroCopy, int64_t handlingTime)
+{
+  CSingleLock lock(m_statisticsSection);
+  HTTPRequestHandlerStatistics &statistics = m_statistics[handler->GetName()];
+  statistics.requests++;
+  if (responseStatus == MHD_HTTP_NOT_MODIFIED)
+    statistics.notModified++;
+  else if (responseStatus >= MHD_HTTP_BAD_REQUEST)
+    statistics.errors++;
+  if (zeroCopy)
+    statistics.zeroCopy++;
+  statistics.bytes += bytes;
+  statistics.handlingTime += handlingTime;
+}
+
+void CWebServer::RecordSentBytes(const char *handlerName, uint64_t bytes)
+{
+  if (handlerName == nullptr || bytes == 0)
+    return;
+
+  CSingleLock lock(m_statisticsSection);
+  m_statistics[handlerName].bytes += bytes;
+}
+
+void CWebServer::GetStatistics(std::map<std::string, HTTPRequestHandlerStatistics> &statistics)
+{
+  CSingleLock lock(m_statisticsSection);
+  statistics = m_statistics;
+}
+
+void CWebServer::LogStatistics()
+{
+  std::map<std::string, HTTPRequestHandlerStatistics> statistics;
+  GetStatistics(statistics);
+
+  double frequency = static_cast<double>(CurrentHostFrequency()) / 1000.0;
+  for (std::map<std::string, HTTPRequestHandlerStatistics>::const_iterator it = statistics.begin(); it != statistics.end(); ++it)
+  {
+    const HTTPRequestHandlerStatistics &handler = it->second;
+    CLog::Log(LOGNOTICE, "CWebServer[%hu]: %s: %" PRIu64 " requests (%" PRIu64 " not modified, %" PRIu64 " errors, %" PRIu64 " zero-copy), %" PRIu64 " bytes sent, %.2f ms average handling time",
+              m_port, it->first.c_str(), handler.requests, handler.notModified, handler.errors, handler.zeroCopy, handler.bytes,
+              handler.requests > 0 ? handler.handlingTime / frequency / handler.requests : 0.0);
+  }
+
+  HTTPResponseCacheStatistics cache;
+  CHTTPResponseCache::GetInstance().GetStatistics(cache);
+  if (cache.hits > 0 || cache.misses > 0)
+    CLog::Log(LOGNOTICE, "CWebServer[%hu]: response cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions, %zu entries using %zu bytes",
+              m_port, cache.hits, cache.misses, cache.evictions, cache.entries, cache.size);
+}
+
 int CWebServer::AddHeader(struct MHD_Response *response, const std::string &name, const std::string &value) const
 {
   if (response == nullptr || name.empty())
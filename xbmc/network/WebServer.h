@@ -22,7 +22,9 @@
 #include "system.h"
 
 #ifdef HAS_WEB_SERVER
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
@@ -35,6 +37,16 @@ namespace XFILE
 class CDateTime;
 class CVariant;
 
+typedef struct HTTPRequestHandlerStatistics
+{
+  uint64_t requests;
+  uint64_t notModified;   ///< requests answered with 304 Not Modified
+  uint64_t errors;
+  uint64_t zeroCopy;      ///< responses sent straight from the file descriptor
+  uint64_t bytes;         ///< bytes of response data sent
+  int64_t handlingTime;   ///< time spent creating the responses in host counter ticks
+} HTTPRequestHandlerStatistics;
+
 class CWebServer
 {
 public:
@@ -49,6 +61,11 @@ public:
   void RegisterRequestHandler(IHTTPRequestHandler *handler);
   void UnregisterRequestHandler(IHTTPRequestHandler *handler);
 
+  /*!
+   \brief Returns the statistics of all requests handled so far, grouped by the name of the request handler
+   */
+  void GetStatistics(std::map<std::string, HTTPRequestHandlerStatistics> &statistics);
+
 protected:
   typedef struct ConnectionHandler
   {
@@ -84,7 +101,11 @@ private:
   int CreateRangedMemoryDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const;
 
   int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response) const;
-  int CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const;
+  int CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response, bool &zeroCopy);
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00094400)
+  int OpenLocalFile(const std::string &filePath, uint64_t fileLength) const;
+#endif
+  int CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response);
   int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const;
   int CreateMemoryDownloadResponse(struct MHD_Connection *connection, const void *data, size_t size, bool free, bool copy, struct MHD_Response *&response) const;
 
@@ -93,6 +114,11 @@ private:
   int AddHeader(struct MHD_Response *response, const std::string &name, const std::string &value) const;
 
   static std::string CreateMimeTypeFromExtension(const char *ext);
+  static bool MatchesETag(const std::string &header, const std::string &etag, bool weak);
+
+  void RecordRequest(const std::shared_ptr<IHTTPRequestHandler>& handler, int responseStatus, uint64_t bytes, bool zeroCopy, int64_t handlingTime);
+  void RecordSentBytes(const char *handlerName, uint64_t bytes);
+  void LogStatistics();
 
   // MHD callback implementations
   static void* UriRequestLogger(void *cls, const char *uri);
@@ -106,6 +132,15 @@ private:
 #endif
   static void ContentReaderFreeCallback(void *cls);
 
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t StreamReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int StreamReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int StreamReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
+  static void StreamReaderFreeCallback(void *cls);
+
 #if (MHD_VERSION >= 0x00040001)
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
@@ -135,5 +170,7 @@ private:
   std::string m_Credentials64Encoded;
   CCriticalSection m_critSection;
   std::vector<IHTTPRequestHandler *> m_requestHandlers;
+  CCriticalSection m_statisticsSection;
+  std::map<std::string, HTTPRequestHandlerStatistics> m_statistics;
 };
 #endif
@@ -29,7 +29,8 @@ CHTTPFileHandler::CHTTPFileHandler()
     m_url(),
     m_canHandleRanges(true),
     m_canBeCached(true),
-    m_lastModified()
+    m_lastModified(),
+    m_etag()
 { }
 
 CHTTPFileHandler::CHTTPFileHandler(const HTTPRequest &request)
@@ -37,7 +38,8 @@ CHTTPFileHandler::CHTTPFileHandler(const HTTPRequest &request)
     m_url(),
     m_canHandleRanges(true),
     m_canBeCached(true),
-    m_lastModified()
+    m_lastModified(),
+    m_etag()
 { }
 
 int CHTTPFileHandler::HandleRequest()
@@ -54,6 +56,15 @@ bool CHTTPFileHandler::GetLastModifiedDate(CDateTime &lastModified) const
   return true;
 }
 
+bool CHTTPFileHandler::GetETag(std::string &etag) const
+{
+  if (m_etag.empty())
+    return false;
+
+  etag = m_etag;
+  return true;
+}
+
 void CHTTPFileHandler::SetFile(const std::string& file, int responseStatus)
 {
   m_url = file;
@@ -88,7 +99,12 @@ void CHTTPFileHandler::SetFile(const std::string& file, int responseStatus)
     {
       struct __stat64 statBuffer;
       if (fileObj.Stat(&statBuffer) == 0)
+      {
         SetLastModifiedDate(&statBuffer);
+
+        // identify the version of the file by its size and modification time
+        m_etag = StringUtils::Format("\"%" PRIx64 "-%" PRIx64 "\"", static_cast<uint64_t>(statBuffer.st_size), static_cast<uint64_t>(statBuffer.st_mtime));
+      }
     }
   }
 
@@ -35,6 +35,7 @@ public:
   virtual bool CanHandleRanges() const { return m_canHandleRanges; }
   virtual bool CanBeCached() const { return m_canBeCached; }
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const;
+  virtual bool GetETag(std::string &etag) const;
 
   virtual std::string GetRedirectUrl() const { return m_url; }
   virtual std::string GetResponseFile() const { return m_url; }
@@ -56,5 +57,6 @@ private:
   bool m_canBeCached;
 
   CDateTime m_lastModified;
+  std::string m_etag;
 
 };
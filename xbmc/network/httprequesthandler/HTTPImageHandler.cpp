@@ -19,6 +19,7 @@
  */
 
 #include "HTTPImageHandler.h"
+#include "TextureCache.h"
 #include "URL.h"
 #include "filesystem/ImageFile.h"
 #include "network/WebServer.h"
@@ -39,6 +40,13 @@ CHTTPImageHandler::CHTTPImageHandler(const HTTPRequest &request)
     if (imageFile.Exists(pathToUrl))
     {
       responseStatus = MHD_HTTP_OK;
+
+      // serve images which have already been cached straight from the texture cache
+      bool needsRecaching = false;
+      std::string cachedFile = CTextureCache::GetInstance().CheckCachedImage(file, needsRecaching);
+      if (!cachedFile.empty())
+        file = cachedFile;
+
       struct __stat64 statBuffer;
       if (imageFile.Stat(pathToUrl, &statBuffer) == 0)
       {
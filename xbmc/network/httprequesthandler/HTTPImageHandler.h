@@ -33,6 +33,7 @@ public:
   virtual bool CanHandleRequest(const HTTPRequest &request);
 
   virtual int GetPriority() const { return 5; }
+  virtual const char* GetName() const { return "image"; }
   virtual int GetMaximumAgeForCaching() const { return 60 * 60 * 24 * 7; }
 
 protected:
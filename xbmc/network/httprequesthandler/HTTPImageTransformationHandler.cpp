@@ -26,6 +26,7 @@
 #include "filesystem/ImageFile.h"
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
+#include "utils/Crc32.h"
 #include "utils/Mime.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -38,16 +39,20 @@ static const std::string ImageBasePath = "/image/";
 
 CHTTPImageTransformationHandler::CHTTPImageTransformationHandler()
   : m_url(),
+    m_imagePath(),
     m_lastModified(),
-    m_buffer(NULL),
+    m_etag(),
+    m_data(),
     m_responseData()
 { }
 
 CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPRequest &request)
   : IHTTPRequestHandler(request),
     m_url(),
+    m_imagePath(),
     m_lastModified(),
-    m_buffer(NULL),
+    m_etag(),
+    m_data(),
     m_responseData()
 {
   m_url = m_request.pathUrl.substr(ImageBasePath.size());
@@ -70,6 +75,30 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
   m_response.type = HTTPMemoryDownloadNoFreeCopy;
   m_response.status = MHD_HTTP_OK;
 
+  // get the transformation options
+  std::map<std::string, std::string> options;
+  HTTPRequestHandlerUtils::GetRequestHeaderValues(m_request.connection, MHD_GET_ARGUMENT_KIND, options);
+
+  std::vector<std::string> urlOptions;
+  std::map<std::string, std::string>::const_iterator option = options.find(TRANSFORMATION_OPTION_WIDTH);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_WIDTH "=" + option->second);
+
+  option = options.find(TRANSFORMATION_OPTION_HEIGHT);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_HEIGHT "=" + option->second);
+
+  option = options.find(TRANSFORMATION_OPTION_SCALING_ALGORITHM);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_SCALING_ALGORITHM "=" + option->second);
+
+  m_imagePath = m_url;
+  if (!urlOptions.empty())
+  {
+    m_imagePath += "?";
+    m_imagePath += StringUtils::Join(urlOptions, "&");
+  }
+
   // determine the content type
   std::string ext = URIUtils::GetExtension(pathToUrl.GetHostName());
   StringUtils::ToLower(ext);
@@ -93,13 +122,15 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
     return;
 
   m_lastModified = *time;
+
+  // identify the transformed image by the transformation and the modification time of the source
+  m_etag = StringUtils::Format("\"%08x-%" PRIx64 "\"", Crc32::Compute(m_imagePath), static_cast<uint64_t>(statBuffer.st_mtime));
 }
 
 CHTTPImageTransformationHandler::~CHTTPImageTransformationHandler()
 {
   m_responseData.clear();
-  delete m_buffer;
-  m_buffer = NULL;
+  m_data.reset();
 }
 
 bool CHTTPImageTransformationHandler::CanHandleRequest(const HTTPRequest &request)
@@ -130,52 +161,40 @@ int CHTTPImageTransformationHandler::HandleRequest()
     return MHD_YES;
   }
 
-  // get the transformation options
-  std::map<std::string, std::string> options;
-  HTTPRequestHandlerUtils::GetRequestHeaderValues(m_request.connection, MHD_GET_ARGUMENT_KIND, options);
-
-  std::vector<std::string> urlOptions;
-  std::map<std::string, std::string>::const_iterator option = options.find(TRANSFORMATION_OPTION_WIDTH);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_WIDTH "=" + option->second);
-
-  option = options.find(TRANSFORMATION_OPTION_HEIGHT);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_HEIGHT "=" + option->second);
-
-  option = options.find(TRANSFORMATION_OPTION_SCALING_ALGORITHM);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_SCALING_ALGORITHM "=" + option->second);
-
-  std::string imagePath = m_url;
-  if (!urlOptions.empty())
-  {
-    imagePath += "?";
-    imagePath += StringUtils::Join(urlOptions, "&");
-  }
-
-  // resize the image into the local buffer
-  size_t bufferSize;
-  if (!CTextureCacheJob::ResizeTexture(imagePath, m_buffer, bufferSize))
+  // transformations of unchanged images are taken from the response cache
+  CHTTPResponseCache &responseCache = CHTTPResponseCache::GetInstance();
+  if (!m_lastModified.IsValid() || !responseCache.Get(m_imagePath, m_lastModified, m_data))
   {
-    m_response.status = MHD_HTTP_INTERNAL_SERVER_ERROR;
-    m_response.type = HTTPError;
-
-    return MHD_YES;
+    // resize the image into a local buffer
+    uint8_t *buffer = NULL;
+    size_t bufferSize;
+    if (!CTextureCacheJob::ResizeTexture(m_imagePath, buffer, bufferSize))
+    {
+      m_response.status = MHD_HTTP_INTERNAL_SERVER_ERROR;
+      m_response.type = HTTPError;
+
+      return MHD_YES;
+    }
+
+    m_data.reset(new std::string(reinterpret_cast<const char*>(buffer), bufferSize));
+    delete[] buffer;
+
+    if (m_lastModified.IsValid())
+      responseCache.Put(m_imagePath, m_lastModified, m_data);
   }
 
   // store the size of the image
-  m_response.totalLength = bufferSize;
+  m_response.totalLength = m_data->size();
 
   // nothing else to do if the request is not ranged
   if (!GetRequestedRanges(m_response.totalLength))
   {
-    m_responseData.push_back(CHttpResponseRange(m_buffer, 0, m_response.totalLength - 1));
+    m_responseData.push_back(CHttpResponseRange(m_data->c_str(), 0, m_response.totalLength - 1));
     return MHD_YES;
   }
 
   for (HttpRanges::const_iterator range = m_request.ranges.Begin(); range != m_request.ranges.End(); ++range)
-    m_responseData.push_back(CHttpResponseRange(m_buffer + range->GetFirstPosition(), range->GetFirstPosition(), range->GetLastPosition()));
+    m_responseData.push_back(CHttpResponseRange(m_data->c_str() + range->GetFirstPosition(), range->GetFirstPosition(), range->GetLastPosition()));
 
   return MHD_YES;
 }
@@ -188,3 +207,12 @@ bool CHTTPImageTransformationHandler::GetLastModifiedDate(CDateTime &lastModifie
   lastModified = m_lastModified;
   return true;
 }
+
+bool CHTTPImageTransformationHandler::GetETag(std::string &etag) const
+{
+  if (m_etag.empty())
+    return false;
+
+  etag = m_etag;
+  return true;
+}
@@ -23,6 +23,7 @@
 #include <string>
 
 #include "XBDateTime.h"
+#include "network/httprequesthandler/HTTPResponseCache.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 
 class CHTTPImageTransformationHandler : public IHTTPRequestHandler
@@ -39,19 +40,23 @@ public:
   virtual bool CanHandleRanges() const { return true; }
   virtual bool CanBeCached() const { return true; }
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const;
+  virtual bool GetETag(std::string &etag) const;
 
   virtual HttpResponseRanges GetResponseData() const { return m_responseData; }
 
   // priority must be higher than the one of CHTTPImageHandler
   virtual int GetPriority() const { return 6; }
+  virtual const char* GetName() const { return "imagetransformation"; }
 
 protected:
   explicit CHTTPImageTransformationHandler(const HTTPRequest &request);
 
 private:
   std::string m_url;
+  std::string m_imagePath;
   CDateTime m_lastModified;
+  std::string m_etag;
 
-  uint8_t* m_buffer;
+  HTTPResponseData m_data;
   HttpResponseRanges m_responseData;
 };
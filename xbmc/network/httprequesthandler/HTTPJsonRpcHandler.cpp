@@ -18,6 +18,9 @@
  *
  */
 
+#include <algorithm>
+#include <string.h>
+
 #include "HTTPJsonRpcHandler.h"
 #include "URL.h"
 #include "filesystem/File.h"
@@ -31,6 +34,8 @@
 #include "utils/Variant.h"
 
 #define MAX_HTTP_POST_SIZE 65536
+// responses up to this size are sent as a whole, larger ones are streamed
+#define MAX_HTTP_RESPONSE_BUFFER_SIZE 65536
 
 bool CHTTPJsonRpcHandler::CanHandleRequest(const HTTPRequest &request)
 {
@@ -84,10 +89,29 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client);
+    m_responseStream = JSONRPC::CJSONRPC::MethodCallStream(m_requestData, &m_transportLayer, &client);
 
     if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+    {
+      m_responseData = jsonpCallback + "(";
+      m_responseSuffix = ");";
+    }
+
+    if (m_responseStream->Read(m_responseData, MAX_HTTP_RESPONSE_BUFFER_SIZE))
+    {
+      m_requestData.clear();
+
+      // the rest is read by the webserver through ReadResponseStream()
+      m_response.type = HTTPStreamDownload;
+      m_response.status = MHD_HTTP_OK;
+      m_response.contentType = "application/json";
+      m_response.totalLength = 0;
+
+      return MHD_YES;
+    }
+
+    m_responseStream.reset();
+    m_responseData += m_responseSuffix;
   }
   else if (jsonpCallback.empty())
   {
@@ -124,6 +148,27 @@ HttpResponseRanges CHTTPJsonRpcHandler::GetResponseData() const
   return ranges;
 }
 
+size_t CHTTPJsonRpcHandler::ReadResponseStream(char *buffer, size_t size)
+{
+  if (m_responseOffset >= m_responseData.size())
+  {
+    m_responseData.clear();
+    m_responseOffset = 0;
+
+    if (m_responseStream != nullptr && !m_responseStream->Read(m_responseData, size))
+    {
+      m_responseStream.reset();
+      m_responseData += m_responseSuffix;
+    }
+  }
+
+  size_t length = std::min(size, m_responseData.size() - m_responseOffset);
+  memcpy(buffer, m_responseData.c_str() + m_responseOffset, length);
+  m_responseOffset += length;
+
+  return length;
+}
+
 #if (MHD_VERSION >= 0x00040001)
 bool CHTTPJsonRpcHandler::appendPostData(const char *data, size_t size)
 #else
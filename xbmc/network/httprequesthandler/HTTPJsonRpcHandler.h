@@ -19,16 +19,22 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 
+namespace JSONRPC
+{
+  class CJSONRPCResponseStream;
+}
+
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
 public:
-  CHTTPJsonRpcHandler() { }
+  CHTTPJsonRpcHandler() : m_responseOffset(0) { }
   virtual ~CHTTPJsonRpcHandler() { }
   
   // implementations of IHTTPRequestHandler
@@ -38,12 +44,15 @@ public:
   virtual int HandleRequest();
 
   virtual HttpResponseRanges GetResponseData() const;
+  virtual size_t ReadResponseStream(char *buffer, size_t size);
 
   virtual int GetPriority() const { return 5; }
+  virtual const char* GetName() const { return "jsonrpc"; }
 
 protected:
   explicit CHTTPJsonRpcHandler(const HTTPRequest &request)
-    : IHTTPRequestHandler(request)
+    : IHTTPRequestHandler(request),
+      m_responseOffset(0)
   { }
 
 #if (MHD_VERSION >= 0x00040001)
@@ -56,6 +65,9 @@ private:
   std::string m_requestData;
   std::string m_responseData;
   CHttpResponseRange m_responseRange;
+  std::shared_ptr<JSONRPC::CJSONRPCResponseStream> m_responseStream;
+  std::string m_responseSuffix;
+  size_t m_responseOffset;
 
   class CHTTPTransportLayer : public JSONRPC::ITransportLayer
   {
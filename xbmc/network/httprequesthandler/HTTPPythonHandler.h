@@ -43,6 +43,7 @@ public:
   virtual std::string GetRedirectUrl() const { return m_redirectUrl; }
 
   virtual int GetPriority() const { return 3; }
+  virtual const char* GetName() const { return "python"; }
 
 protected:
   explicit CHTTPPythonHandler(const HTTPRequest &request);
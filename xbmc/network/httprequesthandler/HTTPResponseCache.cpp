@@ -0,0 +1,121 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HTTPResponseCache.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+
+CHTTPResponseCache::CHTTPResponseCache()
+  : m_size(0),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0)
+{ }
+
+CHTTPResponseCache& CHTTPResponseCache::GetInstance()
+{
+  static CHTTPResponseCache sResponseCache;
+  return sResponseCache;
+}
+
+bool CHTTPResponseCache::Get(const std::string &key, const CDateTime &lastModified, HTTPResponseData &data)
+{
+  CSingleLock lock(m_critSection);
+
+  std::map<std::string, CacheEntries::iterator>::iterator it = m_lookup.find(key);
+  if (it == m_lookup.end())
+  {
+    m_misses++;
+    return false;
+  }
+
+  // the source has changed since the response was generated
+  if (it->second->lastModified != lastModified)
+  {
+    m_size -= it->second->data->size();
+    m_entries.erase(it->second);
+    m_lookup.erase(it);
+    m_misses++;
+    return false;
+  }
+
+  // move the entry to the front as it is the most recently used one
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  data = it->second->data;
+  m_hits++;
+
+  return true;
+}
+
+void CHTTPResponseCache::Put(const std::string &key, const CDateTime &lastModified, const HTTPResponseData &data)
+{
+  size_t maxSize = static_cast<size_t>(g_advancedSettings.m_webserverResponseCacheSize) * 1024 * 1024;
+  if (data == nullptr || data->size() > maxSize / 4)
+    return;
+
+  CSingleLock lock(m_critSection);
+
+  std::map<std::string, CacheEntries::iterator>::iterator it = m_lookup.find(key);
+  if (it != m_lookup.end())
+  {
+    m_size -= it->second->data->size();
+    m_entries.erase(it->second);
+    m_lookup.erase(it);
+  }
+
+  Evict(maxSize - data->size());
+
+  CacheEntry entry;
+  entry.key = key;
+  entry.lastModified = lastModified;
+  entry.data = data;
+  m_entries.push_front(entry);
+  m_lookup[key] = m_entries.begin();
+  m_size += data->size();
+}
+
+void CHTTPResponseCache::Clear()
+{
+  CSingleLock lock(m_critSection);
+  m_entries.clear();
+  m_lookup.clear();
+  m_size = 0;
+}
+
+void CHTTPResponseCache::GetStatistics(HTTPResponseCacheStatistics &statistics)
+{
+  CSingleLock lock(m_critSection);
+  statistics.hits = m_hits;
+  statistics.misses = m_misses;
+  statistics.evictions = m_evictions;
+  statistics.entries = m_entries.size();
+  statistics.size = m_size;
+}
+
+void CHTTPResponseCache::Evict(size_t maxSize)
+{
+  while (!m_entries.empty() && m_size > maxSize)
+  {
+    m_size -= m_entries.back().data->size();
+    m_lookup.erase(m_entries.back().key);
+    m_entries.pop_back();
+    m_evictions++;
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include "XBDateTime.h"
+#include "threads/CriticalSection.h"
+
+typedef std::shared_ptr<const std::string> HTTPResponseData;
+
+typedef struct HTTPResponseCacheStatistics
+{
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  size_t entries;
+  size_t size;
+} HTTPResponseCacheStatistics;
+
+/*!
+ \brief Least recently used cache of generated HTTP response bodies.
+
+ Used for responses which are expensive to generate, like transformed
+ images. An entry is only returned as long as the last modified date of
+ its source hasn't changed.
+ */
+class CHTTPResponseCache
+{
+public:
+  static CHTTPResponseCache& GetInstance();
+
+  /*!
+   \brief Looks up the response stored for the given key
+   \param key Identification of the response, e.g. the URL with all options
+   \param lastModified Last modified date of the source of the response
+   \param data Filled with the cached response
+   \return True if the response was found and is still up to date
+   */
+  bool Get(const std::string &key, const CDateTime &lastModified, HTTPResponseData &data);
+
+  /*!
+   \brief Stores a response, evicting the least recently used ones if the cache is full
+   */
+  void Put(const std::string &key, const CDateTime &lastModified, const HTTPResponseData &data);
+
+  void Clear();
+  void GetStatistics(HTTPResponseCacheStatistics &statistics);
+
+private:
+  CHTTPResponseCache();
+  CHTTPResponseCache(const CHTTPResponseCache&);
+  CHTTPResponseCache& operator=(const CHTTPResponseCache&);
+
+  typedef struct
+  {
+    std::string key;
+    CDateTime lastModified;
+    HTTPResponseData data;
+  } CacheEntry;
+  typedef std::list<CacheEntry> CacheEntries;
+
+  void Evict(size_t maxSize);
+
+  CCriticalSection m_critSection;
+  CacheEntries m_entries;  // most recently used first
+  std::map<std::string, CacheEntries::iterator> m_lookup;
+  size_t m_size;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_evictions;
+};
@@ -37,6 +37,7 @@ public:
   virtual HttpResponseRanges GetResponseData() const;
 
   virtual int GetPriority() const { return 4; }
+  virtual const char* GetName() const { return "webinterfaceaddons"; }
 
 protected:
   explicit CHTTPWebinterfaceAddonsHandler(const HTTPRequest &request)
@@ -33,6 +33,8 @@ public:
   virtual IHTTPRequestHandler* Create(const HTTPRequest &request) { return new CHTTPWebinterfaceHandler(request); }
   virtual bool CanHandleRequest(const HTTPRequest &request);
 
+  virtual const char* GetName() const { return "webinterface"; }
+
   static int ResolveUrl(const std::string &url, std::string &path);
   static int ResolveUrl(const std::string &url, std::string &path, ADDON::AddonPtr &addon);
   static bool ResolveAddon(const std::string &url, ADDON::AddonPtr &addon);
@@ -65,7 +65,10 @@ typedef enum HTTPResponseType
   HTTPMemoryDownloadFreeNoCopy,
   // creates a HTTP response from a buffer by copying followed by freeing the buffer
   // the buffer must have been malloc'ed and not new'ed
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  // creates a HTTP response with the content read from the request handler while it is sent
+  // the length of the content doesn't have to be known in advance
+  HTTPStreamDownload
 } HTTPResponseType;
 
 typedef struct HTTPRequest
@@ -112,6 +115,11 @@ public:
    */
   virtual int GetPriority() const { return 0; }
 
+  /*!
+   * \brief Returns the name of the HTTP request handler used in statistics.
+   */
+  virtual const char* GetName() const = 0;
+
   /*!
   * \brief Checks if the HTTP request handler can handle the given request.
   *
@@ -150,6 +158,14 @@ public:
   * \details This is only used if the response can be cached.
   */
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const { return false; }
+
+  /*!
+  * \brief Returns the entity tag identifying the current version of the response data.
+  *
+  * \details This is only used if the response can be cached. The returned
+  * value must include the quotes and the optional weakness indicator.
+  */
+  virtual bool GetETag(std::string &etag) const { return false; }
  
   /*!
    * \brief Returns the ranges with raw data belonging to the response.
@@ -172,6 +188,17 @@ public:
   */
   virtual std::string GetResponseFile() const { return ""; }
 
+  /*!
+  * \brief Reads the next part of the response data.
+  *
+  * \details This is only used if the response type is HTTPStreamDownload.
+  *
+  * \param buffer Buffer to put the data into
+  * \param size Maximum number of bytes to put into the buffer
+  * \return Number of bytes put into the buffer, 0 once all data has been read
+  */
+  virtual size_t ReadResponseStream(char *buffer, size_t size) { return 0; }
+
   /*!
   * \brief Returns the HTTP request handled by the HTTP request handler.
   */
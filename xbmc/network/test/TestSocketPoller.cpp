@@ -0,0 +1,115 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "network/SocketPoller.h"
+#include "threads/SystemClock.h"
+
+#include <vector>
+
+class TestSocketPoller : public testing::Test
+{
+protected:
+  TestSocketPoller()
+  {
+    poller.Initialize();
+  }
+
+  // the events reported for a socket by a single Wait()
+  int WaitFor(SOCKET socket, int timeoutMs, CSocketPoller::Event *found = NULL)
+  {
+    std::vector<CSocketPoller::Event> events;
+    poller.Wait(timeoutMs, events);
+    for (std::vector<CSocketPoller::Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+    {
+      if (it->socket != socket)
+        continue;
+      if (found != NULL)
+        *found = *it;
+      return it->events;
+    }
+    return 0;
+  }
+
+  CSocketPoller poller;
+};
+
+TEST_F(TestSocketPoller, ReportsReadableAndWritable)
+{
+  int sockets[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+  ASSERT_TRUE(poller.Add(sockets[0], CSocketPoller::EventRead));
+  EXPECT_EQ(0, WaitFor(sockets[0], 0));
+
+  ASSERT_EQ(1, write(sockets[1], "x", 1));
+  EXPECT_EQ(CSocketPoller::EventRead, WaitFor(sockets[0], 1000));
+
+  // only the events asked for are reported
+  ASSERT_TRUE(poller.Modify(sockets[0], CSocketPoller::EventWrite));
+  EXPECT_EQ(CSocketPoller::EventWrite, WaitFor(sockets[0], 1000));
+
+  poller.Remove(sockets[0]);
+  EXPECT_EQ(0, WaitFor(sockets[0], 0));
+
+  close(sockets[0]);
+  close(sockets[1]);
+}
+
+TEST_F(TestSocketPoller, ReusedSocketIsNotCurrent)
+{
+  int sockets[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  ASSERT_TRUE(poller.Add(sockets[0], CSocketPoller::EventRead));
+  ASSERT_EQ(1, write(sockets[1], "x", 1));
+
+  CSocketPoller::Event event;
+  ASSERT_EQ(CSocketPoller::EventRead, WaitFor(sockets[0], 1000, &event));
+  EXPECT_TRUE(poller.IsCurrent(event));
+
+  // the connection is closed while the events are handled and a new one gets
+  // the same descriptor
+  poller.Remove(sockets[0]);
+  close(sockets[0]);
+  close(sockets[1]);
+  EXPECT_FALSE(poller.IsCurrent(event));
+
+  int reused[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, reused));
+  ASSERT_EQ(event.socket, reused[0]);
+  ASSERT_TRUE(poller.Add(reused[0], CSocketPoller::EventRead));
+  EXPECT_FALSE(poller.IsCurrent(event));
+
+  close(reused[0]);
+  close(reused[1]);
+}
+
+TEST_F(TestSocketPoller, WakeUpReturnsEarly)
+{
+  std::vector<CSocketPoller::Event> events;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  poller.WakeUp();
+  EXPECT_EQ(0, poller.Wait(5000, events));
+  EXPECT_TRUE(events.empty());
+  EXPECT_LT(XbmcThreads::SystemClockMillis() - start, 1000u);
+}
@@ -0,0 +1,149 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "network/SocketPoller.h"
+#include "network/TCPServer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// see TCPServer.cpp
+#define OUTBOUND_HIGH_WATERMARK (256 * 1024)
+#define OUTBOUND_QUEUE_LIMIT (4 * 1024 * 1024)
+
+#define ANNOUNCEMENT_SIZE (64 * 1024)
+
+namespace JSONRPC
+{
+class TestTCPServerHelper
+{
+public:
+  typedef CTCPServer::CTCPClient Client;
+
+  static Client* CreateClient(SOCKET socket)
+  {
+    Client *client = new Client();
+    client->m_socket = socket;
+    return client;
+  }
+};
+}
+
+using namespace JSONRPC;
+
+class TestTCPServer : public testing::Test
+{
+protected:
+  TestTCPServer()
+    : announcement(new std::string(ANNOUNCEMENT_SIZE, 'x'))
+  {
+    // the client end is non-blocking like the sockets of accepted connections
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+    fcntl(sockets[0], F_SETFL, fcntl(sockets[0], F_GETFL) | O_NONBLOCK);
+    fcntl(sockets[1], F_SETFL, fcntl(sockets[1], F_GETFL) | O_NONBLOCK);
+    client.reset(TestTCPServerHelper::CreateClient(sockets[0]));
+  }
+
+  ~TestTCPServer()
+  {
+    client->Disconnect();
+    close(sockets[1]);
+  }
+
+  // reads everything the client sends until its queue is empty
+  size_t Drain()
+  {
+    size_t total = 0;
+    char buffer[ANNOUNCEMENT_SIZE];
+    bool received = true;
+    while (received)
+    {
+      EXPECT_TRUE(client->Flush());
+
+      received = false;
+      ssize_t length;
+      while ((length = read(sockets[1], buffer, sizeof(buffer))) > 0)
+      {
+        total += length;
+        received = true;
+      }
+    }
+    return total;
+  }
+
+  int sockets[2];
+  CSocketPoller poller;
+  std::unique_ptr<TestTCPServerHelper::Client> client;
+  std::shared_ptr<const std::string> announcement;
+};
+
+TEST_F(TestTCPServer, DropsAnnouncementsOverQueueLimit)
+{
+  const size_t count = 2 * OUTBOUND_QUEUE_LIMIT / ANNOUNCEMENT_SIZE;
+  for (size_t i = 0; i < count; i++)
+    client->Announce(announcement);
+
+  // whole announcements are dropped once the limit is reached
+  size_t received = Drain();
+  EXPECT_EQ(0u, received % ANNOUNCEMENT_SIZE);
+  EXPECT_GE(received, (size_t)OUTBOUND_QUEUE_LIMIT);
+  EXPECT_LT(received, count * ANNOUNCEMENT_SIZE);
+
+  // announcements are delivered again once the client caught up
+  client->Announce(announcement);
+  EXPECT_EQ((size_t)ANNOUNCEMENT_SIZE, Drain());
+}
+
+TEST_F(TestTCPServer, StopsReadingOverHighWatermark)
+{
+  ASSERT_TRUE(poller.Initialize());
+  client->Attach(&poller);
+
+  for (size_t i = 0; i < 2 * OUTBOUND_HIGH_WATERMARK / ANNOUNCEMENT_SIZE + 8; i++)
+    client->Announce(announcement);
+  ASSERT_EQ(1, write(sockets[1], "{", 1));
+
+  // the pending request isn't read while the client isn't reading its data
+  std::vector<CSocketPoller::Event> events;
+  poller.Wait(100, events);
+  for (std::vector<CSocketPoller::Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+    EXPECT_EQ(0, it->events & CSocketPoller::EventRead);
+
+  Drain();
+  poller.Wait(1000, events);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(sockets[0], events[0].socket);
+  EXPECT_EQ(CSocketPoller::EventRead, events[0].events);
+}
+
+TEST_F(TestTCPServer, DisconnectedClientDropsAnnouncements)
+{
+  client->Disconnect();
+  client->Announce(announcement);
+
+  char buffer[16];
+  EXPECT_EQ(0, read(sockets[1], buffer, sizeof(buffer)));
+}
@@ -587,6 +587,28 @@ TEST_F(TestWebServer, CanGetCachedFileWithNewerIfUnmodifiedSince)
   CheckRangesTestFileResponse(curl);
 }
 
+TEST_F(TestWebServer, CanGetCachedFileWithNonMatchingIfNoneMatch)
+{
+  // get the entity tag of the file
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  std::string etag = curl.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_FALSE(etag.empty());
+  EXPECT_EQ('"', etag.front());
+  EXPECT_EQ('"', etag.back());
+
+  // get the file with a different entity tag
+  CCurlFile curlIfNoneMatch;
+  curlIfNoneMatch.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curlIfNoneMatch.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, "\"0-0\"");
+  ASSERT_TRUE(curlIfNoneMatch.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curlIfNoneMatch);
+  EXPECT_STREQ(etag.c_str(), curlIfNoneMatch.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG).c_str());
+}
+
 TEST_F(TestWebServer, CanGetRangedFileRange0_)
 {
   const std::string rangedFileContent = TEST_FILES_DATA_RANGES;
@@ -288,6 +288,14 @@ bool CGUIWindowPictures::OnClick(int iItem, const std::string &player)
   return false;
 }
 
+CBackgroundInfoLoader* CGUIWindowPictures::GetListingLoader()
+{
+  // Update() only runs the thumb loader when thumbs are generated
+  if (CSettings::GetInstance().GetBool(CSettings::SETTING_PICTURES_GENERATETHUMBS))
+    return &m_thumbLoader;
+  return NULL;
+}
+
 bool CGUIWindowPictures::GetDirectory(const std::string &strDirectory, CFileItemList& items)
 {
   if (!CGUIMediaWindow::GetDirectory(strDirectory, items))
@@ -215,6 +215,26 @@ bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, ui
   uint32_t &dest_width, uint32_t &dest_height, const std::string &dest,
   CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */)
 {
+  uint32_t *buffer = NULL;
+  if (!ScaleTextureForCache(pixels, width, height, pitch, orientation, dest_width, dest_height, buffer, scalingAlgorithm))
+    return false;
+
+  // no resizing or orientation needed
+  if (buffer == NULL)
+    return CreateThumbnailFromSurface(pixels, width, height, pitch, dest);
+
+  bool success = CreateThumbnailFromSurface((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
+  delete[] buffer;
+  return success;
+}
+
+bool CPicture::ScaleTextureForCache(uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pitch, int orientation,
+  uint32_t &dest_width, uint32_t &dest_height, uint32_t *&result,
+  CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */,
+  struct SwsContext **scaler /* = NULL */)
+{
+  result = NULL;
+
   // if no max width or height is specified, don't resize
   if (dest_width == 0)
     dest_width = width;
@@ -238,36 +258,36 @@ bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, ui
 
   if (width > dest_width || height > dest_height || orientation)
   {
-    bool success = false;
-
     dest_width = std::min(width, dest_width);
     dest_height = std::min(height, dest_height);
 
     // create a buffer large enough for the resulting image
     GetScale(width, height, dest_width, dest_height);
     uint32_t *buffer = new uint32_t[dest_width * dest_height];
-    if (buffer)
+    if (!ScaleImage(pixels, width, height, pitch,
+                    (uint8_t *)buffer, dest_width, dest_height, dest_width * 4,
+                    scalingAlgorithm, scaler) ||
+        (orientation && !OrientateImage(buffer, dest_width, dest_height, orientation)))
     {
-      if (ScaleImage(pixels, width, height, pitch,
-                     (uint8_t *)buffer, dest_width, dest_height, dest_width * 4,
-                     scalingAlgorithm))
-      {
-        if (!orientation || OrientateImage(buffer, dest_width, dest_height, orientation))
-        {
-          success = CreateThumbnailFromSurface((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
-        }
-      }
       delete[] buffer;
+      return false;
     }
-    return success;
-  }
-  else
-  { // no orientation needed
-    dest_width = width;
-    dest_height = height;
-    return CreateThumbnailFromSurface(pixels, width, height, pitch, dest);
+
+    result = buffer;
+    return true;
   }
-  return false;
+
+  // no orientation needed
+  dest_width = width;
+  dest_height = height;
+  return true;
+}
+
+void CPicture::FreeScaler(struct SwsContext *&scaler)
+{
+  if (scaler != NULL)
+    sws_freeContext(scaler);
+  scaler = NULL;
 }
 
 bool CPicture::CreateTiledThumb(const std::vector<std::string> &files, const std::string &thumb)
@@ -341,8 +361,27 @@ void CPicture::GetScale(unsigned int width, unsigned int height, unsigned int &o
 
 bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch,
                           uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
-                          CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */)
+                          CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */,
+                          struct SwsContext **scaler /* = NULL */)
 {
+  // swscale picks the SIMD optimised scaler for the CPU, setting it up is
+  // expensive though so callers scaling many images can keep the context
+  if (scaler != NULL)
+  {
+    *scaler = sws_getCachedContext(*scaler, in_width, in_height, AV_PIX_FMT_BGRA,
+                                   out_width, out_height, AV_PIX_FMT_BGRA,
+                                   CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm), NULL, NULL, NULL);
+    if (*scaler == NULL)
+      return false;
+
+    uint8_t *src[] = { in_pixels, 0, 0, 0 };
+    int     srcStride[] = { (int)in_pitch, 0, 0, 0 };
+    uint8_t *dst[] = { out_pixels , 0, 0, 0 };
+    int     dstStride[] = { (int)out_pitch, 0, 0, 0 };
+    sws_scale(*scaler, src, srcStride, 0, in_height, dst, dstStride);
+    return true;
+  }
+
   struct SwsContext *context = sws_getContext(in_width, in_height, AV_PIX_FMT_BGRA,
                                                          out_width, out_height, AV_PIX_FMT_BGRA,
                                                          CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm), NULL, NULL, NULL);
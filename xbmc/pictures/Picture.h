@@ -26,6 +26,7 @@
 #include "utils/Job.h"
 
 class CBaseTexture;
+struct SwsContext;
 
 class CPicture
 {
@@ -59,11 +60,26 @@ public:
     uint32_t &dest_width, uint32_t &dest_height, const std::string &dest,
     CPictureScalingAlgorithm::Algorithm scalingAlgorithm = CPictureScalingAlgorithm::NoAlgorithm);
 
+  /*! \brief Resize, rotate and flip pixels as needed to be cached, without saving them
+   \param dest_width [in/out] maximum width in pixels of cached version - replaced with actual cached width
+   \param dest_height [in/out] maximum height in pixels of cached version - replaced with actual cached height
+   \param result [out] the transformed pixels (allocated with new[]) or NULL if the pixels can be cached as they are
+   \param scaler [in/out] optional scaling context which is reused as long as the dimensions don't change, must be freed with FreeScaler()
+   \return true if successful, false otherwise
+   \sa CacheTexture
+   */
+  static bool ScaleTextureForCache(uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pitch, int orientation,
+    uint32_t &dest_width, uint32_t &dest_height, uint32_t *&result,
+    CPictureScalingAlgorithm::Algorithm scalingAlgorithm = CPictureScalingAlgorithm::NoAlgorithm,
+    struct SwsContext **scaler = NULL);
+  static void FreeScaler(struct SwsContext *&scaler);
+
 private:
   static void GetScale(unsigned int width, unsigned int height, unsigned int &out_width, unsigned int &out_height);
   static bool ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch,
                          uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
-                         CPictureScalingAlgorithm::Algorithm scalingAlgorithm = CPictureScalingAlgorithm::NoAlgorithm);
+                         CPictureScalingAlgorithm::Algorithm scalingAlgorithm = CPictureScalingAlgorithm::NoAlgorithm,
+                         struct SwsContext **scaler = NULL);
   static bool OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, int orientation);
 
   static bool FlipHorizontal(uint32_t *&pixels, unsigned int &width, unsigned int &height);
@@ -125,6 +125,8 @@ void CAdvancedSettings::Initialize()
 
   m_audioDefaultPlayer = "paplayer";
   m_audioPlayCountMinimumPercent = 90.0f;
+  m_audioPreloadTracks = 1;
+  m_audioPreloadSeconds = 10;
 
   m_videoSubsDelayRange = 60;
   m_videoAudioDelayRange = 10;
@@ -323,6 +325,9 @@ void CAdvancedSettings::Initialize()
   m_curlconnecttimeout = 10;
   m_curllowspeedtime = 20;
   m_curlretries = 2;
+  m_curlprefetchconnections = 0;
+  m_curlprefetchchunksize = 1024 * 1024;
+  m_pipelinedListing = false;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
@@ -341,6 +346,7 @@ void CAdvancedSettings::Initialize()
   m_RestrictCapsMask = 0;
   m_sleepBeforeFlip = 0;
   m_bVirtualShares = true;
+  m_parallelThreads = 0;
   m_bAllowDeferredRendering = true;
 
   m_cpuTempCmd = "";
@@ -364,12 +370,30 @@ void CAdvancedSettings::Initialize()
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_cacheReadFactor = 4.0f;
+  // keep fetched data in blocks across seeks instead of a single ring
+  m_cacheSparse = false;
+  // disk space the block cache may spill to, 0 keeps it in memory only
+  m_cacheSpillSize = 0;
+  // memory budget for cached directory listings
+  m_directoryCacheMemSize = 1024 * 1024 * 16;
 
   m_addonPackageFolderSize = 200;
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
 
+  m_announceQueued = true;
+  m_announceCoalesceTime = 250;
+  m_announceQueueSize = 1000;
+
+  m_webserverResponseCacheSize = 16;
+  m_webserverZeroCopy = true;
+
+  m_textureCacheDecodeThreads = 0;
+  m_textureCacheScaleThreads = 0;
+  m_textureCacheEncodeThreads = 0;
+  m_textureCacheQueueSize = 8;
+
 #ifdef HAS_DS_PLAYER
   m_bDSPlayerFastChannelSwitching = true;
   m_bDSPlayerUseUNCPathsForLiveTV = false;
@@ -410,6 +434,7 @@ void CAdvancedSettings::Initialize()
   m_useDisplayControlHWStereo = false;
 
   m_videoAssFixedWorks = false;
+  m_videoLockFreeMessageQueue = false;
 
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
   m_extraLogEnabled = false;
@@ -513,6 +538,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pElement, "defaultplayer", m_audioDefaultPlayer);
     // 101 on purpose - can be used to never automark as watched
     XMLUtils::GetFloat(pElement, "playcountminimumpercent", m_audioPlayCountMinimumPercent, 0.0f, 101.0f);
+    XMLUtils::GetInt(pElement, "preloadtracks", m_audioPreloadTracks, 0, 5);
+    XMLUtils::GetInt(pElement, "preloadseconds", m_audioPreloadSeconds, 2, 60);
 
     XMLUtils::GetBoolean(pElement, "usetimeseeking", m_musicUseTimeSeeking);
     XMLUtils::GetInt(pElement, "timeseekforward", m_musicTimeSeekForward, 0, 6000);
@@ -550,6 +577,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "assfixedworks", m_videoAssFixedWorks);
+    XMLUtils::GetBoolean(pElement, "lockfreemessagequeue", m_videoLockFreeMessageQueue);
     XMLUtils::GetString(pElement, "stereoscopicregex3d", m_stereoscopicregex_3d);
     XMLUtils::GetString(pElement, "stereoscopicregexsbs", m_stereoscopicregex_sbs);
     XMLUtils::GetString(pElement, "stereoscopicregextab", m_stereoscopicregex_tab);
@@ -824,6 +852,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetInt(pElement, "curlprefetchconnections", m_curlprefetchconnections, 0, 16);
+    XMLUtils::GetInt(pElement, "curlprefetchchunksize", m_curlprefetchchunksize, 64 * 1024, 16 * 1024 * 1024);
+    XMLUtils::GetBoolean(pElement, "pipelinedlisting", m_pipelinedListing);
   }
 
   pElement = pRootElement->FirstChildElement("cache");
@@ -832,6 +863,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "memorysize", m_cacheMemSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_cacheBufferMode, 0, 4);
     XMLUtils::GetFloat(pElement, "readfactor", m_cacheReadFactor);
+    XMLUtils::GetBoolean(pElement, "sparse", m_cacheSparse);
+    XMLUtils::GetUInt(pElement, "spillsize", m_cacheSpillSize);
+    XMLUtils::GetUInt(pElement, "directorymemorysize", m_directoryCacheMemSize);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -841,6 +875,30 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
   }
 
+  pElement = pRootElement->FirstChildElement("announcements");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "queued", m_announceQueued);
+    XMLUtils::GetUInt(pElement, "coalescetime", m_announceCoalesceTime, 0, 10000);
+    XMLUtils::GetUInt(pElement, "queuesize", m_announceQueueSize, 10, 100000);
+  }
+
+  pElement = pRootElement->FirstChildElement("webserver");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "responsecachesize", m_webserverResponseCacheSize, 0, 1024);
+    XMLUtils::GetBoolean(pElement, "zerocopy", m_webserverZeroCopy);
+  }
+
+  pElement = pRootElement->FirstChildElement("texturecache");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "decodethreads", m_textureCacheDecodeThreads, 0, 32);
+    XMLUtils::GetUInt(pElement, "scalethreads", m_textureCacheScaleThreads, 0, 32);
+    XMLUtils::GetUInt(pElement, "encodethreads", m_textureCacheEncodeThreads, 0, 32);
+    XMLUtils::GetUInt(pElement, "queuesize", m_textureCacheQueueSize, 1, 256);
+  }
+
   pElement = pRootElement->FirstChildElement("samba");
   if (pElement)
   {
@@ -900,6 +958,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   XMLUtils::GetUInt(pRootElement,"restrictcapsmask", m_RestrictCapsMask);
   XMLUtils::GetFloat(pRootElement,"sleepbeforeflip", m_sleepBeforeFlip, 0.0f, 1.0f);
   XMLUtils::GetBoolean(pRootElement,"virtualshares", m_bVirtualShares);
+  XMLUtils::GetInt(pRootElement, "parallelthreads", m_parallelThreads, 0, 64);
   XMLUtils::GetUInt(pRootElement, "packagefoldersize", m_addonPackageFolderSize);
   XMLUtils::GetBoolean(pRootElement, "allowdeferredrendering", m_bAllowDeferredRendering);
 
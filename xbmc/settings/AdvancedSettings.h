@@ -147,6 +147,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     float m_ac3Gain;
     std::string m_audioDefaultPlayer;
     float m_audioPlayCountMinimumPercent;
+    int m_audioPreloadTracks;   ///< upcoming playlist items paplayer opens and decodes in advance
+    int m_audioPreloadSeconds;  ///< decoded audio held for each of them
     bool m_VideoPlayerIgnoreDTSinWAV;
     float m_limiterHold;
     float m_limiterRelease;
@@ -310,6 +312,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    int m_curlprefetchconnections;   ///< concurrent range requests for seekable http files, <= 1 disables prefetching
+    int m_curlprefetchchunksize;     ///< size of each prefetched byte range
+    bool m_pipelinedListing;         ///< start loading item info while network directories are still listed
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -325,6 +330,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     unsigned int m_RestrictCapsMask;
     float m_sleepBeforeFlip; ///< if greather than zero, XBMC waits for raster to be this amount through the frame prior to calling the flip
     bool m_bVirtualShares;
+    int m_parallelThreads;           ///< threads used to process large file lists, 0 = number of CPUs, 1 = serial
     bool m_bAllowDeferredRendering;
 
     std::string m_cpuTempCmd;
@@ -364,10 +370,25 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     unsigned int m_cacheMemSize;
     unsigned int m_cacheBufferMode;
     float m_cacheReadFactor;
+    bool m_cacheSparse;
+    unsigned int m_cacheSpillSize;        ///< size of the sparse cache spill file in MB
+    unsigned int m_directoryCacheMemSize;
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
 
+    bool m_announceQueued;                ///< deliver announcements to every announcer from its own queue and thread
+    unsigned int m_announceCoalesceTime;  ///< time in ms repeated library announcements are held back to be merged, 0 = off
+    unsigned int m_announceQueueSize;     ///< queued announcements per announcer before library announcements are dropped
+
+    unsigned int m_webserverResponseCacheSize;  ///< size in MiB of the cache for transformed images, 0 = off
+    bool m_webserverZeroCopy;                   ///< send local files with sendfile() instead of reading them through the VFS
+
+    unsigned int m_textureCacheDecodeThreads;  ///< threads loading images for the batch texture cache pipeline, 0 = number of cpus / 2
+    unsigned int m_textureCacheScaleThreads;   ///< threads resizing images for the batch texture cache pipeline, 0 = number of cpus / 2
+    unsigned int m_textureCacheEncodeThreads;  ///< threads writing images for the batch texture cache pipeline, 0 = number of cpus / 2
+    unsigned int m_textureCacheQueueSize;      ///< images waiting between two stages of the pipeline before the previous stage blocks
+
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
     void ParseSettingsFile(const std::string &file);
@@ -403,6 +424,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     True to show at the fixed position set in video calibration
     False to show at the bottom of video (default) */
     bool m_videoAssFixedWorks;
+    bool m_videoLockFreeMessageQueue;
 
     std::string m_userAgent;
 
@@ -0,0 +1,118 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "BackgroundInfoLoader.h"
+#include "FileItem.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace
+{
+class CTestInfoLoader : public CBackgroundInfoLoader
+{
+public:
+  CTestInfoLoader() : m_lookups(0) {}
+
+  bool LoadItemLookup(CFileItem* pItem) override
+  {
+    pItem->SetProperty("loaded", true);
+    pItem->SetArt("fanart", pItem->GetPath() + ".jpg");
+    m_lookups++;
+    return true;
+  }
+
+  size_t LoadedCopies()
+  {
+    CSingleLock lock(m_lock);
+    return m_loaded.size();
+  }
+
+  std::atomic<int> m_lookups;
+};
+
+template<typename Condition>
+bool WaitFor(Condition condition)
+{
+  XbmcThreads::EndTime timeout(5000);
+  while (!condition())
+  {
+    if (timeout.IsTimePast())
+      return false;
+    XbmcThreads::ThreadSleep(10);
+  }
+  return true;
+}
+}
+
+TEST(TestBackgroundInfoLoader, CarriesPartialListingIntoLoad)
+{
+  CTestInfoLoader loader;
+  CFileItemList listing("test://");
+  for (int i = 0; i < 200; i++)
+    listing.Add(CFileItemPtr(new CFileItem(StringUtils::Format("test://item%i", i), false)));
+
+  // the first entries arrive as copies while the listing is still running
+  CFileItemList batch("test://");
+  for (int i = 0; i < 100; i++)
+    batch.Add(CFileItemPtr(new CFileItem(*listing[i])));
+  loader.OnPartialListing(batch);
+  ASSERT_TRUE(WaitFor([&loader]() { return loader.LoadedCopies() == 100; }));
+
+  // the complete listing takes over the loader without stopping it
+  loader.Load(listing);
+  ASSERT_TRUE(WaitFor([&loader]() { return !loader.IsLoading(); }));
+
+  // entries done on the copies are not looked up again
+  EXPECT_EQ(200, loader.m_lookups);
+  for (int i = 0; i < listing.Size(); i++)
+  {
+    EXPECT_TRUE(listing[i]->GetProperty("loaded").asBoolean());
+    EXPECT_EQ(listing[i]->GetPath() + ".jpg", listing[i]->GetArt("fanart"));
+  }
+  loader.StopThread();
+}
+
+TEST(TestBackgroundInfoLoader, StopDropsPartialListing)
+{
+  CTestInfoLoader loader;
+  CFileItemList batch("test://");
+  for (int i = 0; i < 100; i++)
+    batch.Add(CFileItemPtr(new CFileItem(StringUtils::Format("test://item%i", i), false)));
+  loader.OnPartialListing(batch);
+  ASSERT_TRUE(WaitFor([&loader]() { return loader.LoadedCopies() == 100; }));
+
+  // a stopped loader starts over on the next listing
+  loader.StopThread();
+  EXPECT_EQ(0u, loader.LoadedCopies());
+
+  CFileItemList listing("test://");
+  listing.Add(CFileItemPtr(new CFileItem("test://item0", false)));
+  loader.Load(listing);
+  ASSERT_TRUE(WaitFor([&loader]() { return !loader.IsLoading(); }));
+  EXPECT_EQ(101, loader.m_lookups);
+  EXPECT_TRUE(listing[0]->GetProperty("loaded").asBoolean());
+  loader.StopThread();
+}
@@ -0,0 +1,164 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+// enough items for every step to be split into several chunks
+#define LIST_TITLES 800
+
+class TestFileItemList : public testing::Test
+{
+protected:
+  TestFileItemList()
+  {
+    m_parallelThreads = g_advancedSettings.m_parallelThreads;
+
+    // a cue sheet for one of the audio files of the listing
+    m_cuesheet = XBMC_CREATETEMPFILE(".cue");
+    std::string cue = "FILE \"Lions.flac\" WAVE\n"
+                      "  TRACK 01 AUDIO\n"
+                      "    TITLE \"First\"\n"
+                      "    INDEX 01 00:00:00\n"
+                      "  TRACK 02 AUDIO\n"
+                      "    TITLE \"Second\"\n"
+                      "    INDEX 01 03:00:00\n";
+    m_cuesheet->Write(cue.c_str(), cue.size());
+    m_cuesheet->Flush();
+    m_directory = URIUtils::GetDirectory(XBMC_TEMPFILEPATH(m_cuesheet));
+  }
+
+  ~TestFileItemList()
+  {
+    XBMC_DELETETEMPFILE(m_cuesheet);
+    g_advancedSettings.m_parallelThreads = m_parallelThreads;
+  }
+
+  void AddItem(CFileItemList &items, const std::string &name, bool folder, int64_t size)
+  {
+    std::string path = URIUtils::AddFileToFolder(m_directory, name);
+    if (folder)
+      URIUtils::AddSlashAtEnd(path);
+
+    CFileItemPtr item(new CFileItem(path, folder));
+    item->SetLabel(name);
+    item->m_dwSize = size;
+    items.Add(item);
+  }
+
+  // an unsorted listing with files and folders to stack and a cue sheet. The
+  // other names avoid the letters the last stack expression takes as volumes.
+  void FillList(CFileItemList &items)
+  {
+    items.SetPath(m_directory);
+    for (int i = 0; i < LIST_TITLES; i++)
+    {
+      int title = (i * 7919) % LIST_TITLES;
+      AddItem(items, StringUtils::Format("Movie %d cd2.avi", title), false, title * 3);
+      AddItem(items, StringUtils::Format("Trip %d.mp4", title), false, title % 17);
+      AddItem(items, StringUtils::Format("Movie %d cd1.avi", title), false, title * 2);
+      if (title % 2 == 0)
+      {
+        AddItem(items, StringUtils::Format("Show %d.part1.mkv", title), false, title);
+        AddItem(items, StringUtils::Format("Show %d.part2.mkv", title), false, title);
+      }
+      if (title % 10 == 0)
+        AddItem(items, StringUtils::Format("Collection %d", title), true, 0);
+      if (title % 20 == 0)
+        AddItem(items, StringUtils::Format("Film %d cd1", title), true, 0);
+      AddItem(items, StringUtils::Format("Song %d.mp3", title), false, title % 5);
+    }
+
+    AddItem(items, "Lions.flac", false, 1000);
+    items.Add(CFileItemPtr(new CFileItem(XBMC_TEMPFILEPATH(m_cuesheet), false)));
+  }
+
+  // what a listing looks like after the sort, stack and filter steps
+  std::vector<std::string> Process(int threads)
+  {
+    g_advancedSettings.m_parallelThreads = threads;
+
+    CFileItemList items;
+    FillList(items);
+    items.FilterCueItems();
+    items.Stack();
+    items.Sort(SortBySize, SortOrderDescending);
+
+    std::vector<std::string> result;
+    for (int i = 0; i < items.Size(); i++)
+    {
+      result.push_back(StringUtils::Format("%s|%s|%d|%d",
+                                           items[i]->GetPath().c_str(),
+                                           items[i]->GetLabel().c_str(),
+                                           items[i]->m_bIsFolder,
+                                           items[i]->HasCueDocument()));
+    }
+    return result;
+  }
+
+  std::string m_directory;
+
+private:
+  XFILE::CFile *m_cuesheet;
+  int m_parallelThreads;
+};
+
+TEST_F(TestFileItemList, ParallelMatchesSerial)
+{
+  std::vector<std::string> serial = Process(1);
+  std::vector<std::string> parallel = Process(8);
+
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++)
+    EXPECT_EQ(serial[i], parallel[i]);
+}
+
+TEST_F(TestFileItemList, StacksAndFilters)
+{
+  CFileItemList unprocessed;
+  FillList(unprocessed);
+  std::vector<std::string> processed = Process(8);
+
+  // both parts of every movie and show end up in one stack and the cue sheet
+  // is applied to its audio file and removed
+  const int stacks = LIST_TITLES + LIST_TITLES / 2;
+  EXPECT_EQ((size_t)(unprocessed.Size() - stacks - 1), processed.size());
+
+  int stacked = 0;
+  int cues = 0;
+  for (std::vector<std::string>::const_iterator it = processed.begin(); it != processed.end(); ++it)
+  {
+    if (StringUtils::StartsWith(*it, "stack://"))
+      stacked++;
+    if (StringUtils::EndsWith(*it, "|1"))
+      cues++;
+  }
+  EXPECT_EQ(stacks, stacked);
+  EXPECT_EQ(1, cues);
+}
@@ -0,0 +1,118 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+
+#include <vector>
+
+// one period of 5.1 audio as the engine processes it
+#define FRAMES 1024
+#define CHANNELS 6
+
+namespace
+{
+const CAEKernels& Kernels(bool scalar)
+{
+  return scalar ? *CAEKernels::Get(CAEKernels::IMPL_SCALAR) : CAEKernels::Get();
+}
+
+std::vector<float> Samples(unsigned int count)
+{
+  std::vector<float> samples(count);
+  for (unsigned int i = 0; i < count; i++)
+    samples[i] = ((i * 7919) % 2001) / 1000.0f - 1.0f;
+  return samples;
+}
+
+void MixGain(CBenchmarkState &state, bool scalar)
+{
+  const CAEKernels &kernels = Kernels(scalar);
+  std::vector<float> dst = Samples(FRAMES * CHANNELS);
+  std::vector<float> src = Samples(FRAMES * CHANNELS);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    kernels.Gain(&dst[0], 0.5f, dst.size());
+    kernels.MixGain(&dst[0], &src[0], 0.5f, dst.size());
+  }
+  BenchmarkKeep(dst);
+  state.SetItemsProcessed(state.Iterations() * FRAMES);
+}
+
+void Clamp(CBenchmarkState &state, bool scalar)
+{
+  const CAEKernels &kernels = Kernels(scalar);
+  std::vector<float> samples = Samples(FRAMES * CHANNELS);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    BenchmarkKeep(kernels.Peak(&samples[0], samples.size()));
+    kernels.Clamp(&samples[0], samples.size());
+  }
+  BenchmarkKeep(samples);
+  state.SetItemsProcessed(state.Iterations() * FRAMES);
+}
+
+void PlanarToS16(CBenchmarkState &state, bool scalar)
+{
+  const CAEKernels &kernels = Kernels(scalar);
+  std::vector<float> planes[2] = { Samples(FRAMES), Samples(FRAMES) };
+  const float *src[2] = { &planes[0][0], &planes[1][0] };
+  std::vector<float> interleaved(FRAMES * 2);
+  std::vector<int16_t> out(FRAMES * 2);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    kernels.Interleave(src, &interleaved[0], 2, FRAMES);
+    kernels.FloatToS16(&interleaved[0], &out[0], out.size());
+  }
+  BenchmarkKeep(out);
+  state.SetBytesProcessed(state.Iterations() * out.size() * sizeof(int16_t));
+}
+}
+
+XBMC_BENCHMARK(AEKernels, MixGainScalar)
+{
+  MixGain(state, true);
+}
+
+XBMC_BENCHMARK(AEKernels, MixGain)
+{
+  MixGain(state, false);
+}
+
+XBMC_BENCHMARK(AEKernels, ClampScalar)
+{
+  Clamp(state, true);
+}
+
+XBMC_BENCHMARK(AEKernels, Clamp)
+{
+  Clamp(state, false);
+}
+
+XBMC_BENCHMARK(AEKernels, PlanarToS16Scalar)
+{
+  PlanarToS16(state, true);
+}
+
+XBMC_BENCHMARK(AEKernels, PlanarToS16)
+{
+  PlanarToS16(state, false);
+}
@@ -0,0 +1,238 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Interfaces/AEStream.h"
+#include "cores/AudioEngine/Utils/AEAudioFormat.h"
+#include "cores/AudioEngine/Utils/AEStreamData.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "settings/Settings.h"
+#include "threads/Thread.h"
+
+#if defined(TARGET_POSIX)
+#include <sys/resource.h>
+#elif defined(TARGET_WINDOWS)
+#include <windows.h>
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// audio handed to the stream per iteration
+#define PACKET_MS 100
+
+namespace
+{
+void StopEngine()
+{
+  CAEFactory::Shutdown();
+  CAEFactory::UnLoadEngine();
+}
+
+/*!
+ \brief Headless engine writing to the NULL sink
+ The sink consumes audio as fast as the engine delivers it, so the pipeline
+ runs at full speed and the benchmark measures the engine alone.
+ */
+bool StartEngine()
+{
+  static bool started = false;
+  if (started)
+    return CAEFactory::GetEngine() != NULL;
+  started = true;
+
+  CSettings::GetInstance().SetString(CSettings::SETTING_AUDIOOUTPUT_AUDIODEVICE, "NULL:unthrottled");
+  // allow every layout of the benchmarks without downmixing
+  CSettings::GetInstance().SetInt(CSettings::SETTING_AUDIOOUTPUT_CHANNELS, AE_CH_LAYOUT_7_1);
+
+  if (!CAEFactory::LoadEngine() || !CAEFactory::StartEngine())
+  {
+    CAEFactory::UnLoadEngine();
+    return false;
+  }
+
+  CBenchmarkRegistry::GetInstance().RegisterCleanup(StopEngine);
+  return true;
+}
+
+double ProcessCpuSeconds()
+{
+#if defined(TARGET_POSIX)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == -1)
+    return 0.0;
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+#elif defined(TARGET_WINDOWS)
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    return 0.0;
+  ULARGE_INTEGER k, u;
+  k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+  return (k.QuadPart + u.QuadPart) / 10000000.0;
+#else
+  return 0.0;
+#endif
+}
+
+/*!
+ \brief One packet of a sine wave in the format of the stream
+ Every channel gets its own frequency so that remapping can't be skipped.
+ */
+void MakePacket(const AEAudioFormat &format, unsigned int frames, std::vector<uint8_t> &buffer, std::vector<uint8_t*> &planes)
+{
+  unsigned int channels = format.m_channelLayout.Count();
+  unsigned int bytes = CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3;
+  bool planar = AE_IS_PLANAR(format.m_dataFormat);
+
+  buffer.assign(frames * channels * bytes, 0);
+  planes.clear();
+  for (unsigned int ch = 0; ch < (planar ? channels : 1); ch++)
+    planes.push_back(&buffer[ch * frames * bytes * (planar ? 1 : channels)]);
+
+  for (unsigned int ch = 0; ch < channels; ch++)
+  {
+    double step = 2.0 * M_PI * 220.0 * (ch + 1) / format.m_sampleRate;
+    for (unsigned int i = 0; i < frames; i++)
+    {
+      float sample = 0.5f * (float)sin(step * i);
+      uint8_t *dst = planar ? planes[ch] + i * bytes : planes[0] + (i * channels + ch) * bytes;
+      switch (format.m_dataFormat)
+      {
+        case AE_FMT_S16NE:
+        {
+          int16_t value = (int16_t)(sample * 32767.0f);
+          memcpy(dst, &value, sizeof(value));
+          break;
+        }
+        case AE_FMT_S32NE:
+        {
+          int32_t value = (int32_t)(sample * 2147483647.0);
+          memcpy(dst, &value, sizeof(value));
+          break;
+        }
+        default:
+          memcpy(dst, &sample, sizeof(sample));
+          break;
+      }
+    }
+  }
+}
+
+void Pipeline(CBenchmarkState &state, AEDataFormat dataFormat, AEStdChLayout layout, unsigned int sampleRate, double ratio)
+{
+  state.PauseTiming();
+  if (!StartEngine())
+  {
+    state.SetError("unable to start the audio engine");
+    return;
+  }
+
+  AEAudioFormat format;
+  format.m_dataFormat = dataFormat;
+  format.m_sampleRate = sampleRate;
+  format.m_channelLayout = CAEChannelInfo(layout);
+  format.m_frames = sampleRate * PACKET_MS / 1000;
+  format.m_frameSize = format.m_channelLayout.Count() * (CAEUtil::DataFormatToBits(dataFormat) >> 3);
+
+  std::vector<uint8_t> buffer;
+  std::vector<uint8_t*> planes;
+  MakePacket(format, format.m_frames, buffer, planes);
+
+  IAEStream *stream = CAEFactory::MakeStream(format, ratio != 1.0 ? AESTREAM_FORCE_RESAMPLE : 0);
+  if (!stream)
+  {
+    state.SetError("unable to create the stream");
+    return;
+  }
+  if (ratio != 1.0)
+    stream->SetResampleRatio(ratio);
+
+  double cpuStart = ProcessCpuSeconds();
+  state.ResumeTiming();
+
+  double delay = 0.0;
+  double fill = 0.0;
+  uint64_t samples = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    unsigned int offset = 0;
+    while (offset < format.m_frames)
+    {
+      unsigned int added = stream->AddData(&planes[0], offset, format.m_frames - offset);
+      offset += added;
+      if (!added)
+        XbmcThreads::ThreadSleep(1);
+    }
+
+    delay += stream->GetDelay();
+    if (stream->GetCacheTotal() > 0.0)
+      fill += stream->GetCacheTime() / stream->GetCacheTotal();
+    samples++;
+  }
+  stream->Drain(true);
+
+  state.PauseTiming();
+  double cpu = ProcessCpuSeconds() - cpuStart;
+  CAEFactory::FreeStream(stream);
+
+  double audioSeconds = state.Iterations() * PACKET_MS / 1000.0;
+  state.SetItemsProcessed(state.Iterations() * format.m_frames);
+  state.SetCounter("cpu_ms_per_audio_s", 1000.0 * cpu / audioSeconds);
+  state.SetCounter("latency_ms", 1000.0 * delay / samples);
+  state.SetCounter("cache_fill_pct", 100.0 * fill / samples);
+  state.ResumeTiming();
+}
+}
+
+XBMC_BENCHMARK(ActiveAE, StereoFloat48k)
+{
+  Pipeline(state, AE_FMT_FLOAT, AE_CH_LAYOUT_2_0, 48000, 1.0);
+}
+
+XBMC_BENCHMARK(ActiveAE, StereoS16_44k)
+{
+  Pipeline(state, AE_FMT_S16NE, AE_CH_LAYOUT_2_0, 44100, 1.0);
+}
+
+XBMC_BENCHMARK(ActiveAE, StereoS16_44kResample)
+{
+  Pipeline(state, AE_FMT_S16NE, AE_CH_LAYOUT_2_0, 44100, 1.01);
+}
+
+XBMC_BENCHMARK(ActiveAE, Surround51FloatPlanar48k)
+{
+  Pipeline(state, AE_FMT_FLOATP, AE_CH_LAYOUT_5_1, 48000, 1.0);
+}
+
+XBMC_BENCHMARK(ActiveAE, Surround51FloatPlanar48kResample)
+{
+  Pipeline(state, AE_FMT_FLOATP, AE_CH_LAYOUT_5_1, 48000, 0.99);
+}
+
+XBMC_BENCHMARK(ActiveAE, Surround71S32_96k)
+{
+  Pipeline(state, AE_FMT_S32NE, AE_CH_LAYOUT_7_1, 96000, 1.0);
+}
@@ -0,0 +1,138 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "filesystem/CacheStrategy.h"
+#include "filesystem/CircularCache.h"
+#include "utils/RingBuffer.h"
+
+#include <vector>
+
+#define BUFFER_SIZE (1024 * 1024)
+
+namespace
+{
+void RingBufferThroughput(CBenchmarkState &state, unsigned int chunkSize)
+{
+  CRingBuffer buffer;
+  if (!buffer.Create(BUFFER_SIZE))
+  {
+    state.SetError("unable to create ring buffer");
+    return;
+  }
+
+  std::vector<char> in(chunkSize, 'k');
+  std::vector<char> out(chunkSize);
+  // keep the buffer half full so reads and writes wrap around
+  for (unsigned int filled = 0; filled + chunkSize <= BUFFER_SIZE / 2; filled += chunkSize)
+    buffer.WriteData(&in[0], chunkSize);
+
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    if (!buffer.WriteData(&in[0], chunkSize) || !buffer.ReadData(&out[0], chunkSize))
+    {
+      state.SetError("ring buffer over- or underrun");
+      return;
+    }
+  }
+  BenchmarkKeep(out);
+  state.SetBytesProcessed(state.Iterations() * chunkSize);
+}
+
+void CircularCacheThroughput(CBenchmarkState &state, unsigned int chunkSize)
+{
+  XFILE::CCircularCache cache(BUFFER_SIZE / 2, BUFFER_SIZE / 2);
+  if (cache.Open() != CACHE_RC_OK)
+  {
+    state.SetError("unable to open circular cache");
+    return;
+  }
+
+  std::vector<char> in(chunkSize, 'k');
+  std::vector<char> out(chunkSize);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    if (cache.WriteToCache(&in[0], chunkSize) != static_cast<int>(chunkSize) ||
+        cache.ReadFromCache(&out[0], chunkSize) != static_cast<int>(chunkSize))
+    {
+      state.SetError("circular cache did not accept or return a full chunk");
+      break;
+    }
+  }
+  cache.Close();
+  BenchmarkKeep(out);
+  state.SetBytesProcessed(state.Iterations() * chunkSize);
+}
+}
+
+XBMC_BENCHMARK(RingBuffer, Throughput4K)
+{
+  RingBufferThroughput(state, 4096);
+}
+
+XBMC_BENCHMARK(RingBuffer, Throughput64K)
+{
+  RingBufferThroughput(state, 65536);
+}
+
+XBMC_BENCHMARK(RingBuffer, SmallWrites)
+{
+  RingBufferThroughput(state, 188);
+}
+
+XBMC_BENCHMARK(CircularCache, Throughput4K)
+{
+  CircularCacheThroughput(state, 4096);
+}
+
+XBMC_BENCHMARK(CircularCache, Throughput64K)
+{
+  CircularCacheThroughput(state, 65536);
+}
+
+XBMC_BENCHMARK(CircularCache, SeekInCache)
+{
+  XFILE::CCircularCache cache(BUFFER_SIZE / 2, BUFFER_SIZE / 2);
+  if (cache.Open() != CACHE_RC_OK)
+  {
+    state.SetError("unable to open circular cache");
+    return;
+  }
+
+  std::vector<char> data(BUFFER_SIZE / 4, 'k');
+  cache.WriteToCache(&data[0], data.size());
+
+  const int64_t end = data.size();
+  uint64_t total = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    int64_t pos = static_cast<int64_t>((i * 7919) % end);
+    if (cache.Seek(pos) != pos)
+    {
+      state.SetError("seek within the cached range failed");
+      break;
+    }
+    total += cache.CachedDataEndPosIfSeekTo(pos);
+  }
+  cache.Close();
+  BenchmarkKeep(total);
+  state.SetItemsProcessed(state.Iterations());
+}
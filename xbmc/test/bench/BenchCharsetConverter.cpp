@@ -0,0 +1,150 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "utils/CharsetConverter.h"
+
+namespace
+{
+// mixed latin, cyrillic, CJK and a non-BMP character
+std::string CreateUtf8Text()
+{
+  std::string text;
+  while (text.size() < 4096)
+    text += "Kodi Media Center \xc3\xa4\xc3\xb6\xc3\xbc \xd0\x9a\xd0\xbe\xd0\xb4\xd0\xb8 "
+            "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88 \xf0\x9f\x8e\xac ";
+  return text;
+}
+
+std::string CreateAsciiText()
+{
+  std::string text;
+  while (text.size() < 4096)
+    text += "The quick brown fox jumps over the lazy dog. ";
+  return text;
+}
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf8ToW)
+{
+  const std::string text = CreateUtf8Text();
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::wstring result;
+    if (!g_charsetConverter.utf8ToW(text, result))
+    {
+      state.SetError("utf8ToW failed");
+      return;
+    }
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf8ToWAscii)
+{
+  const std::string text = CreateAsciiText();
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::wstring result;
+    g_charsetConverter.utf8ToW(text, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, WToUtf8)
+{
+  const std::string text = CreateUtf8Text();
+  std::wstring wide;
+  g_charsetConverter.utf8ToW(text, wide);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string result;
+    g_charsetConverter.wToUTF8(wide, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf8ToUtf32)
+{
+  const std::string text = CreateUtf8Text();
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::u32string result;
+    g_charsetConverter.utf8ToUtf32(text, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf32ToUtf8)
+{
+  const std::string text = CreateUtf8Text();
+  std::u32string utf32;
+  g_charsetConverter.utf8ToUtf32(text, utf32);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string result;
+    g_charsetConverter.utf32ToUtf8(utf32, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf8ToUtf32Visual)
+{
+  const std::string text = CreateUtf8Text();
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::u32string result;
+    g_charsetConverter.utf8ToUtf32Visual(text, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
+
+XBMC_BENCHMARK(CharsetConverter, Utf16LEToUtf8)
+{
+  const std::string text = CreateAsciiText();
+  std::u16string utf16;
+  g_charsetConverter.utf8To("UTF-16LE", text, utf16);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string result;
+    g_charsetConverter.utf16LEtoUTF8(utf16, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * utf16.size() * sizeof(char16_t));
+}
+
+XBMC_BENCHMARK(CharsetConverter, UnknownToUtf8)
+{
+  const std::string text = CreateUtf8Text();
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string result;
+    g_charsetConverter.unknownToUTF8(text, result);
+    BenchmarkKeep(result);
+  }
+  state.SetBytesProcessed(state.Iterations() * text.size());
+}
@@ -0,0 +1,84 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "cores/VideoPlayer/DVDMessageQueue.h"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+// producers put regular messages while one consumer takes them off the queue
+void MessageQueueThroughput(CBenchmarkState &state, bool lockFree, unsigned int producers)
+{
+  CDVDMessageQueue queue("bench");
+  queue.SetLockFree(lockFree);
+  queue.Init();
+
+  const uint64_t count = state.Iterations() / producers;
+  std::vector<std::thread> threads;
+  for (unsigned int p = 0; p < producers; p++)
+  {
+    threads.push_back(std::thread([&queue, count]() {
+      for (uint64_t i = 0; i < count; i++)
+        queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, (int)i));
+    }));
+  }
+
+  for (uint64_t received = 0; received < count * producers; received++)
+  {
+    CDVDMsg* msg = NULL;
+    if (queue.Get(&msg, 5000) != MSGQ_OK)
+    {
+      state.SetError("message queue lost a message");
+      break;
+    }
+    msg->Release();
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+  queue.End();
+
+  state.SetItemsProcessed(count * producers);
+}
+}
+
+XBMC_BENCHMARK(DVDMessageQueue, Locked1Producer)
+{
+  MessageQueueThroughput(state, false, 1);
+}
+
+XBMC_BENCHMARK(DVDMessageQueue, Locked2Producers)
+{
+  MessageQueueThroughput(state, false, 2);
+}
+
+XBMC_BENCHMARK(DVDMessageQueue, LockFree1Producer)
+{
+  MessageQueueThroughput(state, true, 1);
+}
+
+XBMC_BENCHMARK(DVDMessageQueue, LockFree2Producers)
+{
+  MessageQueueThroughput(state, true, 2);
+}
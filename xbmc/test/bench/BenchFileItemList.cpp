@@ -0,0 +1,107 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+
+#define LIST_ITEMS 50000
+
+namespace
+{
+void CreateItems(CFileItemList &items)
+{
+  // a movie folder where every fourth title is split over two files
+  items.SetPath("/media/movies/");
+  for (unsigned int i = 0; i < LIST_ITEMS; i++)
+  {
+    std::string file;
+    if (i % 4 < 2)
+      file = StringUtils::Format("Movie %u cd%u.avi", i / 4, i % 4 + 1);
+    else
+      file = StringUtils::Format("Movie %u part %u.mkv", i, i % 7);
+
+    CFileItemPtr item(new CFileItem(file));
+    item->SetPath("/media/movies/" + file);
+    item->m_dwSize = 700 * 1024 * 1024;
+    items.Add(item);
+  }
+}
+
+/*!
+ \brief Run the list operation with the given number of threads, 0 uses all CPUs.
+ */
+template<typename TOperation>
+void ProcessList(CBenchmarkState &state, int threads, TOperation operation)
+{
+  CFileItemList source;
+  CreateItems(source);
+
+  int parallelThreads = g_advancedSettings.m_parallelThreads;
+  g_advancedSettings.m_parallelThreads = threads;
+
+  CFileItemList items;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    state.PauseTiming();
+    items.Clear();
+    items.Copy(source);
+    state.ResumeTiming();
+
+    operation(items);
+    BenchmarkKeep(items);
+  }
+
+  g_advancedSettings.m_parallelThreads = parallelThreads;
+  state.SetItemsProcessed(state.Iterations() * LIST_ITEMS);
+}
+
+void SortList(CFileItemList &items)
+{
+  items.Sort(SortByLabel, SortOrderAscending);
+}
+
+void StackList(CFileItemList &items)
+{
+  items.Stack();
+}
+}
+
+XBMC_BENCHMARK(FileItemList, SortSerial)
+{
+  ProcessList(state, 1, SortList);
+}
+
+XBMC_BENCHMARK(FileItemList, SortParallel)
+{
+  ProcessList(state, 0, SortList);
+}
+
+XBMC_BENCHMARK(FileItemList, StackSerial)
+{
+  ProcessList(state, 1, StackList);
+}
+
+XBMC_BENCHMARK(FileItemList, StackParallel)
+{
+  ProcessList(state, 0, StackList);
+}
@@ -0,0 +1,130 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "FileItem.h"
+#include "utils/DatabaseUtils.h"
+#include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#define SORT_ITEMS 10000
+
+namespace
+{
+const char *words[] = { "The", "Return", "of", "a", "Night", "Day", "Last", "First", "Star", "Man", "Women", "Story" };
+
+std::string RandomTitle(unsigned int &seed)
+{
+  std::string title;
+  for (int i = 0; i < 4; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    if (!title.empty())
+      title += " ";
+    title += words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+  }
+  seed = seed * 1103515245 + 12345;
+  return title + StringUtils::Format(" %u", (seed >> 16) % 100);
+}
+
+void CreateItems(CFileItemList &items, unsigned int count)
+{
+  unsigned int seed = 42;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    std::string title = RandomTitle(seed);
+    CFileItemPtr item(new CFileItem(title));
+    item->SetPath(StringUtils::Format("/media/movies/%s/%s.mkv", title.c_str(), title.c_str()));
+    item->m_dwSize = static_cast<int64_t>(seed) * 1024;
+    item->m_dateTime = CDateTime(2000 + seed % 17, 1 + seed % 12, 1 + seed % 28, seed % 24, seed % 60, 0);
+    items.Add(item);
+  }
+}
+
+void SortFileItems(CBenchmarkState &state, SortBy sortBy, SortAttribute attributes)
+{
+  CFileItemList source;
+  CreateItems(source, SORT_ITEMS);
+
+  CFileItemList items;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    state.PauseTiming();
+    items.Assign(source);
+    state.ResumeTiming();
+
+    items.Sort(sortBy, SortOrderAscending, attributes);
+    BenchmarkKeep(items);
+  }
+  state.SetItemsProcessed(state.Iterations() * SORT_ITEMS);
+}
+}
+
+XBMC_BENCHMARK(SortUtils, FileItemListByLabel)
+{
+  SortFileItems(state, SortByLabel, SortAttributeNone);
+}
+
+XBMC_BENCHMARK(SortUtils, FileItemListByLabelIgnoreArticle)
+{
+  SortFileItems(state, SortByLabel, SortAttributeIgnoreArticle);
+}
+
+XBMC_BENCHMARK(SortUtils, FileItemListByFile)
+{
+  SortFileItems(state, SortByFile, SortAttributeNone);
+}
+
+XBMC_BENCHMARK(SortUtils, FileItemListBySize)
+{
+  SortFileItems(state, SortBySize, SortAttributeNone);
+}
+
+XBMC_BENCHMARK(SortUtils, FileItemListByDate)
+{
+  SortFileItems(state, SortByDate, SortAttributeNone);
+}
+
+XBMC_BENCHMARK(SortUtils, DatabaseResultsByTitle)
+{
+  DatabaseResults source;
+  unsigned int seed = 42;
+  for (unsigned int i = 0; i < SORT_ITEMS; i++)
+  {
+    DatabaseResult result;
+    result[FieldTitle] = RandomTitle(seed);
+    result[FieldYear] = 1950 + static_cast<int>(seed % 68);
+    source.push_back(result);
+  }
+
+  DatabaseResults results;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    state.PauseTiming();
+    results = source;
+    state.ResumeTiming();
+
+    SortUtils::Sort(SortByTitle, SortOrderAscending, SortAttributeNone, results);
+    BenchmarkKeep(results);
+  }
+  state.SetItemsProcessed(state.Iterations() * SORT_ITEMS);
+}
@@ -0,0 +1,145 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "utils/StringUtils.h"
+
+#include <vector>
+
+namespace
+{
+const std::string sentence = "  The Quick Brown Fox Jumps Over The Lazy Dog, Again And Again And Again  ";
+const std::string path = "smb://server/share/Movies/Some Movie (2017)/Some.Movie.2017.1080p.BluRay.x264.mkv";
+}
+
+XBMC_BENCHMARK(StringUtils, Format)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string result = StringUtils::Format("%s/%05d - %.2f%%", "prefix", static_cast<int>(i), 12.5);
+    BenchmarkKeep(result);
+  }
+  state.SetItemsProcessed(state.Iterations());
+}
+
+XBMC_BENCHMARK(StringUtils, ToLower)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string str(sentence);
+    StringUtils::ToLower(str);
+    BenchmarkKeep(str);
+  }
+  state.SetBytesProcessed(state.Iterations() * sentence.size());
+}
+
+XBMC_BENCHMARK(StringUtils, EqualsNoCase)
+{
+  const std::string other = "  the quick brown fox jumps over the lazy dog, again and again and again  ";
+  uint64_t equal = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+    equal += StringUtils::EqualsNoCase(sentence, other) ? 1 : 0;
+  BenchmarkKeep(equal);
+  state.SetBytesProcessed(state.Iterations() * sentence.size());
+}
+
+XBMC_BENCHMARK(StringUtils, Trim)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string str(sentence);
+    StringUtils::Trim(str);
+    BenchmarkKeep(str);
+  }
+  state.SetItemsProcessed(state.Iterations());
+}
+
+XBMC_BENCHMARK(StringUtils, Replace)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string str(sentence);
+    StringUtils::Replace(str, "Again", "Once more");
+    BenchmarkKeep(str);
+  }
+  state.SetBytesProcessed(state.Iterations() * sentence.size());
+}
+
+XBMC_BENCHMARK(StringUtils, Split)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::vector<std::string> parts = StringUtils::Split(path, "/");
+    BenchmarkKeep(parts);
+  }
+  state.SetBytesProcessed(state.Iterations() * path.size());
+}
+
+XBMC_BENCHMARK(StringUtils, Join)
+{
+  const std::vector<std::string> parts = StringUtils::Split(path, "/");
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string joined = StringUtils::Join(parts, "/");
+    BenchmarkKeep(joined);
+  }
+  state.SetBytesProcessed(state.Iterations() * path.size());
+}
+
+XBMC_BENCHMARK(StringUtils, Tokenize)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::vector<std::string> tokens = StringUtils::Tokenize(sentence, " ,");
+    BenchmarkKeep(tokens);
+  }
+  state.SetBytesProcessed(state.Iterations() * sentence.size());
+}
+
+XBMC_BENCHMARK(StringUtils, AlphaNumericCompare)
+{
+  const wchar_t *left = L"Episode 10 - The Return of the Thing, Part 2";
+  const wchar_t *right = L"Episode 9 - The Return of the Thing, Part 12";
+  int64_t total = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+    total += StringUtils::AlphaNumericCompare(left, right);
+  BenchmarkKeep(total);
+  state.SetItemsProcessed(state.Iterations());
+}
+
+XBMC_BENCHMARK(StringUtils, FindWords)
+{
+  size_t total = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+    total += StringUtils::FindWords(sentence.c_str(), "lazy");
+  BenchmarkKeep(total);
+  state.SetBytesProcessed(state.Iterations() * sentence.size());
+}
+
+XBMC_BENCHMARK(StringUtils, SizeToString)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string size = StringUtils::SizeToString(static_cast<int64_t>(i) * 7919);
+    BenchmarkKeep(size);
+  }
+  state.SetItemsProcessed(state.Iterations());
+}
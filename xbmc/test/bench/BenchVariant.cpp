@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+namespace
+{
+// roughly the shape of a VideoLibrary.GetMovies response
+CVariant CreateMovieList(unsigned int count)
+{
+  CVariant result(CVariant::VariantTypeObject);
+  result["limits"]["start"] = 0;
+  result["limits"]["end"] = count;
+  result["limits"]["total"] = count;
+  result["movies"] = CVariant(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    CVariant movie(CVariant::VariantTypeObject);
+    movie["movieid"] = i;
+    movie["label"] = StringUtils::Format("Movie title number %u", i);
+    movie["file"] = StringUtils::Format("smb://server/share/movies/Movie %u (2017)/movie.mkv", i);
+    movie["rating"] = 5.0 + (i % 50) / 10.0;
+    movie["year"] = 1950 + static_cast<int>(i % 68);
+    movie["playcount"] = static_cast<int>(i % 3);
+    movie["genre"].push_back("Drama");
+    movie["genre"].push_back("Thriller");
+    movie["plot"] = "A long plot outline that is there to make the strings a realistic size for the benchmark.";
+    result["movies"].push_back(movie);
+  }
+  return result;
+}
+}
+
+XBMC_BENCHMARK(CVariant, ConstructObject)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    CVariant value(CVariant::VariantTypeObject);
+    value["id"] = static_cast<int>(i);
+    value["label"] = "label";
+    value["enabled"] = true;
+    value["rating"] = 7.5;
+    BenchmarkKeep(value);
+  }
+  state.SetItemsProcessed(state.Iterations());
+}
+
+XBMC_BENCHMARK(CVariant, ConstructArray)
+{
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    CVariant value(CVariant::VariantTypeArray);
+    for (int j = 0; j < 100; j++)
+      value.push_back(j);
+    BenchmarkKeep(value);
+  }
+  state.SetItemsProcessed(state.Iterations() * 100);
+}
+
+XBMC_BENCHMARK(CVariant, CopyNested)
+{
+  const CVariant source = CreateMovieList(100);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    CVariant copy(source);
+    BenchmarkKeep(copy);
+  }
+  state.SetItemsProcessed(state.Iterations() * 100);
+}
+
+XBMC_BENCHMARK(CVariant, Lookup)
+{
+  const CVariant source = CreateMovieList(100);
+  uint64_t total = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    const CVariant &movie = source["movies"][i % 100];
+    total += movie["movieid"].asUnsignedInteger() + movie["label"].asString().size();
+  }
+  BenchmarkKeep(total);
+  state.SetItemsProcessed(state.Iterations());
+}
+
+XBMC_BENCHMARK(JSON, Write)
+{
+  const CVariant source = CreateMovieList(100);
+  uint64_t bytes = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string json = CJSONVariantWriter::Write(source, true);
+    bytes += json.size();
+    BenchmarkKeep(json);
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+XBMC_BENCHMARK(JSON, WritePretty)
+{
+  const CVariant source = CreateMovieList(100);
+  uint64_t bytes = 0;
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    std::string json = CJSONVariantWriter::Write(source, false);
+    bytes += json.size();
+    BenchmarkKeep(json);
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+XBMC_BENCHMARK(JSON, Parse)
+{
+  const std::string json = CJSONVariantWriter::Write(CreateMovieList(100), true);
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    CVariant value = CJSONVariantParser::Parse(json);
+    if (value["movies"].size() != 100)
+    {
+      state.SetError("unexpected parse result");
+      return;
+    }
+    BenchmarkKeep(value);
+  }
+  state.SetBytesProcessed(state.Iterations() * json.size());
+}
+
+XBMC_BENCHMARK(JSON, ParseRequest)
+{
+  const std::string json = "{\"jsonrpc\":\"2.0\",\"method\":\"Player.GetProperties\",\"id\":1,"
+                           "\"params\":{\"playerid\":1,\"properties\":[\"time\",\"totaltime\",\"percentage\",\"speed\"]}}";
+  for (uint64_t i = 0; i < state.Iterations(); i++)
+  {
+    CVariant value = CJSONVariantParser::Parse(json);
+    BenchmarkKeep(value);
+  }
+  state.SetItemsProcessed(state.Iterations());
+  state.SetBytesProcessed(state.Iterations() * json.size());
+}
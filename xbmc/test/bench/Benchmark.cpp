@@ -0,0 +1,315 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "CompileInfo.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// upper bound for the calibration so a broken benchmark can't run forever
+#define BENCHMARK_MAX_ITERATIONS 1000000000ULL
+
+CBenchmarkState::CBenchmarkState(uint64_t iterations)
+  : m_iterations(iterations)
+  , m_started(0)
+  , m_elapsed(0)
+  , m_running(false)
+  , m_bytes(0)
+  , m_items(0)
+{
+}
+
+void CBenchmarkState::Start()
+{
+  m_elapsed = 0;
+  ResumeTiming();
+}
+
+void CBenchmarkState::Stop()
+{
+  PauseTiming();
+}
+
+void CBenchmarkState::PauseTiming()
+{
+  if (!m_running)
+    return;
+  m_elapsed += CurrentHostCounter() - m_started;
+  m_running = false;
+}
+
+void CBenchmarkState::ResumeTiming()
+{
+  if (m_running)
+    return;
+  m_started = CurrentHostCounter();
+  m_running = true;
+}
+
+BenchmarkOptions::BenchmarkOptions()
+  : format("text")
+  , repetitions(5)
+  , minTime(100)
+  , list(false)
+{
+}
+
+CBenchmarkRegistry &CBenchmarkRegistry::GetInstance()
+{
+  static CBenchmarkRegistry registry;
+  return registry;
+}
+
+void CBenchmarkRegistry::Register(const std::string &name, BenchmarkFunction function)
+{
+  m_benchmarks.push_back(std::make_pair(name, function));
+}
+
+void CBenchmarkRegistry::RegisterCleanup(BenchmarkCleanup cleanup)
+{
+  if (std::find(m_cleanups.begin(), m_cleanups.end(), cleanup) == m_cleanups.end())
+    m_cleanups.push_back(cleanup);
+}
+
+BenchmarkResult CBenchmarkRegistry::RunOne(const std::string &name, BenchmarkFunction function, const BenchmarkOptions &options)
+{
+  BenchmarkResult result;
+  result.name = name;
+  result.iterations = 0;
+  result.repetitions = 0;
+  result.minNs = result.medianNs = result.meanNs = result.stddevNs = 0.0;
+  result.bytesPerSecond = result.itemsPerSecond = 0.0;
+
+  const double frequency = static_cast<double>(CurrentHostFrequency());
+  const int64_t minTicks = static_cast<int64_t>(frequency * options.minTime / 1000.0);
+
+  // find an iteration count which makes a single run last at least minTime
+  uint64_t iterations = 1;
+  while (true)
+  {
+    CBenchmarkState state(iterations);
+    state.Start();
+    function(state);
+    state.Stop();
+
+    if (!state.Error().empty())
+    {
+      result.error = state.Error();
+      return result;
+    }
+    if (state.ElapsedTicks() >= minTicks || iterations >= BENCHMARK_MAX_ITERATIONS)
+      break;
+
+    // aim slightly above the target, but grow by at most 10x per step
+    double scale = 10.0;
+    if (state.ElapsedTicks() > 0)
+      scale = std::min(10.0, std::max(1.5, 1.4 * minTicks / state.ElapsedTicks()));
+    iterations = std::min<uint64_t>(BENCHMARK_MAX_ITERATIONS,
+                                    static_cast<uint64_t>(iterations * scale) + 1);
+  }
+
+  std::vector<double> perIteration;
+  std::vector<std::pair<uint64_t, uint64_t> > processed;
+  std::vector<std::map<std::string, double> > counters;
+  for (unsigned int i = 0; i < std::max(1U, options.repetitions); i++)
+  {
+    CBenchmarkState state(iterations);
+    state.Start();
+    function(state);
+    state.Stop();
+
+    if (!state.Error().empty())
+    {
+      result.error = state.Error();
+      return result;
+    }
+    perIteration.push_back(state.ElapsedTicks() * 1e9 / frequency / iterations);
+    processed.push_back(std::make_pair(state.BytesProcessed(), state.ItemsProcessed()));
+    counters.push_back(state.Counters());
+  }
+
+  result.iterations = iterations;
+  result.repetitions = perIteration.size();
+
+  double sum = 0.0;
+  for (std::vector<double>::const_iterator it = perIteration.begin(); it != perIteration.end(); ++it)
+    sum += *it;
+  result.meanNs = sum / perIteration.size();
+
+  double variance = 0.0;
+  for (std::vector<double>::const_iterator it = perIteration.begin(); it != perIteration.end(); ++it)
+    variance += (*it - result.meanNs) * (*it - result.meanNs);
+  result.stddevNs = std::sqrt(variance / perIteration.size());
+
+  std::vector<double> sorted(perIteration);
+  std::sort(sorted.begin(), sorted.end());
+  result.minNs = sorted.front();
+  result.medianNs = sorted[sorted.size() / 2];
+
+  // throughput of the median run, using what that run reported
+  size_t median = std::find(perIteration.begin(), perIteration.end(), result.medianNs) - perIteration.begin();
+  result.counters = counters[median];
+  double seconds = result.medianNs * iterations / 1e9;
+  if (seconds > 0.0)
+  {
+    result.bytesPerSecond = processed[median].first / seconds;
+    result.itemsPerSecond = processed[median].second / seconds;
+  }
+
+  return result;
+}
+
+static void WriteText(FILE *out, const std::vector<BenchmarkResult> &results)
+{
+  fprintf(out, "%-48s %12s %14s %14s %10s %14s %14s\n",
+          "benchmark", "iterations", "median ns", "min ns", "stddev %", "MB/s", "items/s");
+  for (std::vector<BenchmarkResult>::const_iterator it = results.begin(); it != results.end(); ++it)
+  {
+    if (!it->error.empty())
+    {
+      fprintf(out, "%-48s ERROR: %s\n", it->name.c_str(), it->error.c_str());
+      continue;
+    }
+    fprintf(out, "%-48s %12llu %14.1f %14.1f %10.2f %14.2f %14.0f\n",
+            it->name.c_str(), static_cast<unsigned long long>(it->iterations),
+            it->medianNs, it->minNs,
+            it->meanNs > 0.0 ? 100.0 * it->stddevNs / it->meanNs : 0.0,
+            it->bytesPerSecond / (1024.0 * 1024.0), it->itemsPerSecond);
+    for (std::map<std::string, double>::const_iterator counter = it->counters.begin(); counter != it->counters.end(); ++counter)
+      fprintf(out, "    %-44s %14.3f\n", counter->first.c_str(), counter->second);
+  }
+}
+
+static void WriteCSV(FILE *out, const std::vector<BenchmarkResult> &results)
+{
+  fprintf(out, "name,iterations,repetitions,median_ns,min_ns,mean_ns,stddev_ns,bytes_per_second,items_per_second,counters,error\n");
+  for (std::vector<BenchmarkResult>::const_iterator it = results.begin(); it != results.end(); ++it)
+  {
+    std::string error(it->error);
+    StringUtils::Replace(error, "\"", "\"\"");
+    std::string counters;
+    for (std::map<std::string, double>::const_iterator counter = it->counters.begin(); counter != it->counters.end(); ++counter)
+      counters += StringUtils::Format("%s%s=%.3f", counters.empty() ? "" : ";", counter->first.c_str(), counter->second);
+    fprintf(out, "%s,%llu,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,\"%s\",\"%s\"\n",
+            it->name.c_str(), static_cast<unsigned long long>(it->iterations), it->repetitions,
+            it->medianNs, it->minNs, it->meanNs, it->stddevNs,
+            it->bytesPerSecond, it->itemsPerSecond, counters.c_str(), error.c_str());
+  }
+}
+
+static void WriteJSON(FILE *out, const std::vector<BenchmarkResult> &results, const BenchmarkOptions &options)
+{
+  CVariant report(CVariant::VariantTypeObject);
+  report["context"]["application"] = CCompileInfo::GetAppName();
+  report["context"]["version"] = StringUtils::Format("%d.%d", CCompileInfo::GetMajor(), CCompileInfo::GetMinor());
+  report["context"]["revision"] = CCompileInfo::GetSCMID();
+  report["context"]["date"] = __DATE__;
+  report["context"]["repetitions"] = options.repetitions;
+  report["context"]["mintime_ms"] = options.minTime;
+  report["benchmarks"] = CVariant(CVariant::VariantTypeArray);
+
+  for (std::vector<BenchmarkResult>::const_iterator it = results.begin(); it != results.end(); ++it)
+  {
+    CVariant entry(CVariant::VariantTypeObject);
+    entry["name"] = it->name;
+    if (!it->error.empty())
+      entry["error"] = it->error;
+    else
+    {
+      entry["iterations"] = it->iterations;
+      entry["repetitions"] = it->repetitions;
+      entry["median_ns"] = it->medianNs;
+      entry["min_ns"] = it->minNs;
+      entry["mean_ns"] = it->meanNs;
+      entry["stddev_ns"] = it->stddevNs;
+      if (it->bytesPerSecond > 0.0)
+        entry["bytes_per_second"] = it->bytesPerSecond;
+      if (it->itemsPerSecond > 0.0)
+        entry["items_per_second"] = it->itemsPerSecond;
+      for (std::map<std::string, double>::const_iterator counter = it->counters.begin(); counter != it->counters.end(); ++counter)
+        entry["counters"][counter->first] = counter->second;
+    }
+    report["benchmarks"].push_back(entry);
+  }
+
+  fprintf(out, "%s\n", CJSONVariantWriter::Write(report, false).c_str());
+}
+
+int CBenchmarkRegistry::Run(const BenchmarkOptions &options)
+{
+  std::vector<std::pair<std::string, BenchmarkFunction> > selected;
+  for (std::vector<std::pair<std::string, BenchmarkFunction> >::const_iterator it = m_benchmarks.begin(); it != m_benchmarks.end(); ++it)
+  {
+    if (options.filter.empty() || it->first.find(options.filter) != std::string::npos)
+      selected.push_back(*it);
+  }
+  std::sort(selected.begin(), selected.end());
+
+  if (options.list)
+  {
+    for (std::vector<std::pair<std::string, BenchmarkFunction> >::const_iterator it = selected.begin(); it != selected.end(); ++it)
+      printf("%s\n", it->first.c_str());
+    return 0;
+  }
+
+  FILE *out = stdout;
+  if (!options.output.empty())
+  {
+    out = fopen(options.output.c_str(), "w");
+    if (!out)
+    {
+      fprintf(stderr, "Unable to open %s for writing.\n", options.output.c_str());
+      return 1;
+    }
+  }
+
+  bool failed = false;
+  std::vector<BenchmarkResult> results;
+  for (std::vector<std::pair<std::string, BenchmarkFunction> >::const_iterator it = selected.begin(); it != selected.end(); ++it)
+  {
+    // progress goes to stderr so stdout stays machine-readable
+    fprintf(stderr, "running %s\n", it->first.c_str());
+    results.push_back(RunOne(it->first, it->second, options));
+    if (!results.back().error.empty())
+      failed = true;
+  }
+
+  for (std::vector<BenchmarkCleanup>::const_iterator it = m_cleanups.begin(); it != m_cleanups.end(); ++it)
+    (*it)();
+
+  if (options.format == "json")
+    WriteJSON(out, results, options);
+  else if (options.format == "csv")
+    WriteCSV(out, results);
+  else
+    WriteText(out, results);
+
+  if (out != stdout)
+    fclose(out);
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Per-run state handed to a benchmark function.
+
+ A benchmark body performs Iterations() repetitions of the operation being
+ measured. Setup that should not be part of the measurement can be
+ bracketed with PauseTiming()/ResumeTiming(). Throughput is reported when
+ the body tells how many bytes or items it processed in total.
+ */
+class CBenchmarkState
+{
+public:
+  explicit CBenchmarkState(uint64_t iterations);
+
+  uint64_t Iterations() const { return m_iterations; }
+
+  void PauseTiming();
+  void ResumeTiming();
+
+  void SetBytesProcessed(uint64_t bytes) { m_bytes = bytes; }
+  void SetItemsProcessed(uint64_t items) { m_items = items; }
+
+  /*!
+   \brief Report a benchmark specific measurement, e.g. a latency
+   Counters of the median run are included in the report.
+   */
+  void SetCounter(const std::string &name, double value) { m_counters[name] = value; }
+
+  /*!
+   \brief Report a failure, the result of the benchmark is discarded.
+   */
+  void SetError(const std::string &error) { m_error = error; }
+
+  // used by the runner
+  void Start();
+  void Stop();
+  int64_t ElapsedTicks() const { return m_elapsed; }
+  uint64_t BytesProcessed() const { return m_bytes; }
+  uint64_t ItemsProcessed() const { return m_items; }
+  const std::map<std::string, double> &Counters() const { return m_counters; }
+  const std::string &Error() const { return m_error; }
+
+private:
+  uint64_t m_iterations;
+  int64_t m_started;
+  int64_t m_elapsed;
+  bool m_running;
+  uint64_t m_bytes;
+  uint64_t m_items;
+  std::map<std::string, double> m_counters;
+  std::string m_error;
+};
+
+typedef void (*BenchmarkFunction)(CBenchmarkState &state);
+typedef void (*BenchmarkCleanup)();
+
+struct BenchmarkOptions
+{
+  BenchmarkOptions();
+
+  std::string filter;       //!< only run benchmarks whose name contains this
+  std::string format;       //!< "text", "json" or "csv"
+  std::string output;       //!< write results to this file instead of stdout
+  unsigned int repetitions; //!< measured runs per benchmark
+  unsigned int minTime;     //!< minimum duration of a single run in ms
+  bool list;                //!< only list the registered benchmarks
+};
+
+struct BenchmarkResult
+{
+  std::string name;
+  uint64_t iterations;
+  unsigned int repetitions;
+  double minNs;      //!< fastest run, ns per iteration
+  double medianNs;   //!< median run, ns per iteration
+  double meanNs;     //!< mean of all runs, ns per iteration
+  double stddevNs;
+  double bytesPerSecond; //!< based on the median run, 0 if not reported
+  double itemsPerSecond; //!< based on the median run, 0 if not reported
+  std::map<std::string, double> counters; //!< reported by the median run
+  std::string error;
+};
+
+class CBenchmarkRegistry
+{
+public:
+  static CBenchmarkRegistry &GetInstance();
+
+  void Register(const std::string &name, BenchmarkFunction function);
+
+  /*!
+   \brief Register a function to run once all benchmarks have finished
+   Benchmarks sharing expensive state, e.g. a running engine, use this to tear it down.
+   */
+  void RegisterCleanup(BenchmarkCleanup cleanup);
+
+  /*!
+   \brief Run all benchmarks matching the options and write the report.
+   \return 0 on success, 1 if any benchmark reported an error
+   */
+  int Run(const BenchmarkOptions &options);
+
+private:
+  CBenchmarkRegistry() {}
+  BenchmarkResult RunOne(const std::string &name, BenchmarkFunction function, const BenchmarkOptions &options);
+
+  std::vector<std::pair<std::string, BenchmarkFunction> > m_benchmarks;
+  std::vector<BenchmarkCleanup> m_cleanups;
+};
+
+class CBenchmarkRegistrar
+{
+public:
+  CBenchmarkRegistrar(const char *name, BenchmarkFunction function)
+  {
+    CBenchmarkRegistry::GetInstance().Register(name, function);
+  }
+};
+
+/*!
+ \brief Keep the compiler from optimizing away a value computed by a benchmark.
+ */
+template<typename T>
+inline void BenchmarkKeep(const T &value)
+{
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static const void * volatile sink;
+  sink = &value;
+#endif
+}
+
+#define XBMC_BENCHMARK(group, name) \
+  static void Benchmark_##group##_##name(CBenchmarkState &state); \
+  static CBenchmarkRegistrar BenchmarkRegistrar_##group##_##name(#group "." #name, Benchmark_##group##_##name); \
+  static void Benchmark_##group##_##name(CBenchmarkState &state)
@@ -0,0 +1,83 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "test/TestBasicEnvironment.h"
+#include "utils/StringUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+static void PrintUsage(const char *program)
+{
+  printf("Usage: %s [options]\n"
+         "  --filter=<text>      only run benchmarks whose name contains <text>\n"
+         "  --format=<format>    output format: text (default), json or csv\n"
+         "  --output=<file>      write the results to <file> instead of stdout\n"
+         "  --repetitions=<n>    measured runs per benchmark (default 5)\n"
+         "  --min-time=<ms>      minimum duration of a single run (default 100)\n"
+         "  --list               list the benchmarks and exit\n",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+  BenchmarkOptions options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    if (StringUtils::StartsWith(arg, "--filter="))
+      options.filter = arg.substr(9);
+    else if (StringUtils::StartsWith(arg, "--format="))
+      options.format = arg.substr(9);
+    else if (StringUtils::StartsWith(arg, "--output="))
+      options.output = arg.substr(9);
+    else if (StringUtils::StartsWith(arg, "--repetitions="))
+      options.repetitions = strtoul(arg.c_str() + 14, NULL, 10);
+    else if (StringUtils::StartsWith(arg, "--min-time="))
+      options.minTime = strtoul(arg.c_str() + 11, NULL, 10);
+    else if (arg == "--list")
+      options.list = true;
+    else
+    {
+      PrintUsage(argv[0]);
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  if (options.format != "text" && options.format != "json" && options.format != "csv")
+  {
+    fprintf(stderr, "Unknown output format %s.\n", options.format.c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (options.list)
+    return CBenchmarkRegistry::GetInstance().Run(options);
+
+  // same environment as the unit tests, some code paths need settings
+  TestBasicEnvironment environment;
+  environment.SetUp();
+  int ret = CBenchmarkRegistry::GetInstance().Run(options);
+  environment.TearDown();
+
+  return ret;
+}
@@ -22,6 +22,7 @@
 
 #include <cerrno>
 #include <algorithm>
+#include <stdint.h>
 
 #include <iconv.h>
 #include <fribidi/fribidi.h>
@@ -87,6 +88,12 @@
   #endif
 #endif
 
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+  #include <arm_neon.h>
+#endif
+
 #define NO_ICONV ((iconv_t)-1)
 
 enum SpecialCharset
@@ -325,6 +332,328 @@ CConverterType CCharsetConverter::CInnerConverter::m_stdConversion[NumberOfStdCo
 
 CCriticalSection CCharsetConverter::CInnerConverter::m_critSectionFriBiDi;
 
+/* Conversions between UTF-8, UTF-16 and UTF-32 are done without iconv. The
+   encoding follows from the size of the string's code units, wchar_t holds
+   UTF-16 or UTF-32 depending on the platform. Like iconv, invalid input is
+   either skipped or fails the conversion. */
+
+static const uint32_t InvalidCodePoint = 0xFFFFFFFF;
+
+static inline bool IsValidCodePoint(uint32_t codePoint)
+{
+  return codePoint < 0xD800 || (codePoint > 0xDFFF && codePoint <= 0x10FFFF);
+}
+
+template<size_t UNIT_SIZE>
+struct CUnicodeUnit;
+
+template<>
+struct CUnicodeUnit<1> // UTF-8
+{
+  template<class CHAR>
+  static inline uint32_t Decode(const CHAR*& str, const CHAR* end, bool /* swap */)
+  {
+    const unsigned char* const strU = (const unsigned char*)str;
+    const unsigned char lead = strU[0];
+    size_t length;
+    uint32_t codePoint, minimum;
+
+    if (lead < 0x80)
+    {
+      str++;
+      return lead;
+    }
+    else if (lead >= 0xC2 && lead <= 0xDF)
+    {
+      length = 2;
+      codePoint = lead & 0x1F;
+      minimum = 0x80;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+      length = 3;
+      codePoint = lead & 0x0F;
+      minimum = 0x800;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+      length = 4;
+      codePoint = lead & 0x07;
+      minimum = 0x10000;
+    }
+    else
+    {
+      str++;
+      return InvalidCodePoint;
+    }
+
+    if ((size_t)(end - str) < length)
+    {
+      str++;
+      return InvalidCodePoint;
+    }
+
+    for (size_t i = 1; i < length; i++)
+    {
+      if ((strU[i] & 0xC0) != 0x80)
+      {
+        str++;
+        return InvalidCodePoint;
+      }
+      codePoint = (codePoint << 6) | (strU[i] & 0x3F);
+    }
+
+    /* reject overlong forms, surrogates and values above U+10FFFF */
+    if (codePoint < minimum || !IsValidCodePoint(codePoint))
+    {
+      str++;
+      return InvalidCodePoint;
+    }
+
+    str += length;
+    return codePoint;
+  }
+
+  template<class STRING>
+  static inline void Append(STRING& str, uint32_t codePoint)
+  {
+    typedef typename STRING::value_type CHAR;
+    if (codePoint < 0x80)
+      str.push_back((CHAR)codePoint);
+    else if (codePoint < 0x800)
+    {
+      str.push_back((CHAR)(0xC0 | (codePoint >> 6)));
+      str.push_back((CHAR)(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+      str.push_back((CHAR)(0xE0 | (codePoint >> 12)));
+      str.push_back((CHAR)(0x80 | ((codePoint >> 6) & 0x3F)));
+      str.push_back((CHAR)(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+      str.push_back((CHAR)(0xF0 | (codePoint >> 18)));
+      str.push_back((CHAR)(0x80 | ((codePoint >> 12) & 0x3F)));
+      str.push_back((CHAR)(0x80 | ((codePoint >> 6) & 0x3F)));
+      str.push_back((CHAR)(0x80 | (codePoint & 0x3F)));
+    }
+  }
+};
+
+template<>
+struct CUnicodeUnit<2> // UTF-16
+{
+  template<class CHAR>
+  static inline uint32_t Read(CHAR unit, bool swap)
+  {
+    const uint16_t value = (uint16_t)unit;
+    return swap ? (uint16_t)((value >> 8) | (value << 8)) : value;
+  }
+
+  template<class CHAR>
+  static inline uint32_t Decode(const CHAR*& str, const CHAR* end, bool swap)
+  {
+    const uint32_t unit = Read(*str++, swap);
+    if (unit < 0xD800 || unit > 0xDFFF)
+      return unit;
+
+    /* a high surrogate must be followed by a low one */
+    if (unit <= 0xDBFF && str < end)
+    {
+      const uint32_t low = Read(*str, swap);
+      if (low >= 0xDC00 && low <= 0xDFFF)
+      {
+        str++;
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+      }
+    }
+    return InvalidCodePoint;
+  }
+
+  template<class STRING>
+  static inline void Append(STRING& str, uint32_t codePoint)
+  {
+    typedef typename STRING::value_type CHAR;
+    if (codePoint < 0x10000)
+      str.push_back((CHAR)codePoint);
+    else
+    {
+      codePoint -= 0x10000;
+      str.push_back((CHAR)(0xD800 + (codePoint >> 10)));
+      str.push_back((CHAR)(0xDC00 + (codePoint & 0x3FF)));
+    }
+  }
+};
+
+template<>
+struct CUnicodeUnit<4> // UTF-32
+{
+  template<class CHAR>
+  static inline uint32_t Decode(const CHAR*& str, const CHAR* /* end */, bool /* swap */)
+  {
+    const uint32_t codePoint = (uint32_t)*str++;
+    return IsValidCodePoint(codePoint) ? codePoint : InvalidCodePoint;
+  }
+
+  template<class STRING>
+  static inline void Append(STRING& str, uint32_t codePoint)
+  {
+    str.push_back((typename STRING::value_type)codePoint);
+  }
+};
+
+/* length of the run of ASCII characters at the start of str */
+static inline size_t AsciiRunLength(const unsigned char* str, size_t length)
+{
+  size_t pos = 0;
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+  for (; pos + 16 <= length; pos += 16)
+  {
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(str + pos))) != 0)
+      break;
+  }
+#elif defined(__ARM_NEON__)
+  for (; pos + 16 <= length; pos += 16)
+  {
+    const uint64x2_t chunk = vreinterpretq_u64_u8(vld1q_u8(str + pos));
+    if (((vgetq_lane_u64(chunk, 0) | vgetq_lane_u64(chunk, 1)) & 0x8080808080808080ULL) != 0)
+      break;
+  }
+#endif
+  while (pos < length && str[pos] < 0x80)
+    pos++;
+  return pos;
+}
+
+/* copy ASCII characters to wider code units */
+template<class CHAR>
+static inline void WidenAscii(const unsigned char* src, size_t length, CHAR* dst)
+{
+  size_t pos = 0;
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; sizeof(CHAR) > 1 && pos + 16 <= length; pos += 16)
+  {
+    const __m128i chunk = _mm_loadu_si128((const __m128i*)(src + pos));
+    const __m128i low = _mm_unpacklo_epi8(chunk, zero);
+    const __m128i high = _mm_unpackhi_epi8(chunk, zero);
+    __m128i* out = (__m128i*)(dst + pos);
+    if (sizeof(CHAR) == 2)
+    {
+      _mm_storeu_si128(out, low);
+      _mm_storeu_si128(out + 1, high);
+    }
+    else
+    {
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(low, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+    }
+  }
+#elif defined(__ARM_NEON__)
+  for (; sizeof(CHAR) > 1 && pos + 16 <= length; pos += 16)
+  {
+    const uint8x16_t chunk = vld1q_u8(src + pos);
+    const uint16x8_t low = vmovl_u8(vget_low_u8(chunk));
+    const uint16x8_t high = vmovl_u8(vget_high_u8(chunk));
+    if (sizeof(CHAR) == 2)
+    {
+      vst1q_u16((uint16_t*)(dst + pos), low);
+      vst1q_u16((uint16_t*)(dst + pos + 8), high);
+    }
+    else
+    {
+      vst1q_u32((uint32_t*)(dst + pos), vmovl_u16(vget_low_u16(low)));
+      vst1q_u32((uint32_t*)(dst + pos + 4), vmovl_u16(vget_high_u16(low)));
+      vst1q_u32((uint32_t*)(dst + pos + 8), vmovl_u16(vget_low_u16(high)));
+      vst1q_u32((uint32_t*)(dst + pos + 12), vmovl_u16(vget_high_u16(high)));
+    }
+  }
+#endif
+  for (; pos < length; pos++)
+    dst[pos] = (CHAR)src[pos];
+}
+
+template<class INPUT,class OUTPUT>
+static bool UnicodeConvert(const INPUT& strSource, OUTPUT& strDest, bool swapSource, bool failOnInvalidChar)
+{
+  typedef typename INPUT::value_type InputChar;
+  typedef typename OUTPUT::value_type OutputChar;
+  typedef CUnicodeUnit<sizeof(InputChar)> Decoder;
+  typedef CUnicodeUnit<sizeof(OutputChar)> Encoder;
+
+  const InputChar* str = strSource.data();
+  const InputChar* const end = str + strSource.length();
+  strDest.reserve(strSource.length());
+
+  while (str < end)
+  {
+    if (sizeof(InputChar) == 1)
+    {
+      /* most text is plain ASCII, copy runs of it without decoding */
+      const size_t run = AsciiRunLength((const unsigned char*)str, end - str);
+      if (run > 0)
+      {
+        const size_t pos = strDest.size();
+        strDest.resize(pos + run);
+        WidenAscii((const unsigned char*)str, run, &strDest[pos]);
+        str += run;
+        continue;
+      }
+    }
+
+    const uint32_t codePoint = Decoder::Decode(str, end, swapSource);
+    if (codePoint == InvalidCodePoint)
+    {
+      if (failOnInvalidChar)
+      {
+        strDest.clear();
+        return false;
+      }
+      continue; // skip invalid input
+    }
+    Encoder::Append(strDest, codePoint);
+  }
+
+  return true;
+}
+
+/* check if the conversion is between Unicode encodings which don't need iconv */
+static bool IsUnicodeConversion(StdConversionType convertType, bool& swapSource)
+{
+#ifdef WORDS_BIGENDIAN
+  static const bool swapLE = true;
+#else
+  static const bool swapLE = false;
+#endif
+
+  swapSource = false;
+  switch (convertType)
+  {
+#if !defined(TARGET_DARWIN)
+  /* UTF-8-MAC input needs the normalization done by iconv */
+  case Utf8ToUtf32:
+  case Utf8toW:
+#endif
+  case Utf32ToUtf8:
+  case Utf32ToW:
+  case WToUtf32:
+  case WtoUtf8:
+    return true;
+  case Utf16LEtoW:
+  case Utf16LEtoUtf8:
+    swapSource = swapLE;
+    return true;
+  case Utf16BEtoUtf8:
+    swapSource = !swapLE;
+    return true;
+  default:
+    return false;
+  }
+}
+
 template<class INPUT,class OUTPUT>
 bool CCharsetConverter::CInnerConverter::stdConvert(StdConversionType convertType, const INPUT& strSource, OUTPUT& strDest, bool failOnInvalidChar /*= false*/)
 {
@@ -335,6 +664,10 @@ bool CCharsetConverter::CInnerConverter::stdConvert(StdConversionType convertTyp
   if (convertType < 0 || convertType >= NumberOfStdConversionTypes)
     return false;
 
+  bool swapSource;
+  if (IsUnicodeConversion(convertType, swapSource))
+    return UnicodeConvert(strSource, strDest, swapSource, failOnInvalidChar);
+
   CConverterType& convType = m_stdConversion[convertType];
   CSingleLock converterLock(convType);
 
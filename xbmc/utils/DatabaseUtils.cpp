@@ -471,6 +471,24 @@ std::string DatabaseUtils::BuildLimitClause(int end, int start /* = 0 */)
   return sql.str();
 }
 
+std::string DatabaseUtils::BuildLimitClause(int end, int start, int &offset, int &count)
+{
+  offset = 0;
+  count = end;
+  if (start > 0)
+  {
+    offset = start;
+    if (end > 0)
+    {
+      count = end - start;
+      if (count < 0)
+        count = 0;
+    }
+  }
+
+  return " LIMIT ?,?";
+}
+
 int DatabaseUtils::GetField(Field field, const MediaType &mediaType, bool asIndex)
 {
   if (field == FieldNone || mediaType == MediaTypeNone)
@@ -165,6 +165,12 @@ public:
   static bool GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::unique_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results);
 
   static std::string BuildLimitClause(int end, int start = 0);
+  /*! \brief Build a limit clause with placeholders for prepared statements
+   \param end, start the range to limit to, as for BuildLimitClause()
+   \param offset, count the values to bind to the two placeholders, in that order
+   \return the limit clause
+   */
+  static std::string BuildLimitClause(int end, int start, int &offset, int &count);
 
 private:
   static int GetField(Field field, const MediaType &mediaType, bool asIndex);
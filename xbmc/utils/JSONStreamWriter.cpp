@@ -0,0 +1,133 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <locale>
+
+#include "JSONStreamWriter.h"
+#include "JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+namespace
+{
+// Set locale to classic ("C") while generating values to ensure valid JSON numbers
+class CNumericLocaleGuard
+{
+public:
+  CNumericLocaleGuard()
+  {
+#ifndef TARGET_WINDOWS
+    const char *currentLocale = setlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != 'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      setlocale(LC_NUMERIC, "C");
+    }
+#else  // TARGET_WINDOWS
+    const wchar_t* const currentLocale = _wsetlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != L'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      _wsetlocale(LC_NUMERIC, L"C");
+    }
+#endif // TARGET_WINDOWS
+  }
+
+  ~CNumericLocaleGuard()
+  {
+#ifndef TARGET_WINDOWS
+    if (!m_backupLocale.empty())
+      setlocale(LC_NUMERIC, m_backupLocale.c_str());
+#else  // TARGET_WINDOWS
+    if (!m_backupLocale.empty())
+      _wsetlocale(LC_NUMERIC, m_backupLocale.c_str());
+#endif // TARGET_WINDOWS
+  }
+
+private:
+#ifndef TARGET_WINDOWS
+  std::string m_backupLocale;
+#else
+  std::wstring m_backupLocale;
+#endif
+};
+}
+
+CJSONStreamWriter::CJSONStreamWriter(bool compact)
+{
+  m_generator = yajl_gen_alloc(NULL);
+  yajl_gen_config(m_generator, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(m_generator, yajl_gen_indent_string, "\t");
+}
+
+CJSONStreamWriter::~CJSONStreamWriter()
+{
+  yajl_gen_free(m_generator);
+}
+
+bool CJSONStreamWriter::BeginObject()
+{
+  return yajl_gen_status_ok == yajl_gen_map_open(m_generator);
+}
+
+bool CJSONStreamWriter::EndObject()
+{
+  return yajl_gen_status_ok == yajl_gen_map_close(m_generator);
+}
+
+bool CJSONStreamWriter::BeginArray()
+{
+  return yajl_gen_status_ok == yajl_gen_array_open(m_generator);
+}
+
+bool CJSONStreamWriter::EndArray()
+{
+  return yajl_gen_status_ok == yajl_gen_array_close(m_generator);
+}
+
+bool CJSONStreamWriter::WriteKey(const std::string &key)
+{
+  return yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), key.size());
+}
+
+bool CJSONStreamWriter::WriteValue(const CVariant &value)
+{
+  CNumericLocaleGuard localeGuard;
+  return CJSONVariantWriter::InternalWrite(m_generator, value);
+}
+
+size_t CJSONStreamWriter::GetBufferedSize() const
+{
+  const unsigned char *buffer;
+  size_t length = 0;
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+
+  return length;
+}
+
+void CJSONStreamWriter::TakeOutput(std::string &output)
+{
+  const unsigned char *buffer;
+  size_t length = 0;
+  if (yajl_gen_get_buf(m_generator, &buffer, &length) != yajl_gen_status_ok || length == 0)
+    return;
+
+  output.append((const char *)buffer, length);
+  yajl_gen_clear(m_generator);
+}
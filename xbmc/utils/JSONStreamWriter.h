@@ -0,0 +1,63 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <yajl/yajl_gen.h>
+#include <string>
+
+class CVariant;
+
+/*!
+ \brief Incremental JSON generator.
+
+ Produces the same output as CJSONVariantWriter::Write() but the document
+ can be built piece by piece and the generated text can be taken out while
+ generation is still in progress, so a large document never has to exist
+ as a whole, neither as a CVariant nor as a string.
+ */
+class CJSONStreamWriter
+{
+public:
+  explicit CJSONStreamWriter(bool compact);
+  ~CJSONStreamWriter();
+
+  bool BeginObject();
+  bool EndObject();
+  bool BeginArray();
+  bool EndArray();
+  bool WriteKey(const std::string &key);
+  bool WriteValue(const CVariant &value);
+
+  /*!
+   \brief Number of generated bytes which haven't been taken out yet.
+   */
+  size_t GetBufferedSize() const;
+
+  /*!
+   \brief Appends the generated bytes to output and clears the internal buffer.
+   */
+  void TakeOutput(std::string &output);
+
+private:
+  CJSONStreamWriter(const CJSONStreamWriter&);
+  CJSONStreamWriter& operator=(const CJSONStreamWriter&);
+
+  yajl_gen m_generator;
+};
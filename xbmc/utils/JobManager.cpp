@@ -23,6 +23,7 @@
 #include <functional>
 #include <stdexcept>
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 #ifdef TARGET_POSIX
 #include "linux/XTimeUtils.h"
@@ -37,9 +38,11 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int queue, bool persistent) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_queue = queue;
+  m_persistent = persistent;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -182,6 +185,11 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_nextQueue = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    m_queueDepth[priority] = 0;
+  m_processingCount = 0;
+  m_workerCount = 0;
   m_running = true;
   m_pauseJobs = false;
 }
@@ -200,15 +208,23 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  for (unsigned int queue = 0; queue < NUM_QUEUES; ++queue)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
-  }
+    CSingleLock queueLock(m_queues[queue].m_section);
+
+    // clear any pending jobs
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      JobQueue &jobs = m_queues[queue].m_jobs[priority];
+      m_queueDepth[priority] -= jobs.size();
+      for_each(jobs.begin(), jobs.end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+      jobs.clear();
+    }
 
-  // cancel any callbacks on jobs still processing
-  for_each(m_processing.begin(), m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
+    // cancel any callbacks on jobs still processing
+    Processing &processing = m_queues[queue].m_processing;
+    for_each(processing.begin(), processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
+  }
 
   // tell our workers to finish
   while (m_workers.size())
@@ -226,111 +242,170 @@ CJobManager::~CJobManager()
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
+  // increment the job counter, ensuring 0 (invalid job) is never hit
+  unsigned int id = ++m_jobCounter;
+  if (id == 0)
+    id = ++m_jobCounter;
 
-  if (!m_running)
-    return 0;
+  // spread jobs over the worker queues, only that queue is locked while adding
+  CWorkerQueue &queue = m_queues[m_nextQueue++ % NUM_QUEUES];
+  {
+    CSingleLock lock(queue.m_section);
 
-  // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+    // checked under the queue lock, so CancelJobs() can't miss this job
+    if (!m_running)
+      return 0;
 
-  // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+    // create a work item for this job
+    CWorkItem work(job, id, priority, callback);
+    work.m_queued = XbmcThreads::SystemClockMillis();
+    queue.m_jobs[priority].push_back(work);
+    m_queueDepth[priority]++;
+  }
 
   StartWorkers(priority);
-  return work.m_id;
+  return id;
 }
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
-  CSingleLock lock(m_section);
-
-  // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  for (unsigned int queue = 0; queue < NUM_QUEUES; ++queue)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    CSingleLock queueLock(m_queues[queue].m_section);
+
+    // check whether we have this job in the queue
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      JobQueue &jobs = m_queues[queue].m_jobs[priority];
+      JobQueue::iterator i = find(jobs.begin(), jobs.end(), jobID);
+      if (i != jobs.end())
+      {
+        delete i->m_job;
+        jobs.erase(i);
+        m_queueDepth[priority]--;
+        return;
+      }
+    }
+
+    // or if we're processing it
+    Processing &processing = m_queues[queue].m_processing;
+    Processing::iterator it = find(processing.begin(), processing.end(), jobID);
+    if (it != processing.end())
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
+      it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
       return;
     }
   }
-  // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
 }
 
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
+  if (m_processingCount >= GetMaxWorkers(priority))
     return;
 
   // do we have any sleeping threads?
-  if (m_processing.size() < m_workers.size())
+  if (m_processingCount < m_workerCount)
+  {
+    m_jobEvent.Set();
+    return;
+  }
+
+  CSingleLock lock(m_section);
+  if (m_processingCount < m_workers.size())
   {
     m_jobEvent.Set();
     return;
   }
 
-  // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+  // everyone is busy - we need more workers. The first NUM_QUEUES workers
+  // stay around while idle so bursts of jobs don't recreate threads.
+  unsigned int queue = m_workers.size() % NUM_QUEUES;
+  bool persistent = m_workers.size() < NUM_QUEUES;
+  m_workers.push_back(new CJobWorker(this, queue, persistent));
+  m_workerCount = m_workers.size();
 }
 
-CJob *CJobManager::PopJob()
+CJob *CJobManager::PopJob(const CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
+  unsigned int home = worker ? worker->GetQueue() : 0;
   for (int priority = CJob::PRIORITY_DEDICATED; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
   {
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if (!m_queueDepth[priority])
+      continue;
+
+    // take a worker slot of this priority, so concurrent pops can't exceed the limit
+    unsigned int processing = m_processingCount;
+    do
     {
-      // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
-
-      // add to the processing vector
-      m_processing.push_back(job);
-      job.m_job->m_callback = this;
-      return job.m_job;
-    }
+      if (processing >= GetMaxWorkers(CJob::PRIORITY(priority)))
+        break;
+    } while (!m_processingCount.compare_exchange_weak(processing, processing + 1));
+    if (processing >= GetMaxWorkers(CJob::PRIORITY(priority)))
+      continue;
+
+    CJob *job = PopJob(home, CJob::PRIORITY(priority));
+    if (job)
+      return job;
+    m_processingCount--;
+  }
+  return NULL;
+}
+
+CJob *CJobManager::PopJob(unsigned int home, CJob::PRIORITY priority)
+{
+  // the worker's own queue first, then steal from the others
+  for (unsigned int i = 0; i < NUM_QUEUES; ++i)
+  {
+    CWorkerQueue &queue = m_queues[(home + i) % NUM_QUEUES];
+    CSingleLock queueLock(queue.m_section);
+    JobQueue &jobs = queue.m_jobs[priority];
+    if (jobs.empty())
+      continue;
+
+    // pop the job off the queue, stolen jobs are taken from the front as well
+    // so the jobs of a queue keep their order
+    CWorkItem job = jobs.front();
+    jobs.pop_front();
+    m_queueDepth[priority]--;
+
+    // add to the processing vector
+    job.m_started = XbmcThreads::SystemClockMillis();
+    queue.m_processing.push_back(job);
+    job.m_job->m_callback = this;
+    return job.m_job;
   }
   return NULL;
 }
 
 void CJobManager::PauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = true;
 }
 
 void CJobManager::UnPauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = false;
 }
 
 bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 {
-  CSingleLock lock(m_section);
-
   if (m_pauseJobs)
     return false;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  for (unsigned int queue = 0; queue < NUM_QUEUES; ++queue)
   {
-    if (priority == it->m_priority)
-      return true;
+    CSingleLock queueLock(m_queues[queue].m_section);
+    const Processing &processing = m_queues[queue].m_processing;
+    for(Processing::const_iterator it = processing.begin(); it < processing.end(); ++it)
+    {
+      if (priority == it->m_priority)
+        return true;
+    }
   }
   return false;
 }
@@ -338,58 +413,98 @@ bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 int CJobManager::IsProcessing(const std::string &type) const
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
 
   if (m_pauseJobs)
     return 0;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  for (unsigned int queue = 0; queue < NUM_QUEUES; ++queue)
   {
-    if (type == std::string(it->m_job->GetType()))
-      jobsMatched++;
+    CSingleLock queueLock(m_queues[queue].m_section);
+    const Processing &processing = m_queues[queue].m_processing;
+    for(Processing::const_iterator it = processing.begin(); it < processing.end(); ++it)
+    {
+      if (type == std::string(it->m_job->GetType()))
+        jobsMatched++;
+    }
   }
   return jobsMatched;
 }
 
-CJob *CJobManager::GetNextJob(const CJobWorker *worker)
+unsigned int CJobManager::GetQueueDepth(const CJob::PRIORITY &priority) const
+{
+  return m_queueDepth[priority];
+}
+
+bool CJobManager::GetJobStatistics(const std::string &type, JobStatistics &stats) const
+{
+  CSingleLock lock(m_section);
+  std::map<std::string, JobStatistics>::const_iterator it = m_statistics.find(type);
+  if (it == m_statistics.end())
+    return false;
+
+  stats = it->second;
+  return true;
+}
+
+std::map<std::string, JobStatistics> CJobManager::GetJobStatistics() const
 {
   CSingleLock lock(m_section);
+  return m_statistics;
+}
+
+CJob *CJobManager::GetNextJob(const CJobWorker *worker)
+{
   while (m_running)
   {
     // grab a job off the queue if we have one
-    CJob *job = PopJob();
+    CJob *job = PopJob(worker);
     if (job)
       return job;
     // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
-    bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
-    if (!newJob)
+    if (!m_jobEvent.WaitMSec(30000) && !worker->IsPersistent())
       break;
   }
-  // ensure no jobs have come in during the period after
-  // timeout and before we held the lock
-  CJob *job = PopJob();
+
+  // ensure no jobs have come in during the period after the timeout
+  CSingleLock lock(m_section);
+  CJob *job = PopJob(worker);
   if (job)
     return job;
   // have no jobs
   RemoveWorker(worker);
+  lock.Leave();
+
+  // AddJob() doesn't take our lock, so a job added meanwhile may have counted
+  // on us. It either sees the lower worker count or we see its job here.
+  if (m_running)
+  {
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      if (m_queueDepth[priority])
+        StartWorkers(CJob::PRIORITY(priority));
+    }
+  }
   return NULL;
 }
 
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
-  CSingleLock lock(m_section);
-  // find the job in the processing queue, and check whether it's cancelled (no callback)
-  Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  // find the job in the processing queues, and check whether it's cancelled (no callback)
+  for (unsigned int queue = 0; queue < NUM_QUEUES; ++queue)
   {
-    CWorkItem item(*i);
-    lock.Leave(); // leave section prior to call
-    if (item.m_callback)
+    CSingleLock queueLock(m_queues[queue].m_section);
+    const Processing &processing = m_queues[queue].m_processing;
+    Processing::const_iterator i = find(processing.begin(), processing.end(), job);
+    if (i != processing.end())
     {
-      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
-      return false;
+      CWorkItem item(*i);
+      queueLock.Leave(); // leave section prior to call
+      if (item.m_callback)
+      {
+        item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+        return false;
+      }
+      break;
     }
   }
   return true; // couldn't find the job, or it's been cancelled
@@ -397,14 +512,39 @@ bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const
 
 void CJobManager::OnJobComplete(bool success, CJob *job)
 {
-  CSingleLock lock(m_section);
-  // remove the job from the processing queue
-  Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  // find the job in the processing queues
+  for (unsigned int index = 0; index < NUM_QUEUES; ++index)
   {
-    // tell any listeners we're done with the job, then delete it
+    CWorkerQueue &queue = m_queues[index];
+    CSingleLock queueLock(queue.m_section);
+    Processing::iterator i = find(queue.m_processing.begin(), queue.m_processing.end(), job);
+    if (i == queue.m_processing.end())
+      continue;
+
     CWorkItem item(*i);
-    lock.Leave();
+    queueLock.Leave();
+
+    // account the time spent waiting and running
+    unsigned int now = XbmcThreads::SystemClockMillis();
+    unsigned int waitTime = item.m_started - item.m_queued;
+    unsigned int runTime = now - item.m_started;
+    {
+      CSingleLock lock(m_section);
+      JobStatistics &stats = m_statistics[item.m_job->GetType()];
+      stats.processed++;
+      stats.totalWaitTime += waitTime;
+      stats.maxWaitTime = std::max(stats.maxWaitTime, waitTime);
+      stats.totalRunTime += runTime;
+      stats.maxRunTime = std::max(stats.maxRunTime, runTime);
+    }
+
+    // tell any listeners we're done with the job, then delete it. Cancelling
+    // clears the callback of the entry in the queue, so look at that one
+    queueLock.Enter();
+    i = find(queue.m_processing.begin(), queue.m_processing.end(), job);
+    if (i != queue.m_processing.end())
+      item.m_callback = i->m_callback;
+    queueLock.Leave();
     try
     {
       if (item.m_callback)
@@ -414,12 +554,14 @@ void CJobManager::OnJobComplete(bool success, CJob *job)
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
     }
-    lock.Enter();
-    Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
-    if (j != m_processing.end())
-      m_processing.erase(j);
-    lock.Leave();
+    queueLock.Enter();
+    i = find(queue.m_processing.begin(), queue.m_processing.end(), job);
+    if (i != queue.m_processing.end())
+      queue.m_processing.erase(i);
+    queueLock.Leave();
+    m_processingCount--;
     item.FreeJob();
+    return;
   }
 }
 
@@ -430,6 +572,7 @@ void CJobManager::RemoveWorker(const CJobWorker *worker)
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
     m_workers.erase(i); // workers auto-delete
+  m_workerCount = m_workers.size();
 }
 
 unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
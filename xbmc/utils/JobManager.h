@@ -19,9 +19,12 @@
  *
  */
 
+#include <atomic>
+#include <map>
 #include <queue>
 #include <vector>
 #include <string>
+#include <stdint.h>
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +34,40 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int queue, bool persistent);
   virtual ~CJobWorker();
 
   void Process();
+
+  /*!
+   \brief The job queue this worker takes jobs from first, before stealing from other queues
+   */
+  unsigned int GetQueue() const { return m_queue; }
+
+  /*!
+   \brief Whether this worker stays alive while idle instead of exiting after a timeout
+   */
+  bool IsPersistent() const { return m_persistent; }
 private:
   CJobManager  *m_jobManager;
+  unsigned int  m_queue;
+  bool          m_persistent;
+};
+
+/*!
+ \ingroup jobs
+ \brief Statistics of the jobs of one type processed by the CJobManager
+ \sa CJobManager::GetJobStatistics()
+ */
+struct JobStatistics
+{
+  JobStatistics() : processed(0), totalWaitTime(0), maxWaitTime(0), totalRunTime(0), maxRunTime(0) {}
+
+  unsigned int processed;     ///< number of completed jobs
+  uint64_t     totalWaitTime; ///< time (ms) jobs spent queued before a worker picked them up
+  unsigned int maxWaitTime;   ///< longest time (ms) a job spent queued
+  uint64_t     totalRunTime;  ///< time (ms) spent in CJob::DoWork
+  unsigned int maxRunTime;    ///< longest time (ms) a job spent in CJob::DoWork
 };
 
 /*!
@@ -183,6 +214,8 @@ class CJobManager
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_queued = 0;
+      m_started = 0;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -205,6 +238,8 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    unsigned int  m_queued;  ///< time the job was added
+    unsigned int  m_started; ///< time a worker picked up the job
   };
 
   template<typename F>
@@ -222,6 +257,14 @@ class CJobManager
   };
 
 public:
+  /*!
+   \brief Number of worker queues, which is also the number of workers that are
+   kept alive while idle. Jobs are spread over the queues in turn; the jobs of a
+   priority in one queue start in the order they were added, jobs in different
+   queues may start in any order.
+   */
+  static const unsigned int NUM_QUEUES = 5;
+
   /*!
    \brief The only way through which the global instance of the CJobManager should be accessed.
    \return the global instance.
@@ -297,6 +340,27 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Number of jobs with a specific priority waiting to be processed.
+   \param priority to count the queued jobs of
+   \return number of queued jobs
+   */
+  unsigned int GetQueueDepth(const CJob::PRIORITY &priority) const;
+
+  /*!
+   \brief Retrieve wait and run time statistics of the jobs of a specific type.
+   \param type Job type to retrieve the statistics of
+   \param stats the statistics, only valid if true is returned
+   \return true if any job of this type has completed, false otherwise
+   */
+  bool GetJobStatistics(const std::string &type, JobStatistics &stats) const;
+
+  /*!
+   \brief Retrieve wait and run time statistics of all job types that have completed.
+   \return map of job type to statistics
+   */
+  std::map<std::string, JobStatistics> GetJobStatistics() const;
+
 protected:
   friend class CJobWorker;
   friend class CJob;
@@ -335,27 +399,53 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  /*! \brief Pop a job off the job queues and add to the processing queue ready to process
+   A job of the highest priority is taken, from the worker's own queue if it has one,
+   else stolen from the other queues. Only the locks of the worker queues are taken.
+   \param worker the worker requesting a job
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(const CJobWorker *worker);
+
+  /*! \brief Pop the front job of one priority off the home queue, or steal it from
+   the next queue that has one
+   \param home the queue to take jobs from first
+   \return the job to process, NULL if there are no jobs of this priority
+   */
+  CJob *PopJob(unsigned int home, CJob::PRIORITY priority);
 
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
 
-  unsigned int m_jobCounter;
-
   typedef std::deque<CWorkItem>    JobQueue;
   typedef std::vector<CWorkItem>   Processing;
   typedef std::vector<CJobWorker*> Workers;
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_DEDICATED + 1];
-  bool       m_pauseJobs;
-  Processing m_processing;
+  /*! \brief Jobs queued on one worker and the jobs taken from them, guarded
+   by their own lock so adding and taking jobs does not contend with the other
+   queues.
+   */
+  class CWorkerQueue
+  {
+  public:
+    CCriticalSection m_section;
+    JobQueue         m_jobs[CJob::PRIORITY_DEDICATED + 1];
+    Processing       m_processing;
+  };
+
+  std::atomic<unsigned int> m_jobCounter;
+  std::atomic<unsigned int> m_nextQueue;
+  std::atomic<unsigned int> m_queueDepth[CJob::PRIORITY_DEDICATED + 1];
+  std::atomic<unsigned int> m_processingCount; ///< jobs being processed, including slots being taken
+  std::atomic<unsigned int> m_workerCount;     ///< size of m_workers
+
+  CWorkerQueue m_queues[NUM_QUEUES];
+  std::atomic<bool> m_pauseJobs;
   Workers    m_workers;
+  std::map<std::string, JobStatistics> m_statistics;
 
-  CCriticalSection m_section;
-  CEvent           m_jobEvent;
-  bool             m_running;
+  CCriticalSection  m_section; ///< guards the workers and the statistics
+  CEvent            m_jobEvent;
+  std::atomic<bool> m_running;
 };
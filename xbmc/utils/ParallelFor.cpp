@@ -0,0 +1,115 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ParallelFor.h"
+#include "CPUInfo.h"
+#include "JobManager.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+class CParallelForState
+{
+public:
+  CParallelForState(size_t count, size_t chunk, const std::function<void(size_t, size_t)> &work)
+    : m_count(count)
+    , m_chunk(chunk)
+    , m_work(work)
+    , m_next(0)
+    , m_done(0)
+  {
+  }
+
+  // process chunks until all of them are taken
+  void Process()
+  {
+    while (true)
+    {
+      size_t begin = m_next.fetch_add(m_chunk);
+      if (begin >= m_count)
+        return;
+
+      size_t end = std::min(begin + m_chunk, m_count);
+      m_work(begin, end);
+
+      if (m_done.fetch_add(end - begin) + (end - begin) == m_count)
+        m_finished.Set();
+    }
+  }
+
+  void Wait()
+  {
+    m_finished.Wait();
+  }
+
+private:
+  const size_t m_count;
+  const size_t m_chunk;
+  // only called for claimed chunks, so helpers starting late never touch it
+  const std::function<void(size_t, size_t)> &m_work;
+  std::atomic<size_t> m_next;
+  std::atomic<size_t> m_done;
+  CEvent m_finished;
+};
+}
+
+namespace KODI
+{
+namespace UTILS
+{
+size_t ParallelThreadCount()
+{
+  if (g_advancedSettings.m_parallelThreads > 0)
+    return g_advancedSettings.m_parallelThreads;
+  return std::max(1, g_cpuInfo.getCPUCount());
+}
+
+void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end)> &work)
+{
+  if (count == 0)
+    return;
+
+  size_t threads = ParallelThreadCount();
+  minChunk = std::max<size_t>(1, minChunk);
+  if (threads == 1 || count < 2 * minChunk)
+  {
+    work(0, count);
+    return;
+  }
+
+  // a few chunks per thread evens out items that take longer than others
+  size_t chunk = std::max(minChunk, count / (threads * 4));
+  size_t chunks = (count + chunk - 1) / chunk;
+  size_t helpers = std::min(threads, chunks) - 1;
+
+  std::shared_ptr<CParallelForState> state(new CParallelForState(count, chunk, work));
+  for (size_t i = 0; i < helpers; i++)
+    CJobManager::GetInstance().Submit([state]() { state->Process(); }, CJob::PRIORITY_HIGH);
+
+  state->Process();
+  state->Wait();
+}
+}
+}
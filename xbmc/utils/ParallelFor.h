@@ -0,0 +1,100 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stddef.h>
+
+namespace KODI
+{
+namespace UTILS
+{
+/*!
+ \brief Number of threads used by ParallelFor().
+
+ Follows the parallelthreads advanced setting, defaults to the number of CPUs.
+ */
+size_t ParallelThreadCount();
+
+/*!
+ \brief Process the index range [0, count) in parallel.
+
+ The range is split into chunks of at least minChunk indices. The calling
+ thread processes chunks itself and is helped by high priority jobs, so it
+ never waits for a job that didn't start yet and it is safe to call this from
+ a job. The call returns once all chunks are done.
+
+ The chunk boundaries depend on the CPU count, work must only touch data
+ belonging to its own range for the result to be deterministic.
+
+ \param count number of indices to process
+ \param minChunk minimum number of indices per chunk, small ranges are processed
+                 on the calling thread only
+ \param work called with [begin, end) for every chunk
+ */
+void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end)> &work);
+
+/*!
+ \brief Stable merge sort of [begin, end) using ParallelFor().
+
+ The runs are sorted and merged in parallel. As every step is stable the
+ result is the same as std::stable_sort() whatever the number of threads.
+
+ \param minChunk minimum number of elements per sorted run
+ */
+template<class TIterator, class TCompare>
+void ParallelStableSort(TIterator begin, TIterator end, TCompare compare, size_t minChunk)
+{
+  size_t count = std::distance(begin, end);
+  size_t runs = std::min(ParallelThreadCount(), count / std::max<size_t>(1, minChunk));
+  if (runs < 2)
+  {
+    std::stable_sort(begin, end, compare);
+    return;
+  }
+
+  size_t width = (count + runs - 1) / runs;
+  ParallelFor(runs, 1, [&](size_t first, size_t last)
+  {
+    for (size_t run = first; run < last; run++)
+      std::stable_sort(begin + std::min(run * width, count), begin + std::min((run + 1) * width, count), compare);
+  });
+
+  // merge neighbouring runs, doubling their width every pass
+  for (; width < count; width *= 2)
+  {
+    size_t pairs = (count + 2 * width - 1) / (2 * width);
+    ParallelFor(pairs, 1, [&](size_t first, size_t last)
+    {
+      for (size_t pair = first; pair < last; pair++)
+      {
+        size_t low = pair * 2 * width;
+        size_t middle = std::min(low + width, count);
+        size_t high = std::min(low + 2 * width, count);
+        if (middle < high)
+          std::inplace_merge(begin + low, begin + middle, begin + high, compare);
+      }
+    });
+  }
+}
+}
+}
@@ -23,11 +23,18 @@
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
+#include "threads/SingleLock.h"
 #include "utils/CharsetConverter.h"
+#include "utils/ParallelFor.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include <algorithm>
+#include <locale>
+#include <stdint.h>
+#include <unordered_map>
+
+using namespace KODI::UTILS;
 
 std::string ArrayToString(SortAttribute attributes, const CVariant &variant, const std::string &seperator = " / ")
 {
@@ -542,6 +549,314 @@ bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortIt
   return SorterIgnoreFoldersDescending(*left, *right);
 }
 
+/* Collation keys
+ *
+ * Comparing the wide sort labels with StringUtils::AlphaNumericCompare() does
+ * the locale lookups and case folding again on every single comparison. The
+ * labels are therefore turned into sequences of small integer weights once,
+ * which compare in the same order:
+ *  - characters are ASCII case folded and replaced by their rank in the
+ *    collation order of all characters present in the sorted labels
+ *  - runs of up to 15 digits become a number token (marker, number of digits
+ *    without leading zeros, digits) so they compare numerically
+ * The leading weights are packed into a 64 bit prefix below the special sort
+ * and folder flags. Items are radix sorted on that prefix and only items
+ * sharing the same prefix are compared on their complete keys. Lists with
+ * more than SORTKEY_MIN_CHUNK items are prepared and keyed in parallel.
+ */
+#define SORTKEY_MAX_DIGITS    15
+#define SORTKEY_MIN_CHUNK     2048
+#define SORTKEY_CLASS_SHIFT   62
+#define SORTKEY_FOLDER_SHIFT  61
+#define SORTKEY_LABEL_BITS    61
+
+typedef struct
+{
+  uint64_t prefix;
+  uint32_t index;
+} SortKeyEntry;
+
+static void RadixSortByPrefix(std::vector<SortKeyEntry> &entries)
+{
+  std::vector<SortKeyEntry> buffer(entries.size());
+  for (unsigned int shift = 0; shift < 64; shift += 8)
+  {
+    size_t offsets[256] = { 0 };
+    for (std::vector<SortKeyEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+      offsets[(it->prefix >> shift) & 0xff]++;
+
+    // all prefixes share this byte, nothing to reorder
+    if (offsets[(entries.front().prefix >> shift) & 0xff] == entries.size())
+      continue;
+
+    size_t offset = 0;
+    for (unsigned int i = 0; i < 256; i++)
+    {
+      size_t bucket = offsets[i];
+      offsets[i] = offset;
+      offset += bucket;
+    }
+    for (std::vector<SortKeyEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+      buffer[offsets[(it->prefix >> shift) & 0xff]++] = *it;
+    entries.swap(buffer);
+  }
+}
+
+/*!
+ \brief Sort items which already carry FieldSort using collation keys.
+ \param items the items to sort
+ \param sortOrder the sort order of the labels
+ \param attributes the sort attributes
+ \param limit only the first limit positions of the result need to be in order
+ \param order receives the indices of the items in sorted order
+ \return false if the items can't be sorted this way, i.e. only some of them
+         carry folder information
+ */
+static bool SortByCollationKeys(const std::vector<const SortItem*> &items, SortOrder sortOrder, SortAttribute attributes, size_t limit, std::vector<uint32_t> &order)
+{
+  const size_t count = items.size();
+  const bool handleFolder = !(attributes & SortAttributeIgnoreFolders);
+
+  std::vector<std::wstring> labels(count);
+  std::vector<uint8_t> classes(count, 1);
+  std::vector<uint8_t> folders(count, 0);
+  size_t withFolder = 0;
+  bool asciiSeen[128] = { false };
+  std::vector<wchar_t> otherSeen;
+  CCriticalSection seenLock;
+
+  ParallelFor(count, SORTKEY_MIN_CHUNK, [&](size_t begin, size_t end)
+  {
+    size_t chunkWithFolder = 0;
+    bool chunkAsciiSeen[128] = { false };
+    std::vector<wchar_t> chunkOtherSeen;
+
+    for (size_t i = begin; i < end; i++)
+    {
+      const SortItem &item = *items[i];
+
+      // items sorted on top or at the bottom are not ordered among each other
+      SortItem::const_iterator it = item.find(FieldSortSpecial);
+      if (it != item.end() && it->second.asInteger() == SortSpecialOnTop)
+        classes[i] = 0;
+      else if (it != item.end() && it->second.asInteger() == SortSpecialOnBottom)
+        classes[i] = 2;
+
+      if (handleFolder && (it = item.find(FieldFolder)) != item.end())
+      {
+        chunkWithFolder++;
+        if (classes[i] == 1)
+          folders[i] = it->second.asBoolean() ? 0 : 1;
+      }
+
+      if (classes[i] != 1)
+        continue;
+
+      labels[i] = item.at(FieldSort).asWideString();
+      for (const wchar_t *c = labels[i].c_str(); *c != 0; c++)
+      {
+        if (*c >= L'0' && *c <= L'9')
+          continue;
+        wchar_t folded = (*c >= L'A' && *c <= L'Z') ? *c + (L'a' - L'A') : *c;
+        if (folded >= 0 && folded < 128)
+          chunkAsciiSeen[folded] = true;
+        else
+          chunkOtherSeen.push_back(folded);
+      }
+    }
+
+    CSingleLock lock(seenLock);
+    withFolder += chunkWithFolder;
+    for (int c = 0; c < 128; c++)
+      asciiSeen[c] |= chunkAsciiSeen[c];
+    otherSeen.insert(otherSeen.end(), chunkOtherSeen.begin(), chunkOtherSeen.end());
+  });
+
+  // the sorters only look at folders if both items know about it
+  if (withFolder != 0 && withFolder != count)
+    return false;
+
+  // rank all characters in use, numbers rank just before '0'
+  const std::collate<wchar_t>& coll = std::use_facet<std::collate<wchar_t> >(g_langInfo.GetSystemLocale());
+  std::vector<wchar_t> chars;
+  for (wchar_t c = 0; c < 128; c++)
+  {
+    if (asciiSeen[c] || c == L'0')
+      chars.push_back(c);
+  }
+  std::sort(otherSeen.begin(), otherSeen.end());
+  otherSeen.erase(std::unique(otherSeen.begin(), otherSeen.end()), otherSeen.end());
+  chars.insert(chars.end(), otherSeen.begin(), otherSeen.end());
+
+  auto collateLess = [&coll](wchar_t left, wchar_t right)
+  {
+    return coll.compare(&left, &left + 1, &right, &right + 1) < 0;
+  };
+  std::sort(chars.begin(), chars.end(), collateLess);
+
+  uint32_t asciiWeights[128] = { 0 };
+  std::unordered_map<wchar_t, uint32_t> otherWeights;
+  uint32_t rank = 0;
+  for (size_t i = 0; i < chars.size(); i++)
+  {
+    if (i > 0 && collateLess(chars[i - 1], chars[i]))
+      rank++;
+    if (chars[i] >= 0 && chars[i] < 128)
+      asciiWeights[chars[i]] = 2 * rank + 2;
+    else
+      otherWeights[chars[i]] = 2 * rank + 2;
+  }
+  const uint32_t numberMarker = asciiWeights[L'0'] - 1;
+  const uint32_t maxWeight = std::max<uint32_t>(2 * rank + 2, SORTKEY_MAX_DIGITS);
+
+  auto weightOf = [&asciiWeights, &otherWeights](wchar_t folded)
+  {
+    return folded >= 0 && folded < 128 ? asciiWeights[folded] : otherWeights.find(folded)->second;
+  };
+
+  // build the keys into one contiguous pool, first measure every key so the
+  // items can be written to their place in parallel
+  std::vector<size_t> offsets(count + 1);
+  ParallelFor(count, SORTKEY_MIN_CHUNK, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      size_t length = 0;
+      const wchar_t *c = labels[i].c_str();
+      while (*c != 0)
+      {
+        if (*c >= L'0' && *c <= L'9')
+        {
+          const wchar_t *start = c;
+          while (*c >= L'0' && *c <= L'9' && c < start + SORTKEY_MAX_DIGITS)
+            c++;
+          while (start < c && *start == L'0')
+            start++;
+          length += 2 + (c - start);
+          continue;
+        }
+        length++;
+        c++;
+      }
+      offsets[i + 1] = length;
+    }
+  });
+  for (size_t i = 0; i < count; i++)
+    offsets[i + 1] += offsets[i];
+
+  std::vector<uint32_t> keys(offsets[count]);
+  ParallelFor(count, SORTKEY_MIN_CHUNK, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      uint32_t *key = keys.data() + offsets[i];
+      const wchar_t *c = labels[i].c_str();
+      while (*c != 0)
+      {
+        if (*c >= L'0' && *c <= L'9')
+        {
+          const wchar_t *start = c;
+          while (*c >= L'0' && *c <= L'9' && c < start + SORTKEY_MAX_DIGITS)
+            c++;
+          while (start < c && *start == L'0')
+            start++;
+          *key++ = numberMarker;
+          *key++ = c - start;
+          for (; start < c; start++)
+            *key++ = *start - L'0';
+          continue;
+        }
+
+        wchar_t folded = (*c >= L'A' && *c <= L'Z') ? *c + (L'a' - L'A') : *c;
+        *key++ = weightOf(folded);
+        c++;
+      }
+      std::wstring().swap(labels[i]);
+    }
+  });
+
+  // pack as many leading weights into the prefix as fit
+  unsigned int bits = 1;
+  while ((1U << bits) <= maxWeight)
+    bits++;
+  const unsigned int perPrefix = SORTKEY_LABEL_BITS / bits;
+  const uint64_t labelMask = (1ULL << SORTKEY_LABEL_BITS) - 1;
+  const bool descending = sortOrder == SortOrderDescending;
+
+  std::vector<SortKeyEntry> entries(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    uint64_t packed = 0;
+    for (unsigned int j = 0; j < perPrefix; j++)
+    {
+      packed <<= bits;
+      if (offsets[i] + j < offsets[i + 1])
+        packed |= keys[offsets[i] + j];
+    }
+    packed <<= SORTKEY_LABEL_BITS - perPrefix * bits;
+    if (descending)
+      packed = ~packed & labelMask;
+
+    entries[i].prefix = ((uint64_t)classes[i] << SORTKEY_CLASS_SHIFT) |
+                        ((uint64_t)folders[i] << SORTKEY_FOLDER_SHIFT) | packed;
+    entries[i].index = i;
+  }
+
+  RadixSortByPrefix(entries);
+
+  // order items sharing a prefix by their complete keys, as far as needed
+  auto keyLess = [&keys, &offsets, descending](const SortKeyEntry &left, const SortKeyEntry &right)
+  {
+    const uint32_t *l = keys.data() + offsets[left.index];
+    const uint32_t *lEnd = keys.data() + offsets[left.index + 1];
+    const uint32_t *r = keys.data() + offsets[right.index];
+    const uint32_t *rEnd = keys.data() + offsets[right.index + 1];
+    if (descending)
+      return std::lexicographical_compare(r, rEnd, l, lEnd);
+    return std::lexicographical_compare(l, lEnd, r, rEnd);
+  };
+  std::vector<std::pair<size_t, size_t> > ties;
+  for (size_t start = 0; start < count && start < limit; )
+  {
+    size_t end = start + 1;
+    while (end < count && entries[end].prefix == entries[start].prefix)
+      end++;
+    if (end - start > 1)
+      ties.push_back(std::make_pair(start, end));
+    start = end;
+  }
+  ParallelFor(ties.size(), SORTKEY_MIN_CHUNK / 16, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+      std::stable_sort(entries.begin() + ties[i].first, entries.begin() + ties[i].second, keyLess);
+  });
+
+  order.resize(count);
+  for (size_t i = 0; i < count; i++)
+    order[i] = entries[i].index;
+
+  return true;
+}
+
+/*!
+ \brief Add the fields needed for sorting and store the sort label under FieldSort.
+ */
+static void PrepareSortItem(SortUtils::SortPreparator preparator, SortAttribute attributes, const Fields &sortingFields, SortItem &item)
+{
+  // add all fields to the item that are required for sorting if they are currently missing
+  for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+  {
+    if (item.find(*field) == item.end())
+      item.insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+  }
+
+  const std::string label = preparator(attributes, item);
+
+  std::wstring sortLabel;
+  g_charsetConverter.utf8ToW(label, sortLabel, false);
+  item.insert(std::pair<Field, CVariant>(FieldSort, CVariant(std::move(sortLabel))));
+}
+
 std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
 {
   std::map<SortBy, SortUtils::SortPreparator> preparators;
@@ -700,22 +1015,34 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
       // Prepare the string used for sorting and store it under FieldSort
-      for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
+      std::vector<const SortItem*> sortItems(items.size());
+      auto prepare = [&](size_t begin, size_t end)
       {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+        for (size_t i = begin; i < end; i++)
         {
-          if (item->find(*field) == item->end())
-            item->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          PrepareSortItem(preparator, attributes, sortingFields, items[i]);
+          sortItems[i] = &items[i];
         }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+      };
+      // random numbers come from a shared seed, keep those in order
+      if (sortBy == SortByRandom)
+        prepare(0, items.size());
+      else
+        ParallelFor(items.size(), SORTKEY_MIN_CHUNK, prepare);
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      std::vector<uint32_t> order;
+      size_t limit = limitEnd > 0 ? (size_t)limitEnd : items.size();
+      if (items.size() > 1 && SortByCollationKeys(sortItems, sortOrder, attributes, limit, order))
+      {
+        DatabaseResults sorted;
+        sorted.reserve(items.size());
+        for (std::vector<uint32_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+          sorted.push_back(std::move(items[*it]));
+        items.swap(sorted);
+      }
+      else
+        ParallelStableSort(items.begin(), items.end(), getSorter(sortOrder, attributes), SORTKEY_MIN_CHUNK);
     }
   }
 
@@ -739,22 +1066,34 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
       // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
+      std::vector<const SortItem*> sortItems(items.size());
+      auto prepare = [&](size_t begin, size_t end)
       {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+        for (size_t i = begin; i < end; i++)
         {
-          if ((*item)->find(*field) == (*item)->end())
-            (*item)->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          PrepareSortItem(preparator, attributes, sortingFields, *items[i]);
+          sortItems[i] = items[i].get();
         }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+      };
+      // random numbers come from a shared seed, keep those in order
+      if (sortBy == SortByRandom)
+        prepare(0, items.size());
+      else
+        ParallelFor(items.size(), SORTKEY_MIN_CHUNK, prepare);
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
+      std::vector<uint32_t> order;
+      size_t limit = limitEnd > 0 ? (size_t)limitEnd : items.size();
+      if (items.size() > 1 && SortByCollationKeys(sortItems, sortOrder, attributes, limit, order))
+      {
+        SortItems sorted;
+        sorted.reserve(items.size());
+        for (std::vector<uint32_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+          sorted.push_back(std::move(items[*it]));
+        items.swap(sorted);
+      }
+      else
+        ParallelStableSort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes), SORTKEY_MIN_CHUNK);
     }
   }
 
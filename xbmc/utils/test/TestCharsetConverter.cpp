@@ -265,6 +265,72 @@ TEST_F(TestCharsetConverter, wToUTF8)
   EXPECT_STREQ(refstra1.c_str(), varstra1.c_str());
 }
 
+TEST_F(TestCharsetConverter, utf8ToUtf32_NonBMP)
+{
+  std::u32string varstr32;
+  EXPECT_TRUE(g_charsetConverter.utf8ToUtf32("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x90\xAD", varstr32));
+  EXPECT_TRUE(varstr32 == std::u32string(U"a\u00E9\u20AC\U0001F42D"));
+
+  varstra1.clear();
+  EXPECT_TRUE(g_charsetConverter.utf32ToUtf8(varstr32, varstra1));
+  EXPECT_STREQ("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x90\xAD", varstra1.c_str());
+}
+
+TEST_F(TestCharsetConverter, utf8ToUtf32_Invalid)
+{
+  // stray continuation byte, overlong form, surrogate and truncated sequence
+  refstra1 = "a\x80" "b\xC0\xAF" "c\xED\xA0\x80" "d\xE2\x82";
+  std::u32string varstr32;
+  EXPECT_FALSE(g_charsetConverter.utf8ToUtf32(refstra1, varstr32, true));
+  EXPECT_TRUE(varstr32.empty());
+
+  EXPECT_TRUE(g_charsetConverter.utf8ToUtf32(refstra1, varstr32, false));
+  EXPECT_TRUE(varstr32 == std::u32string(U"abcd"));
+}
+
+TEST_F(TestCharsetConverter, utf8ToW_Long)
+{
+  // long enough for the vectorized ASCII path, with multi-byte characters in between
+  refstra1.clear();
+  refstrw1.clear();
+  for (int i = 0; i < 50; i++)
+  {
+    refstra1 += "plain ascii text \xC3\xA9";
+    refstrw1 += L"plain ascii text \u00E9";
+  }
+  varstrw1.clear();
+  g_charsetConverter.utf8ToW(refstra1, varstrw1, false);
+  EXPECT_TRUE(refstrw1 == varstrw1);
+}
+
+TEST_F(TestCharsetConverter, utf16ToUTF8_Surrogates)
+{
+  std::u16string refstr16;
+  refstr16.push_back(0x0061);
+  refstr16.push_back(0xD83D);
+  refstr16.push_back(0xDC2D);
+  refstr16.push_back(0xDC2D); // unpaired low surrogate is dropped
+
+  // the converters take the byte order from their name, not from the host
+  const uint16_t probe = 1;
+  const bool littleEndian = *(const uint8_t*)&probe == 1;
+  std::u16string refstr16LE, refstr16BE;
+  for (size_t i = 0; i < refstr16.size(); i++)
+  {
+    const char16_t swapped = (char16_t)((refstr16[i] >> 8) | (refstr16[i] << 8));
+    refstr16LE.push_back(littleEndian ? refstr16[i] : swapped);
+    refstr16BE.push_back(littleEndian ? swapped : refstr16[i]);
+  }
+
+  varstra1.clear();
+  g_charsetConverter.utf16LEtoUTF8(refstr16LE, varstra1);
+  EXPECT_STREQ("a\xF0\x9F\x90\xAD", varstra1.c_str());
+
+  varstra1.clear();
+  g_charsetConverter.utf16BEtoUTF8(refstr16BE, varstra1);
+  EXPECT_STREQ("a\xF0\x9F\x90\xAD", varstra1.c_str());
+}
+
 //TEST_F(TestCharsetConverter, utf16BEtoUTF8)
 //{
 //  refstr16_1.assign(refutf16BE);
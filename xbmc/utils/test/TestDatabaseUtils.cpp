@@ -1361,6 +1361,23 @@ TEST(TestDatabaseUtils, BuildLimitClause)
   EXPECT_STREQ(" LIMIT 100", a.c_str());
 }
 
+TEST(TestDatabaseUtils, BuildLimitClauseParameters)
+{
+  int offset, count;
+  std::string a = DatabaseUtils::BuildLimitClause(100, 0, offset, count);
+  EXPECT_STREQ(" LIMIT ?,?", a.c_str());
+  EXPECT_EQ(0, offset);
+  EXPECT_EQ(100, count);
+
+  DatabaseUtils::BuildLimitClause(100, 40, offset, count);
+  EXPECT_EQ(40, offset);
+  EXPECT_EQ(60, count);
+
+  DatabaseUtils::BuildLimitClause(10, 40, offset, count);
+  EXPECT_EQ(40, offset);
+  EXPECT_EQ(0, count);
+}
+
 // class DatabaseUtils
 // {
 // public:
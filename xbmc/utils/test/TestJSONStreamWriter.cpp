@@ -0,0 +1,230 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/JSONStreamWriter.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+static CVariant CreateItem(int id)
+{
+  CVariant item(CVariant::VariantTypeObject);
+  item["movieid"] = id;
+  item["label"] = "Movie";
+  item["rating"] = 7.5;
+  item["genre"].push_back("Drama");
+  item["genre"].push_back("Thriller");
+  return item;
+}
+
+static std::string WriteStreamed(const CVariant &limits, int count, bool compact)
+{
+  std::string output;
+  CJSONStreamWriter writer(compact);
+
+  EXPECT_TRUE(writer.BeginObject());
+  EXPECT_TRUE(writer.WriteKey("limits"));
+  EXPECT_TRUE(writer.WriteValue(limits));
+  EXPECT_TRUE(writer.WriteKey("movies"));
+  EXPECT_TRUE(writer.BeginArray());
+  for (int i = 0; i < count; i++)
+  {
+    EXPECT_TRUE(writer.WriteValue(CreateItem(i)));
+    // take out the output in between like a network transport would
+    if (i % 3 == 0)
+      writer.TakeOutput(output);
+  }
+  EXPECT_TRUE(writer.EndArray());
+  EXPECT_TRUE(writer.EndObject());
+
+  writer.TakeOutput(output);
+  EXPECT_EQ(0U, writer.GetBufferedSize());
+
+  return output;
+}
+
+// writes containers member by member so the streamed structure is
+// generated by the writer itself, not by a single WriteValue()
+static void StreamVariant(CJSONStreamWriter &writer, const CVariant &value, std::string &output)
+{
+  if (value.isObject())
+  {
+    EXPECT_TRUE(writer.BeginObject());
+    for (CVariant::const_iterator_map it = value.begin_map(); it != value.end_map(); ++it)
+    {
+      EXPECT_TRUE(writer.WriteKey(it->first));
+      StreamVariant(writer, it->second, output);
+    }
+    EXPECT_TRUE(writer.EndObject());
+  }
+  else if (value.isArray())
+  {
+    EXPECT_TRUE(writer.BeginArray());
+    for (CVariant::const_iterator_array it = value.begin_array(); it != value.end_array(); ++it)
+      StreamVariant(writer, *it, output);
+    EXPECT_TRUE(writer.EndArray());
+  }
+  else
+    EXPECT_TRUE(writer.WriteValue(value));
+
+  writer.TakeOutput(output);
+}
+
+static void ExpectSameOutput(const CVariant &value)
+{
+  for (int compact = 0; compact < 2; compact++)
+  {
+    std::string streamed;
+    CJSONStreamWriter writer(compact != 0);
+    StreamVariant(writer, value, streamed);
+    EXPECT_EQ(CJSONVariantWriter::Write(value, compact != 0), streamed) << (compact ? "compact" : "pretty");
+
+    // whole values written at once give the same document
+    std::string whole;
+    CJSONStreamWriter valueWriter(compact != 0);
+    EXPECT_TRUE(valueWriter.WriteValue(value));
+    valueWriter.TakeOutput(whole);
+    EXPECT_EQ(streamed, whole);
+  }
+}
+
+TEST(TestJSONStreamWriter, MatchesVariantWriter)
+{
+  CVariant limits;
+  limits["start"] = 0;
+  limits["end"] = 10;
+  limits["total"] = 10;
+
+  CVariant result;
+  result["limits"] = limits;
+  for (int i = 0; i < 10; i++)
+    result["movies"].push_back(CreateItem(i));
+
+  EXPECT_EQ(CJSONVariantWriter::Write(result, true), WriteStreamed(limits, 10, true));
+  EXPECT_EQ(CJSONVariantWriter::Write(result, false), WriteStreamed(limits, 10, false));
+}
+
+TEST(TestJSONStreamWriter, TakeOutput)
+{
+  CJSONStreamWriter writer(true);
+  std::string output;
+
+  writer.TakeOutput(output);
+  EXPECT_TRUE(output.empty());
+
+  EXPECT_TRUE(writer.BeginArray());
+  EXPECT_TRUE(writer.WriteValue(CVariant(1)));
+  EXPECT_LT(0U, writer.GetBufferedSize());
+  writer.TakeOutput(output);
+  EXPECT_STREQ("[1", output.c_str());
+  EXPECT_EQ(0U, writer.GetBufferedSize());
+
+  EXPECT_TRUE(writer.WriteValue(CVariant("two")));
+  EXPECT_TRUE(writer.EndArray());
+  writer.TakeOutput(output);
+  EXPECT_STREQ("[1,\"two\"]", output.c_str());
+}
+
+TEST(TestJSONStreamWriter, NestedContainers)
+{
+  CVariant value(CVariant::VariantTypeObject);
+  value["empty object"] = CVariant(CVariant::VariantTypeObject);
+  value["empty array"] = CVariant(CVariant::VariantTypeArray);
+  value["null"] = CVariant(CVariant::VariantTypeNull);
+  value["matrix"].push_back(CVariant(CVariant::VariantTypeArray));
+  value["matrix"][0].push_back(1);
+  value["matrix"][0].push_back(2);
+  value["matrix"].push_back(CVariant(CVariant::VariantTypeArray));
+  value["matrix"][1].push_back(CVariant(CVariant::VariantTypeArray));
+  value["deep"]["er"]["est"]["list"].push_back(CreateItem(1));
+  value["deep"]["er"]["flag"] = true;
+  value["deep"]["count"] = static_cast<uint64_t>(18446744073709551615ULL);
+  value["deep"]["negative"] = static_cast<int64_t>(-9223372036854775807LL);
+
+  ExpectSameOutput(value);
+
+  CVariant list(CVariant::VariantTypeArray);
+  list.push_back(value);
+  list.push_back(CVariant(CVariant::VariantTypeArray));
+  list.push_back(false);
+  ExpectSameOutput(list);
+}
+
+TEST(TestJSONStreamWriter, Escaping)
+{
+  CVariant value(CVariant::VariantTypeObject);
+  value["quote \" and backslash \\"] = "\"quoted\" \\path\\";
+  value["control"] = "tab\tnewline\nreturn\rformfeed\fbackspace\b";
+  value["slash"] = "</script>";
+  value["low"] = std::string("nul\0bell\x07", 9);
+  value["list"].push_back("line 1\nline 2");
+
+  ExpectSameOutput(value);
+}
+
+TEST(TestJSONStreamWriter, NonAsciiText)
+{
+  CVariant value(CVariant::VariantTypeObject);
+  value["title"] = "Am\xC3\xA9lie";
+  value["\xE6\x97\xA5\xE6\x9C\xAC"] = "\xE6\x9D\xB1\xE4\xBA\xAC\xE7\x89\xA9\xE8\xAA\x9E";
+  value["emoji"] = "\xF0\x9F\x8E\xAC";
+  value["genres"].push_back("Com\xC3\xA9\x64ie");
+  value["genres"].push_back("\xD0\x94\xD1\x80\xD0\xB0\xD0\xBC\xD0\xB0");
+
+  ExpectSameOutput(value);
+}
+
+TEST(TestJSONStreamWriter, Doubles)
+{
+  CVariant value(CVariant::VariantTypeArray);
+  value.push_back(0.0);
+  value.push_back(-0.5);
+  value.push_back(7.5);
+  value.push_back(1.0 / 3.0);
+  value.push_back(123456789.123456789);
+  value.push_back(1e-300);
+  value.push_back(6.02214076e23);
+  value.push_back(static_cast<float>(0.1f));
+
+  ExpectSameOutput(value);
+
+  CVariant object(CVariant::VariantTypeObject);
+  object["rating"] = 8.25;
+  object["ratings"] = value;
+  ExpectSameOutput(object);
+}
+
+TEST(TestJSONStreamWriter, CompactAndPretty)
+{
+  CVariant value = CreateItem(5);
+  value["cast"].push_back(CreateItem(6));
+
+  std::string compact, pretty;
+  CJSONStreamWriter compactWriter(true);
+  StreamVariant(compactWriter, value, compact);
+  CJSONStreamWriter prettyWriter(false);
+  StreamVariant(prettyWriter, value, pretty);
+
+  EXPECT_EQ(std::string::npos, compact.find('\n'));
+  EXPECT_NE(std::string::npos, pretty.find("\n\t"));
+  EXPECT_EQ(CJSONVariantWriter::Write(value, true), compact);
+  EXPECT_EQ(CJSONVariantWriter::Write(value, false), pretty);
+}
@@ -22,6 +22,11 @@
 #include "settings/Settings.h"
 #include "utils/SystemInfo.h"
 
+#include <vector>
+#ifdef TARGET_POSIX
+#include "linux/XTimeUtils.h"
+#endif
+
 #include "gtest/gtest.h"
 
 /* CSysInfoJob::GetInternetState() will test for network connectivity. */
@@ -153,6 +158,37 @@ WaitForJobToStartProcessing(CJob::PRIORITY priority, JobControlPackage &package)
 
   return job;
 }
+
+class OrderedJob :
+  public CJob
+{
+public:
+
+  OrderedJob(unsigned int index, std::vector<unsigned int> &order, CCriticalSection &section) :
+    m_index(index),
+    m_order(order),
+    m_section(section)
+  {
+  }
+
+  const char * GetType() const
+  {
+    return "OrderedJob";
+  }
+
+  bool DoWork()
+  {
+    CSingleLock lock(m_section);
+    m_order.push_back(m_index);
+    return true;
+  }
+
+private:
+
+  unsigned int m_index;
+  std::vector<unsigned int> &m_order;
+  CCriticalSection &m_section;
+};
 }
   
 TEST_F(TestJobManager, PauseLowPriorityJob)
@@ -178,3 +214,52 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+TEST_F(TestJobManager, JobStatistics)
+{
+  JobControlPackage package;
+  BroadcastingJob *job (WaitForJobToStartProcessing(CJob::PRIORITY_NORMAL, package));
+
+  EXPECT_EQ(0U, CJobManager::GetInstance().GetQueueDepth(CJob::PRIORITY_NORMAL));
+  EXPECT_EQ(1, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  job->FinishAndStopBlocking();
+  while (CJobManager::GetInstance().IsProcessing("BroadcastingJob"))
+    Sleep(1);
+
+  JobStatistics stats;
+  EXPECT_TRUE(CJobManager::GetInstance().GetJobStatistics("BroadcastingJob", stats));
+  EXPECT_LE(1U, stats.processed);
+  EXPECT_GE(stats.totalRunTime, stats.maxRunTime);
+}
+
+TEST_F(TestJobManager, KeepsOrderWithinQueue)
+{
+  // low pausable jobs get two workers, so with one of them blocked the
+  // remaining jobs run one after the other
+  JobControlPackage package;
+  BroadcastingJob *job (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package));
+
+  // jobs are spread over the queues in turn, so every NUM_QUEUES-th job
+  // lands in the same queue
+  const unsigned int count = 4 * CJobManager::NUM_QUEUES;
+  std::vector<unsigned int> order;
+  CCriticalSection section;
+  for (unsigned int i = 0; i < count; i++)
+    CJobManager::GetInstance().AddJob(new OrderedJob(i, order, section), NULL, CJob::PRIORITY_LOW_PAUSABLE);
+
+  while (CJobManager::GetInstance().GetQueueDepth(CJob::PRIORITY_LOW_PAUSABLE) ||
+         CJobManager::GetInstance().IsProcessing("OrderedJob"))
+    Sleep(1);
+
+  CSingleLock lock(section);
+  ASSERT_EQ(count, order.size());
+  std::vector<unsigned int> position(count);
+  for (unsigned int i = 0; i < count; i++)
+    position[order[i]] = i;
+  for (unsigned int i = CJobManager::NUM_QUEUES; i < count; i++)
+    EXPECT_LT(position[i - CJobManager::NUM_QUEUES], position[i]);
+  lock.Leave();
+
+  job->FinishAndStopBlocking();
+}
@@ -0,0 +1,77 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ParallelFor.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace KODI::UTILS;
+
+TEST(TestParallelFor, ProcessesEveryIndexOnce)
+{
+  std::vector<std::atomic<int> > visits(10000);
+  for (size_t i = 0; i < visits.size(); i++)
+    visits[i] = 0;
+
+  ParallelFor(visits.size(), 16, [&visits](size_t begin, size_t end)
+  {
+    EXPECT_LT(begin, end);
+    for (size_t i = begin; i < end; i++)
+      visits[i]++;
+  });
+
+  for (size_t i = 0; i < visits.size(); i++)
+    EXPECT_EQ(1, visits[i]);
+}
+
+TEST(TestParallelFor, SmallRangeIsOneChunk)
+{
+  int calls = 0;
+  ParallelFor(10, 16, [&calls](size_t begin, size_t end)
+  {
+    EXPECT_EQ(0U, begin);
+    EXPECT_EQ(10U, end);
+    calls++;
+  });
+  EXPECT_EQ(1, calls);
+
+  ParallelFor(0, 16, [&calls](size_t begin, size_t end) { calls++; });
+  EXPECT_EQ(1, calls);
+}
+
+TEST(TestParallelFor, StableSortKeepsEqualOrder)
+{
+  std::vector<std::pair<int, int> > values;
+  for (int i = 0; i < 5000; i++)
+    values.push_back(std::make_pair((i * 7919) % 37, i));
+
+  std::vector<std::pair<int, int> > expected(values);
+  auto byKey = [](const std::pair<int, int> &left, const std::pair<int, int> &right)
+  {
+    return left.first < right.first;
+  };
+  std::stable_sort(expected.begin(), expected.end(), byKey);
+
+  ParallelStableSort(values.begin(), values.end(), byKey, 100);
+  EXPECT_TRUE(values == expected);
+}
@@ -19,6 +19,7 @@
  */
 
 #include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
@@ -115,6 +116,76 @@ TEST(TestSortUtils, Sort_SortDescription)
   EXPECT_STREQ("R Artist", (*items.at(6))[FieldArtist].asString().c_str());
 }
 
+TEST(TestSortUtils, Sort_NaturalOrder)
+{
+  const char *labels[] = { "track 10", "Track 2", "track 001", "Track 2b", "track", "TRACK 02a" };
+  SortItems items;
+  for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); i++)
+  {
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = labels[i];
+    items.push_back(item);
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  EXPECT_STREQ("track", (*items.at(0))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("track 001", (*items.at(1))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Track 2", (*items.at(2))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("TRACK 02a", (*items.at(3))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Track 2b", (*items.at(4))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("track 10", (*items.at(5))[FieldLabel].asString().c_str());
+
+  SortUtils::Sort(SortByLabel, SortOrderDescending, SortAttributeNone, items);
+
+  EXPECT_STREQ("track 10", (*items.at(0))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Track 2b", (*items.at(1))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("TRACK 02a", (*items.at(2))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Track 2", (*items.at(3))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("track 001", (*items.at(4))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("track", (*items.at(5))[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_FoldersAndSpecials)
+{
+  SortItems items;
+  for (int i = 0; i < 6; i++)
+  {
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = StringUtils::Format("Item %d", 6 - i);
+    (*item)[FieldFolder] = i % 2 == 0;
+    items.push_back(item);
+  }
+  (*items.at(5))[FieldSortSpecial] = SortSpecialOnTop;
+  (*items.at(0))[FieldSortSpecial] = SortSpecialOnBottom;
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  EXPECT_STREQ("Item 1", (*items.at(0))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Item 2", (*items.at(1))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Item 4", (*items.at(2))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Item 3", (*items.at(3))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Item 5", (*items.at(4))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Item 6", (*items.at(5))[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_Limits)
+{
+  DatabaseResults items;
+  for (int i = 0; i < 100; i++)
+  {
+    DatabaseResult item;
+    item[FieldTitle] = StringUtils::Format("Title %d", (i * 37) % 100);
+    items.push_back(item);
+  }
+
+  SortUtils::Sort(SortByTitle, SortOrderAscending, SortAttributeNone, items, 15, 10);
+
+  ASSERT_EQ((size_t)5, items.size());
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(StringUtils::Format("Title %d", 10 + i), items.at(i)[FieldTitle].asString());
+}
+
 TEST(TestSortUtils, GetFieldsForSorting)
 {
   Fields fields;
@@ -530,12 +530,12 @@ int CVideoDatabase::GetPathId(const std::string& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL);
-    if (!m_pDS->eof())
-      idPath = m_pDS->fv("path.idPath").get_asInt();
+    strSQL = "select idPath from path where strPath=?";
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    stmt->bind_text(1, strPath1);
+    if (stmt->step())
+      idPath = stmt->column_int(0);
 
-    m_pDS->close();
     return idPath;
   }
   catch (...)
@@ -667,6 +667,20 @@ bool CVideoDatabase::GetPathsForTvShow(int idShow, std::set<int>& paths)
   return false;
 }
 
+int CVideoDatabase::RunQuery(const dbiplus::StatementPtr &stmt, const std::string &sql)
+{
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  int rows = -1;
+  if (m_pDS->query_statement(stmt))
+  {
+    rows = m_pDS->num_rows();
+    if (rows == 0)
+      m_pDS->close();
+  }
+  CLog::Log(LOGDEBUG, "%s took %d ms for %d items query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, rows, sql.c_str());
+  return rows;
+}
+
 int CVideoDatabase::RunQuery(const std::string &sql)
 {
   unsigned int time = XbmcThreads::SystemClockMillis();
@@ -1062,15 +1076,11 @@ int CVideoDatabase::GetFileId(const std::string& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      std::string strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL);
-      if (m_pDS->num_rows() > 0)
-      {
-        int idFile = m_pDS->fv("files.idFile").get_asInt();
-        m_pDS->close();
-        return idFile;
-      }
+      dbiplus::StatementPtr stmt = m_pDB->prepare_statement("select idFile from files where strFileName=? and idPath=?");
+      stmt->bind_text(1, strFileName);
+      stmt->bind_int(2, idPath);
+      if (stmt->step())
+        return stmt->column_int(0);
     }
   }
   catch (...)
@@ -6634,17 +6644,69 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
       return false;
 
     // Apply the limiting directly here if there's no special sorting but limiting
+    bool limit = false;
+    int limitOffset, limitCount;
     if (extFilter.limit.empty() &&
         sorting.sortBy == SortByNone &&
        (sorting.limitStart > 0 || sorting.limitEnd > 0))
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      total = GetCount(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra);
+      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart, limitOffset, limitCount);
+      limit = true;
     }
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // the listing is compiled once and reused from the statement cache when
+    // it is refreshed, only the range of rows is bound
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    if (limit)
+    {
+      stmt->bind_int(1, limitOffset);
+      stmt->bind_int(2, limitCount);
+    }
+
+    auto addMovie = [&](const dbiplus::sql_record* const record)
+    {
+      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
+      if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
+          g_passwordManager.bMasterUser                                   ||
+          g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
+      {
+        CFileItemPtr pItem(new CFileItem(movie));
+
+        CVideoDbUrl itemUrl = videoUrl;
+        std::string path = StringUtils::Format("%i", movie.m_iDbId);
+        itemUrl.AppendPath(path);
+        pItem->SetPath(itemUrl.ToString());
+
+        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
+        items.Add(pItem);
+      }
+    };
+
+    // without sorting on our side the rows can be consumed as the database
+    // produces them instead of materializing the whole result set first.
+    // Fetching details runs further queries, so keep those on the buffered path.
+    if (sortDescription.sortBy == SortByNone && getDetails == VideoDbDetailsNone)
+    {
+      unsigned int time = XbmcThreads::SystemClockMillis();
+      if (!m_pDS->query_statement_streaming(stmt))
+        return false;
+
+      for (; !m_pDS->eof(); m_pDS->next())
+        addMovie(m_pDS->get_sql_record());
+
+      if (total < m_pDS->num_rows())
+        total = m_pDS->num_rows();
+      items.SetProperty("total", total);
+      CLog::Log(LOGDEBUG, "%s took %d ms for %d items streaming query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, m_pDS->num_rows(), strSQL.c_str());
+
+      m_pDS->close();
+      return true;
+    }
+
+    int iRowsFound = RunQuery(stmt, strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
@@ -6665,23 +6727,7 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     for (const auto &i : results)
     {
       unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-
-      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
-      if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
-          g_passwordManager.bMasterUser                                   ||
-          g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
-      {
-        CFileItemPtr pItem(new CFileItem(movie));
-
-        CVideoDbUrl itemUrl = videoUrl;
-        std::string path = StringUtils::Format("%i", movie.m_iDbId);
-        itemUrl.AppendPath(path);
-        pItem->SetPath(itemUrl.ToString());
-
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
-        items.Add(pItem);
-      }
+      addMovie(data.at(targetRow));
     }
 
     // cleanup
@@ -6868,17 +6914,29 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
       return false;
 
     // Apply the limiting directly here if there's no special sorting but limiting
+    bool limit = false;
+    int limitOffset, limitCount;
     if (extFilter.limit.empty() &&
       sorting.sortBy == SortByNone &&
       (sorting.limitStart > 0 || sorting.limitEnd > 0))
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      total = GetCount(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra);
+      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart, limitOffset, limitCount);
+      limit = true;
     }
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // the listing is compiled once and reused from the statement cache when
+    // it is refreshed, only the range of rows is bound
+    dbiplus::StatementPtr stmt = m_pDB->prepare_statement(strSQL);
+    if (limit)
+    {
+      stmt->bind_int(1, limitOffset);
+      stmt->bind_int(2, limitCount);
+    }
+
+    int iRowsFound = RunQuery(stmt, strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
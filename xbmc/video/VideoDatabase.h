@@ -947,6 +947,7 @@ private:
    \return the number of rows, -1 for an error.
    */
   int RunQuery(const std::string &sql);
+  int RunQuery(const dbiplus::StatementPtr &stmt, const std::string &sql);
 
   void AppendIdLinkFilter(const char* field, const char *table, const MediaType& mediaType, const char *view, const char *viewKey, const CUrlOptions::UrlOptions& options, Filter &filter);
   void AppendLinkFilter(const char* field, const char *table, const MediaType& mediaType, const char *view, const char *viewKey, const CUrlOptions::UrlOptions& options, Filter &filter);
@@ -1427,10 +1427,8 @@ void CGUIWindowVideoBase::GetGroupedItems(CFileItemList &items)
     }
   }
 
-  // reload thumbs after filtering and grouping
-  if (m_thumbLoader.IsLoading())
-    m_thumbLoader.StopThread();
-
+  // reload thumbs after filtering and grouping. Load() stops a running loader,
+  // or carries on with the one started on a partial listing.
   m_thumbLoader.Load(items);
 }
 
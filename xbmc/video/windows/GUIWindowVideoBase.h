@@ -93,6 +93,7 @@ protected:
   void OnScan(const std::string& strPath, bool scanAll = false);
   virtual bool Update(const std::string &strDirectory, bool updateFilterPath = true) override;
   virtual bool GetDirectory(const std::string &strDirectory, CFileItemList &items) override;
+  virtual CBackgroundInfoLoader* GetListingLoader() override { return &m_thumbLoader; }
   virtual void OnItemLoaded(CFileItem* pItem) override {};
   virtual void GetGroupedItems(CFileItemList &items) override;
 
@@ -20,6 +20,7 @@
 
 #include "GUIMediaWindow.h"
 #include "Application.h"
+#include "BackgroundInfoLoader.h"
 #include "messaging/ApplicationMessenger.h"
 #include "ContextMenuManager.h"
 #include "FileItemListModification.h"
@@ -60,6 +61,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "storage/MediaManager.h"
+#include "threads/SingleLock.h"
 #include "threads/SystemClock.h"
 #include "utils/FileUtils.h"
 #include "utils/LabelFormatter.h"
@@ -99,6 +101,9 @@ CGUIMediaWindow::CGUIMediaWindow(int id, const char *xmlFile)
   m_vecItems->SetPath("?");
   m_iLastControl = -1;
   m_canFilterAdvanced = false;
+  m_listingLoader = NULL;
+  m_showPartialListing = false;
+  m_partialListingShown = false;
 
   m_guiState.reset(CGUIViewState::GetViewState(GetID(), *m_vecItems));
 }
@@ -479,6 +484,12 @@ bool CGUIMediaWindow::OnMessage(CGUIMessage& message)
       return true;
     }
     break;
+  case GUI_MSG_PARTIAL_LISTING:
+    {
+      ShowPartialListing();
+      return true;
+    }
+    break;
   case GUI_MSG_WINDOW_INIT:
     {
       if (m_vecItems->GetPath() == "?")
@@ -674,8 +685,36 @@ bool CGUIMediaWindow::GetDirectory(const std::string &strDirectory, CFileItemLis
     if (strDirectory.empty())
       SetupShares();
     
+    // show a slow listing and let the info loader work on it before it is complete
+    bool pipelined = g_advancedSettings.m_pipelinedListing;
+    if (pipelined)
+    {
+      m_listingLoader = GetListingLoader();
+      if (m_listingLoader)
+        m_listingLoader->StopThread();
+      m_showPartialListing = &items == m_vecItems;
+      m_partialListingShown = false;
+      m_rootDir.SetListingObserver(this);
+    }
+
     CFileItemList dirItems;
-    if (!m_rootDir.GetDirectory(pathToUrl, dirItems, UseFileDirectories()))
+    bool result = m_rootDir.GetDirectory(pathToUrl, dirItems, UseFileDirectories());
+
+    if (pipelined)
+    {
+      m_rootDir.SetListingObserver(NULL);
+      m_showPartialListing = false;
+      {
+        CSingleLock lock(m_partialSection);
+        m_partialItems.clear();
+      }
+      // on success the loader carries on when the window Load()s the listing
+      if (m_listingLoader && !result)
+        m_listingLoader->StopThread();
+      m_listingLoader = NULL;
+    }
+
+    if (!result)
       return false;
     
     // assign fetched directory items
@@ -875,6 +914,45 @@ void CGUIMediaWindow::OnPrepareFileItems(CFileItemList &items)
   CFileItemListModification::GetInstance().Modify(items);
 }
 
+void CGUIMediaWindow::OnPartialListing(const CFileItemList &items)
+{
+  if (m_listingLoader)
+    m_listingLoader->OnPartialListing(items);
+
+  if (!m_showPartialListing)
+    return;
+
+  {
+    CSingleLock lock(m_partialSection);
+    for (int i = 0; i < items.Size(); i++)
+      m_partialItems.push_back(items.Get(i));
+  }
+
+  CGUIMessage msg(GUI_MSG_PARTIAL_LISTING, GetID(), GetID());
+  g_windowManager.SendThreadMessage(msg, GetID());
+}
+
+void CGUIMediaWindow::ShowPartialListing()
+{
+  std::vector<CFileItemPtr> items;
+  {
+    CSingleLock lock(m_partialSection);
+    items.swap(m_partialItems);
+  }
+  if (!m_showPartialListing || items.empty())
+    return;
+
+  // the previous folder stays until the first entries of the new one arrive
+  if (!m_partialListingShown)
+  {
+    m_vecItems->ClearItems();
+    m_partialListingShown = true;
+  }
+  for (std::vector<CFileItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it)
+    m_vecItems->Add(*it);
+  m_viewControl.SetItems(*m_vecItems);
+}
+
 // \brief This function will be called by Update() before
 // any additional formatting, filtering or sorting is applied.
 // Override this function to define a custom caching behaviour.
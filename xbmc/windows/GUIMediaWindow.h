@@ -22,16 +22,19 @@
 
 #include "dialogs/GUIDialogContextMenu.h"
 #include "filesystem/DirectoryHistory.h"
+#include "filesystem/IDirectory.h"
 #include "filesystem/VirtualDirectory.h"
 #include "guilib/GUIWindow.h"
 #include "playlists/SmartPlayList.h"
+#include "threads/CriticalSection.h"
 #include "view/GUIViewControl.h"
 
+class CBackgroundInfoLoader;
 class CFileItemList;
 class CGUIViewState;
 
 // base class for all media windows
-class CGUIMediaWindow : public CGUIWindow
+class CGUIMediaWindow : public CGUIWindow, public XFILE::IDirectoryListingObserver
 {
 public:
   CGUIMediaWindow(int id, const char *xmlFile);
@@ -63,6 +66,9 @@ public:
   const CGUIViewState *GetViewState() const;
   virtual bool UseFileDirectories() { return true; }
 
+  // implementation of IDirectoryListingObserver
+  virtual void OnPartialListing(const CFileItemList &items) override;
+
 protected:
   // specializations of CGUIControlGroup
   virtual CGUIControl *GetFirstFocusableControl(int id) override;
@@ -92,6 +98,19 @@ protected:
   virtual void RestoreControlStates() override;
 
   virtual bool GetDirectory(const std::string &strDirectory, CFileItemList &items);
+  /*! \brief Loader that may start on a directory while it is still being listed
+   Only used when pipelined listing is enabled in advancedsettings. The window
+   is expected to Load() the complete listing into the same loader afterwards.
+   \return the loader, or NULL if the window does not want partial listings
+   \sa GetDirectory
+   */
+  virtual CBackgroundInfoLoader* GetListingLoader() { return NULL; }
+  /*! \brief Add the entries that arrived from a slow listing to the view
+   Called on the GUI thread while GetDirectory() is still waiting for the listing.
+   The entries are shown unsorted until the complete listing replaces them.
+   \sa OnPartialListing
+   */
+  void ShowPartialListing();
   /*! \brief Retrieves the items from the given path and updates the list
    \param strDirectory The path to the directory to get the items from
    \param updateFilterPath Whether to update the filter path in m_strFilterPath or not
@@ -210,4 +229,11 @@ protected:
    \sa Update
    */
   std::string m_strFilterPath;
+
+private:
+  CBackgroundInfoLoader* m_listingLoader;  ///< loader fed by the listing GetDirectory() is running
+  bool m_showPartialListing;               ///< whether partial listings go to m_vecItems
+  bool m_partialListingShown;              ///< whether m_vecItems holds entries of the running listing
+  CCriticalSection m_partialSection;
+  std::vector<CFileItemPtr> m_partialItems; ///< listed entries not yet shown
 };